@@ -0,0 +1,322 @@
+/**
+ * @file:    hdlcBench.c
+ *
+ * Purpose:  Throughput benchmark for the HDLC framing routines
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Sierra Wireless Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *----------------------------------------------------------------------------
+ *
+ * NOTES:
+ *
+ * Measures hdlc_Pack + hdlc_PackFinalize and hdlc_Unpack throughput, in MB/s of payload,
+ * for each combination of:
+ * - payload size:      10 B to 100 KB
+ * - escape density:    percentage of payload bytes which are 0x7E or 0x7D
+ * - input chunking:    bytes handed to each call: 1, 64, or the whole buffer (reported as 0)
+ *
+ * Every case is checked to round-trip before it is timed.  Results are written to stdout
+ * as JSON.
+ *
+ * Usage:  hdlcBench [min time per measurement, ms (default 50)]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hdlc.h"
+
+
+#define BENCH_PAYLOAD_SIZE_MAX   100000
+#define BENCH_FRAME_SIZE_MAX     ((BENCH_PAYLOAD_SIZE_MAX * 2) + HDLC_OVERHEAD_BYTES_COUNT)
+
+static const size_t payloadSizes[] = { 10, 100, 1000, 10000, 100000 };
+static const int    escapePercents[] = { 0, 1, 50, 100 };
+static const size_t chunkSizes[] = { 1, 64, 0 };     // 0: whole buffer
+
+#define ARRAY_COUNT(a)  (sizeof(a) / sizeof((a)[0]))
+
+static uint8_t payload[BENCH_PAYLOAD_SIZE_MAX];
+static uint8_t frame[BENCH_FRAME_SIZE_MAX];
+static uint8_t unpacked[BENCH_FRAME_SIZE_MAX];
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Monotonic time in seconds
+ */
+//--------------------------------------------------------------------------------------------------
+static double bench_Now
+(
+    void
+)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fill the payload with pseudo-random bytes, of which the given percentage need escaping
+ *
+ * @note:  A fixed seed keeps the payloads, and so the results, comparable between runs
+ */
+//--------------------------------------------------------------------------------------------------
+static void bench_PayloadFill
+(
+    size_t len,
+    int    escapePercent
+)
+{
+    uint32_t seed = 0x12345678;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        seed = (seed * 1103515245) + 12345;
+        uint32_t r = seed >> 8;
+
+        if ((int)(r % 100) < escapePercent)
+        {
+            payload[i] = (r & 0x100) ? 0x7E : 0x7D;
+        }
+        else
+        {
+            // Any other byte value
+            payload[i] = (r & 0xFF);
+            if ((0x7E == payload[i]) || (0x7D == payload[i]))
+            {
+                payload[i] = 0x55;
+            }
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pack the payload into a frame, handing at most chunk bytes to each hdlc_Pack call
+ *
+ * @return: frame length, or -1 on failure
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t bench_Pack
+(
+    size_t len,
+    size_t chunk
+)
+{
+    hdlc_context_t context;
+    size_t srcIdx = 0;
+    ssize_t frameLen = 0;
+    ssize_t count;
+
+    hdlc_Init(&context);
+
+    while (srcIdx < len)
+    {
+        size_t srcLen = len - srcIdx;
+        if (chunk && (srcLen > chunk))
+        {
+            srcLen = chunk;
+        }
+
+        count = hdlc_Pack(&context, frame + frameLen, sizeof(frame) - frameLen,
+                          payload + srcIdx, &srcLen);
+        if (count < 0)
+        {
+            return -1;
+        }
+        frameLen += count;
+        srcIdx += srcLen;
+    }
+
+    count = hdlc_PackFinalize(&context, frame + frameLen, sizeof(frame) - frameLen);
+    if (count < 0)
+    {
+        return -1;
+    }
+
+    return frameLen + count;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Unpack a frame, handing at most chunk bytes to each hdlc_Unpack call
+ *
+ * @return: unpacked length, or -1 on failure
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t bench_Unpack
+(
+    size_t frameLen,
+    size_t chunk
+)
+{
+    hdlc_context_t context;
+    size_t srcIdx = 0;
+    ssize_t len = 0;
+
+    hdlc_Init(&context);
+
+    while (srcIdx < frameLen)
+    {
+        size_t srcLen = frameLen - srcIdx;
+        if (chunk && (srcLen > chunk))
+        {
+            srcLen = chunk;
+        }
+
+        ssize_t count = hdlc_Unpack(&context, unpacked + len, sizeof(unpacked) - len,
+                                    frame + srcIdx, &srcLen);
+        if (count < 0)
+        {
+            return -1;
+        }
+        len += count;
+        srcIdx += srcLen;
+
+        if (hdlc_UnpackDone(&context))
+        {
+            return len;
+        }
+    }
+
+    return -1;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Time one operation on the current payload or frame, repeating it for at least minTime seconds
+ *
+ * @return: payload throughput, MB/s
+ */
+//--------------------------------------------------------------------------------------------------
+static double bench_Measure
+(
+    bool          unpack,
+    size_t        len,
+    size_t        frameLen,
+    size_t        chunk,
+    double        minTime,
+    unsigned long *iterations
+)
+{
+    unsigned long count = 0;
+    unsigned long batch = 1;
+    double start = bench_Now();
+    double elapsed;
+
+    do
+    {
+        for (unsigned long i = 0; i < batch; i++)
+        {
+            if (unpack)
+            {
+                (void)bench_Unpack(frameLen, chunk);
+            }
+            else
+            {
+                (void)bench_Pack(len, chunk);
+            }
+        }
+        count += batch;
+        batch *= 2;
+        elapsed = bench_Now() - start;
+    } while (elapsed < minTime);
+
+    *iterations = count;
+    return ((double)len * count) / elapsed / 1e6;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run all cases and print the results as JSON
+ */
+//--------------------------------------------------------------------------------------------------
+int main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    double minTime = 0.05;
+    bool first = true;
+
+    if (argc > 1)
+    {
+        minTime = atof(argv[1]) / 1000;
+    }
+
+    printf("{\n  \"benchmark\": \"hdlc\",\n  \"unit\": \"MB/s\",\n  \"results\": [");
+
+    for (size_t s = 0; s < ARRAY_COUNT(payloadSizes); s++)
+    {
+        for (size_t e = 0; e < ARRAY_COUNT(escapePercents); e++)
+        {
+            size_t len = payloadSizes[s];
+
+            bench_PayloadFill(len, escapePercents[e]);
+
+            for (size_t c = 0; c < ARRAY_COUNT(chunkSizes); c++)
+            {
+                size_t chunk = chunkSizes[c];
+                unsigned long packCount, unpackCount;
+
+                // Check the round trip, which also leaves the frame in place for unpacking
+                ssize_t frameLen = bench_Pack(len, chunk);
+                if (   (frameLen < 0)
+                    || (bench_Unpack(frameLen, chunk) != (ssize_t)len)
+                    || memcmp(payload, unpacked, len))
+                {
+                    fprintf(stderr, "Round trip failed: size %zu, escapes %d%%, chunk %zu\n",
+                            len, escapePercents[e], chunk);
+                    return EXIT_FAILURE;
+                }
+
+                double pack = bench_Measure(false, len, frameLen, chunk, minTime, &packCount);
+                double unpack = bench_Measure(true, len, frameLen, chunk, minTime, &unpackCount);
+
+                printf("%s\n    { \"size\": %zu, \"escape_pct\": %d, \"chunk\": %zu, "
+                       "\"frame_size\": %zd, "
+                       "\"pack_mbps\": %.2f, \"pack_iterations\": %lu, "
+                       "\"unpack_mbps\": %.2f, \"unpack_iterations\": %lu }",
+                       first ? "" : ",", len, escapePercents[e], chunk, frameLen,
+                       pack, packCount, unpack, unpackCount);
+                first = false;
+                fflush(stdout);
+            }
+        }
+    }
+
+    printf("\n  ]\n}\n");
+
+    return EXIT_SUCCESS;
+}
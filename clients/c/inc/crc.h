@@ -0,0 +1,88 @@
+/**
+ * @file:    crc.h
+ *
+ * Purpose:  16-bit CRC-CCITT utilities
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Sierra Wireless Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *----------------------------------------------------------------------------
+ *
+ * NOTES:
+ *
+ * CRC-16/CCITT (polynomial 0x1021, MSB first, no final XOR), as used by the HDLC framing.
+ *
+ * - crc16_update processes a buffer of any length using slicing-by-8 lookup tables, or on x86-64
+ *   CPUs with PCLMULQDQ, by carry-less multiply folding.  The kernel is selected at start-up
+ * - _crc_ccitt_update processes a single byte, and is kept as the reference implementation
+ * - All tables are constant, so these routines may be called concurrently from any thread
+ */
+
+#ifndef CRC_H_INCLUDE_GUARD
+#define CRC_H_INCLUDE_GUARD
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Defines, Constants
+ */
+//--------------------------------------------------------------------------------------------------
+#define CRC_CRC16_CCITT_INIT 0xFFFF
+#define CRC_POLY_CCITT       0x1021
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Update a CRC-16/CCITT with a buffer of bytes
+ *
+ * @note:  To compute the CRC of a stream spanning multiple buffers, pass the result of the
+ * previous call as the crc of the next.  Start with CRC_CRC16_CCITT_INIT
+ *
+ * @return  updated crc
+ */
+//--------------------------------------------------------------------------------------------------
+uint16_t crc16_update
+(
+    uint16_t       crc,                // current crc value
+    const uint8_t *buf,                // pointer to the data
+    size_t         len                 // number of data bytes
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Update a CRC-16/CCITT with a single byte
+ *
+ * @return  updated crc
+ */
+//--------------------------------------------------------------------------------------------------
+uint16_t _crc_ccitt_update
+(
+    uint16_t crc,
+    uint8_t  c
+);
+
+
+#endif // CRC_H_INCLUDE_GUARD
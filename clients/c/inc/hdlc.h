@@ -37,6 +37,10 @@
  *
  * - hdlc_Pack / hdlc_Unpack routines may be called multiple times on a stream
  *   of bytes
+ * - hdlc_Unpack may be used in place, with the destination aliasing the source
+ * - hdlc_PackInPlace frames a whole packet within the buffer holding it
+ * - hdlc_PackV frames a list of segments into a list of segments for writev, without
+ *   copying the data
  * - hdlc_Init must be called before packing / unpacking each new frame
  * - hdlc_UnpackDone must be called to check for unpacking complete
  * - hdlc_PackFinalize must be called to complete packing
@@ -46,6 +50,7 @@
 #define HDLC_H_INCLUDE_GUARD
 
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -58,6 +63,9 @@
 // Leading 0x7E + 16-bit CRC (possibly escaped to 4 bytes) + trailing 0x7E
 #define HDLC_OVERHEAD_BYTES_COUNT 6
 
+// Space to leave ahead of a packet to be framed by hdlc_PackInPlace: the leading 0x7E
+#define HDLC_PACK_HEADROOM        1
+
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -94,6 +102,20 @@ typedef enum
 hdlc_error_t;
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * HDLC frame descriptor, as returned by hdlc_UnpackBurst
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    size_t offset;                     // offset of the unpacked data in the buffer
+    size_t length;                     // length of the unpacked data
+    int    status;                     // 0: valid frame, otherwise an hdlc_error_t
+}
+hdlc_frame_t;
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Initialize HDLC context
@@ -119,12 +141,16 @@ void hdlc_Init
  * - Call hdlc_state after each call to hdlc_Unpack to check if unpacking is complete
  * - May be called multiple times until a complete frame is decoded
  * - If started in the middle of a frame, will search for <7E> or <7E><7E>
+ * - May unpack in place:  dest may alias src, provided that dest does not point past src.
+ *   Each source byte unpacks to at most one byte, so the output never overtakes the input
  *
  * @return  >= 0 : length data unpacked on this call
  * @return  <  0 : failure
  * @return  srclen : IN - count of source bytes to unpack.  OUT - count of source bytes unpacked
  *
- * *** The trailing frame byte is NOT included in the count of source bytes unpacked ***
+ * *** On a CRC or framing error at a frame octet, that octet is NOT included in the count of
+ *     source bytes unpacked.  It is rescanned as the start of the next frame on the next call,
+ *     so that a lost closing flag does not also cost the following frame ***
  */
 //--------------------------------------------------------------------------------------------------
 ssize_t hdlc_Unpack
@@ -137,6 +163,35 @@ ssize_t hdlc_Unpack
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Unpack all complete HDLC frames in a buffer, in place
+ *
+ * @note
+ * - hdlc_Init must be called once before the first call on a stream.  It is not required
+ *   between frames
+ * - Each frame is unpacked in place and described by one entry of frames[]: the unpacked data
+ *   is at buf + offset.  Frames which fail to unpack are reported with length 0 and an error
+ *   status
+ * - Processing stops after the last frame octet in the buffer, or when maxFrames descriptors
+ *   have been filled.  Bytes beyond that point are not modified, and should be presented again,
+ *   followed by more data, on the next call
+ *
+ * @return  >= 0 : number of frame descriptors filled
+ * @return  <  0 : failure
+ * @return  buflen : IN - count of bytes in the buffer.  OUT - count of bytes processed
+ */
+//--------------------------------------------------------------------------------------------------
+ssize_t hdlc_UnpackBurst
+(
+    hdlc_context_t *hdlc,              // pointer to HDLC context structure
+    uint8_t        *buf,               // pointer to the received (framed) bytes
+    size_t         *buflen,            // number of bytes in, or processed-from, the buffer
+    hdlc_frame_t   *frames,            // array of frame descriptors to fill
+    size_t          maxFrames          // number of entries in frames[]
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Check whether HDLC unpacking is complete
@@ -174,6 +229,63 @@ ssize_t hdlc_Pack
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pack a complete HDLC frame in place
+ *
+ * @note
+ * - The packet must be at buf + HDLC_PACK_HEADROOM.  The frame is built around it, starting at
+ *   buf.  No context is used, and hdlc_PackFinalize must not be called
+ * - If the packet contains no bytes needing escape, it is not moved
+ * - buflen must allow for the framing and any escapes: up to 2 * len + HDLC_OVERHEAD_BYTES_COUNT
+ *
+ * @return  >  0 : length of the frame, starting at buf
+ * @return  <  0 : failure
+ */
+//--------------------------------------------------------------------------------------------------
+ssize_t hdlc_PackInPlace
+(
+    uint8_t        *buf,               // pointer to the frame buffer, holding the packet
+    size_t          buflen,            // size of the frame buffer
+    size_t          len                // length of the packet at buf + HDLC_PACK_HEADROOM
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pack an HDLC frame from a list of segments (scatter-gather)
+ *
+ * @note
+ * - hdlc_Init must be called first, for each new frame to be encoded
+ * - The output segments point into the source segments for runs of data which need no
+ *   escaping.  The opening frame octet and escape sequences are written to the scratch buffer.
+ *   Source and scratch buffers must remain valid until the output has been sent
+ * - Output is bounded by the number of output segments and the scratch buffer size.  Call
+ *   again, with a fresh set of output segments and scratch buffer, until srcoffset reaches the
+ *   total source length
+ * - hdlc_PackFinalize must be called to finalize the encoding, after all data is processed.
+ *   hdlc_Pack may also follow, but must not precede, calls to hdlc_PackV on the same frame
+ *
+ * @return  >= 0 : number of frame bytes described by the output segments filled on this call
+ * @return  <  0 : failure
+ * @return  destcnt : IN - count of output segments.  OUT - count of output segments filled
+ * @return  srcoffset : IN - bytes of the source already packed.  OUT - updated by the bytes
+ *                      packed on this call
+ */
+//--------------------------------------------------------------------------------------------------
+ssize_t hdlc_PackV
+(
+    hdlc_context_t     *hdlc,          // pointer to HDLC context structure
+    struct iovec       *dest,          // output segments to fill
+    int                *destcnt,       // number of entries in, or filled-in, dest[]
+    uint8_t            *scratch,       // buffer for frame octets and escape sequences
+    size_t              scratchlen,    // size of the scratch buffer
+    const struct iovec *src,           // source segments
+    int                 srccnt,        // number of entries in src[]
+    size_t             *srcoffset      // number of bytes of the source segments packed so far
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Complete HDLC packing - call to complete packing, after all data has been processed
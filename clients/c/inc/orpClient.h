@@ -35,7 +35,15 @@
 #define ORP_CLIENT_H_INCLUDE_GUARD
 
 #include <stdbool.h>
+#include <pthread.h>
+#include <sys/uio.h>
 #include "orpProtocol.h"
+#include "hdlc.h"
+#include "orpPathDict.h"
+#include "orpFile.h"
+#include "orpUring.h"
+#include "orpRxRing.h"
+#include "orpTxQueue.h"
 
 
 //--------------------------------------------------------------------------------------------------
@@ -43,24 +51,159 @@
  * Transmission mode
  */
 //--------------------------------------------------------------------------------------------------
-
-extern uint8_t mode;
-
 enum mode{
     MODE_HDLC,
     MODE_AT
 };
 
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Buffer sizes of a client, see orpClient.c
+ */
+//--------------------------------------------------------------------------------------------------
+// Max data length.  Setting equal to the Datahub max here
+#define ORP_PACKET_DATA_SIZE_MAX    IO_MAX_STRING_VALUE_LEN
+
+// Max size of an unframed request/response packet; including protocol fields:
+#define ORP_PACKET_SIZE_MAX         (  ORP_PROTOCOL_LEN_NO_DATA_MAX \
+                                     + ORP_PACKET_DATA_SIZE_MAX)
+
+// The receive ring holds 8 of the largest packets, after skipping to its start before any of them
+_Static_assert(9 * ORP_RX_RING_RECORD_LEN(ORP_PACKET_SIZE_MAX) - ORP_RX_RING_HEADER_LEN
+               <= ORP_RX_RING_SIZE, "ORP_RX_RING_SIZE holds fewer than 8 of the largest packets");
+
+/* Max frame size.  Using a factor of 2 here in order to support stress-testing with all
+ * needing to be escaped.  Normally, this isn't necessary
+ */
+#define ORP_HDLC_FRAME_SIZE_MAX     ((ORP_PACKET_SIZE_MAX * 2) + HDLC_OVERHEAD_BYTES_COUNT)
+
+// Max number of frame segments, and bytes of frame octets and escapes, per writev
+#define ORP_TX_SEGMENTS_MAX         64
+#define ORP_TX_SCRATCH_SIZE         1024
+
+// Max number of records in a batch, sent or received.  Batches are sent whole, so must also fit
+// in a packet
+#define ORP_CLIENT_BATCH_RECORDS_MAX    64
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Client of one link
+ *
+ * Holds the transport, codec, buffers and session state of the link, so that one process may
+ * drive any number of links.  Every orp_ function of the client takes it as a parameter.  It is
+ * large, so is best allocated statically or from the heap, rather than on the stack.  Buffers
+ * needed only by some links, or only at times, are allocated from the heap as they are needed
+ */
+//--------------------------------------------------------------------------------------------------
+struct orp_Client
+{
+    int                         fd;            ///< File descriptor on which to send and receive
+                                               ///< frames, passed in by caller
+    enum mode                   mode;          ///< Transmission mode
+    struct orp_ProtocolCodec    codec;         ///< ORP encoder/decoder of the link
+    hdlc_context_t              rxHdlcContext; ///< HDLC context of received frames
+    uint16_t                    rxSequenceNum; ///< Sequence number of the last packet received
+
+    /* Capabilities, exchanged in SYN and SYNACK.  Those last advertised by the peer, those
+     * offered by this client, and those in use: offered by both
+     */
+    unsigned int                peerCapabilities;
+    unsigned int                offeredCapabilities;
+    unsigned int                sessionCapabilities;
+
+    /* Whole seconds of the time of the last SYN, or if it had none of the SYNACK in reply, and
+     * the time base of the session: the same once ORP_CAPABILITY_TIME_DELTA is agreed
+     */
+    int64_t                     syncTime;
+    int64_t                     sessionTimeBase;
+
+    struct orp_PathDict         pathDict;      ///< Path identifiers of the link
+    struct orp_FileTransfer     file;          ///< Inbound file transfer of the link
+
+    struct orp_Uring           *uring;         ///< Ring used for I/O, or NULL for read/write
+    int                         uringBufIndex; ///< Registered slot of rxFrameBuf.  That of
+                                               ///< txFrameBuf follows
+
+    struct orp_RxRing          *rxRing;        ///< Ring filled by the receive thread, or NULL
+    pthread_t                   rxThread;      ///< Receive thread, while rxRing is set
+    int                         rxEventFd;     ///< Readable once the receive thread has pushed
+                                               ///< packets, or stopped
+    int                         rxStopFd;      ///< Tells the receive thread to stop
+
+    size_t                      rxFrameLen;    ///< Bytes held in rxFrameBuf
+    uint8_t                     rxFrameBuf[ORP_HDLC_FRAME_SIZE_MAX];
+    uint8_t                     txFrameBuf[ORP_HDLC_FRAME_SIZE_MAX];
+    uint8_t                    *txPacketBuf;   ///< AT mode only: ORP_PACKET_SIZE_MAX, packet
+                                               ///< before it is framed as text
+    uint8_t                     txHeaderBuf[ORP_PROTOCOL_LEN_NO_DATA_MAX];
+    uint8_t                     txScratchBuf[ORP_TX_SCRATCH_SIZE];
+    uint8_t                     txTrailerBuf[HDLC_OVERHEAD_BYTES_COUNT];
+    struct iovec                txFrameSegments[ORP_TX_SEGMENTS_MAX];
+    struct orp_Message         *txRecords;     ///< ORP_CLIENT_BATCH_RECORDS_MAX, allocated by
+                                               ///< the first batch sent
+    struct orp_Message         *rxRecords;     ///< ORP_CLIENT_BATCH_RECORDS_MAX, allocated by
+                                               ///< the first batch received
+};
+
+
 //--------------------------------------------------------------------------------------------------
 /**
- * Initialize internal data for the client
+ * Initialize a client
  *
+ * @param:  client:         Client to initialize.  Any previous state is discarded: a client
+ *                          initialized before must first be released with orp_ClientFini()
  * @param:  fileDescriptor: An open file descriptor for reading and writing framed ORP packets
+ * @param:  mode:           Transmission mode
+ * @param:  encoding:       Packet encoding used on the link.  Binary requires HDLC mode
  */
 //--------------------------------------------------------------------------------------------------
 bool orp_ClientInit
 (
-    int fileDescriptor
+    struct orp_Client *client,
+    int fileDescriptor,
+    enum mode mode,
+    enum orp_ProtocolEncoding encoding
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release a client: stop its receive thread, return it to plain read() and write(), and free the
+ * buffers it has allocated.  The file descriptor is left open
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_ClientFini
+(
+    struct orp_Client *client
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Use an io_uring for the I/O of a client: writes of whole frames from a registered buffer, and
+ * writes of file transfer data batched into one submission per chunk.  An orp_Reactor also reads
+ * into a registered buffer, batched with the reads of its other links
+ *
+ * @return: true on success.  Otherwise the client keeps to plain read() and write()
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ClientUringAttach
+(
+    struct orp_Client *client,
+    struct orp_Uring *ring
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Return a client to plain read() and write(), releasing its registered buffers
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_ClientUringDetach
+(
+    struct orp_Client *client
 );
 
 
@@ -69,12 +212,106 @@ bool orp_ClientInit
  * Receive and process incoming data on the registered file descriptor
  *
  * @note:  The client does not monitor the file descriptor for incoming data.  It is the
- *         responsibility of the layer above to call this function when data is available
+ *         responsibility of the layer above to call this function when data is available, or
+ *         to register the client with an orp_Reactor
+ *
+ * @return: LE_OK if data was read, and more may be waiting.  LE_WOULD_BLOCK once a non-blocking
+ *          file descriptor is drained, LE_CLOSED at end of file, or LE_FAULT on error
+ */
+//--------------------------------------------------------------------------------------------------
+int orp_ClientReceive
+(
+    struct orp_Client *client
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Process the result of a read into rxFrameBuf, after its first rxFrameLen bytes, made by the
+ * layer above rather than by orp_ClientReceive(), e.g. batched with the reads of other links
+ *
+ * @param:  result:         Bytes read, or -errno
+ *
+ * @return: as orp_ClientReceive()
+ */
+//--------------------------------------------------------------------------------------------------
+int orp_ClientReceiveComplete
+(
+    struct orp_Client *client,
+    ssize_t result
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Receive on a thread of the client's own, so that reading and deframing keep up with the link
+ * however long the layer above takes to handle packets
+ *
+ * The thread deframes packets into the ring.  The layer above waits for client->rxEventFd to
+ * become readable, then calls orp_ClientRxDrain() to decode and process them.  Packets
+ * arriving while the ring is full are dropped, and counted.  The client must not meanwhile be
+ * read by orp_ClientReceive() or an orp_Reactor.  HDLC mode only
+ *
+ * @param:  ring:           Ring to fill, allocated by the caller.  Must outlive the thread
+ *
+ * @return: true if the thread was started
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ClientRxThreadStart
+(
+    struct orp_Client *client,
+    struct orp_RxRing *ring
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop the receive thread, discarding any packets left in its ring
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_ClientRxThreadStop
+(
+    struct orp_Client *client
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode and process packets pushed by the receive thread, oldest first
+ *
+ * @param:  max:            Most packets to process, or 0 for all.  If any are left,
+ *                          client->rxEventFd stays readable
+ *
+ * @return: LE_OK, or LE_CLOSED once the receive thread has stopped at end of file or on error,
+ *          and the ring is empty
+ */
+//--------------------------------------------------------------------------------------------------
+int orp_ClientRxDrain
+(
+    struct orp_Client *client,
+    size_t max
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send messages queued by other threads, oldest first.  Only the thread owning the client may
+ * call this, or any other orp_ function sending on it
+ *
+ * The owner waits for queue->eventFd to become readable, then calls this to encode, frame and
+ * write what has been queued, assigning sequence numbers as it goes
+ *
+ * @param:  max:            Most messages to send, or 0 for all.  If any are left,
+ *                          queue->eventFd stays readable
+ *
+ * @return: LE_OK, or LE_FAULT if any message failed to send
  */
 //--------------------------------------------------------------------------------------------------
-void orp_ClientReceive
+int orp_ClientTxQueueSend
 (
-    void
+    struct orp_Client *client,
+    struct orp_TxQueue *queue,
+    size_t max
 );
 
 
@@ -85,6 +322,7 @@ void orp_ClientReceive
 //--------------------------------------------------------------------------------------------------
 int orp_CreateResource
 (
+    struct orp_Client *client,
     bool isInput,
     const char *path,
     enum orp_IoDataType dataType,
@@ -99,6 +337,7 @@ int orp_CreateResource
 //--------------------------------------------------------------------------------------------------
 int orp_DeleteResource
 (
+    struct orp_Client *client,
     const char *path
 );
 
@@ -110,6 +349,7 @@ int orp_DeleteResource
 //--------------------------------------------------------------------------------------------------
 int orp_AddPushHandler
 (
+    struct orp_Client *client,
     const char *path
 );
 
@@ -121,6 +361,7 @@ int orp_AddPushHandler
 //--------------------------------------------------------------------------------------------------
 int orp_RemovePushHandler
 (
+    struct orp_Client *client,
     const char *path
 );
 
@@ -132,6 +373,7 @@ int orp_RemovePushHandler
 //--------------------------------------------------------------------------------------------------
 int orp_Push
 (
+    struct orp_Client *client,
     const char *path,
     enum orp_IoDataType dataType,
     double timestamp,
@@ -139,6 +381,54 @@ int orp_Push
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push a string-encoded data sample, with a fixed-point timestamp
+ *
+ * @note:  Avoids the rounding of a floating point timestamp.  Pass ORP_TIME_SECONDS_INVALID
+ * as seconds to push without a timestamp
+ */
+//--------------------------------------------------------------------------------------------------
+int orp_PushTime
+(
+    struct orp_Client *client,
+    const char *path,
+    enum orp_IoDataType dataType,
+    int64_t seconds,
+    uint32_t microseconds,
+    const char *value
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Data sample, for a batch push
+ */
+//--------------------------------------------------------------------------------------------------
+struct orp_Sample
+{
+    const char     *path;           ///< Resource path
+    struct orp_Time time;           ///< Timestamp.  ORP_TIME_SECONDS_INVALID to push without one
+    const char     *value;          ///< String-encoded value, or NULL
+};
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push a batch of string-encoded data samples of one data type, in a single packet
+ *
+ * @note:  The batch is not split: it fails if the samples do not fit in one packet
+ */
+//--------------------------------------------------------------------------------------------------
+int orp_PushBatch
+(
+    struct orp_Client *client,
+    enum orp_IoDataType dataType,
+    const struct orp_Sample *samples,
+    size_t count
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Request a string-encoded data sample
@@ -146,10 +436,27 @@ int orp_Push
 //--------------------------------------------------------------------------------------------------
 int orp_Get
 (
+    struct orp_Client *client,
     const char *path
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Request string-encoded data samples from several resources, in a single packet
+ *
+ * @note:  The response carries one record per path, in order, each with its own status.  The
+ * request is not split: it fails if the paths do not fit in one packet
+ */
+//--------------------------------------------------------------------------------------------------
+int orp_GetBatch
+(
+    struct orp_Client *client,
+    const char *const *paths,
+    size_t count
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Set the example value for a JSON-type Input resource
@@ -157,6 +464,7 @@ int orp_Get
 //--------------------------------------------------------------------------------------------------
 int orp_SetJsonExample
 (
+    struct orp_Client *client,
     const char *path,
     const char *example
 );
@@ -169,6 +477,7 @@ int orp_SetJsonExample
 //--------------------------------------------------------------------------------------------------
 int orp_CreateSensor
 (
+    struct orp_Client *client,
     const char *path,
     enum orp_IoDataType dataType,
     const char *units
@@ -182,6 +491,7 @@ int orp_CreateSensor
 //--------------------------------------------------------------------------------------------------
 int orp_DestroySensor
 (
+    struct orp_Client *client,
     const char *path
 );
 
@@ -193,23 +503,37 @@ int orp_DestroySensor
 //--------------------------------------------------------------------------------------------------
 int orp_Respond
 (
+    struct orp_Client *client,
     enum orp_PacketType type,
     int status
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Capabilities supported by this client, see ORP_CAPABILITY_ in orpProtocol.h
+ */
+//--------------------------------------------------------------------------------------------------
+#define ORP_CLIENT_CAPABILITIES     (ORP_CAPABILITY_PATH_ID | ORP_CAPABILITY_TIME_DELTA)
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Send a sync packet
+ *
+ * @param:  capabilities:  Capabilities offered in a SYN or SYNACK, or -1 to offer those which
+ *                         the peer has advertised and this client supports
  */
 //--------------------------------------------------------------------------------------------------
 int orp_SyncSend
 (
+    struct orp_Client *client,
     enum orp_PacketType type,
     int version,
     int sentCount,
     int recvCount,
-    int mtu
+    int mtu,
+    int capabilities
 );
 
 
@@ -220,6 +544,7 @@ int orp_SyncSend
 //--------------------------------------------------------------------------------------------------
 int orp_FileTransferNotify
 (
+    struct orp_Client *client,
     unsigned int status,
     const char *controlData
 );
@@ -232,6 +557,7 @@ int orp_FileTransferNotify
 //--------------------------------------------------------------------------------------------------
 int orp_FileTransferData
 (
+    struct orp_Client *client,
     unsigned int status,
     const char *fileData
 );
@@ -35,6 +35,7 @@
 #define ORP_FILE_H_INCLUDE_GUARD
 
 #include "orpProtocol.h"
+#include "orpUring.h"
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -43,6 +44,31 @@
 //--------------------------------------------------------------------------------------------------
 #define FILE_NAME_MAX_LEN   128
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum data to be read
+ */
+//--------------------------------------------------------------------------------------------------
+#define ORP_FILE_DATA_MAX_LEN   (100 * 1024)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Inbound file transfer of one link.  Zero-initialized, no transfer is in progress
+ */
+//--------------------------------------------------------------------------------------------------
+struct orp_FileTransfer
+{
+    bool        autoMode;                           ///< Write data as received, and ack it
+    char        fileName[FILE_NAME_MAX_LEN];        ///< Local file name
+    uint8_t    *incomingData;                       ///< Data held until acked, unless auto mode.
+                                                    ///< ORP_FILE_DATA_MAX_LEN, allocated while
+                                                    ///< a transfer is in progress
+    size_t      incomingDataLen;                    ///< Length of incomingData
+    size_t      receivedBytes;                      ///< Total bytes received for the file
+    ssize_t     expectedBytes;                      ///< Total bytes expected, if > 0
+    struct orp_Uring *uring;                        ///< Ring to write data with, or NULL
+};
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Function to set the auto mode
@@ -50,7 +76,8 @@
 //--------------------------------------------------------------------------------------------------
 void orp_FileTransferSetAuto
 (
-    bool isAuto                 ///< [IN] Is auto mode set ?
+    struct orp_FileTransfer *file,  ///< [IN/OUT] File transfer of the link
+    bool isAuto                     ///< [IN] Is auto mode set ?
 );
 
 //--------------------------------------------------------------------------------------------------
@@ -60,7 +87,7 @@ void orp_FileTransferSetAuto
 //--------------------------------------------------------------------------------------------------
 bool orp_FileTransferGetAuto
 (
-    void
+    const struct orp_FileTransfer *file ///< [IN] File transfer of the link
 );
 
 //--------------------------------------------------------------------------------------------------
@@ -70,6 +97,7 @@ bool orp_FileTransferGetAuto
 //--------------------------------------------------------------------------------------------------
 void orp_FileDataSetup
 (
+    struct orp_FileTransfer *file,
     char   *namePtr,
     size_t  fileSize,
     bool    isAuto
@@ -82,19 +110,31 @@ void orp_FileDataSetup
 //--------------------------------------------------------------------------------------------------
 void orp_FileDataCache
 (
+    struct orp_FileTransfer *file,
     void   *dataPtr,
     size_t  dataLen
 );
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release the data held for an inbound file transfer, once it is complete or the link is closed
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_FileDataRelease
+(
+    struct orp_FileTransfer *file   ///< [IN/OUT] File transfer of the link
+);
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Flush saved data from RAM to the file
- * To be called when the user acks a file data packet.  Does nothing if auto mode is active
+ * To be called when the user acks a file data packet.  Does nothing if auto mode is active.
+ * Once every byte expected has been flushed, the held data is released
  */
 //--------------------------------------------------------------------------------------------------
 void orp_FileDataFlush
 (
-    void
+    struct orp_FileTransfer *file   ///< [IN/OUT] File transfer of the link
 );
 
 #endif // ORP_FILE_H_INCLUDE_GUARD
@@ -0,0 +1,147 @@
+/**
+ * @file:    orpPathDict.h
+ *
+ * Purpose:  Path dictionary: compact identifiers in place of resource paths
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Sierra Wireless Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *----------------------------------------------------------------------------
+ *
+ * NOTES:
+ *
+ * Used only while ORP_CAPABILITY_PATH_ID is agreed with the peer, see orpProtocol.h
+ *
+ */
+
+#ifndef ORP_PATH_DICT_H_INCLUDE_GUARD
+#define ORP_PATH_DICT_H_INCLUDE_GUARD
+
+#include "orpProtocol.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of paths held.  Identifiers are the table index, so must not exceed ORP_PATH_ID_MAX
+ */
+//--------------------------------------------------------------------------------------------------
+#define ORP_PATH_DICT_SIZE  64
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Requests of types carrying identifiers which may await responses at once, as many as the transmit
+ * queue holds.  Beyond that, the oldest is taken to have lost its response
+ */
+//--------------------------------------------------------------------------------------------------
+#define ORP_PATH_DICT_REQUESTS_MAX  256
+
+// Sets of identifiers, one bit each
+#if ORP_PATH_DICT_SIZE > 64
+#error "ORP_PATH_DICT_SIZE exceeds the bits of an identifier set"
+#endif
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Dictionary entry
+ */
+//--------------------------------------------------------------------------------------------------
+struct orp_PathDictEntry
+{
+    uint32_t    hash;                                   ///< Hash of path, to skip most compares
+    bool        used;                                   ///< Entry holds a path
+    bool        bound;                                  ///< Peer has accepted the binding
+    char        path[ORP_PROTOCOL_PATH_LEN_MAX + 1];    ///< Resource path
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Request sent with identifiers, awaiting its response
+ */
+//--------------------------------------------------------------------------------------------------
+struct orp_PathDictRequest
+{
+    enum orp_PacketType type;       ///< Request type
+    uint64_t            carried;    ///< Identifiers sent, one bit each
+    uint64_t            binding;    ///< ... of which those sent with their paths
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Dictionary of one link.  Zero-initialized, it holds no paths and identifiers are not in use
+ */
+//--------------------------------------------------------------------------------------------------
+struct orp_PathDict
+{
+    struct orp_PathDictEntry   entries[ORP_PATH_DICT_SIZE];
+    bool                       enabled;     ///< Session state: are identifiers in use ?
+
+    // Requests awaiting their responses, in the order sent, which is the order of responses
+    struct orp_PathDictRequest requests[ORP_PATH_DICT_REQUESTS_MAX];
+    unsigned int               requestFirst;    ///< Index of the oldest
+    unsigned int               requestCount;    ///< Number awaiting responses
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start a new session: forget which identifiers the peer has accepted
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_PathDictReset
+(
+    struct orp_PathDict *dict,  ///< [IN/OUT] Dictionary of the link
+    bool                 enable ///< [IN] Use path identifiers in this session ?
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Replace or bind the path of an outgoing message with its identifier, before encoding
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_PathDictOutbound
+(
+    struct orp_PathDict *dict,      ///< [IN/OUT] Dictionary of the link
+    struct orp_Message  *message    ///< [IN/OUT] Message to be sent
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Resolve the path identifier of an incoming message, and track the acceptance of bindings
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_PathDictInbound
+(
+    struct orp_PathDict *dict,      ///< [IN/OUT] Dictionary of the link
+    struct orp_Message  *message    ///< [IN/OUT] Decoded message
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Resolve the path identifiers of the records of an incoming message, once decoded
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_PathDictInboundRecords
+(
+    struct orp_PathDict *dict,      ///< [IN/OUT] Dictionary of the link
+    struct orp_Message  *records,   ///< [IN/OUT] Decoded records
+    size_t               count      ///< [IN] Number of records
+);
+
+#endif // ORP_PATH_DICT_H_INCLUDE_GUARD
@@ -40,6 +40,8 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
 
 
 /* The following defines are taken from the Datahub io.api file for the WP77 familly.  These
@@ -99,9 +101,20 @@
                                         + ORP_PROTOCOL_TIMESTAMP_DECIMAL_LEN_MAX \
                                         + 1 /* for decimal point */ )
 
+/* Path identifiers stand in for a resource path once bound, see ORP_CAPABILITY_PATH_ID.  When
+ * binding, both are sent: ,I<identifier> adds up to 6 to the path
+ */
+#define ORP_PATH_ID_NONE                (-1)
+#define ORP_PATH_ID_MAX                 9999
+#define ORP_PROTOCOL_PATH_ID_LEN_MAX    6
+
+// Maximum length of numeric data received in binary and decoded to text: "%.17g" of a double
+#define ORP_PROTOCOL_NUMERIC_LEN_MAX    24
+
 // Maximum size of a protocol packet, before accounting for data
 #define ORP_PROTOCOL_LEN_NO_DATA_MAX    (  ORP_PROTOCOL_OVERHEAD_LEN_MAX \
                                          + ORP_PROTOCOL_PATH_LEN_MAX \
+                                         + ORP_PROTOCOL_PATH_ID_LEN_MAX \
                                          + ORP_PROTOCOL_UNITS_LEN_MAX \
                                          + ORP_PROTOCOL_TIMESTAMP_LEN_MAX )
 
@@ -129,6 +142,37 @@ enum orp_ProtocolVersion
 };
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Packet encodings.  Both ends of a link must use the same one
+ *
+ * ASCII:   human-readable fields, separated by ','
+ * Binary:  tagged fields with varint lengths and integers, and IEEE-754 numeric data.  Sized for
+ *          slow serial links
+ */
+//--------------------------------------------------------------------------------------------------
+enum orp_ProtocolEncoding
+{
+    ORP_PROTOCOL_ENCODING_ASCII = 0,
+    ORP_PROTOCOL_ENCODING_BINARY,
+};
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Optional protocol features, advertised in the capabilities field of SYN and SYNACK.  A feature
+ * is used once both ends have advertised it, and is dropped by the next SYN
+ *
+ * PATH_ID:  a path identifier may replace the path.  An identifier is bound by any packet which
+ *           carries both, and is used alone once the peer has accepted a binding packet
+ * TIME_DELTA:  a timestamp may be sent as a delta from the session time base: the whole seconds
+ *           of the time of the SYN, or if it has none, of the SYNACK
+ */
+//--------------------------------------------------------------------------------------------------
+#define ORP_CAPABILITY_PATH_ID          (1u << 0)
+#define ORP_CAPABILITY_TIME_DELTA       (1u << 1)
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Packet types
@@ -185,6 +229,11 @@ enum orp_PacketType
     ORP_NTFY_FILE_CONTROL   = 17,
     ORP_RESP_FILE_CONTROL   = ORP_NTFY_FILE_CONTROL  | ORP_RESPONSE_MASK,
 
+    ORP_RQST_PUSH_BATCH     = 18,
+    ORP_RESP_PUSH_BATCH     = ORP_RQST_PUSH_BATCH    | ORP_RESPONSE_MASK,
+    ORP_RQST_GET_BATCH      = 19,
+    ORP_RESP_GET_BATCH      = ORP_RQST_GET_BATCH     | ORP_RESPONSE_MASK,
+
     ORP_RESP_UNKNOWN_RQST   = 128                    | ORP_RESPONSE_MASK,
 };
 
@@ -205,6 +254,25 @@ enum orp_IoDataType
 };
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fixed-point timestamp: whole seconds plus microseconds
+ *
+ * Covers the range which the protocol can carry: up to ORP_PROTOCOL_TIMESTAMP_INTEGER_LEN_MAX
+ * integer and ORP_PROTOCOL_TIMESTAMP_DECIMAL_LEN_MAX decimal digits, with no loss of precision
+ */
+//--------------------------------------------------------------------------------------------------
+struct orp_Time
+{
+    int64_t                     seconds;       ///< Whole seconds, or ORP_TIME_SECONDS_INVALID
+    uint32_t                    microseconds;  ///< Fraction of a second, 0 - 999999
+};
+
+#define  ORP_TIME_SECONDS_INVALID         ((int64_t)(-1))
+#define  ORP_TIME_SECONDS_MAX             ((int64_t)99999999999)
+#define  ORP_TIME_MICROSECONDS_PER_SECOND 1000000
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Message structure
@@ -218,20 +286,83 @@ struct orp_Message
     int                         version;       ///< Protocol version (sync packets only)
     int                         status;        ///< Status of a response or event
 
-    uint16_t                    sequenceNum;   ///< Number of this packet (16-bit rollover)
+    uint16_t                    sequenceNum;   ///< Number of this packet (16-bit rollover).
+                                               ///< See orp_PacketSequenceNext() to encode
     double                      timestamp;     ///< Timestamp read/write
+    struct orp_Time             time;          ///< Timestamp read/write, fixed-point.  Takes
+                                               ///< precedence over timestamp when encoding
+    bool                        timeDelta;     ///< Time is a delta from the session time base
     const char                 *path;          ///< Resource path
+    int                         pathId;        ///< Path identifier, or ORP_PATH_ID_NONE
     const char                 *unit;          ///< Resource units
     void                       *data;          ///< Data (binary permitted)
     size_t                      dataLen;       ///< Data length
     int                         sentCount;     ///< Sent packet count (sync packets only)
     int                         receivedCount; ///< Received packet count (sync packets only)
     int                         mtu;           ///< Maximum transfer unit (sync packets only)
+    unsigned int                capabilities;  ///< ORP_CAPABILITY_ flags (sync packets only)
+    struct orp_Message         *records;       ///< Records (batch packets only).  Each carries
+                                               ///< the fields of one sample.  Encode only
+    size_t                      recordCount;   ///< Number of records, to send or received
+    uint8_t                    *recordsBuf;    ///< Decoded only: the records as received, for
+                                               ///< the codec's decoderecords.  NULL if none
+    size_t                      recordsLen;    ///< Decoded only: length of recordsBuf
+    char                        numeric[ORP_PROTOCOL_NUMERIC_LEN_MAX + 1];
+                                               ///< Decoded only: numeric data received in
+                                               ///< binary, as text.  data points here
 };
 
 #define  ORP_TIMESTAMP_INVALID   ((double)(-1))
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Variable length field of a received packet, referenced in place.  Not null terminated
+ */
+//--------------------------------------------------------------------------------------------------
+struct orp_Field
+{
+    const uint8_t              *ptr;           ///< Field contents, after the ID byte, or NULL
+                                               ///< if the field is absent
+    size_t                      len;           ///< Field contents length
+};
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read-only view of a received packet
+ *
+ * The fixed length fields are decoded up front.  Variable length fields point into the packet
+ * buffer, which must outlive the view, and are only parsed by the orp_View accessors
+ */
+//--------------------------------------------------------------------------------------------------
+struct orp_MessageView
+{
+    enum orp_ProtocolEncoding   encoding;      ///< Encoding of the variable length fields
+    enum orp_PacketType         type;          ///< Type of ORP packet
+    enum orp_IoDataType         dataType;      ///< Data type of resource
+    int                         version;       ///< Protocol version (sync packets only)
+    int                         status;        ///< Status of a response or event
+    uint16_t                    sequenceNum;   ///< Number of this packet (16-bit rollover)
+
+    struct orp_Field            time;          ///< Timestamp, see orp_ViewTime()
+    bool                        timeDelta;     ///< Time is a delta from the session time base
+    struct orp_Field            path;          ///< Resource path
+    struct orp_Field            pathId;        ///< Path identifier, see orp_ViewInt()
+    struct orp_Field            unit;          ///< Resource units
+    struct orp_Field            data;          ///< Data (binary permitted)
+    struct orp_Field            numeric;       ///< Numeric data as IEEE-754, binary encoding
+                                               ///< only.  See orp_ViewNumeric()
+    struct orp_Field            sentCount;     ///< Sent packet count, see orp_ViewInt()
+    struct orp_Field            receivedCount; ///< Received packet count, see orp_ViewInt()
+    struct orp_Field            mtu;           ///< Maximum transfer unit, see orp_ViewInt()
+    struct orp_Field            capabilities;  ///< Capability flags, see orp_ViewInt()
+    struct orp_Field            records;       ///< Records, see orp_ViewRecordNext()
+    struct orp_Field            recordStatus;  ///< Status of a record, applied to status by
+                                               ///< orp_ViewRecordNext()
+};
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Packet decode function:  Packet -> Message structure
@@ -245,6 +376,39 @@ typedef bool (*orp_ProtocolDecode_t)
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Packet decode function:  Packet -> Message view
+ *
+ * Unlike the decode function, the packet buffer is neither modified nor read beyond
+ * packetLength, so it may be read-only or shared
+ */
+//--------------------------------------------------------------------------------------------------
+typedef bool (*orp_ProtocolDecodeView_t)
+(
+    const uint8_t *packetBuffer,       ///< IN : Unframed ORP packet
+    size_t   packetLength,             ///< IN : Unframed ORP packet length
+    struct orp_MessageView *view       ///< OUT: Message view, referencing packetBuffer
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Records decode function:  Decoded message -> Record message structures
+ *
+ * Each record takes the packet type, fixed length fields and sequence number of the message.  As
+ * with the decode function, fields are null-terminated in place, so the records of a message may
+ * only be decoded once
+ */
+//--------------------------------------------------------------------------------------------------
+typedef bool (*orp_ProtocolDecodeRecords_t)
+(
+    const struct orp_Message *message, ///< IN : Decoded message
+    struct orp_Message *records,       ///< OUT: Records
+    size_t  *recordCount               ///< IN/OUT: Max number of records / records decoded
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Message encode function:  Message structure -> Packet
@@ -258,6 +422,38 @@ typedef bool (*orp_ProtocolEncode_t)
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Message encode function:  Message structure -> Packet segments
+ *
+ * The protocol fields are encoded into the header buffer and the data, if any, is referenced
+ * in place rather than copied.  The segments, concatenated, form the same packet as the encode
+ * function would produce
+ */
+//--------------------------------------------------------------------------------------------------
+typedef bool (*orp_ProtocolEncodeV_t)
+(
+    uint8_t *headerBuffer,             ///< OUT: Protocol fields of the ORP packet
+    size_t   headerLength,             ///< IN : Header buffer size
+    struct iovec *segments,            ///< OUT: Packet segments
+    int     *segmentCount,             ///< IN/OUT: Max number of segments / segments used
+    struct orp_Message *response       ///< IN : Message structure
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encoded size function:  Message structure -> Packet length
+ *
+ * @return: encoded length, or 0 if the message cannot be encoded
+ */
+//--------------------------------------------------------------------------------------------------
+typedef size_t (*orp_ProtocolEncodedSize_t)
+(
+    const struct orp_Message *message  ///< IN : Message structure
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Structure to access protocol functions
@@ -265,15 +461,20 @@ typedef bool (*orp_ProtocolEncode_t)
 //--------------------------------------------------------------------------------------------------
 struct orp_ProtocolCodec
 {
-    enum orp_ProtocolVersion version;
-    orp_ProtocolDecode_t     decode;
-    orp_ProtocolEncode_t     encode;
+    enum orp_ProtocolVersion  version;
+    enum orp_ProtocolEncoding encoding;
+    orp_ProtocolDecode_t      decode;
+    orp_ProtocolDecodeView_t  decodeview;
+    orp_ProtocolDecodeRecords_t decoderecords;
+    orp_ProtocolEncode_t      encode;
+    orp_ProtocolEncodeV_t     encodev;
+    orp_ProtocolEncodedSize_t encodedsize;
 };
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Initialize protocol interface
+ * Initialize protocol interface, for the ASCII encoding
  */
 //--------------------------------------------------------------------------------------------------
 bool orp_ProtocolClientInit
@@ -283,6 +484,19 @@ bool orp_ProtocolClientInit
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize protocol interface, for a given encoding
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ProtocolCodecInit
+(
+    enum orp_ProtocolVersion   version,
+    enum orp_ProtocolEncoding  encoding,
+    struct orp_ProtocolCodec  *interface
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Initialize an outbound message
@@ -295,4 +509,151 @@ void orp_MessageInit
     unsigned int         status
 );
 
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sequence number of an outbound message, from that of the last packet received.  A response
+ * carries the number of the request it answers, and a SYN the same.  Any other packet takes the
+ * next number
+ */
+//--------------------------------------------------------------------------------------------------
+uint16_t orp_PacketSequenceNext
+(
+    enum orp_PacketType type,
+    uint16_t            received
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of bytes the message will occupy once encoded in ASCII, before any link layer framing
+ *
+ * @return: encoded length, or 0 if the message cannot be encoded
+ *
+ * @note:  Data is counted in full.  The encoder truncates data which does not fit its buffer
+ */
+//--------------------------------------------------------------------------------------------------
+size_t orp_EncodedSize
+(
+    const struct orp_Message *message
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Format a fixed-point timestamp as a protocol time string: <seconds>.<6 decimal digits>
+ *
+ * @return: string length, excluding the null terminator, or -1 if the time is invalid or the
+ *          buffer too small
+ */
+//--------------------------------------------------------------------------------------------------
+ssize_t orp_TimeFormat
+(
+    char                  *buf,
+    size_t                 bufLen,
+    const struct orp_Time *time
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse a protocol time string into a fixed-point timestamp
+ *
+ * Parsing stops at len characters or a null terminator, whichever comes first.  Only decimal
+ * digits with an optional decimal point are accepted, within the protocol's digit limits
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_TimeParse
+(
+    const char      *str,
+    size_t           len,
+    struct orp_Time *time
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Convert a timestamp in seconds to fixed-point, rounding to the nearest microsecond
+ *
+ * @return: false if the timestamp is negative or too large for the protocol
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_TimeFromDouble
+(
+    double           seconds,
+    struct orp_Time *time
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Convert a fixed-point timestamp to seconds
+ */
+//--------------------------------------------------------------------------------------------------
+double orp_TimeToDouble
+(
+    const struct orp_Time *time
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse the timestamp of a message view
+ *
+ * @return: false if the packet has no timestamp or it is malformed
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ViewTime
+(
+    const struct orp_MessageView *view,
+    struct orp_Time              *time
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse a non-negative integer field of a message view, e.g. view->mtu
+ *
+ * @return: false if the field is absent, malformed or exceeds INT_MAX
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ViewInt
+(
+    const struct orp_MessageView *view,
+    const struct orp_Field       *field,
+    int                          *value
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Locate the next record of a message view
+ *
+ * @param:  offset:  Position in view->records, 0 for the first record.  Advanced past the record
+ * @param:  record:  View of the record's fields.  Its fixed length fields are those of the view
+ *
+ * @return: false if there are no more records or the record is malformed
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ViewRecordNext
+(
+    const struct orp_MessageView *view,
+    size_t                       *offset,
+    struct orp_MessageView       *record
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse the data of a message view as a number, whether received as text or IEEE-754
+ *
+ * @return: false if the packet has no data or it is not a number
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ViewNumeric
+(
+    const struct orp_MessageView *view,
+    double                       *value
+);
+
 #endif // ORP_PROTOCOL_H_INCLUDE_GUARD
@@ -0,0 +1,231 @@
+/**
+ * @file:    orpReactor.h
+ *
+ * Purpose:  Event loop servicing many ORP links, timers and other file descriptors
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Sierra Wireless Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *----------------------------------------------------------------------------
+ *
+ * NOTES:
+ *
+ * Linux only: built on epoll, with a timerfd per timer.  Each wakeup costs in proportion to
+ * the sources ready, not to the number registered.
+ *
+ * Sources are allocated by the caller, and stay registered until removed.  A handler may add or
+ * remove any source, including its own.
+ *
+ * Given an io_uring, the reads of all links ready in a wakeup are submitted together, into
+ * registered buffers, rather than made one system call each.
+ *
+ */
+
+#ifndef ORP_REACTOR_H_INCLUDE_GUARD
+#define ORP_REACTOR_H_INCLUDE_GUARD
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include "orpClient.h"
+#include "orpUring.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Max number of ready sources handled per wakeup.  Any more are handled on the next
+ */
+//--------------------------------------------------------------------------------------------------
+#define ORP_REACTOR_EVENTS_MAX  64
+
+struct orp_ReactorSource;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handler of a source, called with the epoll events which are ready (EPOLLIN, EPOLLHUP, ...)
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*orp_ReactorHandler_t)
+(
+    struct orp_ReactorSource *source,   ///< [IN] Source ready
+    uint32_t                  events    ///< [IN] Ready events
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * A file descriptor, timer or link registered with a reactor
+ */
+//--------------------------------------------------------------------------------------------------
+struct orp_ReactorSource
+{
+    int                     fd;         ///< File descriptor watched
+    orp_ReactorHandler_t    handler;    ///< Called when ready
+    void                   *context;    ///< Caller's context, or the client of a link
+    bool                    isTimer;    ///< fd is a timerfd owned by the reactor
+    bool                    isLink;     ///< fd is the non-blocking fd of context's orp_Client
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reactor state
+ */
+//--------------------------------------------------------------------------------------------------
+struct orp_Reactor
+{
+    int                 epollFd;
+    bool                running;                        ///< Cleared by orp_ReactorStop()
+    unsigned int        sourceCount;                    ///< Sources registered
+    struct epoll_event  ready[ORP_REACTOR_EVENTS_MAX];  ///< Events of the current wakeup
+    int                 readyCount;                     ///< ... and their number
+
+    struct orp_Uring         *uring;                        ///< Ring to read links, or NULL
+    struct orp_ReactorSource *links[ORP_REACTOR_EVENTS_MAX];///< Links of the current wakeup, to
+    uint32_t                  linkEvents[ORP_REACTOR_EVENTS_MAX];   ///< read with the ring
+    int                       linkCount;
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize a reactor
+ *
+ * @return: true on success
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ReactorInit
+(
+    struct orp_Reactor *reactor     ///< [OUT] Reactor
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release a reactor.  Its sources must already be removed
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_ReactorFini
+(
+    struct orp_Reactor *reactor     ///< [IN/OUT] Reactor
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read links with an io_uring, which should hold at least ORP_REACTOR_EVENTS_MAX entries.  Links
+ * added from then on have their clients attached to it, see orp_ClientUringAttach()
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_ReactorUringSet
+(
+    struct orp_Reactor *reactor,    ///< [IN/OUT] Reactor
+    struct orp_Uring   *ring        ///< [IN] Initialized ring, or NULL to use read()
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Watch a file descriptor
+ *
+ * @note:  With EPOLLET, the handler is called only when more data arrives, so must read until
+ *         the file descriptor would block
+ *
+ * @return: true on success.  false with errno set on failure: EPERM, unreported, if epoll cannot
+ *          watch the file descriptor, e.g. a regular file or /dev/null
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ReactorAdd
+(
+    struct orp_Reactor       *reactor,  ///< [IN] Reactor
+    struct orp_ReactorSource *source,   ///< [OUT] Source, to stay valid until removed
+    int                       fd,       ///< [IN] File descriptor
+    uint32_t                  events,   ///< [IN] epoll events to watch, e.g. EPOLLIN
+    orp_ReactorHandler_t      handler,  ///< [IN] Handler
+    void                     *context   ///< [IN] Caller's context
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start a periodic timer
+ *
+ * @return: true on success
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ReactorTimerAdd
+(
+    struct orp_Reactor       *reactor,      ///< [IN] Reactor
+    struct orp_ReactorSource *source,       ///< [OUT] Source, to stay valid until removed
+    unsigned int              intervalMs,   ///< [IN] Interval between calls, in milliseconds
+    orp_ReactorHandler_t      handler,      ///< [IN] Handler
+    void                     *context       ///< [IN] Caller's context
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Service an ORP link: receive from its client whenever data arrives
+ *
+ * The file descriptor of the client is made non-blocking and read edge-triggered.  The handler
+ * is called only on hang up or error, or at end of file, and may then remove the link
+ *
+ * @return: true on success
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ReactorLinkAdd
+(
+    struct orp_Reactor       *reactor,  ///< [IN] Reactor
+    struct orp_ReactorSource *source,   ///< [OUT] Source, to stay valid until removed
+    struct orp_Client        *client,   ///< [IN] Initialized client of the link
+    orp_ReactorHandler_t      handler   ///< [IN] Hang up handler, or NULL
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop watching a source.  A timer is also closed, but the file descriptor of any other source
+ * is left to the caller
+ *
+ * @note:  Does nothing if the source is already removed, or failed to be added, as its fd is
+ *         then -1
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_ReactorRemove
+(
+    struct orp_Reactor       *reactor,  ///< [IN] Reactor
+    struct orp_ReactorSource *source    ///< [IN/OUT] Source
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for and handle events until orp_ReactorStop() is called, or no source remains
+ *
+ * @return: false on error
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ReactorRun
+(
+    struct orp_Reactor *reactor     ///< [IN/OUT] Reactor
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Return from orp_ReactorRun() once the current handler returns
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_ReactorStop
+(
+    struct orp_Reactor *reactor     ///< [IN/OUT] Reactor
+);
+
+#endif // ORP_REACTOR_H_INCLUDE_GUARD
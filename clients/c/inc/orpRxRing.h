@@ -0,0 +1,132 @@
+/**
+ * @file:    orpRxRing.h
+ *
+ * Purpose:  Lock-free single-producer, single-consumer ring of received packets
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Sierra Wireless Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *----------------------------------------------------------------------------
+ *
+ * NOTES:
+ *
+ * Packets are held whole and contiguous, each after a 4 byte length and followed by at least
+ * one spare byte, so the consumer decodes them in place.  A packet which does not fit before the
+ * end of the ring starts again at its beginning, after a wrap marker.
+ *
+ * One thread pushes, and one other peeks and releases.  Each owns one index, which the other
+ * only reads: with acquire ordering, matching the release ordering of its owner's writes.
+ *
+ */
+
+#ifndef ORP_RX_RING_H_INCLUDE_GUARD
+#define ORP_RX_RING_H_INCLUDE_GUARD
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Ring size, a power of 2.  Holds at least 8 records of the largest packet, ORP_PACKET_SIZE_MAX,
+ * each with its length and spare byte, even when up to a record less 4 bytes is skipped at the
+ * end of the ring before one of them: checked in orpClient.h
+ */
+//--------------------------------------------------------------------------------------------------
+#define ORP_RX_RING_SIZE        (1u << 19)
+
+// Indices are kept on cache lines of their own, so producer and consumer do not contend
+#define ORP_RX_RING_LINE_SIZE   64
+
+// Length of the length of each packet, and packet alignment
+#define ORP_RX_RING_HEADER_LEN  sizeof(uint32_t)
+
+// Bytes taken by a packet and its length.  A byte is spare after the packet, as the decoder
+// null-terminates its last field there
+#define ORP_RX_RING_RECORD_LEN(len) \
+    (ORP_RX_RING_HEADER_LEN + (((len) + ORP_RX_RING_HEADER_LEN) & ~(ORP_RX_RING_HEADER_LEN - 1)))
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Ring state.  Indices count bytes since initialization, and are reduced modulo the ring size
+ * only to address it
+ */
+//--------------------------------------------------------------------------------------------------
+struct orp_RxRing
+{
+    _Alignas(ORP_RX_RING_LINE_SIZE) atomic_size_t head;    ///< Written by the producer
+    _Alignas(ORP_RX_RING_LINE_SIZE) atomic_size_t tail;    ///< Written by the consumer
+    size_t                          peekLen;                ///< Consumer: bytes of packet peeked
+    _Alignas(ORP_RX_RING_LINE_SIZE) atomic_size_t dropped; ///< Packets refused for lack of room
+    atomic_bool                     closed;                 ///< Producer has stopped for good
+    _Alignas(ORP_RX_RING_LINE_SIZE) uint8_t data[ORP_RX_RING_SIZE];
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize a ring, empty.  Neither thread may be using it
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_RxRingInit
+(
+    struct orp_RxRing *ring     ///< [OUT] Ring
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Producer: copy in a packet
+ *
+ * @return: true on success.  false if there is no room, and the packet is counted as dropped
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_RxRingPush
+(
+    struct orp_RxRing *ring,    ///< [IN/OUT] Ring
+    const uint8_t     *packet,  ///< [IN] Packet
+    size_t             len      ///< [IN] Packet length
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Consumer: get the oldest packet, which stays in the ring until released
+ *
+ * @return: packet, which may be modified in place, or NULL if the ring is empty
+ */
+//--------------------------------------------------------------------------------------------------
+uint8_t *orp_RxRingPeek
+(
+    struct orp_RxRing *ring,    ///< [IN/OUT] Ring
+    size_t            *len      ///< [OUT] Packet length
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Consumer: release the packet last peeked, making room for the producer
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_RxRingRelease
+(
+    struct orp_RxRing *ring     ///< [IN/OUT] Ring
+);
+
+#endif // ORP_RX_RING_H_INCLUDE_GUARD
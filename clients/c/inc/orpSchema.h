@@ -0,0 +1,233 @@
+/**
+ * @file:    orpSchema.h
+ *
+ * Purpose:  Packet schema for the Octave Resource Protocol
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Sierra Wireless Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *----------------------------------------------------------------------------
+ *
+ * NOTES:
+ *
+ * This is the single description of the packet layouts.  Each list is an X-macro, expanded
+ * where needed into:
+ * - the wire identifiers and lookup tables of the codec (orpProtocol.c)
+ * - one encoder, and decoders of the header, fields and records, per packet type (orpProtocol.c)
+ * - the packet names of the message printer (orpUtils.c)
+ * - the Python client's protocol tables (tools/orpSchemaPy.c -> orp_schema.py)
+ *
+ * After editing, regenerate the Python tables with:  make python_schema
+ *
+ */
+
+#ifndef ORP_SCHEMA_H_INCLUDE_GUARD
+#define ORP_SCHEMA_H_INCLUDE_GUARD
+
+#include "orpProtocol.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Variable length fields:  X(name, id, description)
+ *
+ * Listed in the order in which they are encoded.  Data may contain the separator so must be the
+ * last field of any packet which carries it
+ */
+//--------------------------------------------------------------------------------------------------
+#define ORP_FIELD_SCHEMA(X)                                     \
+    X( TIME,         'T', "Timestamp"                         ) \
+    X( PATH,         'P', "Path"                              ) \
+    X( PATH_ID,      'I', "Path identifier"                   ) \
+    X( UNITS,        'U', "Units"                             ) \
+    X( DATA,         'D', "Data"                              ) \
+    X( MTU,          'M', "Maximum Transfer Unit"             ) \
+    X( SENT_COUNT,   'S', "Sent byte count"                   ) \
+    X( RECV_COUNT,   'R', "Received byte count"               ) \
+    X( CAPABILITIES, 'C', "Capabilities"                      ) \
+    X( RECORD,       'N', "Record"                            ) \
+    X( STATUS,       'E', "Status"                            )
+
+enum orp_FieldIndex
+{
+#define X(name, id, description)  ORP_FIELD_INDEX_##name,
+    ORP_FIELD_SCHEMA(X)
+#undef X
+    ORP_FIELD_COUNT
+};
+
+// Bitmask of the fields carried by a packet type
+#define ORP_FIELD(name)  (1u << ORP_FIELD_INDEX_##name)
+
+// A resource path, sent in full or as an identifier bound earlier in the session
+#define ORP_FIELD_PATHS  (ORP_FIELD(PATH) | ORP_FIELD(PATH_ID))
+
+/* Records: a packet type which carries records carries them as its only variable length fields.
+ * Each record holds the fields given, in the upper half of the packet type's field mask
+ */
+#define ORP_RECORD_SHIFT            16
+#define ORP_RECORDS(fields)         (ORP_FIELD(RECORD) | ((fields) << ORP_RECORD_SHIFT))
+#define ORP_RECORD_FIELDS(fields)   (((fields) >> ORP_RECORD_SHIFT) & 0xFFFFu)
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Resource data types:  X(name, encoded, decoded, keyword)
+ *
+ * keyword is the command line spelling of the type
+ */
+//--------------------------------------------------------------------------------------------------
+#define ORP_DATA_TYPE_SCHEMA(X)                                            \
+    X( TRIGGER, 'T', ORP_IO_DATA_TYPE_TRIGGER, "trig"                    ) \
+    X( BOOLEAN, 'B', ORP_IO_DATA_TYPE_BOOLEAN, "bool"                    ) \
+    X( NUMERIC, 'N', ORP_IO_DATA_TYPE_NUMERIC, "num"                     ) \
+    X( STRING,  'S', ORP_IO_DATA_TYPE_STRING,  "str"                     ) \
+    X( JSON,    'J', ORP_IO_DATA_TYPE_JSON,    "json"                    ) \
+    X( UNDEF,   ' ', ORP_IO_DATA_TYPE_UNDEF,   ""                        )
+
+
+/* Content of the second byte of a packet.  NONE marks packet types which are only ever sent by
+ * this client, so byte 1 is written as 0 and not accepted on receipt
+ */
+enum orp_Byte1Field
+{
+    ORP_BYTE1_NONE = 0,
+    ORP_BYTE1_UNUSED,
+    ORP_BYTE1_STATUS,
+    ORP_BYTE1_DATA_TYPE,
+    ORP_BYTE1_VERSION,
+    ORP_BYTE1_EVENT,
+};
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Packet types:  X(packet, encoded, decoded, byte1, fields, name)
+ *
+ *   packet:   wire identifier, as ORP_PKT_<packet>
+ *   encoded:  byte 0 on the wire
+ *   decoded:  enum orp_PacketType
+ *   byte1:    content of byte 1, as ORP_BYTE1_<byte1>
+ *   fields:   variable length fields carried, as a mask of ORP_FIELD(), or ORP_RECORDS()
+ *   name:     description, for printing
+ *
+ * Bytes 2 and 3 hold the sequence number for all packet types
+ */
+//--------------------------------------------------------------------------------------------------
+#define ORP_PACKET_SCHEMA(X)                                                                       \
+    X( RQST_INPUT_CREATE,   'I', ORP_RQST_INPUT_CREATE,   DATA_TYPE,                               \
+       ORP_FIELD_PATHS | ORP_FIELD(UNITS),                 "Request, input create"               ) \
+    X( RESP_INPUT_CREATE,   'i', ORP_RESP_INPUT_CREATE,   STATUS,    0,                            \
+                                                           "Response, input create"              ) \
+                                                                                                   \
+    X( RQST_OUTPUT_CREATE,  'O', ORP_RQST_OUTPUT_CREATE,  DATA_TYPE,                               \
+       ORP_FIELD_PATHS | ORP_FIELD(UNITS),                 "Request, output create"              ) \
+    X( RESP_OUTPUT_CREATE,  'o', ORP_RESP_OUTPUT_CREATE,  STATUS,    0,                            \
+                                                           "Response, output create"             ) \
+                                                                                                   \
+    X( RQST_DELETE,         'D', ORP_RQST_DELETE,         NONE,      ORP_FIELD_PATHS,              \
+                                                           "Request, delete"                     ) \
+    X( RESP_DELETE,         'd', ORP_RESP_DELETE,         STATUS,    0,                            \
+                                                           "Response, delete"                    ) \
+                                                                                                   \
+    X( RQST_HANDLER_ADD,    'H', ORP_RQST_HANDLER_ADD,    NONE,      ORP_FIELD_PATHS,              \
+                                                           "Request, handler add"                ) \
+    X( RESP_HANDLER_ADD,    'h', ORP_RESP_HANDLER_ADD,    STATUS,    0,                            \
+                                                           "Response, handler add"               ) \
+                                                                                                   \
+    X( RQST_HANDLER_REMOVE, 'K', ORP_RQST_HANDLER_REM,    NONE,      ORP_FIELD_PATHS,              \
+                                                           "Request, handler remove"             ) \
+    X( RESP_HANDLER_REMOVE, 'k', ORP_RESP_HANDLER_REM,    STATUS,    0,                            \
+                                                           "Response, handler remove"            ) \
+                                                                                                   \
+    X( RQST_PUSH,           'P', ORP_RQST_PUSH,           DATA_TYPE,                               \
+       ORP_FIELD(TIME) | ORP_FIELD_PATHS | ORP_FIELD(DATA), "Request, push"                      ) \
+    X( RESP_PUSH,           'p', ORP_RESP_PUSH,           STATUS,    0,                            \
+                                                           "Response, push"                      ) \
+                                                                                                   \
+    X( RQST_PUSH_BATCH,     'M', ORP_RQST_PUSH_BATCH,     DATA_TYPE,                               \
+       ORP_RECORDS(ORP_FIELD(TIME) | ORP_FIELD_PATHS | ORP_FIELD(DATA)),                           \
+                                                           "Request, push batch"                 ) \
+    X( RESP_PUSH_BATCH,     'm', ORP_RESP_PUSH_BATCH,     STATUS,    0,                            \
+                                                           "Response, push batch"                ) \
+                                                                                                   \
+    X( RQST_GET,            'G', ORP_RQST_GET,            NONE,      ORP_FIELD_PATHS,              \
+                                                           "Request, get"                        ) \
+    X( RESP_GET,            'g', ORP_RESP_GET,            STATUS,                                  \
+       ORP_FIELD(TIME) | ORP_FIELD(DATA),                  "Response, get"                       ) \
+    X( RQST_GET_BATCH,      'Q', ORP_RQST_GET_BATCH,      NONE,      ORP_RECORDS(ORP_FIELD_PATHS), \
+                                                           "Request, get batch"                  ) \
+    X( RESP_GET_BATCH,      'q', ORP_RESP_GET_BATCH,      STATUS,                                  \
+       ORP_RECORDS(ORP_FIELD(STATUS) | ORP_FIELD(TIME) | ORP_FIELD_PATHS | ORP_FIELD(DATA)),       \
+                                                           "Response, get batch"                 ) \
+                                                                                                   \
+    X( RQST_EXAMPLE_SET,    'E', ORP_RQST_EXAMPLE_SET,    DATA_TYPE,                               \
+       ORP_FIELD_PATHS | ORP_FIELD(DATA),                  "Request, set example"                ) \
+    X( RESP_EXAMPLE_SET,    'e', ORP_RESP_EXAMPLE_SET,    STATUS,    0,                            \
+                                                           "Response, set example"               ) \
+                                                                                                   \
+    X( RQST_SENSOR_CREATE,  'S', ORP_RQST_SENSOR_CREATE,  DATA_TYPE,                               \
+       ORP_FIELD_PATHS | ORP_FIELD(UNITS),                 "Request, sensor create"              ) \
+    X( RESP_SENSOR_CREATE,  's', ORP_RESP_SENSOR_CREATE,  STATUS,    0,                            \
+                                                           "Response, sensor create"             ) \
+                                                                                                   \
+    X( RQST_SENSOR_REMOVE,  'R', ORP_RQST_SENSOR_REMOVE,  NONE,      ORP_FIELD_PATHS,              \
+                                                           "Request, sensor remove"              ) \
+    X( RESP_SENSOR_REMOVE,  'r', ORP_RESP_SENSOR_REMOVE,  STATUS,    0,                            \
+                                                           "Response, sensor remove"             ) \
+                                                                                                   \
+    X( NTFY_HANDLER_CALL,   'c', ORP_NTFY_HANDLER_CALL,   UNUSED,                                  \
+       ORP_FIELD(TIME) | ORP_FIELD_PATHS | ORP_FIELD(DATA), "Notification, handler called"       ) \
+    X( RESP_HANDLER_CALL,   'C', ORP_RESP_HANDLER_CALL,   STATUS,    0,                            \
+                                                           "Response, handler called"            ) \
+                                                                                                   \
+    X( NTFY_SENSOR_CALL,    'b', ORP_NTFY_SENSOR_CALL,    UNUSED,    ORP_FIELD_PATHS,              \
+                                                           "Notification, sensor call"           ) \
+    X( RESP_SENSOR_CALL,    'B', ORP_RESP_SENSOR_CALL,    STATUS,    0,                            \
+                                                           "Response, sensor call"               ) \
+                                                                                                   \
+    /* Version 2 */                                                                                \
+    X( SYNC_SYN,            'Y', ORP_SYNC_SYN,            VERSION,                                 \
+       ORP_FIELD(TIME) | ORP_FIELD(MTU) | ORP_FIELD(SENT_COUNT) | ORP_FIELD(RECV_COUNT)            \
+       | ORP_FIELD(CAPABILITIES),                                                                  \
+                                                           "Synchronization, sync"               ) \
+    X( SYNC_SYNACK,         'y', ORP_SYNC_SYNACK,         VERSION,                                 \
+       ORP_FIELD(TIME) | ORP_FIELD(MTU) | ORP_FIELD(SENT_COUNT) | ORP_FIELD(RECV_COUNT)            \
+       | ORP_FIELD(CAPABILITIES),                                                                  \
+                                                           "Synchronization, sync-ack"           ) \
+    X( SYNC_ACK,            'z', ORP_SYNC_ACK,            VERSION,   0,                            \
+                                                           "Synchronization, ack"                ) \
+                                                                                                   \
+    X( RQST_FILE_DATA,      'T', ORP_RQST_FILE_DATA,      UNUSED,    ORP_FIELD(DATA),              \
+                                                           "Request, File transfer data"         ) \
+    X( RESP_FILE_DATA,      't', ORP_RESP_FILE_DATA,      STATUS,    0,                            \
+                                                           "Response, File transfer data"        ) \
+                                                                                                   \
+    X( NTFY_FILE_CONTROL,   'L', ORP_NTFY_FILE_CONTROL,   EVENT,     ORP_FIELD(DATA),              \
+                                                           "Notification, File transfer control" ) \
+    X( RESP_FILE_CONTROL,   'l', ORP_RESP_FILE_CONTROL,   STATUS,    0,                            \
+                                                           "Response, File transfer control"     ) \
+                                                                                                   \
+    X( RESP_UNKNOWN_RQST,   '?', ORP_RESP_UNKNOWN_RQST,   NONE,      0,                            \
+                                                           "Response, unknown request"           )
+
+#endif // ORP_SCHEMA_H_INCLUDE_GUARD
@@ -0,0 +1,166 @@
+/**
+ * @file:    orpTxQueue.h
+ *
+ * Purpose:  Lock-free multi-producer, single-consumer queue of messages to send
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Sierra Wireless Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *----------------------------------------------------------------------------
+ *
+ * NOTES:
+ *
+ * Any number of threads may queue messages, each copied whole into a slot of the queue, paths
+ * and data included.  One thread, which owns the client, sends them in the order the slots
+ * were claimed: encoding and framing each in the client's buffers, and assigning its sequence
+ * number.
+ *
+ * Each slot carries a sequence, telling whether it is free to claim for a given lap of the
+ * queue, or holds a message ready to send.  Producers claim slots by advancing a shared index
+ * with compare-and-swap, and publish them by setting the sequence with release ordering.
+ *
+ */
+
+#ifndef ORP_TX_QUEUE_H_INCLUDE_GUARD
+#define ORP_TX_QUEUE_H_INCLUDE_GUARD
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "orpProtocol.h"
+#include "legato.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Slots in the queue, a power of 2, and the most bytes of path, units and data a message may
+ * carry.  Larger messages are sent directly, by the thread owning the client
+ */
+//--------------------------------------------------------------------------------------------------
+#define ORP_TX_QUEUE_SLOTS          256
+#define ORP_TX_QUEUE_DATA_MAX       1024
+
+// Shared indices are kept on cache lines of their own
+#define ORP_TX_QUEUE_LINE_SIZE      64
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * A queued message, and the storage its fields point into
+ */
+//--------------------------------------------------------------------------------------------------
+struct orp_TxQueueSlot
+{
+    atomic_size_t               sequence;       ///< Position which may claim the slot, or that
+                                                ///< plus 1 once its message is ready
+    struct orp_Message          message;
+    uint8_t                     storage[ORP_TX_QUEUE_DATA_MAX];
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queue state.  Positions count messages since initialization
+ */
+//--------------------------------------------------------------------------------------------------
+struct orp_TxQueue
+{
+    _Alignas(ORP_TX_QUEUE_LINE_SIZE) atomic_size_t enqueuePos; ///< Next position to claim
+    _Alignas(ORP_TX_QUEUE_LINE_SIZE) size_t dequeuePos;        ///< Consumer: next to send
+    int                             eventFd;    ///< Readable once messages have been queued
+    struct orp_TxQueueSlot          slots[ORP_TX_QUEUE_SLOTS];
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize a queue, empty.  No thread may be using it
+ *
+ * @return: true on success
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_TxQueueInit
+(
+    struct orp_TxQueue *queue   ///< [OUT] Queue
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release a queue.  Messages still queued are discarded
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_TxQueueFini
+(
+    struct orp_TxQueue *queue   ///< [IN/OUT] Queue
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Producer: queue a copy of a message.  Its sequence number is assigned when it is sent
+ *
+ * @return: LE_OK, LE_NO_MEMORY if the queue is full, LE_OVERFLOW if the message carries more
+ *          than ORP_TX_QUEUE_DATA_MAX bytes, or LE_BAD_PARAMETER if it has records
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t orp_TxQueueMessage
+(
+    struct orp_TxQueue       *queue,    ///< [IN/OUT] Queue
+    const struct orp_Message *message   ///< [IN] Message, initialized by orp_MessageInit()
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Producer: queue a push of a string-encoded data sample, as orp_PushTime()
+ *
+ * @return: as orp_TxQueueMessage()
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t orp_TxQueuePush
+(
+    struct orp_TxQueue  *queue,         ///< [IN/OUT] Queue
+    const char          *path,          ///< [IN] Resource path
+    enum orp_IoDataType  dataType,      ///< [IN] Data type
+    int64_t              seconds,       ///< [IN] Timestamp, or ORP_TIME_SECONDS_INVALID
+    uint32_t             microseconds,  ///< [IN] Timestamp fraction
+    const char          *value          ///< [IN] Value, or NULL
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Consumer: get the oldest queued message, which stays queued until released
+ *
+ * @return: message, or NULL if none is ready
+ */
+//--------------------------------------------------------------------------------------------------
+struct orp_Message *orp_TxQueuePeek
+(
+    struct orp_TxQueue *queue   ///< [IN/OUT] Queue
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Consumer: release the message last peeked, freeing its slot for producers
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_TxQueueRelease
+(
+    struct orp_TxQueue *queue   ///< [IN/OUT] Queue
+);
+
+#endif // ORP_TX_QUEUE_H_INCLUDE_GUARD
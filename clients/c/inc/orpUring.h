@@ -0,0 +1,179 @@
+/**
+ * @file:    orpUring.h
+ *
+ * Purpose:  Minimal io_uring interface, to batch the system calls of links and file transfers
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Sierra Wireless Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *----------------------------------------------------------------------------
+ *
+ * NOTES:
+ *
+ * Built only with ORP_IO_URING defined (make IO_URING=1), and needs Linux 5.19 or later for
+ * sparse buffer and file tables.  Otherwise orp_UringInit() fails, and its users keep to plain
+ * read() and write().
+ *
+ * Requests are synchronous: prepared, then submitted together with orp_UringSubmitWait(),
+ * which returns once all have completed.  A ring serves one thread.
+ *
+ */
+
+#ifndef ORP_URING_H_INCLUDE_GUARD
+#define ORP_URING_H_INCLUDE_GUARD
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/uio.h>
+#ifdef ORP_IO_URING
+#include <linux/io_uring.h>
+#endif
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Slots of the registered buffer table, and of the registered file table
+ */
+//--------------------------------------------------------------------------------------------------
+#define ORP_URING_BUFFERS_MAX   512
+#define ORP_URING_FILES_MAX     1
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Ring state
+ */
+//--------------------------------------------------------------------------------------------------
+struct orp_Uring
+{
+    int                     fd;             ///< Ring file descriptor, -1 if not initialized
+#ifdef ORP_IO_URING
+    unsigned int           *sqHead;
+    unsigned int           *sqTail;
+    unsigned int           *sqMask;
+    unsigned int           *sqArray;
+    struct io_uring_sqe    *sqes;
+    unsigned int            sqEntries;
+    unsigned int            sqPending;      ///< Prepared and not yet submitted
+    unsigned int           *cqHead;
+    unsigned int           *cqTail;
+    unsigned int           *cqMask;
+    struct io_uring_cqe    *cqes;
+    void                   *sqRing;         ///< Mappings, and their sizes
+    size_t                  sqRingSize;
+    void                   *cqRing;
+    size_t                  cqRingSize;
+    size_t                  sqesSize;
+    bool                    bufferUsed[ORP_URING_BUFFERS_MAX];
+#endif
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set up a ring
+ *
+ * @return: true on success.  false if io_uring is not built in, or not supported by the kernel
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_UringInit
+(
+    struct orp_Uring *ring,     ///< [OUT] Ring
+    unsigned int      entries   ///< [IN] Max requests submitted at once
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release a ring
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_UringFini
+(
+    struct orp_Uring *ring      ///< [IN/OUT] Ring
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Register buffers, in consecutive slots of the buffer table
+ *
+ * @return: slot of the first buffer, or -1 if there is no room
+ */
+//--------------------------------------------------------------------------------------------------
+int orp_UringBuffersAdd
+(
+    struct orp_Uring   *ring,       ///< [IN/OUT] Ring
+    const struct iovec *buffers,    ///< [IN] Buffers
+    unsigned int        count       ///< [IN] Number of buffers
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Unregister buffers added by orp_UringBuffersAdd()
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_UringBuffersRemove
+(
+    struct orp_Uring *ring,     ///< [IN/OUT] Ring
+    int               index,    ///< [IN] Slot of the first buffer
+    unsigned int      count     ///< [IN] Number of buffers
+);
+
+#ifdef ORP_IO_URING
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a cleared submission queue entry to prepare
+ *
+ * @return: entry, or NULL if as many are already prepared as the ring holds
+ */
+//--------------------------------------------------------------------------------------------------
+struct io_uring_sqe *orp_UringSqeGet
+(
+    struct orp_Uring *ring      ///< [IN/OUT] Ring
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Discard the entries prepared and not yet submitted, e.g. when a later orp_UringSqeGet() fails
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_UringDiscard
+(
+    struct orp_Uring *ring      ///< [IN/OUT] Ring
+);
+#endif
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Submit the entries prepared, and wait for all to complete
+ *
+ * Each entry's user_data must be its index, below count, in results
+ *
+ * @return: true if all were submitted and completed.  Each result is then that of the system
+ *          call, or -errno
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_UringSubmitWait
+(
+    struct orp_Uring *ring,     ///< [IN/OUT] Ring
+    int32_t          *results,  ///< [OUT] Result of each entry
+    unsigned int      count     ///< [IN] Number of entries prepared
+);
+
+#endif // ORP_URING_H_INCLUDE_GUARD
@@ -67,8 +67,8 @@ ssize_t at_Pack
         return dst_idx;
     }
 
-    // AT command prefix
-    strncpy(dest, at_prefix, destlen);
+    // AT command prefix.  No padding: the caller gets the frame length
+    memcpy(dest, at_prefix, strlen(at_prefix));
     dst_idx = strlen(at_prefix);
     
     // ORP packet type
@@ -97,7 +97,12 @@ ssize_t at_Pack
     }
 
     // AT command suffix
-    strncpy(dest + dst_idx, at_suffix, destlen - dst_idx);
+    if (destlen - dst_idx < strlen(at_suffix))
+    {
+        LE_ERROR("Dest buffer too small");
+        return -1;
+    }
+    memcpy(dest + dst_idx, at_suffix, strlen(at_suffix));
     dst_idx += strlen(at_suffix);
     
     return dst_idx;
@@ -55,10 +55,11 @@ const char helpStr[] =
 \tdelete resource|handler|sensor <path>\n\
 \tadd handler <path>\n\
 \tpush trig|bool|num|str|json <path> <timestamp> [<data>] (note: if <timestamp> = 0, current timestamp is used)\n\
-\tget <path>\n\
+\tbatch trig|bool|num|str|json <path> <timestamp> <data> [<path> <timestamp> <data> ...]\n\
+\tget <path> [<path> ...]\n\
 \texample json <path> [<data>]\n\
 \treply handler|sensor|control|data <status>\n\
-\tsync syn|synack|ack [-v] [-s] [-r] [-m]\n\
+\tsync syn|synack|ack [-v] [-s] [-r] [-m] [-c]\n\
 \tfile control info|ready|pending|suspend|resume|abort [<private data>]\n\
 \tfile control start <remote file> [-a <remote file size>] [-f <local file>]\n\
 \tfile data [<data>]\n\
@@ -77,6 +78,7 @@ enum commandTypeE {
     ORPCLI_CMD_DELETE,
     ORPCLI_CMD_ADD,
     ORPCLI_CMD_PUSH,
+    ORPCLI_CMD_BATCH,
     ORPCLI_CMD_GET,
     ORPCLI_CMD_EXAMPLE,
     ORPCLI_CMD_FILE,
@@ -105,6 +107,8 @@ static enum commandTypeE commandExtract(char **line)
         return ORPCLI_CMD_ADD;
     if (!strncasecmp(cmdStr, "push", cmdLen))
         return ORPCLI_CMD_PUSH;
+    if (!strncasecmp(cmdStr, "batch", cmdLen))
+        return ORPCLI_CMD_BATCH;
     if (!strncasecmp(cmdStr, "get", cmdLen))
         return ORPCLI_CMD_GET;
     if (!strncasecmp(cmdStr, "example", cmdLen))
@@ -198,7 +202,7 @@ static enum orp_IoDataType dataTypeRead(char *dtypeStr)
 /* Create a resource:
  * > create input|output|sensor  trig|bool|num|str|json <path> [<units>]
  */
-static void commandCreate(char *args)
+static void commandCreate(struct orp_Client *client, char *args)
 {
     char *argv[6];
     int argc = 0;
@@ -223,9 +227,9 @@ static void commandCreate(char *args)
     // input | output | sensor
     switch (tolower(argv[0][0]))
     {
-        case 'i': (void)orp_CreateResource(true, path, dataType, units); break;
-        case 'o': (void)orp_CreateResource(false, path, dataType, units); break;
-        case 's': (void)orp_CreateSensor(path, dataType, units); break;
+        case 'i': (void)orp_CreateResource(client, true, path, dataType, units); break;
+        case 'o': (void)orp_CreateResource(client, false, path, dataType, units); break;
+        case 's': (void)orp_CreateSensor(client, path, dataType, units); break;
         default: printf("Invalid resource type %s\n", argv[0]); break;
     }
 }
@@ -233,7 +237,7 @@ static void commandCreate(char *args)
 /* Delete resource || sensor || handler:
  * > delete resource|handler|sensor <path>'
  */
-static void commandDelete(char *args)
+static void commandDelete(struct orp_Client *client, char *args)
 {
     char *argv[6];
     int argc = 0;
@@ -251,9 +255,9 @@ static void commandDelete(char *args)
     // resource | handler | sensor
     switch (tolower(argv[0][0]))
     {
-        case 'r': (void)orp_DeleteResource(path); break;
-        case 'h': (void)orp_RemovePushHandler(path); break;
-        case 's': (void)orp_DestroySensor(path); break;
+        case 'r': (void)orp_DeleteResource(client, path); break;
+        case 'h': (void)orp_RemovePushHandler(client, path); break;
+        case 's': (void)orp_DestroySensor(client, path); break;
         default: printf("Unrecognized type: %s\n", argv[0]); break;
     }
 }
@@ -261,7 +265,7 @@ static void commandDelete(char *args)
 /* Add a push handler on a resource
  * > add handler <path>
  */
-static void commandAdd(char *args)
+static void commandAdd(struct orp_Client *client, char *args)
 {
     char *argv[6];
     int argc = 0;
@@ -281,13 +285,13 @@ static void commandAdd(char *args)
         printf("Unrecognized type: %s\n", argv[0]);
         return;
     }
-    (void)orp_AddPushHandler(path);
+    (void)orp_AddPushHandler(client, path);
 }
 
 /* Push value to a resource
  * > push trig|bool|num|str|json <path> <timestamp> [<data>] (note: if <timestamp> = 0, current timestamp will be used)
  */
-static void commandPush(char *args)
+static void commandPush(struct orp_Client *client, char *args)
 {
     char *argv[6];
     int argc = 0;
@@ -319,40 +323,95 @@ static void commandPush(char *args)
     {
         return;
     }
-    double timestamp = 0.0;
-    if (1 != sscanf(argv[2], "%lf", &timestamp))
+    struct orp_Time timestamp;
+    if (!orp_TimeParse(argv[2], strlen(argv[2]), &timestamp))
     {
         printf("Invalid timestamp %s\n", argv[2]);
         return;
     }
-    (void)orp_Push(path, dataType, timestamp, data);
+    (void)orp_PushTime(client, path, dataType, timestamp.seconds, timestamp.microseconds, data);
 }
 
-/* Get the value from a resource
- * > get <path>
+/* Push values to several resources in one packet.  Data may not contain spaces
+ * > batch trig|bool|num|str|json <path> <timestamp> <data> [<path> <timestamp> <data> ...]
  */
-static void commandGet(char *args)
+#define BATCH_SAMPLES_MAX   16
+static void commandBatch(struct orp_Client *client, char *args)
 {
-    char *argv[6];
+    char *argv[1 + (3 * BATCH_SAMPLES_MAX)];
+    struct orp_Sample samples[BATCH_SAMPLES_MAX];
     int argc = 0;
 
-    argc = string2Args(args, argv, 6);
-    if (!checkArgCount(argc, 1, 1))
+    argc = string2Args(args, argv, 1 + (3 * BATCH_SAMPLES_MAX));
+    if (!checkArgCount(argc, 4, 1 + (3 * BATCH_SAMPLES_MAX)))
     {
         return;
     }
-    char *path = argv[0];
-    if (!checkPath(path))
+    if ((argc - 1) % 3)
+    {
+        printf("Each sample needs a path, timestamp and data\n");
+        return;
+    }
+
+    enum orp_IoDataType dataType = dataTypeRead(argv[0]);
+    if (ORP_IO_DATA_TYPE_UNDEF == dataType)
+    {
+        return;
+    }
+    int count = (argc - 1) / 3;
+    for (int i = 0; i < count; i++)
+    {
+        char **sample = &argv[1 + (3 * i)];
+
+        if (!checkPath(sample[0]))
+        {
+            return;
+        }
+        if (!orp_TimeParse(sample[1], strlen(sample[1]), &samples[i].time))
+        {
+            printf("Invalid timestamp %s\n", sample[1]);
+            return;
+        }
+        samples[i].path = sample[0];
+        samples[i].value = sample[2];
+    }
+    (void)orp_PushBatch(client, dataType, samples, count);
+}
+
+/* Get the value from a resource, or from several in one packet
+ * > get <path> [<path> ...]
+ */
+static void commandGet(struct orp_Client *client, char *args)
+{
+    char *argv[BATCH_SAMPLES_MAX];
+    int argc = 0;
+
+    argc = string2Args(args, argv, BATCH_SAMPLES_MAX);
+    if (!checkArgCount(argc, 1, BATCH_SAMPLES_MAX))
     {
         return;
     }
-    (void)orp_Get(path);
+    for (int i = 0; i < argc; i++)
+    {
+        if (!checkPath(argv[i]))
+        {
+            return;
+        }
+    }
+    if (1 == argc)
+    {
+        (void)orp_Get(client, argv[0]);
+    }
+    else
+    {
+        (void)orp_GetBatch(client, (const char *const *)argv, argc);
+    }
 }
 
 /* Set JSON example
  * > example json <path> [<data>]
  */
-static void commandExample(char *args)
+static void commandExample(struct orp_Client *client, char *args)
 {
     char *argv[6];
     int argc = 0;
@@ -373,13 +432,13 @@ static void commandExample(char *args)
         return;
     }
     char *data = argv[2];
-    (void)orp_SetJsonExample(path, data);
+    (void)orp_SetJsonExample(client, path, data);
 }
 
 /* Respond to a notification or unsolicited packet
  * > reply handler|sensor|control|data <status>
  */
-static void commandRespond(char *args)
+static void commandRespond(struct orp_Client *client, char *args)
 {
     char *argv[6];
     int argc = 0;
@@ -419,7 +478,7 @@ static void commandRespond(char *args)
         printf("Unknown response type %s\n", argv[0]);
         return;
     }
-    (void)orp_Respond(responseType, status);
+    (void)orp_Respond(client, responseType, status);
 }
 
 /* Send file control or data packet
@@ -430,7 +489,7 @@ static void commandRespond(char *args)
  * Data:
  * > file data <data>
  */
-static void commandFileTransfer(char *args)
+static void commandFileTransfer(struct orp_Client *client, char *args)
 {
     char *argv[8];
     int argc;
@@ -543,13 +602,13 @@ static void commandFileTransfer(char *args)
             {
                 snprintf(filename, FILE_NAME_MAX_LEN, "%s", data);
             }
-            orp_FileDataSetup(filename, fileSize, autoAck);
+            orp_FileDataSetup(&client->file, filename, fileSize, autoAck);
         }
-        (void)orp_FileTransferNotify(event, data);
+        (void)orp_FileTransferNotify(client, event, data);
     }
     else if ('d' == tolower(argv[0][0]))
     {
-        (void)orp_FileTransferData(0, data);
+        (void)orp_FileTransferData(client, 0, data);
     }
     else
     {
@@ -559,20 +618,22 @@ static void commandFileTransfer(char *args)
 
 /* Send one of the SYNC type packets
  * > sync syn|synack [-v <version>] [-s <sent count>] [-r <received count>] [-m <mtu>]
+ *                   [-c <capabilities>]
  * > sync ack
  */
-static void commandSync(char *args)
+static void commandSync(struct orp_Client *client, char *args)
 {
-    char *argv[8];
+    char *argv[10];
     int argc = 0;
 
     int version   =  0;
     int sentCount = -1;  // -1 will not be encoded
     int recvCount = -1;
     int mtu       = -1;
+    int capabilities = -1;  // -1 offers those advertised by the peer
 
-    argc = string2Args(args, argv, 8);
-    if (!checkArgCount(argc, 1, 8))
+    argc = string2Args(args, argv, 10);
+    if (!checkArgCount(argc, 1, 10))
     {
         return;
     }
@@ -600,7 +661,7 @@ static void commandSync(char *args)
     optind = 1;
     opterr = 0;
     int c;
-    while ((c = getopt(argc, argv, "v:s:r:m:")) != -1)
+    while ((c = getopt(argc, argv, "v:s:r:m:c:")) != -1)
     {
         switch (c)
         {
@@ -608,10 +669,11 @@ static void commandSync(char *args)
             case 's': sentCount = (int)strtoul(optarg, NULL, 0); break;
             case 'r': recvCount = (int)strtoul(optarg, NULL, 0); break;
             case 'm': mtu = (int)strtoul(optarg, NULL, 0);       break;
+            case 'c': capabilities = (int)strtoul(optarg, NULL, 0); break;
 
             case '?':
             {
-                if (strchr("vsrm", optopt))
+                if (strchr("vsrmc", optopt))
                 {
                     printf("Option %c requires value\n", optopt);
                 }
@@ -627,7 +689,7 @@ static void commandSync(char *args)
         }
     }
 
-    (void)orp_SyncSend(syncType, version, sentCount, recvCount, mtu);
+    (void)orp_SyncSend(client, syncType, version, sentCount, recvCount, mtu, capabilities);
 }
 
 /* > help
@@ -637,22 +699,23 @@ static void commandHelp(char *args)
     printf(helpStr);
 }
 
-bool commandDispatch(char *request)
+bool commandDispatch(struct orp_Client *client, char *request)
 {
     if (strlen(request) >= 1)
     {
         // The command (first argument) determines how parsing is done on the rest of the line
         switch (commandExtract(&request))
         {
-            case ORPCLI_CMD_CREATE:  commandCreate(request); break;
-            case ORPCLI_CMD_DELETE:  commandDelete(request); break;
-            case ORPCLI_CMD_ADD:     commandAdd(request); break;
-            case ORPCLI_CMD_PUSH:    commandPush(request); break;
-            case ORPCLI_CMD_GET:     commandGet(request); break;
-            case ORPCLI_CMD_EXAMPLE: commandExample(request); break;
-            case ORPCLI_CMD_FILE:    commandFileTransfer(request); break;
-            case ORPCLI_CMD_REPLY:   commandRespond(request); break;
-            case ORPCLI_CMD_SYNC:    commandSync(request); break;
+            case ORPCLI_CMD_CREATE:  commandCreate(client, request); break;
+            case ORPCLI_CMD_DELETE:  commandDelete(client, request); break;
+            case ORPCLI_CMD_ADD:     commandAdd(client, request); break;
+            case ORPCLI_CMD_PUSH:    commandPush(client, request); break;
+            case ORPCLI_CMD_BATCH:   commandBatch(client, request); break;
+            case ORPCLI_CMD_GET:     commandGet(client, request); break;
+            case ORPCLI_CMD_EXAMPLE: commandExample(client, request); break;
+            case ORPCLI_CMD_FILE:    commandFileTransfer(client, request); break;
+            case ORPCLI_CMD_REPLY:   commandRespond(client, request); break;
+            case ORPCLI_CMD_SYNC:    commandSync(client, request); break;
             case ORPCLI_CMD_HELP:    commandHelp(request); break;
             case ORPCLI_CMD_QUIT:    return false;
             default:
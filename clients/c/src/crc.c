@@ -0,0 +1,326 @@
+/**
+ * @file:    crc.c
+ *
+ * Purpose:  16-bit CRC-CCITT utilities
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Sierra Wireless Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *----------------------------------------------------------------------------
+ *
+ * NOTES:
+ *
+ * Usage: see crc.h
+ *
+ */
+
+#include "crc.h"
+#include "legato.h"
+#include <stdbool.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CRC_CLMUL_SUPPORTED
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Slicing-by-8 lookup tables for polynomial CRC_POLY_CCITT, generated at compile time
+ *
+ * crc_tabccitt[0][i] is the CRC (initial value 0) of the single byte i, and crc_tabccitt[n][i] is
+ * the contribution of byte i when it is followed by n more bytes, that is i * x^(16 + 8n) mod P.
+ * Each entry is therefore the XOR, over the bits b set in i, of x^(16 + 8n + b) mod P.
+ *
+ * The enumeration below holds those powers: CRC_K<n>_<b> is x^(16 + 8n + b) mod P, each one
+ * shifted from the one before it, starting from x^15.
+ */
+//--------------------------------------------------------------------------------------------------
+// Multiply a remainder by x, modulo P
+#define CRC_STEP(r)     ((((r) << 1) ^ (((r) & 0x8000) ? CRC_POLY_CCITT : 0)) & 0xFFFF)
+
+// The eight powers of x for table n, following on from the power prev
+#define CRC_K_ROW(n, prev)                                                                         \
+    CRC_K##n##_0 = CRC_STEP(prev),                                                                 \
+    CRC_K##n##_1 = CRC_STEP(CRC_K##n##_0),                                                         \
+    CRC_K##n##_2 = CRC_STEP(CRC_K##n##_1),                                                         \
+    CRC_K##n##_3 = CRC_STEP(CRC_K##n##_2),                                                         \
+    CRC_K##n##_4 = CRC_STEP(CRC_K##n##_3),                                                         \
+    CRC_K##n##_5 = CRC_STEP(CRC_K##n##_4),                                                         \
+    CRC_K##n##_6 = CRC_STEP(CRC_K##n##_5),                                                         \
+    CRC_K##n##_7 = CRC_STEP(CRC_K##n##_6)
+
+enum
+{
+    CRC_K_ROW(0, 0x8000),
+    CRC_K_ROW(1, CRC_K0_7),
+    CRC_K_ROW(2, CRC_K1_7),
+    CRC_K_ROW(3, CRC_K2_7),
+    CRC_K_ROW(4, CRC_K3_7),
+    CRC_K_ROW(5, CRC_K4_7),
+    CRC_K_ROW(6, CRC_K5_7),
+    CRC_K_ROW(7, CRC_K6_7)
+};
+
+// Entry i of table n, then runs of 4, 16, 64 and 256 entries
+#define CRC_ENTRY(n, i)                                                                            \
+    ((((i) & 0x01) ? CRC_K##n##_0 : 0) ^ (((i) & 0x02) ? CRC_K##n##_1 : 0) ^                       \
+     (((i) & 0x04) ? CRC_K##n##_2 : 0) ^ (((i) & 0x08) ? CRC_K##n##_3 : 0) ^                       \
+     (((i) & 0x10) ? CRC_K##n##_4 : 0) ^ (((i) & 0x20) ? CRC_K##n##_5 : 0) ^                       \
+     (((i) & 0x40) ? CRC_K##n##_6 : 0) ^ (((i) & 0x80) ? CRC_K##n##_7 : 0))
+#define CRC_ENTRIES4(n, i)                                                                         \
+    CRC_ENTRY(n, (i)), CRC_ENTRY(n, (i) + 1), CRC_ENTRY(n, (i) + 2), CRC_ENTRY(n, (i) + 3)
+#define CRC_ENTRIES16(n, i)                                                                        \
+    CRC_ENTRIES4(n, (i)), CRC_ENTRIES4(n, (i) + 4), CRC_ENTRIES4(n, (i) + 8),                      \
+    CRC_ENTRIES4(n, (i) + 12)
+#define CRC_ENTRIES64(n, i)                                                                        \
+    CRC_ENTRIES16(n, (i)), CRC_ENTRIES16(n, (i) + 16), CRC_ENTRIES16(n, (i) + 32),                 \
+    CRC_ENTRIES16(n, (i) + 48)
+#define CRC_TABLE(n)                                                                               \
+    { CRC_ENTRIES64(n, 0), CRC_ENTRIES64(n, 64), CRC_ENTRIES64(n, 128), CRC_ENTRIES64(n, 192) }
+
+static const uint16_t crc_tabccitt[8][256] =
+{
+    CRC_TABLE(0), CRC_TABLE(1), CRC_TABLE(2), CRC_TABLE(3),
+    CRC_TABLE(4), CRC_TABLE(5), CRC_TABLE(6), CRC_TABLE(7)
+};
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Update a CRC-16/CCITT with a buffer of bytes, using the slicing-by-8 tables
+ */
+//--------------------------------------------------------------------------------------------------
+static uint16_t crc16_UpdateTable
+(
+    uint16_t       crc,
+    const uint8_t *buf,
+    size_t         len
+)
+//--------------------------------------------------------------------------------------------------
+{
+    /* Eight bytes per iteration.  The current crc is folded into the first two bytes, and each
+     * byte is then looked up in the table matching the number of bytes which follow it
+     */
+    while (len >= 8)
+    {
+        crc = crc_tabccitt[7][(uint8_t)(crc >> 8) ^ buf[0]] ^
+              crc_tabccitt[6][(uint8_t)(crc)      ^ buf[1]] ^
+              crc_tabccitt[5][buf[2]] ^
+              crc_tabccitt[4][buf[3]] ^
+              crc_tabccitt[3][buf[4]] ^
+              crc_tabccitt[2][buf[5]] ^
+              crc_tabccitt[1][buf[6]] ^
+              crc_tabccitt[0][buf[7]];
+        buf += 8;
+        len -= 8;
+    }
+
+    while (len--)
+    {
+        crc = (crc << 8) ^ crc_tabccitt[0][(uint8_t)(crc >> 8) ^ *buf++];
+    }
+
+    return crc;
+}
+
+
+#ifdef CRC_CLMUL_SUPPORTED
+//--------------------------------------------------------------------------------------------------
+/**
+ * Carry-less multiply (PCLMULQDQ) folding
+ *
+ * The data is loaded 16 bytes at a time and byte-reversed, so that each block is a 128-bit
+ * polynomial with the first bit on the wire as its highest term.  Blocks are folded forward by
+ * multiplying each 64-bit half with x^n mod P, for the distance n being folded over.  Folding
+ * preserves the remainder modulo P, so the CRC of the final 128-bit block is the CRC of the data.
+ * The constants below are x^n mod 0x11021.
+ */
+//--------------------------------------------------------------------------------------------------
+// Minimum length for which the folding kernel is used: four blocks to start the accumulators
+#define CRC_CLMUL_LEN_MIN    64
+
+#define CRC_CLMUL_X128       0xAEFC
+#define CRC_CLMUL_X192       0x650B
+#define CRC_CLMUL_X256       0x8E29
+#define CRC_CLMUL_X320       0x26AA
+#define CRC_CLMUL_X384       0xCDE2
+#define CRC_CLMUL_X448       0x2535
+#define CRC_CLMUL_X512       0x13FC
+#define CRC_CLMUL_X576       0x8832
+
+// Selected at start-up, if the CPU supports the instructions and the kernel passes its self-test
+static bool crc_clmulEnabled = false;
+
+// Load 16 bytes as a big-endian 128-bit polynomial
+#define CRC_CLMUL_LOAD(p, swap) \
+    _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(p)), (swap))
+
+// Fold a block forward: high half by x^(n+64) mod P, low half by x^n mod P
+#define CRC_CLMUL_FOLD(a, k) \
+    _mm_xor_si128(_mm_clmulepi64_si128((a), (k), 0x11), _mm_clmulepi64_si128((a), (k), 0x00))
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Update a CRC-16/CCITT with a buffer of at least CRC_CLMUL_LEN_MIN bytes, using PCLMULQDQ
+ */
+//--------------------------------------------------------------------------------------------------
+__attribute__((target("pclmul,ssse3")))
+static uint16_t crc16_UpdateClmul
+(
+    uint16_t       crc,
+    const uint8_t *buf,
+    size_t         len
+)
+//--------------------------------------------------------------------------------------------------
+{
+    const __m128i swap  = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i k512  = _mm_set_epi64x(CRC_CLMUL_X576, CRC_CLMUL_X512);
+    const __m128i k384  = _mm_set_epi64x(CRC_CLMUL_X448, CRC_CLMUL_X384);
+    const __m128i k256  = _mm_set_epi64x(CRC_CLMUL_X320, CRC_CLMUL_X256);
+    const __m128i k128  = _mm_set_epi64x(CRC_CLMUL_X192, CRC_CLMUL_X128);
+    uint8_t block[16];
+
+    // Four independent accumulators.  The incoming crc is added to the first two data bytes
+    __m128i a0 = CRC_CLMUL_LOAD(buf,      swap);
+    __m128i a1 = CRC_CLMUL_LOAD(buf + 16, swap);
+    __m128i a2 = CRC_CLMUL_LOAD(buf + 32, swap);
+    __m128i a3 = CRC_CLMUL_LOAD(buf + 48, swap);
+    a0 = _mm_xor_si128(a0, _mm_set_epi64x((int64_t)((uint64_t)crc << 48), 0));
+    buf += 64;
+    len -= 64;
+
+    while (len >= 64)
+    {
+        a0 = _mm_xor_si128(CRC_CLMUL_FOLD(a0, k512), CRC_CLMUL_LOAD(buf,      swap));
+        a1 = _mm_xor_si128(CRC_CLMUL_FOLD(a1, k512), CRC_CLMUL_LOAD(buf + 16, swap));
+        a2 = _mm_xor_si128(CRC_CLMUL_FOLD(a2, k512), CRC_CLMUL_LOAD(buf + 32, swap));
+        a3 = _mm_xor_si128(CRC_CLMUL_FOLD(a3, k512), CRC_CLMUL_LOAD(buf + 48, swap));
+        buf += 64;
+        len -= 64;
+    }
+
+    // Combine the accumulators into one
+    a3 = _mm_xor_si128(a3, CRC_CLMUL_FOLD(a0, k384));
+    a3 = _mm_xor_si128(a3, CRC_CLMUL_FOLD(a1, k256));
+    a3 = _mm_xor_si128(a3, CRC_CLMUL_FOLD(a2, k128));
+
+    while (len >= 16)
+    {
+        a3 = _mm_xor_si128(CRC_CLMUL_FOLD(a3, k128), CRC_CLMUL_LOAD(buf, swap));
+        buf += 16;
+        len -= 16;
+    }
+
+    // Reduce the remaining block, then any trailing bytes, through the tables
+    _mm_storeu_si128((__m128i *)block, _mm_shuffle_epi8(a3, swap));
+    crc = crc16_UpdateTable(0, block, sizeof(block));
+
+    return crc16_UpdateTable(crc, buf, len);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Select the folding kernel at start-up if the CPU supports it
+ *
+ * @note:  The kernel is cross-checked against the single byte implementation before it is
+ * enabled.  On any mismatch, the table implementation continues to be used
+ */
+//--------------------------------------------------------------------------------------------------
+__attribute__((constructor))
+static void crc16_KernelSelect
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    unsigned int eax, ebx, ecx, edx;
+    uint8_t pattern[CRC_CLMUL_LEN_MIN * 4 + 15];
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_PCLMUL) || !(ecx & bit_SSSE3))
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < sizeof(pattern); i++)
+    {
+        pattern[i] = (uint8_t)((i * 167) ^ (i >> 3));
+    }
+
+    // Cover every path through the kernel: accumulator loop, block loop and trailing bytes
+    for (size_t len = CRC_CLMUL_LEN_MIN; len <= sizeof(pattern); len++)
+    {
+        uint16_t expected = CRC_CRC16_CCITT_INIT;
+        for (size_t i = 0; i < len; i++)
+        {
+            expected = _crc_ccitt_update(expected, pattern[i]);
+        }
+        if (crc16_UpdateClmul(CRC_CRC16_CCITT_INIT, pattern, len) != expected)
+        {
+            LE_ERROR("CRC folding kernel self-test failed, length %zu", len);
+            return;
+        }
+    }
+
+    crc_clmulEnabled = true;
+}
+#endif // CRC_CLMUL_SUPPORTED
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Update a CRC-16/CCITT with a buffer of bytes
+ */
+//--------------------------------------------------------------------------------------------------
+uint16_t crc16_update
+(
+    uint16_t       crc,
+    const uint8_t *buf,
+    size_t         len
+)
+//--------------------------------------------------------------------------------------------------
+{
+#ifdef CRC_CLMUL_SUPPORTED
+    if (crc_clmulEnabled && (len >= CRC_CLMUL_LEN_MIN))
+    {
+        return crc16_UpdateClmul(crc, buf, len);
+    }
+#endif
+    return crc16_UpdateTable(crc, buf, len);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Update a CRC-16/CCITT with a single byte
+ */
+//--------------------------------------------------------------------------------------------------
+uint16_t _crc_ccitt_update
+(
+    uint16_t crc,
+    uint8_t  c
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return (crc << 8) ^ crc_tabccitt[0][(uint8_t)(crc >> 8) ^ c];
+}
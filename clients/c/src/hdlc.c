@@ -37,10 +37,18 @@
  *
  */
 
+#define _GNU_SOURCE                    // memrchr
+
 #include "hdlc.h"
+#include "crc.h"
 #include "legato.h"
 #include <string.h>
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HDLC_SIMD_X86
+#include <immintrin.h>
+#endif
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Internal Definitions
@@ -87,44 +95,132 @@ enum hdlc_state
     PACK_ESCAPED               /* Escape character was sent                         */
 };
 
-// This is to be moved to crc.[ch]
-#define CRC_CRC16_CCITT_INIT 0xFFFF
-#define CRC_POLY_CCITT 0x1021
-static bool             crc_tabccitt_init       = false;
-static uint16_t         crc_tabccitt[256];
-static void init_crcccitt_tab( void ) {
-
-	uint16_t i;
-	uint16_t j;
-	uint16_t crc;
-	uint16_t c;
-
-	for (i=0; i<256; i++) {
+#ifndef MIN
+#    define MIN(a,b) (((a) < (b)) ? (a) : (b))
+#endif
 
-		crc = 0;
-		c   = i << 8;
+//--------------------------------------------------------------------------------------------------
+/**
+ * Escape scanning
+ *
+ * Returns the offset of the first frame or escape octet in a buffer, or the buffer length if
+ * there is none.  Data rarely contains either octet, so most buffers are scanned 16 (SSE2) or
+ * 32 (AVX2) bytes at a time and the clean runs between them can be copied in bulk
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t hdlc_EscapeScanScalar
+(
+    const uint8_t *buf,
+    size_t         len
+)
+{
+    size_t i;
 
-		for (j=0; j<8; j++) {
+    for (i = 0; i < len; i++)
+    {
+        if ((buf[i] == HDLC_FRAME_OCTET) || (buf[i] == HDLC_ESC_OCTET))
+        {
+            break;
+        }
+    }
+    return i;
+}
 
-			if ( (crc ^ c) & 0x8000 ) crc = ( crc << 1 ) ^ CRC_POLY_CCITT;
-			else                      crc =   crc << 1;
+#ifdef HDLC_SIMD_X86
+// Selected at start-up, if the CPU supports AVX2.  SSE2 is always available on x86-64
+static bool hdlc_avx2Enabled = false;
 
-			c = c << 1;
-		}
+__attribute__((constructor))
+static void hdlc_ScanSelect
+(
+    void
+)
+{
+    __builtin_cpu_init();
+    hdlc_avx2Enabled = __builtin_cpu_supports("avx2") ? true : false;
+}
 
-		crc_tabccitt[i] = crc;
-	}
+static size_t hdlc_EscapeScanSse2
+(
+    const uint8_t *buf,
+    size_t         len
+)
+{
+    const __m128i frame  = _mm_set1_epi8(HDLC_FRAME_OCTET);
+    const __m128i escape = _mm_set1_epi8(HDLC_ESC_OCTET);
+    size_t i;
 
-	crc_tabccitt_init = true;
+    for (i = 0; i + sizeof(__m128i) <= len; i += sizeof(__m128i))
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(buf + i));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, frame),
+                                                  _mm_cmpeq_epi8(v, escape)));
+        if (mask)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + hdlc_EscapeScanScalar(buf + i, len - i);
+}
 
-}  /* init_crcccitt_tab */
+__attribute__((target("avx2")))
+static size_t hdlc_EscapeScanAvx2
+(
+    const uint8_t *buf,
+    size_t         len
+)
+{
+    const __m256i frame  = _mm256_set1_epi8(HDLC_FRAME_OCTET);
+    const __m256i escape = _mm256_set1_epi8(HDLC_ESC_OCTET);
+    unsigned int mask = 0;
+    size_t i;
 
-uint16_t _crc_ccitt_update( uint16_t crc, uint8_t c ) {
+    for (i = 0; i + sizeof(__m256i) <= len; i += sizeof(__m256i))
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(buf + i));
+        mask = (unsigned int)_mm256_movemask_epi8(
+                   _mm256_or_si256(_mm256_cmpeq_epi8(v, frame),
+                                   _mm256_cmpeq_epi8(v, escape)));
+        if (mask)
+        {
+            break;
+        }
+    }
 
-	if ( ! crc_tabccitt_init ) init_crcccitt_tab();
+    /* Callers, and the SSE2 tail, are not VEX encoded.  Clear the upper register halves before
+     * leaving to avoid an AVX-SSE transition stall on every call: the compiler does not always
+     * do so, and never without optimization
+     */
+    _mm256_zeroupper();
 
-	return (crc << 8) ^ crc_tabccitt[ ((crc >> 8) ^ (uint16_t) c) & 0x00FF ];
+    if (mask)
+    {
+        return i + __builtin_ctz(mask);
+    }
+    return i + hdlc_EscapeScanSse2(buf + i, len - i);
+}
+#endif // HDLC_SIMD_X86
 
+static size_t hdlc_EscapeScan
+(
+    const uint8_t *buf,
+    size_t         len
+)
+{
+#ifdef HDLC_SIMD_X86
+    // Short runs, as when data is streamed a few bytes at a time, do not repay the vector setup
+    if (len < sizeof(__m128i))
+    {
+        return hdlc_EscapeScanScalar(buf, len);
+    }
+    if (hdlc_avx2Enabled && (len >= sizeof(__m256i)))
+    {
+        return hdlc_EscapeScanAvx2(buf, len);
+    }
+    return hdlc_EscapeScanSse2(buf, len);
+#else
+    return hdlc_EscapeScanScalar(buf, len);
+#endif
 }
 
 
@@ -163,11 +259,52 @@ ssize_t hdlc_Unpack
 {
     int      dst_idx = 0;               // recieved length of the packet
     int      src_idx = 0;               // recieved length of the packet
+    bool     rescan  = false;           // leave the current frame octet for the next frame
+    int      crc_idx = 0;               // first unpacked byte not yet added to the crc
 
     if (hdlc)
     {
         while ((src_idx < (int)*srclen) && (dst_idx < (int)destlen))
         {
+            if ((UNPACK_DATA == hdlc->state) && (hdlc->count > 1))
+            {
+                /* Fast path: copy a run of regular data bytes in bulk.  Every byte in the run
+                 * pushes one byte out of the two byte crc delay line, so the run is limited by
+                 * the space left in the destination as well as the source
+                 */
+                size_t run = hdlc_EscapeScan(src + src_idx,
+                                             MIN(*srclen - src_idx, destlen - dst_idx));
+                if (run >= sizeof(hdlc->crcbuf))
+                {
+                    /* When unpacking in place, dest may be src itself: take the new held back
+                     * bytes and move the run before the old ones are written over the source
+                     */
+                    uint8_t msb = src[src_idx + run - 2];
+                    uint8_t lsb = src[src_idx + run - 1];
+                    memmove(dest + dst_idx + 2, src + src_idx, run - 2);
+                    dest[dst_idx]     = hdlc->crcbuf[HDLC_FRAM_CRC_MSB];
+                    dest[dst_idx + 1] = hdlc->crcbuf[HDLC_FRAM_CRC_LSB];
+                    hdlc->crcbuf[HDLC_FRAM_CRC_MSB] = msb;
+                    hdlc->crcbuf[HDLC_FRAM_CRC_LSB] = lsb;
+                    dst_idx += run;
+                    src_idx += run;
+                    hdlc->count += run;
+                    continue;
+                }
+                /* Otherwise, a single data byte or a frame / escape octet: use the state machine */
+            }
+            else if (UNPACK_SOF_SEARCH == hdlc->state)
+            {
+                // Discard anything up to the next frame octet
+                const uint8_t *flag = memchr(src + src_idx, HDLC_FRAME_OCTET, *srclen - src_idx);
+                if (!flag)
+                {
+                    src_idx = *srclen;
+                    break;
+                }
+                src_idx = flag - src;
+            }
+
             uint8_t data = src[src_idx];
 
             switch (hdlc->state)
@@ -211,11 +348,15 @@ ssize_t hdlc_Unpack
                          */
                         case HDLC_FRAME_OCTET:
                         {
+                            hdlc->crc = crc16_update(hdlc->crc, dest + crc_idx, dst_idx - crc_idx);
+                            crc_idx = dst_idx;
+
                             uint16_t sndrcrc = ((uint16_t)(hdlc->crcbuf[HDLC_FRAM_CRC_MSB]) << 8) + hdlc->crcbuf[HDLC_FRAM_CRC_LSB];
                             if (hdlc->crc != sndrcrc)
                             {
                                 LE_INFO("CRC Mismatch: calculated %04X, received %04X", hdlc->crc, sndrcrc);
                                 dst_idx = HDLC_ERROR_CRC;
+                                rescan = true;
                             }
                             hdlc->state = HDLC_INIT;
                             break;
@@ -238,8 +379,11 @@ ssize_t hdlc_Unpack
                          * - Duplicate escape
                          * - Frame boundary while escaped
                          */
-                        case HDLC_ESC_OCTET:
                         case HDLC_FRAME_OCTET:
+                            rescan = true;
+                            /* fall through */
+
+                        case HDLC_ESC_OCTET:
                             LE_ERROR("Framing error");
                             dst_idx = HDLC_ERROR_FRAME;
                             hdlc->state = HDLC_INIT;
@@ -260,23 +404,28 @@ ssize_t hdlc_Unpack
             /* If unpacking, copy data to output buffer and update CRC */
             if (UNPACK_DATA == hdlc->state)
             {
-                /* running crc calculation on the unpacked data
-                 * if the current length of data unpacked is less than 2 bytes, it may actually be
+                /* if the current length of data unpacked is less than 2 bytes, it may actually be
                  * the crc itself.  Therefore, buffer the two most recent bytes until the end of
-                 * frame occurs
+                 * frame occurs.  The crc is calculated on the unpacked data in bulk, at the end
+                 * of the frame or of this call
                  */
                 if (hdlc->count > 1)
                 {
-                    dest[dst_idx] = hdlc->crcbuf[HDLC_FRAM_CRC_MSB];
-                    hdlc->crc = _crc_ccitt_update(hdlc->crc, dest[dst_idx]);
-                    dst_idx++;
+                    dest[dst_idx++] = hdlc->crcbuf[HDLC_FRAM_CRC_MSB];
                 }
                 hdlc->crcbuf[HDLC_FRAM_CRC_MSB] = hdlc->crcbuf[HDLC_FRAM_CRC_LSB];
                 hdlc->crcbuf[HDLC_FRAM_CRC_LSB] = data;
                 hdlc->count++;
             }
 
-            src_idx++;
+            /* A frame octet which ends a corrupt frame is not consumed.  If the real end of the
+             * frame was lost, it is the opening flag of the next frame, so it is scanned again
+             * as such on the next call rather than discarding that frame too
+             */
+            if (!rescan)
+            {
+                src_idx++;
+            }
 
             if (HDLC_INIT == hdlc->state)
             {
@@ -286,12 +435,78 @@ ssize_t hdlc_Unpack
         }
     }
 
+    // Running crc calculation on the data unpacked since the last update
+    if (dst_idx > crc_idx)
+    {
+        hdlc->crc = crc16_update(hdlc->crc, dest + crc_idx, dst_idx - crc_idx);
+    }
+
     *srclen = src_idx;
 
      return dst_idx;
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Unpack all complete HDLC frames in a buffer, in place
+ */
+//--------------------------------------------------------------------------------------------------
+ssize_t hdlc_UnpackBurst
+(
+    hdlc_context_t *hdlc,
+    uint8_t        *buf,
+    size_t         *buflen,
+    hdlc_frame_t   *frames,
+    size_t          maxFrames
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t count = 0;
+    size_t pos = 0;
+
+    if (!hdlc || !buf || !buflen || (!frames && maxFrames))
+    {
+        return HDLC_ERROR_UNSPECIFIED;
+    }
+
+    /* A frame can only be completed by a frame octet, so stop at the last one.  Anything after
+     * it is left as is, so that an incomplete frame is never partially unpacked
+     */
+    const uint8_t *last = memrchr(buf, HDLC_FRAME_OCTET, *buflen);
+    size_t limit = last ? (size_t)(last - buf) + 1 : 0;
+
+    while ((pos < limit) && (count < maxFrames))
+    {
+        size_t srclen = limit - pos;
+
+        /* Each frame is unpacked over its own source bytes.  A completed frame returns the
+         * context to HDLC_INIT, which restarts the crc and count for the next one
+         */
+        ssize_t result = hdlc_Unpack(hdlc, buf + pos, limit - pos, buf + pos, &srclen);
+        if (result < 0)
+        {
+            frames[count].offset = pos;
+            frames[count].length = 0;
+            frames[count].status = (int)result;
+            count++;
+        }
+        else if (hdlc_UnpackDone(hdlc))
+        {
+            frames[count].offset = pos;
+            frames[count].length = result;
+            frames[count].status = 0;
+            count++;
+        }
+        pos += srclen;
+    }
+
+    *buflen = pos;
+
+    return count;
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Check whether HDLC unpacking is complete
@@ -326,8 +541,9 @@ ssize_t hdlc_Pack
 )
 //--------------------------------------------------------------------------------------------------
 {
-    int src_idx = 0;
-    int dst_idx = -1;
+    size_t src_idx = 0;
+    size_t dst_idx = 0;
+    size_t crc_idx = 0;                 // first source byte not yet added to the crc
 
 
     if (hdlc)
@@ -338,32 +554,42 @@ ssize_t hdlc_Pack
             hdlc->state = PACK_START;
         }
 
+        /* If resuming after an escape, the escaped byte was already added to the crc */
+        if (PACK_ESCAPED == hdlc->state)
+        {
+            crc_idx = 1;
+        }
+
         for (dst_idx = 0;
-             (src_idx < *srclen) && (dst_idx < destlen);
-             dst_idx++)
+             (src_idx < *srclen) && (dst_idx < destlen); )
         {
             switch (hdlc->state)
             {
                 case PACK_START:
-                    dest[dst_idx] = HDLC_FRAME_OCTET;
+                    dest[dst_idx++] = HDLC_FRAME_OCTET;
                     hdlc->state = PACK_DATA;
                     break;
 
                 case PACK_DATA:
-                    hdlc->crc = _crc_ccitt_update(hdlc->crc, src[src_idx]);
-                    if ((src[src_idx] == HDLC_FRAME_OCTET) || (src[src_idx] == HDLC_ESC_OCTET))
+                {
+                    // Copy the run of bytes which do not need escaping in one go
+                    size_t run = hdlc_EscapeScan(src + src_idx,
+                                                 MIN(*srclen - src_idx, destlen - dst_idx));
+                    memcpy(dest + dst_idx, src + src_idx, run);
+                    src_idx += run;
+                    dst_idx += run;
+
+                    // If the run stopped short of either buffer end, the next byte needs escaping
+                    if ((src_idx < *srclen) && (dst_idx < destlen))
                     {
-                        dest[dst_idx] = HDLC_ESC_OCTET;
+                        dest[dst_idx++] = HDLC_ESC_OCTET;
                         hdlc->state = PACK_ESCAPED;
                     }
-                    else
-                    {
-                        dest[dst_idx] = src[src_idx++];
-                    }
                     break;
+                }
 
                 case PACK_ESCAPED:
-                    dest[dst_idx] = (src[src_idx++] ^ HDLC_ESC_MASK);
+                    dest[dst_idx++] = (src[src_idx++] ^ HDLC_ESC_MASK);
                     hdlc->state = PACK_DATA;
                     break;
 
@@ -372,11 +598,248 @@ ssize_t hdlc_Pack
                     break;
             }
         }
+
+        /* Running crc calculation on the source bytes packed by this call, including a byte
+         * whose escape has been sent but which has not been consumed yet
+         */
+        size_t crc_end = src_idx + ((PACK_ESCAPED == hdlc->state) ? 1 : 0);
+        if (crc_end > crc_idx)
+        {
+            hdlc->crc = crc16_update(hdlc->crc, src + crc_idx, crc_end - crc_idx);
+        }
     }
 
     *srclen = src_idx;
 
-    return dst_idx;
+    return hdlc ? (ssize_t)dst_idx : -1;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pack an HDLC frame from a list of segments, without copying the data
+ *
+ * Runs of source bytes which need no escaping are described in place.  Only the opening frame
+ * octet and escape sequences are written, to the scratch buffer.  Consecutive scratch bytes are
+ * described by a single output segment
+ */
+//--------------------------------------------------------------------------------------------------
+ssize_t hdlc_PackV
+(
+    hdlc_context_t     *hdlc,
+    struct iovec       *dest,
+    int                *destcnt,
+    uint8_t            *scratch,
+    size_t              scratchlen,
+    const struct iovec *src,
+    int                 srccnt,
+    size_t             *srcoffset
+)
+//--------------------------------------------------------------------------------------------------
+{
+    int seg = 0;
+    int dst_idx = 0;
+    int scratch_iov = -1;               // output segment describing the end of the scratch bytes
+    size_t scratch_idx = 0;
+    size_t skip;
+    ssize_t count = 0;
+
+
+    if (!hdlc || !dest || !destcnt || !scratch || !srcoffset || (!src && srccnt))
+    {
+        return HDLC_ERROR_UNSPECIFIED;
+    }
+
+    /* Newly initialized context - move to first state for packing */
+    if (HDLC_INIT == hdlc->state)
+    {
+        hdlc->state = PACK_START;
+    }
+
+    /* Escape sequences are always emitted whole, so the only way to get here with an escape
+     * pending is from hdlc_Pack, whose source byte is not available
+     */
+    if (PACK_ESCAPED == hdlc->state)
+    {
+        LE_ERROR("Escaped byte pending");
+        return HDLC_ERROR_UNSPECIFIED;
+    }
+
+    if (PACK_START == hdlc->state)
+    {
+        if ((*destcnt < 1) || (scratchlen < 1))
+        {
+            *destcnt = 0;
+            return 0;
+        }
+        scratch[scratch_idx++] = HDLC_FRAME_OCTET;
+        dest[dst_idx].iov_base = scratch;
+        dest[dst_idx].iov_len = 1;
+        scratch_iov = dst_idx++;
+        count++;
+        hdlc->state = PACK_DATA;
+    }
+
+    /* Find the first unpacked byte */
+    skip = *srcoffset;
+    while ((seg < srccnt) && (skip >= src[seg].iov_len))
+    {
+        skip -= src[seg].iov_len;
+        seg++;
+    }
+
+    for (; seg < srccnt; seg++, skip = 0)
+    {
+        const uint8_t *data = (const uint8_t *)src[seg].iov_base + skip;
+        size_t remaining = src[seg].iov_len - skip;
+
+        while (remaining)
+        {
+            size_t run = hdlc_EscapeScan(data, remaining);
+
+            if (run)
+            {
+                if (dst_idx >= *destcnt)
+                {
+                    goto done;
+                }
+                dest[dst_idx].iov_base = (void *)data;
+                dest[dst_idx].iov_len = run;
+                dst_idx++;
+                scratch_iov = -1;
+
+                hdlc->crc = crc16_update(hdlc->crc, data, run);
+                data += run;
+                remaining -= run;
+                *srcoffset += run;
+                count += run;
+            }
+
+            if (remaining)
+            {
+                if (scratchlen - scratch_idx < 2)
+                {
+                    goto done;
+                }
+                if (scratch_iov < 0)
+                {
+                    if (dst_idx >= *destcnt)
+                    {
+                        goto done;
+                    }
+                    dest[dst_idx].iov_base = scratch + scratch_idx;
+                    dest[dst_idx].iov_len = 0;
+                    scratch_iov = dst_idx++;
+                }
+                scratch[scratch_idx++] = HDLC_ESC_OCTET;
+                scratch[scratch_idx++] = *data ^ HDLC_ESC_MASK;
+                dest[scratch_iov].iov_len += 2;
+
+                hdlc->crc = crc16_update(hdlc->crc, data, 1);
+                data++;
+                remaining--;
+                (*srcoffset)++;
+                count += 2;
+            }
+        }
+    }
+
+done:
+    *destcnt = dst_idx;
+
+    return count;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pack an HDLC frame in place
+ *
+ * One scan counts the bytes which need escaping.  Usually there are none, and the packet stays
+ * where it is: only the frame octets and the CRC are added around it.  Otherwise the packet is
+ * expanded in place, working back from its end so that no byte is overwritten before it has
+ * been moved
+ */
+//--------------------------------------------------------------------------------------------------
+ssize_t hdlc_PackInPlace
+(
+    uint8_t *buf,
+    size_t   buflen,
+    size_t   len
+)
+//--------------------------------------------------------------------------------------------------
+{
+    uint8_t *packet = buf + HDLC_PACK_HEADROOM;
+    uint8_t crcbuf[sizeof(uint16_t)];
+    size_t escapes = 0;
+    size_t crcEscapes = 0;
+    size_t idx;
+    size_t i;
+
+
+    if (!buf || (buflen < HDLC_PACK_HEADROOM) || (len > buflen - HDLC_PACK_HEADROOM))
+    {
+        return HDLC_ERROR_UNSPECIFIED;
+    }
+
+    uint16_t crc = crc16_update(CRC_CRC16_CCITT_INIT, packet, len);
+    crcbuf[0] = crc >> 8;
+    crcbuf[1] = crc & 0x00FF;
+
+    for (idx = hdlc_EscapeScan(packet, len); idx < len; )
+    {
+        escapes++;
+        idx++;
+        idx += hdlc_EscapeScan(packet + idx, len - idx);
+    }
+    for (i = 0; i < sizeof(crcbuf); i++)
+    {
+        if ((HDLC_FRAME_OCTET == crcbuf[i]) || (HDLC_ESC_OCTET == crcbuf[i]))
+        {
+            crcEscapes++;
+        }
+    }
+
+    // Opening frame octet, escaped packet, escaped CRC and closing frame octet
+    if (HDLC_PACK_HEADROOM + len + escapes + sizeof(crcbuf) + crcEscapes + 1 > buflen)
+    {
+        LE_ERROR("Insufficient space");
+        return HDLC_ERROR_UNSPECIFIED;
+    }
+
+    // Bytes before the first one needing escape are already in place
+    for (size_t src_idx = len, dst_idx = len + escapes; src_idx != dst_idx; )
+    {
+        uint8_t c = packet[--src_idx];
+
+        if ((HDLC_FRAME_OCTET == c) || (HDLC_ESC_OCTET == c))
+        {
+            packet[--dst_idx] = c ^ HDLC_ESC_MASK;
+            packet[--dst_idx] = HDLC_ESC_OCTET;
+        }
+        else
+        {
+            packet[--dst_idx] = c;
+        }
+    }
+
+    buf[0] = HDLC_FRAME_OCTET;
+    idx = HDLC_PACK_HEADROOM + len + escapes;
+    for (i = 0; i < sizeof(crcbuf); i++)
+    {
+        if ((HDLC_FRAME_OCTET == crcbuf[i]) || (HDLC_ESC_OCTET == crcbuf[i]))
+        {
+            buf[idx++] = HDLC_ESC_OCTET;
+            buf[idx++] = crcbuf[i] ^ HDLC_ESC_MASK;
+        }
+        else
+        {
+            buf[idx++] = crcbuf[i];
+        }
+    }
+    buf[idx++] = HDLC_FRAME_OCTET;
+
+    return idx;
 }
 
 
@@ -43,17 +43,28 @@
 #include <termios.h>
 #include <fcntl.h>
 #include <unistd.h>
-#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include "orpClient.h"
+#include "orpReactor.h"
+#include "legato.h"
 
 
 // Individual commands kept in command.c
-extern bool commandDispatch(char *request);
+extern bool commandDispatch(struct orp_Client *client, char *request);
 
 // String lengths for some arguments
 #define DEV_STR_LEN_MAX   128
 #define BAUD_STR_LEN_MAX   32
 #define MODE_STR_LEN_MAX   5
+#define CONTROL_STR_LEN_MAX 108
+
+// Connections to the control socket served at once, and their longest command line
+#define CONTROL_CONNECTIONS_MAX  4
+#define CONTROL_LINE_LEN_MAX     1024
+
+// Packets received by the receive thread processed per wakeup, between commands
+#define RX_DRAIN_PACKETS_MAX     64
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -63,10 +74,14 @@ extern bool commandDispatch(char *request);
 const char usageStr[] =
 "Usage:\n\
 \tOctave Resource Protocol Client Utility\n\
-\tusage: orp [-h] -d DEV [-b BAUD]\n\
+\tusage: orp [-h] -d DEV [-b BAUD] [-e ENCODING] [-s SOCKET] [-u] [-t]\n\
 \tWhere:\n\
 \t  DEV is the serial port (e.g. /dev/ttyUSB0)\n\
 \t  BAUD is the baudrate (example 115200, default value is 9600)\n\
+\t  ENCODING is the packet encoding: ascii (default) or binary.  Binary requires HDLC mode\n\
+\t  SOCKET is the path of a Unix domain socket on which to also accept commands, one per line\n\
+\t  -u uses io_uring for serial and file I/O, if built with make IO_URING=1\n\
+\t  -t receives on a thread of its own, so that slow output does not hold up the serial port\n\
 ";
 
 void usage(void)
@@ -78,11 +93,260 @@ void usage(void)
 static char devStr[DEV_STR_LEN_MAX]   = {'\0'};
 static char baudStr[BAUD_STR_LEN_MAX] = {'\0'};
 static char modeStr[MODE_STR_LEN_MAX] = {'\0'};
-static struct pollfd fds[2];
+static enum orp_ProtocolEncoding encoding = ORP_PROTOCOL_ENCODING_ASCII;
+static enum mode mode = MODE_HDLC;  // Transmission mode : MODE_AT or MODE_HDLC
+static char controlStr[CONTROL_STR_LEN_MAX] = {'\0'};
+static bool useUring = false;
+static bool useRxThread = false;
+static struct orp_Client client;
+static struct orp_Uring uring;
+static struct orp_RxRing rxRing;
+
+static struct orp_Reactor reactor;
+static struct orp_ReactorSource stdinSource;
+static struct orp_ReactorSource linkSource;
+static struct orp_ReactorSource rxSource;
+static struct orp_ReactorSource keepAliveTimer;
+static struct orp_ReactorSource controlSource;
+
+// A connection to the control socket, and its partial command line
+struct controlConnection
+{
+    int fd;
+    struct orp_ReactorSource source;
+    size_t len;
+    char line[CONTROL_LINE_LEN_MAX];
+};
+static struct controlConnection controlConnections[CONTROL_CONNECTIONS_MAX];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Dispatch a command line.  Returns false to exit
+ */
+//--------------------------------------------------------------------------------------------------
+static bool lineDispatch(char *line, size_t len)
+{
+    if (len && ('\n' == line[len - 1]))
+        line[len - 1] = '\0';
+    bool keepGoing = commandDispatch(&client, line);
+    if (keepGoing)
+    {
+        printf("\norp > ");
+    }
+    return keepGoing;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handle a command typed on stdin
+ */
+//--------------------------------------------------------------------------------------------------
+static void stdinHandler(struct orp_ReactorSource *source, uint32_t events)
+{
+    (void)events;
+    char *line = NULL;
+    size_t size = 0;
+    ssize_t len = getline(&line, &size, stdin);
+
+    if (len < 0)
+    {
+        // End of input.  Keep serving the control socket, if any
+        orp_ReactorRemove(&reactor, source);
+        if (controlSource.fd < 0)
+        {
+            orp_ReactorStop(&reactor);
+        }
+    }
+    else if (!lineDispatch(line, len))
+    {
+        printf("Exiting\n");
+        orp_ReactorStop(&reactor);
+    }
+    free(line);
+    fflush(stdout);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run the commands of a stdin which epoll cannot watch, a regular file or /dev/null, to its end.
+ * Returns false to exit
+ */
+//--------------------------------------------------------------------------------------------------
+static bool stdinRun(void)
+{
+    char *line = NULL;
+    size_t size = 0;
+    ssize_t len;
+    bool keepGoing = true;
+
+    while (keepGoing && ((len = getline(&line, &size, stdin)) >= 0))
+    {
+        keepGoing = lineDispatch(line, len);
+        fflush(stdout);
+    }
+    if (!keepGoing)
+    {
+        printf("Exiting\n");
+    }
+    free(line);
+    fflush(stdout);
+    return keepGoing;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handle commands from a control socket connection, one per line
+ */
+//--------------------------------------------------------------------------------------------------
+static void controlConnectionHandler(struct orp_ReactorSource *source, uint32_t events)
+{
+    (void)events;
+    struct controlConnection *conn = source->context;
+    ssize_t count = read(source->fd, conn->line + conn->len, sizeof(conn->line) - 1 - conn->len);
+    bool keepGoing = true;
+
+    if (count <= 0)
+    {
+        keepGoing = false;
+    }
+    else
+    {
+        conn->len += count;
+        for (char *end; keepGoing && (end = memchr(conn->line, '\n', conn->len)) != NULL; )
+        {
+            size_t len = end - conn->line + 1;
+
+            *end = '\0';
+            keepGoing = lineDispatch(conn->line, len - 1);
+            conn->len -= len;
+            memmove(conn->line, conn->line + len, conn->len);
+        }
+        // A line longer than the buffer is discarded
+        if (conn->len == sizeof(conn->line) - 1)
+        {
+            conn->len = 0;
+        }
+    }
+
+    if (!keepGoing)
+    {
+        orp_ReactorRemove(&reactor, source);
+        close(conn->fd);
+        conn->fd = -1;
+    }
+    fflush(stdout);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Accept a connection on the control socket
+ */
+//--------------------------------------------------------------------------------------------------
+static void controlHandler(struct orp_ReactorSource *source, uint32_t events)
+{
+    (void)events;
+    int fd = accept(source->fd, NULL, NULL);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    for (int i = 0; i < CONTROL_CONNECTIONS_MAX; i++)
+    {
+        struct controlConnection *conn = &controlConnections[i];
+
+        if (conn->fd < 0)
+        {
+            conn->fd = fd;
+            conn->len = 0;
+            if (orp_ReactorAdd(&reactor, &conn->source, fd, EPOLLIN,
+                               controlConnectionHandler, conn))
+            {
+                return;
+            }
+            conn->fd = -1;
+            break;
+        }
+    }
+    printf("Control connection refused\n");
+    close(fd);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open the control socket, a Unix domain stream socket at the given path
+ */
+//--------------------------------------------------------------------------------------------------
+static int controlOpen(const char *path)
+{
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    size_t len = strlen(path);
+    int fd;
+
+    if (len >= sizeof(addr.sun_path))
+    {
+        printf("Control socket path %s too long, max %zu characters\n", path,
+               sizeof(addr.sun_path) - 1);
+        return -1;
+    }
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        printf("Failed to create control socket.  Error %s\n", strerror(errno));
+        return -1;
+    }
+    memcpy(addr.sun_path, path, len + 1);
+    (void)unlink(path);
+    if ((bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) || (listen(fd, 4) < 0))
+    {
+        printf("Failed to open control socket %s.  Error %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handle a hang up of the serial port
+ */
+//--------------------------------------------------------------------------------------------------
+static void linkHandler(struct orp_ReactorSource *source, uint32_t events)
+{
+    (void)events;
+    printf("Received hang up from %s. Exiting\n", devStr);
+    orp_ReactorRemove(&reactor, source);
+    orp_ReactorStop(&reactor);
+}
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Handle stdin and serial port data from a single thread
+ * Process packets from the receive thread, and handle a hang up of the serial port
+ */
+//--------------------------------------------------------------------------------------------------
+static void rxHandler(struct orp_ReactorSource *source, uint32_t events)
+{
+    if (LE_CLOSED == orp_ClientRxDrain(&client, RX_DRAIN_PACKETS_MAX))
+    {
+        linkHandler(source, events);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a preamble byte to keep USB awake
+ */
+//--------------------------------------------------------------------------------------------------
+static void keepAliveHandler(struct orp_ReactorSource *source, uint32_t events)
+{
+    (void)source;
+    (void)events;
+    (void)write(client.fd, "~", 1);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handle stdin, the control socket and serial port data from a single thread
  */
 //--------------------------------------------------------------------------------------------------
 void processIO(void)
@@ -93,51 +357,94 @@ void processIO(void)
      * 5 seconds seems to work
      */
     int timeout_msecs = 3000;
+    int controlFd = -1;
+
+    stdinSource.fd = -1;
+    linkSource.fd = -1;
+    rxSource.fd = -1;
+    keepAliveTimer.fd = -1;
+    controlSource.fd = -1;
+    for (int i = 0; i < CONTROL_CONNECTIONS_MAX; i++)
+    {
+        controlConnections[i].fd = -1;
+    }
 
-    fds[0].fd = 0; //stdin;
-    fds[0].events = POLLIN | POLLHUP;
-    fds[1].events = POLLIN | POLLHUP;
+    if (!orp_ReactorInit(&reactor))
+    {
+        return;
+    }
+    uring.fd = -1;
+    if (useUring && orp_UringInit(&uring, ORP_REACTOR_EVENTS_MAX))
+    {
+        orp_ReactorUringSet(&reactor, &uring);
+    }
+    if (strlen(controlStr))
+    {
+        controlFd = controlOpen(controlStr);
+        if ((controlFd < 0) ||
+            !orp_ReactorAdd(&reactor, &controlSource, controlFd, EPOLLIN, controlHandler, NULL))
+        {
+            goto done;
+        }
+    }
+    if (useRxThread)
+    {
+        // The reactor is woken by the receive thread, rather than by the serial port
+        if (!orp_ClientRxThreadStart(&client, &rxRing) ||
+            !orp_ReactorAdd(&reactor, &rxSource, client.rxEventFd, EPOLLIN, rxHandler, NULL))
+        {
+            goto done;
+        }
+        if ((uring.fd >= 0) && !orp_ClientUringAttach(&client, &uring))
+        {
+            printf("Link not using io_uring\n");
+        }
+    }
+    else if (!orp_ReactorLinkAdd(&reactor, &linkSource, &client, linkHandler))
+    {
+        goto done;
+    }
 
     printf("\norp > ");
     fflush(stdout);
-    for (bool done = false; !done; )
+    if (!orp_ReactorAdd(&reactor, &stdinSource, 0, EPOLLIN, stdinHandler, NULL))
     {
-        if (poll(fds, 2, timeout_msecs) > 0)
+        // A regular file or /dev/null is always readable, so is run at once.  As at the end of
+        // any input, keep serving the control socket, if any
+        if ((EPERM != errno) || !stdinRun() || (controlSource.fd < 0))
         {
-            if (fds[0].revents & POLLIN)
-            {
-                char *line = NULL;
-                size_t len = 0;
+            goto done;
+        }
+    }
+    if (!orp_ReactorTimerAdd(&reactor, &keepAliveTimer, timeout_msecs, keepAliveHandler, NULL))
+    {
+        goto done;
+    }
+    (void)orp_ReactorRun(&reactor);
 
-                len = getline(&line, &len, stdin);
-                if (line && len > 0)
-                {
-                    if ('\n' == line[len - 1])
-                        line[len - 1] = '\0';
-                    bool keepGoing = commandDispatch(line);
-                    free(line);
-                    if (!keepGoing)
-                    {
-                        printf("Exiting\n");
-                        break;
-                    }
-                    printf("\norp > ");
-                }
-            }
-            if (fds[1].revents & POLLIN)
-            {
-                orp_ClientReceive();
-            }
-            if (fds[1].revents & POLLHUP)
-            {
-                printf("Received POLLHUP from %s. Exiting\n", devStr);
-                break;
-            }
-            fflush(stdout);
+done:
+    orp_ReactorRemove(&reactor, &keepAliveTimer);
+    orp_ReactorRemove(&reactor, &linkSource);
+    orp_ReactorRemove(&reactor, &rxSource);
+    orp_ClientRxThreadStop(&client);
+    orp_ClientUringDetach(&client);
+    orp_ReactorRemove(&reactor, &stdinSource);
+    orp_ReactorRemove(&reactor, &controlSource);
+    for (int i = 0; i < CONTROL_CONNECTIONS_MAX; i++)
+    {
+        if (controlConnections[i].fd >= 0)
+        {
+            orp_ReactorRemove(&reactor, &controlConnections[i].source);
+            close(controlConnections[i].fd);
         }
-        // send preamble byte to keep USB awake
-        (void)write(fds[1].fd, "~", 1);
     }
+    if (controlFd >= 0)
+    {
+        close(controlFd);
+        (void)unlink(controlStr);
+    }
+    orp_ReactorFini(&reactor);
+    orp_UringFini(&uring);
 }
 
 speed_t baudGet(char *baudStr)
@@ -198,20 +505,18 @@ int configureSerial(char *devStr, char *baudStr)
     return fd;
 }
 
-uint8_t mode; // Transmission mode : MODE_AT or MODE_HDLC.
-
 int main(int argc, char **argv)
 {
     int c;
     int i;
+    int serialFd = -1;
     bool status = false;
     opterr = 0;
 
     /* Default mode is HDLC */
-    mode = MODE_HDLC;
     strncpy(modeStr, "HDLC", sizeof(modeStr));
 
-    while ((c = getopt(argc, argv, "b:d:m:h:v")) != -1)
+    while ((c = getopt(argc, argv, "b:d:e:m:s:tuh:v")) != -1)
     {
         switch (c)
         {
@@ -223,6 +528,38 @@ int main(int argc, char **argv)
                 strncpy(devStr, optarg, sizeof(devStr));
                 break;
 
+            case 'e':  // packet encoding
+                if (0 == strcmp(optarg, "binary"))
+                {
+                    encoding = ORP_PROTOCOL_ENCODING_BINARY;
+                }
+                else if (0 != strcmp(optarg, "ascii"))
+                {
+                    fprintf(stderr, "Unknown encoding %s\n", optarg);
+                    usage();
+                    goto done;
+                }
+                break;
+
+            case 's':  // control socket
+                if (strlen(optarg) >= sizeof(controlStr))
+                {
+                    fprintf(stderr, "Control socket path too long, max %zu characters\n",
+                            sizeof(controlStr) - 1);
+                    usage();
+                    goto done;
+                }
+                strcpy(controlStr, optarg);
+                break;
+
+            case 't':  // receive thread
+                useRxThread = true;
+                break;
+
+            case 'u':  // io_uring
+                useUring = true;
+                break;
+
             case 'm':  // transmission mode
                 if (0 == strcmp(optarg, "AT"))
                 {
@@ -232,7 +569,7 @@ int main(int argc, char **argv)
                 break;
 
             case '?':
-                if (optopt == 'b' || optopt == 'd')
+                if (optopt == 'b' || optopt == 'd' || optopt == 'e' || optopt == 's')
                 {
                     fprintf (stderr, "Option -%c requires an argument.\n", optopt);
                     status = true;
@@ -256,14 +593,15 @@ int main(int argc, char **argv)
     }
 
     printf("ORP Serial Client - \"h\" for help, \"q\" to exit\n");
-    printf("Using device: %s, Baud: %s, Mode %s\n", devStr, baudStr, modeStr);
+    printf("Using device: %s, Baud: %s, Mode %s, Encoding %s\n", devStr, baudStr, modeStr,
+           (ORP_PROTOCOL_ENCODING_BINARY == encoding) ? "binary" : "ascii");
 
-    fds[1].fd = configureSerial(devStr, baudStr);
-    if (fds[1].fd < 0)
+    serialFd = configureSerial(devStr, baudStr);
+    if (serialFd < 0)
     {
         goto done;
     }
-    if (!orp_ClientInit(fds[1].fd))
+    if (!orp_ClientInit(&client, serialFd, mode, encoding))
     {
         goto done;
     }
@@ -272,9 +610,10 @@ int main(int argc, char **argv)
 
 
 done:
-    if (fds[1].fd > 0)
+    orp_ClientFini(&client);
+    if (serialFd > 0)
     {
-        close(fds[1].fd);
+        close(serialFd);
     }
 
     exit(status ? EXIT_SUCCESS : EXIT_FAILURE);
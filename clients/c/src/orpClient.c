@@ -32,20 +32,30 @@
  */
 
 #include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/eventfd.h>
 #include "orpClient.h"
 #include "orpUtils.h"
-#include "hdlc.h"
 #include "at.h"
 #include "legato.h"
-#include "orpFile.h"
 
 
 /* Buffers:
  *
- * The hdlc functions require non-overlapping input and output buffers so we must keep
- * at least one for each of: outbound encoded, outbound framed, inbound framed, and
- * inbound decoded.
+ * Outbound HDLC packets are encoded straight into the frame buffer and framed there by
+ * hdlc_PackInPlace.  The packet buffer is only used to stage AT commands.  Inbound frames
+ * are unpacked in place, in batches, by hdlc_UnpackBurst and decoded within the receive
+ * buffer itself.
+ *
+ * Outbound HDLC messages which carry data are not staged in either buffer.  The protocol
+ * fields are encoded into a small header buffer, and hdlc_PackV frames the header and the
+ * caller's data into a list of segments for writev.  Only frame octets and escape sequences
+ * are written, to a small scratch buffer, which bounds the output of each writev.
  *
  * Sizing:
  *
@@ -59,69 +69,161 @@
  * escaped contents is: 2 * <max data length>.  If buffer size is a concern, a smaller
  * increase over the max data length is usually enough for real-world data - e.g. 10%
  *
- * This example is written to handle only one outbound and one inbound message at a time,
- * using static buffers
- */
-
-// Max data length.  Setting equal to the Datahub max here
-#define ORP_PACKET_DATA_SIZE_MAX    IO_MAX_STRING_VALUE_LEN
-
-// Max size of an unframed request/response packet; including protocol fields:
-#define ORP_PACKET_SIZE_MAX         (  ORP_PROTOCOL_LEN_NO_DATA_MAX \
-                                     + ORP_PACKET_DATA_SIZE_MAX)
-
-/* Max frame size.  Using a factor of 2 here in order to support stress-testing with all
- * needing to be escaped.  Normally, this isn't necessary
+ * A client handles only one outbound and one inbound message at a time, using the buffers of
+ * its struct orp_Client.  Sizes are defined in orpClient.h
+ *
+ * With a receive thread, the receive buffer and HDLC context belong to that thread, which copies
+ * each unpacked packet into the ring.  Packets are decoded out of the ring, in place, by the
+ * thread draining it.  All session state - sequence numbers, path identifiers, time base and
+ * file transfer - so stays with that thread, as do the transmit buffers
+ *
+ * Other threads send through an orp_TxQueue, whose messages are encoded into the transmit
+ * buffers by the thread owning the client, one at a time
  */
-#define ORP_HDLC_FRAME_SIZE_MAX     ((ORP_PACKET_SIZE_MAX * 2) + HDLC_OVERHEAD_BYTES_COUNT)
-
-static uint8_t rxFrameBuf[ORP_HDLC_FRAME_SIZE_MAX];
-static uint8_t rxPacketBuf[ORP_PACKET_SIZE_MAX];
 
-static uint8_t txFrameBuf[ORP_HDLC_FRAME_SIZE_MAX];
-static uint8_t txPacketBuf[ORP_PACKET_SIZE_MAX];
+// Max number of frames handed to the decoder per unpacking pass
+#define ORP_RX_BURST_FRAMES_MAX     32
 
-// ORP encoder/decoder structure, initialized via orp_ProtocolClientInit()
-static struct orp_ProtocolCodec codec;
+// Longest wait for room to write on a non-blocking link, in milliseconds
+#define ORP_TX_WAIT_MS              3000
 
-// File descriptor on which to send and receive frames, passed in by caller
-static int fd = -1;
-
-// HDLC context
-static hdlc_context_t rxHdlcContext;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Initialize local variables and state
+ * Initialize a client
  */
 //--------------------------------------------------------------------------------------------------
 bool orp_ClientInit
 (
-    int fileDescriptor
+    struct orp_Client *client,
+    int fileDescriptor,
+    enum mode mode,
+    enum orp_ProtocolEncoding encoding
 )
 {
+    if (!client)
+    {
+        printf("Invalid client\n");
+        return false;
+    }
     if (fileDescriptor < 0)
     {
         printf("Invalid file descriptor\n");
         return false;
     }
-    if (!orp_ProtocolClientInit(ORP_PROTOCOL_V1, &codec))
+    // AT commands carry the packet as text
+    if ((mode == MODE_AT) && (encoding != ORP_PROTOCOL_ENCODING_ASCII))
+    {
+        printf("AT mode requires the ASCII encoding\n");
+        return false;
+    }
+
+    // A new link: no session, no paths bound, and no file transfer in progress
+    memset(client, 0, sizeof(*client));
+    if (!orp_ProtocolCodecInit(ORP_PROTOCOL_V1, encoding, &client->codec))
     {
         printf("Failed to initialize protocol\n");
         return false;
     }
     printf("Protocol codec initialized\n");
-    fd = fileDescriptor;
-
-    if (mode == MODE_HDLC)
+    client->fd = fileDescriptor;
+    client->mode = mode;
+    client->syncTime = ORP_TIME_SECONDS_INVALID;
+    client->sessionTimeBase = ORP_TIME_SECONDS_INVALID;
+    client->rxEventFd = -1;
+    client->rxStopFd = -1;
+
+    if (client->mode == MODE_HDLC)
+    {
+        hdlc_Init(&client->rxHdlcContext);
+    }
+    else
     {
-        hdlc_Init(&rxHdlcContext);
+        // HDLC frames packets as they are encoded.  AT commands need the packet first
+        client->txPacketBuf = malloc(ORP_PACKET_SIZE_MAX);
+        if (!client->txPacketBuf)
+        {
+            printf("Failed to allocate packet buffer\n");
+            return false;
+        }
     }
 
     return true;
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release a client
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_ClientFini
+(
+    struct orp_Client *client
+)
+{
+    orp_ClientRxThreadStop(client);
+    orp_ClientUringDetach(client);
+    orp_FileDataRelease(&client->file);
+
+    free(client->txPacketBuf);
+    free(client->txRecords);
+    free(client->rxRecords);
+    client->txPacketBuf = NULL;
+    client->txRecords = NULL;
+    client->rxRecords = NULL;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Use an io_uring for the I/O of a client
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ClientUringAttach
+(
+    struct orp_Client *client,
+    struct orp_Uring *ring
+)
+{
+    struct iovec buffers[] =
+    {
+        { .iov_base = client->rxFrameBuf, .iov_len = sizeof(client->rxFrameBuf) },
+        { .iov_base = client->txFrameBuf, .iov_len = sizeof(client->txFrameBuf) },
+    };
+
+    orp_ClientUringDetach(client);
+    client->uringBufIndex = orp_UringBuffersAdd(ring, buffers, 2);
+    if (client->uringBufIndex < 0)
+    {
+        printf("Failed to register client buffers\n");
+        return false;
+    }
+    client->uring = ring;
+    client->file.uring = ring;
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Return a client to plain read() and write()
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_ClientUringDetach
+(
+    struct orp_Client *client
+)
+{
+    if (client->uring)
+    {
+        orp_UringBuffersRemove(client->uring, client->uringBufIndex, 2);
+        client->uring = NULL;
+        client->file.uring = NULL;
+    }
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Encode a message structure into a packet buffer
@@ -129,12 +231,13 @@ bool orp_ClientInit
 //--------------------------------------------------------------------------------------------------
 static bool orp_Encode
 (
+    struct orp_Client  *client,
     uint8_t            *packetBuffer,
     size_t             *packetBufferLen,
     struct orp_Message *message
 )
 {
-    return codec.encode(packetBuffer, packetBufferLen, message);
+    return client->codec.encode(packetBuffer, packetBufferLen, message);
 }
 
 
@@ -145,12 +248,36 @@ static bool orp_Encode
 //--------------------------------------------------------------------------------------------------
 static bool orp_Decode
 (
+    struct orp_Client  *client,
     uint8_t            *packetBuffer,
     size_t              packetBufferLen,
     struct orp_Message *message
 )
 {
-    return codec.decode(packetBuffer, packetBufferLen, message);
+    return client->codec.decode(packetBuffer, packetBufferLen, message);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Print the variable length fields of a packet: as text in ASCII, or as hex in binary
+ */
+//--------------------------------------------------------------------------------------------------
+static void orp_FieldsPrint
+(
+    struct orp_Client *client,
+    const uint8_t     *buf,
+    size_t             len
+)
+{
+    if (client->codec.encoding == ORP_PROTOCOL_ENCODING_ASCII)
+    {
+        printf("%.*s", (int)len, (const char *)buf);
+        return;
+    }
+    for (size_t i = 0; i < len; i++)
+    {
+        printf(" %02X", buf[i]);
+    }
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -171,342 +298,1084 @@ static ssize_t orp_AtEnframe
     size_t frameLen;
     size_t count = packetLen;
 
-    memset(frameBuf, 0, frameBufSize);
+    // AT mode
+    frameLen = at_Pack(frameBuf, frameBufSize, packet, &count);
+
+    return frameLen;
+}
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode a message into the frame buffer and frame it as HDLC, in place
+ *
+ * @note:  The packet is encoded after room for the leading 0x7E.  Unless it contains bytes
+ * which need escaping, it is not moved: only the frame octets and CRC are added around it
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t orp_HdlcEnframe
+(
+    struct orp_Client  *client,
+    uint8_t            *frameBuf,
+    size_t              frameBufSize,
+    struct orp_Message *message
+)
+{
+    // Leave room to escape every byte of the packet
+    size_t packetLen = (frameBufSize - HDLC_OVERHEAD_BYTES_COUNT) / 2;
+    size_t encodedSize = client->codec.encodedsize(message);
+    ssize_t frameLen;
+
+    LE_ASSERT(frameBuf && (frameBufSize > HDLC_OVERHEAD_BYTES_COUNT));
+
+    // Only the bytes the encoder will write need to be available
+    if (encodedSize && (encodedSize < packetLen))
+    {
+        packetLen = encodedSize;
+    }
+
+    if (!orp_Encode(client, frameBuf + HDLC_PACK_HEADROOM, &packetLen, message))
+    {
+        printf("Failed to encode request\n");
+        goto err;
+    }
+
+    frameLen = hdlc_PackInPlace(frameBuf, frameBufSize, packetLen);
+    if (frameLen < 0)
+    {
+        printf("Failed to frame packet %zd\n", frameLen);
+        goto err;
+    }
+
+    return frameLen;
+
+err:
+    return -1;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Transmit a list of segments, resuming after partial writes
+ *
+ * @note:  The segment list is modified
+ * @note:  On a non-blocking file descriptor, waits for room to write rather than failing
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_TransmitV
+(
+    struct orp_Client *client,
+    struct iovec      *segments,
+    int                segmentCount
+)
+{
+    while (segmentCount > 0)
+    {
+        ssize_t rc = writev(client->fd, segments, segmentCount);
+        if ((rc < 0) && ((EAGAIN == errno) || (EWOULDBLOCK == errno) || (EINTR == errno)))
+        {
+            struct pollfd pfd = { .fd = client->fd, .events = POLLOUT };
+
+            (void)poll(&pfd, 1, ORP_TX_WAIT_MS);
+            if (!(pfd.revents & POLLOUT))
+            {
+                return false;
+            }
+            continue;
+        }
+        if (rc <= 0)
+        {
+            return false;
+        }
+
+        // Skip the segments sent, and the sent part of the first segment remaining
+        while (segmentCount && ((size_t)rc >= segments->iov_len))
+        {
+            rc -= segments->iov_len;
+            segments++;
+            segmentCount--;
+        }
+        if (segmentCount)
+        {
+            segments->iov_base = (uint8_t *)segments->iov_base + rc;
+            segments->iov_len -= rc;
+        }
+    }
+
+    return true;
+}
+
+
+#ifdef ORP_IO_URING
+//--------------------------------------------------------------------------------------------------
+/**
+ * Transmit from the registered txFrameBuf, resuming after partial writes
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_TransmitFixed
+(
+    struct orp_Client *client,
+    uint8_t           *data,
+    size_t             dataLen
+)
+{
+    while (dataLen > 0)
+    {
+        struct io_uring_sqe *sqe = orp_UringSqeGet(client->uring);
+        int32_t rc;
+
+        if (!sqe)
+        {
+            return false;
+        }
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->fd = client->fd;
+        sqe->addr = (uint64_t)(uintptr_t)data;
+        sqe->len = dataLen;
+        sqe->buf_index = client->uringBufIndex + 1;
+        sqe->user_data = 0;
+        if (!orp_UringSubmitWait(client->uring, &rc, 1))
+        {
+            return false;
+        }
+
+        if ((-EAGAIN == rc) || (-EINTR == rc))
+        {
+            struct pollfd pfd = { .fd = client->fd, .events = POLLOUT };
+
+            (void)poll(&pfd, 1, ORP_TX_WAIT_MS);
+            if (!(pfd.revents & POLLOUT))
+            {
+                return false;
+            }
+            continue;
+        }
+        if (rc <= 0)
+        {
+            return false;
+        }
+        data += rc;
+        dataLen -= rc;
+    }
+
+    return true;
+}
+#endif
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Simple transmit routine
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_Transmit
+(
+    struct orp_Client *client,
+    uint8_t           *data,
+    size_t             dataLen
+)
+{
+    struct iovec segment = { .iov_base = data, .iov_len = dataLen };
+
+    if (!dataLen)
+    {
+        return false;
+    }
+#ifdef ORP_IO_URING
+    if (client->uring && (data >= client->txFrameBuf) &&
+        (data + dataLen <= client->txFrameBuf + sizeof(client->txFrameBuf)))
+    {
+        return orp_TransmitFixed(client, data, dataLen);
+    }
+#endif
+    return orp_TransmitV(client, &segment, 1);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Frame a list of packet segments as HDLC and send, without copying the packet
+ *
+ * @note:  Each writev sends at most ORP_TX_SEGMENTS_MAX segments, including up to
+ * ORP_TX_SCRATCH_SIZE bytes of frame octets and escapes
+ *
+ * @return: number of frame bytes sent, or -1 on failure
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t orp_HdlcEnframeSend
+(
+    struct orp_Client  *client,
+    const struct iovec *segments,
+    int                 segmentCount
+)
+{
+    hdlc_context_t context;
+    size_t packetLen = 0;
+    size_t packed = 0;
+    ssize_t frameLen = 0;
+
+    for (int i = 0; i < segmentCount; i++)
+    {
+        packetLen += segments[i].iov_len;
+    }
+
+    hdlc_Init(&context);
+
+    do
+    {
+        // Leave one segment for the CRC and closing frame octet
+        int count = ORP_TX_SEGMENTS_MAX - 1;
+        ssize_t len = hdlc_PackV(&context, client->txFrameSegments, &count,
+                                 client->txScratchBuf, sizeof(client->txScratchBuf),
+                                 segments, segmentCount, &packed);
+        if (len < 0)
+        {
+            printf("Failed to frame packet (loaded: %zu / %zu)\n", packed, packetLen);
+            goto err;
+        }
+
+        if (packed == packetLen)
+        {
+            ssize_t trailerLen = hdlc_PackFinalize(&context, client->txTrailerBuf,
+                                                   sizeof(client->txTrailerBuf));
+            if (trailerLen < 0)
+            {
+                printf("Frame buffer too small to finalize (%zu bytes)\n",
+                       sizeof(client->txTrailerBuf));
+                goto err;
+            }
+            client->txFrameSegments[count].iov_base = client->txTrailerBuf;
+            client->txFrameSegments[count].iov_len = trailerLen;
+            count++;
+            len += trailerLen;
+        }
+
+        if (!orp_TransmitV(client, client->txFrameSegments, count))
+        {
+            printf("Failed to send request\n");
+            goto err;
+        }
+        frameLen += len;
+
+    } while (packed < packetLen);
+
+    return frameLen;
+
+err:
+    return -1;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode a message structure carrying data, then frame and send it without staging copies
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t orp_ClientMessageSendV
+(
+    struct orp_Client *client,
+    struct orp_Message *message
+)
+{
+    struct iovec packetSegments[2];
+    int segmentCount = 2;
+
+    /* As when encoding into txPacketBuf, send no more data than fits in a packet.  The header
+     * buffer bounds the protocol fields, so this is done before encoding, which lets encodings
+     * with a data length field state the length sent
+     */
+    if (message->dataLen > ORP_PACKET_DATA_SIZE_MAX)
+    {
+        message->dataLen = ORP_PACKET_DATA_SIZE_MAX;
+    }
+
+    if (!client->codec.encodev(client->txHeaderBuf, sizeof(client->txHeaderBuf),
+                               packetSegments, &segmentCount, message))
+    {
+        printf("Failed to encode request\n");
+        goto err;
+    }
+
+    ssize_t frameLen = orp_HdlcEnframeSend(client, packetSegments, segmentCount);
+    if (frameLen < 0)
+    {
+        goto err;
+    }
+
+    uint8_t *header = packetSegments[0].iov_base;
+    printf("Sending:");
+    printf(" '%c%c%c%01u%01u", 0x7E, header[0], header[1], header[2], header[3]);
+    orp_FieldsPrint(client, &header[ORP_OFFSET_VARLENGTH],
+                    packetSegments[0].iov_len - ORP_OFFSET_VARLENGTH);
+    if (segmentCount > 1)
+    {
+        orp_FieldsPrint(client, packetSegments[1].iov_base, packetSegments[1].iov_len);
+    }
+    printf("', (%zd bytes)\n", frameLen);
+    orp_MessagePrint(message);
+
+    return LE_OK;
+
+err:
+    return LE_FAULT;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send the time of an outgoing message as a delta from the session time base, if agreed.  Times
+ * before the base, such as 0 for the current time, are sent in full
+ */
+//--------------------------------------------------------------------------------------------------
+static void orp_TimeDeltaOutbound
+(
+    struct orp_Client *client,
+    struct orp_Message *message
+)
+{
+    struct orp_Time time = message->time;
+
+    // The time of a sync packet is the time base itself
+    if (   (ORP_TIME_SECONDS_INVALID == client->sessionTimeBase)
+        || (ORP_SYNC_SYN == message->type) || (ORP_SYNC_SYNACK == message->type))
+    {
+        return;
+    }
+    if (   (ORP_TIME_SECONDS_INVALID == time.seconds)
+        && (   (ORP_TIMESTAMP_INVALID == message->timestamp)
+            || !orp_TimeFromDouble(message->timestamp, &time)))
+    {
+        return;
+    }
+    if (time.seconds >= client->sessionTimeBase)
+    {
+        time.seconds -= client->sessionTimeBase;
+        message->time = time;
+        message->timeDelta = true;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restore the time of an incoming message sent as a delta from the session time base
+ */
+//--------------------------------------------------------------------------------------------------
+static void orp_TimeDeltaInbound
+(
+    struct orp_Client *client,
+    struct orp_Message *message
+)
+{
+    if (!message->timeDelta)
+    {
+        return;
+    }
+    if (ORP_TIME_SECONDS_INVALID == client->sessionTimeBase)
+    {
+        printf("Time delta received without a session time base\n");
+        return;
+    }
+    message->time.seconds += client->sessionTimeBase;
+    message->timestamp = orp_TimeToDouble(&message->time);
+    message->timeDelta = false;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Convert a message structure to a framed ORP packet and send
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t orp_ClientMessageSend
+(
+    struct orp_Client *client,
+    struct orp_Message *message
+)
+{
+    uint8_t *packetBuffer = client->txPacketBuf;
+    size_t   packetBufferLen = ORP_PACKET_SIZE_MAX;
+    uint8_t *frameBuffer = client->txFrameBuf;
+    size_t   frameBufferSize = sizeof(client->txFrameBuf);
+
+    message->sequenceNum = orp_PacketSequenceNext(message->type, client->rxSequenceNum);
+    orp_PathDictOutbound(&client->pathDict, message);
+    orp_TimeDeltaOutbound(client, message);
+    for (size_t i = 0; i < message->recordCount; i++)
+    {
+        orp_TimeDeltaOutbound(client, &message->records[i]);
+    }
+
+    ssize_t frameLen;
+    if (client->mode == MODE_HDLC)
+    {
+        // Data is framed straight from the caller's buffer
+        if (message->data && message->dataLen)
+        {
+            return orp_ClientMessageSendV(client, message);
+        }
+
+        // Encode and frame packet
+        frameLen = orp_HdlcEnframe(client, frameBuffer, frameBufferSize, message);
+        if (frameLen < 0)
+        {
+            goto err;
+        }
+        printf("Sending:");
+        printf(" '%c%c%c%01u%01u",
+            frameBuffer[0], frameBuffer[1], frameBuffer[2], frameBuffer[3], frameBuffer[4]);
+        orp_FieldsPrint(client, &frameBuffer[5], frameLen - 5);
+        printf("', (%zu bytes)\n", frameLen);
+
+    }
+    else
+    {
+        // Encode the packet
+        if (!orp_Encode(client, packetBuffer, &packetBufferLen, message))
+        {
+            printf("Failed to encode request\n");
+            goto err;
+        }
+
+        frameLen = orp_AtEnframe(frameBuffer, frameBufferSize, packetBuffer, packetBufferLen);
+        if (frameLen < 0)
+        {
+            printf("Failed to frame packet %zd\n", frameLen);
+            goto err;
+        }
+        printf("Sending:");
+        printf(" '%.*s', (%zu bytes)\n", (int)frameLen, frameBuffer, frameLen);
+    }
+    orp_MessagePrint(message);
+
+    if (!orp_Transmit(client, frameBuffer, frameLen))
+    {
+        printf("Failed to send request\n");
+        goto err;
+    }
+
+    return LE_OK;
+
+err:
+    return LE_FAULT;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the capabilities in use for a new session
+ */
+//--------------------------------------------------------------------------------------------------
+static void orp_SessionCapabilitiesSet
+(
+    struct orp_Client *client,
+    unsigned int capabilities
+)
+{
+    if (capabilities != client->sessionCapabilities)
+    {
+        printf("Session capabilities: 0x%X\n", capabilities);
+    }
+    client->sessionCapabilities = capabilities;
+    orp_PathDictReset(&client->pathDict, capabilities & ORP_CAPABILITY_PATH_ID);
+    client->sessionTimeBase = (capabilities & ORP_CAPABILITY_TIME_DELTA) ? client->syncTime :
+                                                                           ORP_TIME_SECONDS_INVALID;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handle an incomimg message
+ */
+//--------------------------------------------------------------------------------------------------
+static void orp_Dispatch
+(
+    struct orp_Client *client,
+    struct orp_Message *message
+)
+{
+    switch (message->type)
+    {
+        case ORP_SYNC_SYN:
+            // A new session.  Capabilities are agreed by the SYNACK in reply
+            client->peerCapabilities = message->capabilities;
+            client->syncTime = message->time.seconds;
+            orp_SessionCapabilitiesSet(client, 0);
+            break;
+
+        case ORP_SYNC_SYNACK:
+            client->peerCapabilities = message->capabilities;
+            if (ORP_TIME_SECONDS_INVALID == client->syncTime)
+            {
+                client->syncTime = message->time.seconds;
+            }
+            orp_SessionCapabilitiesSet(client,
+                                       client->offeredCapabilities & client->peerCapabilities);
+            break;
+
+        default:
+            break;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode AT packets
+ *
+ * No deframe action for AT packets, so simply print the AT result
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t orp_AtDeframe
+(
+    uint8_t *frameBuf,
+    size_t   frameLen
+)
+{
+    for(int i=0; i<frameLen; i++)
+    {
+        printf("%c", frameBuf[i]);
+    }
+
+    return frameLen;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the records of a client, rxRecords or txRecords, allocating them on first use
+ *
+ * @return: ORP_CLIENT_BATCH_RECORDS_MAX records, or NULL on failure
+ */
+//--------------------------------------------------------------------------------------------------
+static struct orp_Message *orp_RecordsGet
+(
+    struct orp_Message **records
+)
+{
+    if (!*records)
+    {
+        *records = calloc(ORP_CLIENT_BATCH_RECORDS_MAX, sizeof(struct orp_Message));
+        if (!*records)
+        {
+            printf("Failed to allocate records\n");
+        }
+    }
+    return *records;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode and print the records of a batch packet
+ */
+//--------------------------------------------------------------------------------------------------
+static void orp_RecordsProcess
+(
+    struct orp_Client *client,
+    struct orp_Message *message
+)
+{
+    size_t count = ORP_CLIENT_BATCH_RECORDS_MAX;
+
+    if (!orp_RecordsGet(&client->rxRecords))
+    {
+        return;
+    }
+    if (!client->codec.decoderecords(message, client->rxRecords, &count))
+    {
+        printf("Failed to decode %zu records\n", message->recordCount);
+        return;
+    }
+    orp_PathDictInboundRecords(&client->pathDict, client->rxRecords, count);
+    for (size_t i = 0; i < count; i++)
+    {
+        orp_TimeDeltaInbound(client, &client->rxRecords[i]);
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        printf("Record %zu:\n", i);
+        orp_MessagePrint(&client->rxRecords[i]);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode and process one unframed packet
+ *
+ * @return: true if the packet requires a file data acknowledgement
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_PacketProcess
+(
+    struct orp_Client *client,
+    uint8_t           *packetBuf,
+    size_t             packetLen
+)
+{
+    struct orp_Message message;
+    bool ack = false;
+
+    if (!orp_Decode(client, packetBuf, packetLen, &message))
+    {
+        return false;
+    }
+    client->rxSequenceNum = message.sequenceNum;
+    orp_PathDictInbound(&client->pathDict, &message);
+    orp_TimeDeltaInbound(client, &message);
+
+    printf("\nReceived:");
+    if (message.type != ORP_RQST_FILE_DATA)
+    {
+        // Binary fields have been partly overwritten by decoding, and are printed decoded below
+        printf(" '%c%c%01X%01X%s', (%zu bytes)",
+               packetBuf[0], packetBuf[1], packetBuf[2], packetBuf[3],
+               (client->codec.encoding == ORP_PROTOCOL_ENCODING_ASCII) ?
+                   (char *)&packetBuf[4] : "",
+               packetLen);
+    }
+    else
+    {
+        if (message.data && message.dataLen)
+        {
+            // Auto-ack file transfer data, if using auto mode
+            if (orp_FileTransferGetAuto(&client->file))
+            {
+                ack = true;
+            }
+            orp_FileDataCache(&client->file, message.data, message.dataLen);
+        }
+
+        // In case of file transfer, do not print data (packetBuf[4]) which can be binary
+        printf(" '%c%c%01X%01X', (%zu bytes)",
+               packetBuf[0], packetBuf[1], packetBuf[2], packetBuf[3], packetLen);
+    }
+    printf("\n");
+    orp_MessagePrint(&message);
+
+    // Records are decoded in place, so only once the packet has been printed
+    if (message.recordCount)
+    {
+        orp_RecordsProcess(client, &message);
+    }
+
+    orp_Dispatch(client, &message);
+
+    printf("\norp > ");
+
+    return ack;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wake the thread draining the receive ring
+ */
+//--------------------------------------------------------------------------------------------------
+static void orp_RxSignal
+(
+    struct orp_Client *client
+)
+{
+    uint64_t one = 1;
+
+    // Only fails if the counter is about to overflow, when it is readable anyway
+    (void)write(client->rxEventFd, &one, sizeof(one));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Deframe and decode HDLC packets
+ *
+ * @note:  All complete frames in the buffer are unpacked in place, in batches, and then handed
+ * to the decoder, or with a receive thread pushed to its ring.  Bytes of an incomplete frame are
+ * not consumed
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t orp_HdlcDeframe
+(
+    struct orp_Client *client,
+    uint8_t           *frameBuf,
+    size_t             frameLen
+)
+{
+    hdlc_frame_t frames[ORP_RX_BURST_FRAMES_MAX];
+    ssize_t frameCount;
+    size_t consumed = 0;
+    bool ack = false;
+    bool pushed = false;
+
+    do
+    {
+        size_t count = frameLen - consumed;
+        frameCount = hdlc_UnpackBurst(&client->rxHdlcContext, frameBuf + consumed, &count,
+                                      frames, ORP_RX_BURST_FRAMES_MAX);
+        if (frameCount < 0)
+        {
+            printf("Failed to unpack data %zd\n", frameCount);
+            hdlc_Init(&client->rxHdlcContext);
+            return frameLen;
+        }
+
+        for (ssize_t i = 0; i < frameCount; i++)
+        {
+            /* A negative status will happen if bytes are missed or are corrupt.  The frame is
+             * not useable, but the rest of the batch is unaffected
+             */
+            if (frames[i].status < 0)
+            {
+                printf("Failed to unpack data %d\n", frames[i].status);
+                continue;
+            }
+            if (frames[i].length > ORP_PACKET_SIZE_MAX)
+            {
+                printf("Packet length exceeded %zu\n", frames[i].length);
+                continue;
+            }
+            if (client->rxRing)
+            {
+                // Processed by orp_ClientRxDrain().  A full ring drops the packet, and counts it
+                (void)orp_RxRingPush(client->rxRing, frameBuf + consumed + frames[i].offset,
+                                     frames[i].length);
+                pushed = true;
+                continue;
+            }
+            if (orp_PacketProcess(client, frameBuf + consumed + frames[i].offset, frames[i].length))
+            {
+                ack = true;
+            }
+        }
+        consumed += count;
+
+    // A full batch may mean there are more frames to unpack
+    } while (frameCount == ORP_RX_BURST_FRAMES_MAX);
+
+    if (pushed)
+    {
+        orp_RxSignal(client);
+    }
+    if (ack)
+    {
+        (void)orp_Respond(client, ORP_RESP_FILE_DATA, 0);
+    }
+
+    return consumed;
+}
 
-    // AT mode
-    frameLen = at_Pack(frameBuf, frameBufSize, packet, &count);
 
-    return frameLen;
-}
 //--------------------------------------------------------------------------------------------------
 /**
- * Frame a packet as HDLC
- *
- * @note:  The hdlc_Pack routine allows data to be streamed through it, to allow the use of
- * buffers which are smaller than the frame size
+ * Deframes and decodes bytes read into the Frame Buffer.  This routine can be called on any
+ * number of received bytes - i.e. it is not necessary to wait for a frame boundary.  When a full
+ * frame has been received, the resulting packet is decoded.
  */
 //--------------------------------------------------------------------------------------------------
-static ssize_t orp_HdlcEnframe
+le_result_t orp_ClientReceiveComplete
 (
-    uint8_t *frameBuf,
-    size_t   frameBufSize,
-    uint8_t *packet,
-    size_t   packetLen
+    struct orp_Client *client,
+    ssize_t result
 )
 {
-    hdlc_context_t context;
-    ssize_t frameLen;
-    size_t count = packetLen;
-
-    LE_ASSERT(frameBuf && packet);
+    size_t count;
 
-    if (frameBufSize < packetLen + HDLC_OVERHEAD_BYTES_COUNT)
+    if (result < 0)
     {
-        printf("Frame buffer too small (%zu bytes)\n", frameBufSize);
-        goto err;
+        if ((-EAGAIN == result) || (-EWOULDBLOCK == result))
+        {
+            return LE_WOULD_BLOCK;
+        }
+        if (-EINTR == result)
+        {
+            return LE_OK;
+        }
+        printf("Failed to receive\n");
+        return LE_FAULT;
+    }
+    else if (0 == result)
+    {
+        return LE_CLOSED;
     }
 
-    // Initialize the framing context
-    hdlc_Init(&context);
-    memset(frameBuf, 0, frameBufSize);
-
-    // Frame the packet
-    frameLen = hdlc_Pack(&context, frameBuf, frameBufSize, packet, &count);
-
-    // Check that all of the packet was loaded into the frame buffer
-    if (count < packetLen)
+    client->rxFrameLen += result;
+    if (MODE_HDLC == client->mode)
     {
-        printf("Failed to frame packet (loaded: %zu / %zu)\n", count, packetLen);
-        goto err;
+        count = orp_HdlcDeframe(client, client->rxFrameBuf, client->rxFrameLen);
     }
-    // Check that there is enough room remaining in the buffer to finalize the frame
-    // (leading 0x7E already prepended)
-    if (frameBufSize - frameLen < (HDLC_OVERHEAD_BYTES_COUNT - 1))
+    else
     {
-        printf("Frame buffer too small to finalize (used: %zu / %zu)\n", frameLen, frameBufSize);
-        goto err;
+        count = orp_AtDeframe(client->rxFrameBuf, client->rxFrameLen);
     }
-    count = hdlc_PackFinalize(&context, frameBuf + frameLen, frameBufSize - frameLen);
-    if (count < 0)
+    client->rxFrameLen -= count;
+    // Shift remaining bytes in the Frame Buffer to the beginning, for processing next time
+    if (client->rxFrameLen > 0)
     {
-        printf("Frame buffer too small to finalize (%zu bytes)\n", frameBufSize);
-        goto err;
+        memmove(client->rxFrameBuf, client->rxFrameBuf + count, client->rxFrameLen);
+    }
+    // A full buffer which holds no complete frame can never complete one.  Discard it
+    if (client->rxFrameLen == sizeof(client->rxFrameBuf))
+    {
+        printf("Frame length exceeded %zu\n", client->rxFrameLen);
+        hdlc_Init(&client->rxHdlcContext);
+        client->rxFrameLen = 0;
     }
-    frameLen += count;
+    return LE_OK;
+}
 
-    return frameLen;
 
-err:
-    return -1;
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reads bytes from the file descriptor, and deframes and decodes them
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t orp_ClientReceive
+(
+    struct orp_Client *client
+)
+{
+    ssize_t count;
+
+    count = read(client->fd, client->rxFrameBuf + client->rxFrameLen,
+                 sizeof(client->rxFrameBuf) - client->rxFrameLen);
+    return orp_ClientReceiveComplete(client, (count < 0) ? -errno : count);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Simple transmit routine
+ * Receive thread: read and deframe until stopped, or the link closes or fails
  */
 //--------------------------------------------------------------------------------------------------
-static bool orp_Transmit
+static void *orp_RxThread
 (
-    uint8_t *data,
-    size_t  dataLen
+    void *context
 )
 {
-    int rc = -1;
+    struct orp_Client *client = context;
+    struct pollfd fds[2] =
+    {
+        { .fd = client->fd,       .events = POLLIN },
+        { .fd = client->rxStopFd, .events = POLLIN },
+    };
+    le_result_t result = LE_WOULD_BLOCK;
 
-    if (dataLen)
+    while ((LE_OK == result) || (LE_WOULD_BLOCK == result))
     {
-        rc = write(fd, data, dataLen);
+        if (LE_WOULD_BLOCK == result)
+        {
+            if ((poll(fds, 2, -1) < 0) && (EINTR != errno))
+            {
+                printf("Failed to wait for data.  Error %s\n", strerror(errno));
+                result = LE_FAULT;
+                break;
+            }
+            if (fds[1].revents)
+            {
+                return NULL;
+            }
+        }
+        result = orp_ClientReceive(client);
     }
 
-    return rc > 0 ? true : false;
+    // Let the draining thread find out, once it has processed what was received
+    atomic_store(&client->rxRing->closed, true);
+    orp_RxSignal(client);
+    return NULL;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Convert a message structure to a framed ORP packet and send
+ * Start receiving on a thread
  */
 //--------------------------------------------------------------------------------------------------
-static le_result_t orp_ClientMessageSend
+bool orp_ClientRxThreadStart
 (
-    struct orp_Message *message
+    struct orp_Client *client,
+    struct orp_RxRing *ring
 )
 {
-    uint8_t *packetBuffer = txPacketBuf;
-    size_t   packetBufferLen = sizeof(txPacketBuf);
-    uint8_t *frameBuffer = txFrameBuf;
-    size_t   frameBufferSize = sizeof(txFrameBuf);
+    int flags = fcntl(client->fd, F_GETFL);
+    int rc;
 
-    // Encode the packet
-    if (!orp_Encode(packetBuffer, &packetBufferLen, message))
+    if (MODE_HDLC != client->mode)
     {
-        printf("Failed to encode request\n");
-        goto err;
+        printf("Receive thread requires HDLC mode\n");
+        return false;
     }
-
-    ssize_t frameLen;
-    if (mode == MODE_HDLC)
+    if (client->rxRing)
     {
-        // Frame packet
-        frameLen = orp_HdlcEnframe(frameBuffer, frameBufferSize, packetBuffer, packetBufferLen);
-        if (frameLen < 0)
-        {
-            printf("Failed to frame packet %zd\n", frameLen);
-            goto err;
-        }
-        printf("Sending:");
-        printf(" '%c%c%c%01u%01u%s', (%zu bytes)\n",
-            frameBuffer[0], frameBuffer[1], frameBuffer[2], frameBuffer[3], frameBuffer[4], &frameBuffer[5], frameLen);
-
+        printf("Receive thread already started\n");
+        return false;
     }
-    else
+    // The thread waits with poll(), so must not block in read()
+    if ((flags < 0) || (fcntl(client->fd, F_SETFL, flags | O_NONBLOCK) < 0))
     {
-        frameLen = orp_AtEnframe(frameBuffer, frameBufferSize, packetBuffer, packetBufferLen);
-        if (frameLen < 0)
-        {
-            printf("Failed to frame packet %zd\n", frameLen);
-            goto err;
-        }
-        printf("Sending:");
-        printf(" '%s', (%zu bytes)\n", frameBuffer, frameLen);
+        printf("Failed to set fd %d non-blocking.  Error %s\n", client->fd, strerror(errno));
+        return false;
     }
-    orp_MessagePrint(message);
 
-    if (!orp_Transmit(frameBuffer, frameLen))
+    client->rxEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    client->rxStopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if ((client->rxEventFd < 0) || (client->rxStopFd < 0))
     {
-        printf("Failed to send request\n");
+        printf("Failed to create events.  Error %s\n", strerror(errno));
         goto err;
     }
 
-    return LE_OK;
+    orp_RxRingInit(ring);
+    client->rxRing = ring;
+    rc = pthread_create(&client->rxThread, NULL, orp_RxThread, client);
+    if (rc)
+    {
+        printf("Failed to start receive thread.  Error %s\n", strerror(rc));
+        client->rxRing = NULL;
+        goto err;
+    }
+    return true;
 
 err:
-    return LE_FAULT;
+    if (client->rxEventFd >= 0)
+    {
+        close(client->rxEventFd);
+    }
+    if (client->rxStopFd >= 0)
+    {
+        close(client->rxStopFd);
+    }
+    client->rxEventFd = -1;
+    client->rxStopFd = -1;
+    return false;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Handle an incomimg message
+ * Stop the receive thread
  */
 //--------------------------------------------------------------------------------------------------
-static void orp_Dispatch
+void orp_ClientRxThreadStop
 (
-    struct orp_Message *message
+    struct orp_Client *client
 )
 {
-    // nothing implemented yet
-}
+    uint64_t one = 1;
 
-//--------------------------------------------------------------------------------------------------
-/**
- * Decode AT packets
- *
- * No deframe action for AT packets, so simply print the AT result
- *
- */
-//--------------------------------------------------------------------------------------------------
-static size_t orp_AtDeframe
-(
-    uint8_t *frameBuf,
-    size_t   frameLen
-)
-{
-    for(int i=0; i<frameLen; i++)
+    if (!client->rxRing)
     {
-        printf("%c", frameBuf[i]);
+        return;
     }
-
-    return frameLen;
+    (void)write(client->rxStopFd, &one, sizeof(one));
+    (void)pthread_join(client->rxThread, NULL);
+
+    close(client->rxEventFd);
+    close(client->rxStopFd);
+    client->rxEventFd = -1;
+    client->rxStopFd = -1;
+    client->rxRing = NULL;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Deframe and decode HDLC packets
+ * Decode and process packets pushed by the receive thread
  */
 //--------------------------------------------------------------------------------------------------
-static size_t orp_HdlcDeframe
+le_result_t orp_ClientRxDrain
 (
-    uint8_t *frameBuf,
-    size_t   frameLen
+    struct orp_Client *client,
+    size_t max
 )
 {
-    static size_t rxPacketLen = 0;
-    size_t consumed = 0;
+    struct orp_RxRing *ring = client->rxRing;
+    uint64_t events;
+    uint8_t *packet;
+    size_t packetLen;
+    size_t dropped;
+    size_t count = 0;
     bool ack = false;
+    bool closed;
 
-
-    do
+    if (!ring)
     {
-        /* hdlc_Unpack returns a negative value on error.  This will happen if bytes are missed
-         * or are corrupt.  When this occurs, decrement the count of received hdlc bytes as usual
-         * Reset the deframed buffer as the frame is not useable
-         */
-        size_t count = frameLen;
-        ssize_t hdlcResult = hdlc_Unpack(&rxHdlcContext,
-                                         rxPacketBuf + rxPacketLen,
-                                         sizeof(rxPacketBuf) - rxPacketLen,
-                                         frameBuf, &count);
-        frameLen -= count;
-        frameBuf += count;
-        consumed += count;
-        if (hdlcResult < 0)
-        {
-            printf("Failed to unpack data %zd\n", hdlcResult);
-            goto err;
-        }
-
-        // Increment the deframed packet length and check for overflow
-        rxPacketLen += hdlcResult;
-        if (rxPacketLen > sizeof(rxPacketBuf))
-        {
-            printf("Packet length exceeded %zd\n", rxPacketLen);
-            goto err;
-        }
+        return LE_CLOSED;
+    }
 
-        // If a complete frame was NOT unpacked, there is nothing left to do
-        if (!hdlc_UnpackDone(&rxHdlcContext))
-        {
-            break;
-        }
+    // Clear the event before looking at the ring, so that no packet pushed later goes unseen
+    (void)read(client->rxEventFd, &events, sizeof(events));
 
-        // Decode and process the received packet
-        struct orp_Message message;
-        bool result = orp_Decode(rxPacketBuf, rxPacketLen, &message);
-        if (!result)
-        {
-            goto err;
-        }
+    dropped = atomic_exchange(&ring->dropped, 0);
+    if (dropped)
+    {
+        printf("Receive ring full.  Dropped %zu packets\n", dropped);
+    }
 
-        printf("\nReceived:");
-        if (message.type != ORP_RQST_FILE_DATA)
-        {
-            printf(" '%c%c%01X%01X%s', (%zu bytes)",
-                   rxPacketBuf[0], rxPacketBuf[1], rxPacketBuf[2], rxPacketBuf[3], &rxPacketBuf[4], rxPacketLen);
-        }
-        else
+    while ((!max || (count < max)) && (NULL != (packet = orp_RxRingPeek(ring, &packetLen))))
+    {
+        if (orp_PacketProcess(client, packet, packetLen))
         {
-            if (message.data && message.dataLen)
-            {
-                // Auto-ack file transfer data, if using auto mode
-                if (orp_FileTransferGetAuto())
-                {
-                    ack = true;
-                }
-                orp_FileDataCache(message.data, message.dataLen);
-            }
-
-            // In case of file transfer, do not print data (rxPacketBuf[4]) which can be binary
-            printf(" '%c%c%01X%01X', (%zu bytes)",
-                   rxPacketBuf[0], rxPacketBuf[1], rxPacketBuf[2], rxPacketBuf[3], rxPacketLen);
+            ack = true;
         }
-        printf("\n");
-        orp_MessagePrint(&message);
-
-        orp_Dispatch(&message);
-
-        printf("\norp > ");
-
-        // Reset hdlc context and packet length for the next frame
-        hdlc_Init(&rxHdlcContext);
-        rxPacketLen = 0;
-
-    } while (frameLen > 0);
+        orp_RxRingRelease(ring);
+        count++;
+    }
 
+    // File data is acknowledged once per drain, as it is once per read without the thread
     if (ack)
     {
-        (void)orp_Respond(ORP_RESP_FILE_DATA, 0);
+        (void)orp_Respond(client, ORP_RESP_FILE_DATA, 0);
     }
 
-    return consumed;
-
-err:
-    hdlc_Init(&rxHdlcContext);
-    rxPacketLen = 0;
-    return consumed;
+    // The thread stops after its last push, so if it had stopped, an empty ring stays empty
+    closed = atomic_load(&ring->closed);
+    if (orp_RxRingPeek(ring, &packetLen))
+    {
+        orp_RxSignal(client);
+    }
+    else if (closed)
+    {
+        return LE_CLOSED;
+    }
+    return LE_OK;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Reads bytes from the file descriptor, deframes them, and decodes packets. This routine can be
- * called on any number of received bytes - i.e. it is not necessary to wait for a frame boundary.
- * When a full frame has been received, the resulting packet is decoded.
+ * Send messages queued by other threads
  */
 //--------------------------------------------------------------------------------------------------
-void orp_ClientReceive
+le_result_t orp_ClientTxQueueSend
 (
-    void
+    struct orp_Client *client,
+    struct orp_TxQueue *queue,
+    size_t max
 )
 {
-    static size_t rxFrameLen = 0;
-    ssize_t count;
+    struct orp_Message *message;
+    le_result_t result = LE_OK;
+    uint64_t events;
+    uint64_t one = 1;
+    size_t count = 0;
 
-    count = read(fd, rxFrameBuf + rxFrameLen, sizeof(rxFrameBuf) - rxFrameLen);
-    if (count < 0)
-    {
-        printf("Failed to receive\n");
-    }
-    else
+    // Clear the event before looking at the queue, so that no message queued later goes unseen
+    (void)read(queue->eventFd, &events, sizeof(events));
+
+    while ((!max || (count < max)) && (NULL != (message = orp_TxQueuePeek(queue))))
     {
-        rxFrameLen += count;
-        if (MODE_HDLC == mode)
-        {
-            count = orp_HdlcDeframe(rxFrameBuf, rxFrameLen);
-        }
-        else
+        if (LE_OK != orp_ClientMessageSend(client, message))
         {
-            count = orp_AtDeframe(rxFrameBuf, rxFrameLen);
-        }
-        rxFrameLen -= count;
-        // Shift remaining bytes in the Frame Buffer to the beginning, for processing next time
-        if (rxFrameLen > 0)
-        {
-            memmove(rxFrameBuf, rxFrameBuf + count, rxFrameLen);
+            result = LE_FAULT;
         }
+        orp_TxQueueRelease(queue);
+        count++;
+    }
+
+    if (orp_TxQueuePeek(queue))
+    {
+        (void)write(queue->eventFd, &one, sizeof(one));
     }
+    return result;
 }
 
 
@@ -517,6 +1386,7 @@ void orp_ClientReceive
 //--------------------------------------------------------------------------------------------------
 le_result_t orp_CreateResource
 (
+    struct orp_Client *client,
     bool isInput,
     const char *path,
     enum orp_IoDataType dataType,
@@ -531,7 +1401,7 @@ le_result_t orp_CreateResource
     message.path = path;           // Resource path
     message.dataType = dataType;   // Resource data type
     message.unit = units;          // Resource units (optional)
-    return orp_ClientMessageSend(&message);
+    return orp_ClientMessageSend(client, &message);
 }
 
 
@@ -542,6 +1412,7 @@ le_result_t orp_CreateResource
 //--------------------------------------------------------------------------------------------------
 le_result_t orp_DeleteResource
 (
+    struct orp_Client *client,
     const char *path
 )
 {
@@ -549,7 +1420,7 @@ le_result_t orp_DeleteResource
 
     orp_MessageInit(&message, ORP_RQST_DELETE, 0);
     message.path = path;
-    return orp_ClientMessageSend(&message);
+    return orp_ClientMessageSend(client, &message);
 }
 
 
@@ -560,6 +1431,7 @@ le_result_t orp_DeleteResource
 //--------------------------------------------------------------------------------------------------
 le_result_t orp_AddPushHandler
 (
+    struct orp_Client *client,
     const char *path
 )
 {
@@ -567,7 +1439,7 @@ le_result_t orp_AddPushHandler
 
     orp_MessageInit(&message, ORP_RQST_HANDLER_ADD, 0);
     message.path = path;
-    return orp_ClientMessageSend(&message);
+    return orp_ClientMessageSend(client, &message);
 }
 
 
@@ -578,6 +1450,7 @@ le_result_t orp_AddPushHandler
 //--------------------------------------------------------------------------------------------------
 le_result_t orp_RemovePushHandler
 (
+    struct orp_Client *client,
     const char *path
 )
 {
@@ -585,7 +1458,7 @@ le_result_t orp_RemovePushHandler
 
     orp_MessageInit(&message, ORP_RQST_HANDLER_REM, 0);
     message.path = path;
-    return orp_ClientMessageSend(&message);
+    return orp_ClientMessageSend(client, &message);
 }
 
 
@@ -596,6 +1469,7 @@ le_result_t orp_RemovePushHandler
 //--------------------------------------------------------------------------------------------------
 le_result_t orp_Push
 (
+    struct orp_Client *client,
     const char *path,
     enum orp_IoDataType dataType,
     double timestampSec,
@@ -613,7 +1487,85 @@ le_result_t orp_Push
         message.data = (void *)value;
         message.dataLen = strlen(value);
     }
-    return orp_ClientMessageSend(&message);
+    return orp_ClientMessageSend(client, &message);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push a string-encoded data sample, with a fixed-point timestamp
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t orp_PushTime
+(
+    struct orp_Client *client,
+    const char *path,
+    enum orp_IoDataType dataType,
+    int64_t seconds,
+    uint32_t microseconds,
+    const char *value
+)
+{
+    struct orp_Message message;
+
+    orp_MessageInit(&message, ORP_RQST_PUSH, 0);
+    message.dataType = dataType;
+    message.path = path;
+    message.time.seconds = seconds;
+    message.time.microseconds = microseconds;
+    if (value)
+    {
+        message.data = (void *)value;
+        message.dataLen = strlen(value);
+    }
+    return orp_ClientMessageSend(client, &message);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push a batch of string-encoded data samples, one record per sample
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t orp_PushBatch
+(
+    struct orp_Client *client,
+    enum orp_IoDataType dataType,
+    const struct orp_Sample *samples,
+    size_t count
+)
+{
+    struct orp_Message message;
+
+    if (!count || (count > ORP_CLIENT_BATCH_RECORDS_MAX))
+    {
+        printf("Batch of %zu samples not supported, max %d\n", count, ORP_CLIENT_BATCH_RECORDS_MAX);
+        return LE_BAD_PARAMETER;
+    }
+
+    if (!orp_RecordsGet(&client->txRecords))
+    {
+        return LE_NO_MEMORY;
+    }
+
+    orp_MessageInit(&message, ORP_RQST_PUSH_BATCH, 0);
+    message.dataType = dataType;
+    for (size_t i = 0; i < count; i++)
+    {
+        struct orp_Message *record = &client->txRecords[i];
+
+        orp_MessageInit(record, ORP_RQST_PUSH_BATCH, 0);
+        record->path = samples[i].path;
+        record->time = samples[i].time;
+        if (samples[i].value)
+        {
+            record->data = (void *)samples[i].value;
+            record->dataLen = strlen(samples[i].value);
+        }
+    }
+    message.records = client->txRecords;
+    message.recordCount = count;
+    return orp_ClientMessageSend(client, &message);
 }
 
 
@@ -624,6 +1576,7 @@ le_result_t orp_Push
 //--------------------------------------------------------------------------------------------------
 le_result_t orp_Get
 (
+    struct orp_Client *client,
     const char *path
 )
 {
@@ -631,7 +1584,44 @@ le_result_t orp_Get
 
     orp_MessageInit(&message, ORP_RQST_GET, 0);
     message.path = path;
-    return orp_ClientMessageSend(&message);
+    return orp_ClientMessageSend(client, &message);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Request string-encoded data samples from several resources, one record per path
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t orp_GetBatch
+(
+    struct orp_Client *client,
+    const char *const *paths,
+    size_t count
+)
+{
+    struct orp_Message message;
+
+    if (!count || (count > ORP_CLIENT_BATCH_RECORDS_MAX))
+    {
+        printf("Batch of %zu paths not supported, max %d\n", count, ORP_CLIENT_BATCH_RECORDS_MAX);
+        return LE_BAD_PARAMETER;
+    }
+
+    if (!orp_RecordsGet(&client->txRecords))
+    {
+        return LE_NO_MEMORY;
+    }
+
+    orp_MessageInit(&message, ORP_RQST_GET_BATCH, 0);
+    for (size_t i = 0; i < count; i++)
+    {
+        orp_MessageInit(&client->txRecords[i], ORP_RQST_GET_BATCH, 0);
+        client->txRecords[i].path = paths[i];
+    }
+    message.records = client->txRecords;
+    message.recordCount = count;
+    return orp_ClientMessageSend(client, &message);
 }
 
 
@@ -642,6 +1632,7 @@ le_result_t orp_Get
 //--------------------------------------------------------------------------------------------------
 le_result_t orp_SetJsonExample
 (
+    struct orp_Client *client,
     const char *path,
     const char *example
 )
@@ -652,7 +1643,7 @@ le_result_t orp_SetJsonExample
     message.path = path;
     message.dataType = ORP_IO_DATA_TYPE_JSON;
     message.data = (void *)example;
-    return orp_ClientMessageSend(&message);
+    return orp_ClientMessageSend(client, &message);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -662,6 +1653,7 @@ le_result_t orp_SetJsonExample
 //--------------------------------------------------------------------------------------------------
 le_result_t orp_CreateSensor
 (
+    struct orp_Client *client,
     const char *path,
     enum orp_IoDataType dataType,
     const char *units
@@ -673,7 +1665,7 @@ le_result_t orp_CreateSensor
     message.path = path;
     message.dataType = dataType;
     message.unit = units;
-    return orp_ClientMessageSend(&message);
+    return orp_ClientMessageSend(client, &message);
 }
 
 
@@ -684,6 +1676,7 @@ le_result_t orp_CreateSensor
 //--------------------------------------------------------------------------------------------------
 le_result_t orp_DestroySensor
 (
+    struct orp_Client *client,
     const char *path
 )
 {
@@ -691,7 +1684,7 @@ le_result_t orp_DestroySensor
 
     orp_MessageInit(&message, ORP_RQST_SENSOR_REMOVE, 0);
     message.path = path;
-    return orp_ClientMessageSend(&message);
+    return orp_ClientMessageSend(client, &message);
 }
 
 
@@ -702,6 +1695,7 @@ le_result_t orp_DestroySensor
 //--------------------------------------------------------------------------------------------------
 le_result_t orp_Respond
 (
+    struct orp_Client *client,
     enum orp_PacketType type,
     int status
 )
@@ -720,7 +1714,7 @@ le_result_t orp_Respond
             if (LE_OK == status)
             {
                 // Data is being accepted, flush to file if required
-                orp_FileDataFlush();
+                orp_FileDataFlush(&client->file);
             }
             break;
 
@@ -731,7 +1725,7 @@ le_result_t orp_Respond
             return LE_BAD_PARAMETER;
     }
     orp_MessageInit(&message, type, status);
-    return orp_ClientMessageSend(&message);
+    return orp_ClientMessageSend(client, &message);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -741,11 +1735,13 @@ le_result_t orp_Respond
 //--------------------------------------------------------------------------------------------------
 le_result_t orp_SyncSend
 (
+    struct orp_Client *client,
     enum orp_PacketType type,
     int version,
     int sentCount,
     int recvCount,
-    int mtu
+    int mtu,
+    int capabilities
 )
 {
     struct orp_Message message;
@@ -764,7 +1760,37 @@ le_result_t orp_SyncSend
     message.receivedCount = recvCount;
     message.mtu = mtu;
 
-    return orp_ClientMessageSend(&message);
+    /* Peers which predate capabilities reject the field, so by default it is only sent to a peer
+     * which has advertised its own.  Otherwise none are agreed, and paths are sent in full
+     */
+    if (type != ORP_SYNC_ACK)
+    {
+        if (capabilities < 0)
+        {
+            capabilities = ORP_CLIENT_CAPABILITIES & client->peerCapabilities;
+        }
+        message.capabilities = capabilities;
+        client->offeredCapabilities = capabilities;
+
+        /* The time of the SYN, or if it has none of the SYNACK, is the time base of the session.
+         * It is only sent when a time delta may be agreed
+         */
+        if (type == ORP_SYNC_SYN)
+        {
+            client->syncTime = ORP_TIME_SECONDS_INVALID;
+        }
+        if (   (ORP_TIME_SECONDS_INVALID == client->syncTime)
+            && (capabilities & ORP_CAPABILITY_TIME_DELTA)
+            && ((type == ORP_SYNC_SYN) || (client->peerCapabilities & ORP_CAPABILITY_TIME_DELTA)))
+        {
+            client->syncTime = (int64_t)time(NULL);
+            message.time.seconds = client->syncTime;
+        }
+        orp_SessionCapabilitiesSet(client, (type == ORP_SYNC_SYNACK) ?
+                                           (capabilities & client->peerCapabilities) : 0);
+    }
+
+    return orp_ClientMessageSend(client, &message);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -774,6 +1800,7 @@ le_result_t orp_SyncSend
 //--------------------------------------------------------------------------------------------------
 le_result_t orp_FileTransferNotify
 (
+    struct orp_Client *client,
     unsigned int status,
     const char *controlData
 )
@@ -786,7 +1813,7 @@ le_result_t orp_FileTransferNotify
         message.data = (void *)controlData;
         message.dataLen = strlen(controlData);
     }
-    return orp_ClientMessageSend(&message);
+    return orp_ClientMessageSend(client, &message);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -796,6 +1823,7 @@ le_result_t orp_FileTransferNotify
 //--------------------------------------------------------------------------------------------------
 le_result_t orp_FileTransferData
 (
+    struct orp_Client *client,
     unsigned int status,
     const char *fileData
 )
@@ -808,5 +1836,5 @@ le_result_t orp_FileTransferData
         message.data = (void *)fileData;
         message.dataLen = strlen(fileData);
     }
-    return orp_ClientMessageSend(&message);
+    return orp_ClientMessageSend(client, &message);
 }
@@ -33,6 +33,7 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
@@ -41,55 +42,6 @@
 #include "legato.h"
 
 
-//--------------------------------------------------------------------------------------------------
-/**
- * Maximum data to be read
- */
-//--------------------------------------------------------------------------------------------------
-#define FILE_DATA_MAX_LEN   (100 * 1024)
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Static for auto mode
- */
-//--------------------------------------------------------------------------------------------------
-static int AutoMode = false;
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Static for file name
- */
-//--------------------------------------------------------------------------------------------------
-static char FileName[FILE_NAME_MAX_LEN] = {0};
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Static buffer for incoming file data
- */
-//--------------------------------------------------------------------------------------------------
-static uint8_t IncomingFileData[FILE_DATA_MAX_LEN];
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Static for incoming file data length
- */
-//--------------------------------------------------------------------------------------------------
-static size_t IncomingFileDataLen = 0;
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Total bytes received for the current file
- */
-//--------------------------------------------------------------------------------------------------
-static size_t ReceivedFileBytes = 0;
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Total bytes expected for the current file
- */
-//--------------------------------------------------------------------------------------------------
-static ssize_t ExpectedFileBytes = -1;
-
 //--------------------------------------------------------------------------------------------------
 /**
  * Function to set the file name (from the 'file control start/auto <filename>' command)
@@ -97,7 +49,8 @@ static ssize_t ExpectedFileBytes = -1;
 //--------------------------------------------------------------------------------------------------
 static void FileTransferSetName
 (
-    char* namePtr               ///< [IN] File name
+    struct orp_FileTransfer *file,  ///< [IN/OUT] File transfer of the link
+    char* namePtr                   ///< [IN] File name
 )
 {
     int fd;
@@ -108,10 +61,10 @@ static void FileTransferSetName
         return;
     }
 
-    snprintf(FileName, FILE_NAME_MAX_LEN, "%s", namePtr);
+    snprintf(file->fileName, FILE_NAME_MAX_LEN, "%s", namePtr);
 
     // Check if a file already exists
-    fd = open(FileName, O_RDONLY);
+    fd = open(file->fileName, O_RDONLY);
     if (fd != -1)
     {
         close(fd);
@@ -120,22 +73,117 @@ static void FileTransferSetName
     }
 }
 
+#ifdef ORP_IO_URING
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write data to the file with a single submission of linked open, write and close requests
+ *
+ * The file is opened into slot 0 of the ring's file table, which is free again once closed.  The
+ * close is hard-linked, so runs even if the write fails.  After a short write, the rest is written
+ * by another submission
+ *
+ * @return: bytes written, or -1 on failure
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t FileDataWriteUring
+(
+    struct orp_FileTransfer *file,  ///< [IN] File transfer of the link
+    void*   dataPtr,                ///< [IN] Data pointer
+    size_t  dataLen                 ///< [IN] Data length
+)
+{
+    size_t len = 0;
+
+    while (len < dataLen)
+    {
+        struct io_uring_sqe *openSqe = orp_UringSqeGet(file->uring);
+        struct io_uring_sqe *writeSqe = openSqe ? orp_UringSqeGet(file->uring) : NULL;
+        struct io_uring_sqe *closeSqe = writeSqe ? orp_UringSqeGet(file->uring) : NULL;
+        int32_t results[3];
+
+        if (!closeSqe)
+        {
+            // The ring is prepared and submitted synchronously, so this is a ring too small
+            orp_UringDiscard(file->uring);
+            printf("io_uring too small for file writes\n");
+            return -1;
+        }
+
+        openSqe->opcode = IORING_OP_OPENAT;
+        openSqe->fd = AT_FDCWD;
+        openSqe->addr = (uint64_t)(uintptr_t)file->fileName;
+        openSqe->open_flags = O_WRONLY | O_APPEND | O_CREAT;
+        openSqe->len = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP;
+        openSqe->file_index = 1;    // Slot 0, as a direct descriptor
+        openSqe->flags = IOSQE_IO_LINK;
+        openSqe->user_data = 0;
+
+        writeSqe->opcode = IORING_OP_WRITE;
+        writeSqe->fd = 0;           // Slot 0
+        writeSqe->addr = (uint64_t)(uintptr_t)((uint8_t *)dataPtr + len);
+        writeSqe->len = dataLen - len;
+        writeSqe->off = -1;         // At the file position, which O_APPEND keeps at the end
+        writeSqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+        writeSqe->user_data = 1;
+
+        closeSqe->opcode = IORING_OP_CLOSE;
+        closeSqe->file_index = 1;
+        closeSqe->user_data = 2;
+
+        if (!orp_UringSubmitWait(file->uring, results, 3))
+        {
+            return -1;
+        }
+        if (results[0] < 0)
+        {
+            printf("Cannot open output file: Error %s\n", strerror(-results[0]));
+            return -1;
+        }
+        if (results[1] < 0)
+        {
+            printf("Failed to write data: Error %s\n", strerror(-results[1]));
+            return -1;
+        }
+        if (results[2] < 0)
+        {
+            printf("Failed to close file: Error %s\n", strerror(-results[2]));
+        }
+        if (0 == results[1])
+        {
+            // Nothing written, so nothing more would be: report what was
+            break;
+        }
+        len += results[1];
+    }
+    return len;
+}
+#endif
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Function to write data to the file
- * Each time this function is called, the file is opened/created, updated and closed
+ * Each time this function is called, the file is opened/created, updated and closed.  With an
+ * io_uring, that takes one system call rather than three or more
  */
 //--------------------------------------------------------------------------------------------------
 ssize_t FileDataWrite
 (
-    void*   dataPtr,            ///< [IN] Data pointer
-    size_t  dataLen             ///< [IN] Data length
+    struct orp_FileTransfer *file,  ///< [IN] File transfer of the link
+    void*   dataPtr,                ///< [IN] Data pointer
+    size_t  dataLen                 ///< [IN] Data length
 )
 {
-    if (strlen(FileName) && dataLen && dataPtr)
+    if (strlen(file->fileName) && dataLen && dataPtr)
     {
+#ifdef ORP_IO_URING
+        if (file->uring)
+        {
+            return FileDataWriteUring(file, dataPtr, dataLen);
+        }
+#endif
         // Open the file, create it if it does not exist
-        int fd = open(FileName, O_WRONLY | O_APPEND | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+        int fd = open(file->fileName, O_WRONLY | O_APPEND | O_CREAT,
+                      S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
         if (fd == -1)
         {
             perror("Cannot open output file\n");
@@ -170,23 +218,36 @@ ssize_t FileDataWrite
 //--------------------------------------------------------------------------------------------------
 /**
  * Function to keep data in RAM before storing it
- * This is used if auto mode is not set
+ * This is used if auto mode is not set.  The buffer is allocated by the first packet kept
+ *
+ * @return: bytes kept, or -1 on failure
  */
 //--------------------------------------------------------------------------------------------------
-void FileDataKeep
+ssize_t FileDataKeep
 (
-    void*   dataPtr,            ///< [IN] Data pointer
-    size_t  dataLen             ///< [IN] Data length
+    struct orp_FileTransfer *file,  ///< [IN/OUT] File transfer of the link
+    void*   dataPtr,                ///< [IN] Data pointer
+    size_t  dataLen                 ///< [IN] Data length
 )
 {
-    if (!dataPtr)
+    if (!dataPtr || (dataLen > ORP_FILE_DATA_MAX_LEN))
     {
-        return;
+        return -1;
     }
 
-    memset(IncomingFileData, 0, FILE_DATA_MAX_LEN);
-    memcpy(IncomingFileData, dataPtr, dataLen);
-    IncomingFileDataLen = dataLen;
+    if (!file->incomingData)
+    {
+        file->incomingData = malloc(ORP_FILE_DATA_MAX_LEN);
+        if (!file->incomingData)
+        {
+            printf("Failed to allocate file data buffer\n");
+            return -1;
+        }
+    }
+
+    memcpy(file->incomingData, dataPtr, dataLen);
+    file->incomingDataLen = dataLen;
+    return dataLen;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -196,10 +257,11 @@ void FileDataKeep
 //--------------------------------------------------------------------------------------------------
 void orp_FileTransferSetAuto
 (
-    bool isAuto                 ///< [IN] Is auto mode set ?
+    struct orp_FileTransfer *file,  ///< [IN/OUT] File transfer of the link
+    bool isAuto                     ///< [IN] Is auto mode set ?
 )
 {
-    AutoMode = isAuto;
+    file->autoMode = isAuto;
 }
 
 
@@ -210,10 +272,10 @@ void orp_FileTransferSetAuto
 //--------------------------------------------------------------------------------------------------
 bool orp_FileTransferGetAuto
 (
-    void
+    const struct orp_FileTransfer *file ///< [IN] File transfer of the link
 )
 {
-    return AutoMode;
+    return file->autoMode;
 }
 
 
@@ -224,18 +286,18 @@ bool orp_FileTransferGetAuto
 //--------------------------------------------------------------------------------------------------
 void orp_FileDataSetup
 (
+    struct orp_FileTransfer *file,
     char   *namePtr,
     size_t  fileSize,
     bool    isAuto
 )
 {
-    FileTransferSetName(namePtr);
-    AutoMode = isAuto;
-    ReceivedFileBytes = 0;
-    ExpectedFileBytes = fileSize;
+    FileTransferSetName(file, namePtr);
+    file->autoMode = isAuto;
+    file->receivedBytes = 0;
+    file->expectedBytes = fileSize;
 
-    IncomingFileDataLen = 0;
-    memset(IncomingFileData, 0, FILE_DATA_MAX_LEN);
+    orp_FileDataRelease(file);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -245,6 +307,7 @@ void orp_FileDataSetup
 //--------------------------------------------------------------------------------------------------
 void orp_FileDataCache
 (
+    struct orp_FileTransfer *file,
     void   *dataPtr,
     size_t  dataLen
 )
@@ -252,19 +315,18 @@ void orp_FileDataCache
     ssize_t writtenLen = -1;
 
 
-    if (AutoMode)
+    if (file->autoMode)
     {
-        writtenLen = FileDataWrite(dataPtr, dataLen);
+        writtenLen = FileDataWrite(file, dataPtr, dataLen);
     }
     else
     {
-        FileDataKeep(dataPtr, dataLen);
-        writtenLen = dataLen;
+        writtenLen = FileDataKeep(file, dataPtr, dataLen);
     }
 
     if (writtenLen != -1)
     {
-        ReceivedFileBytes += dataLen;
+        file->receivedBytes += dataLen;
     }
     else
     {
@@ -272,12 +334,27 @@ void orp_FileDataCache
     }
 
     // Once all bytes are received, disable auto mode
-    if ((ExpectedFileBytes > 0) && (ReceivedFileBytes >= ExpectedFileBytes))
+    if ((file->expectedBytes > 0) && ((ssize_t)file->receivedBytes >= file->expectedBytes))
     {
-        AutoMode = false;
+        file->autoMode = false;
     }
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release the data held for an inbound file transfer
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_FileDataRelease
+(
+    struct orp_FileTransfer *file   ///< [IN/OUT] File transfer of the link
+)
+{
+    free(file->incomingData);
+    file->incomingData = NULL;
+    file->incomingDataLen = 0;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Flush saved data from RAM to the file
@@ -286,13 +363,18 @@ void orp_FileDataCache
 //--------------------------------------------------------------------------------------------------
 void orp_FileDataFlush
 (
-    void
+    struct orp_FileTransfer *file   ///< [IN/OUT] File transfer of the link
 )
 {
-    if (!AutoMode && IncomingFileDataLen)
+    if (!file->autoMode && file->incomingDataLen)
+    {
+        FileDataWrite(file, file->incomingData, file->incomingDataLen);
+        file->incomingDataLen = 0;
+    }
+
+    // The transfer is complete: nothing more will be held
+    if ((file->expectedBytes > 0) && (file->receivedBytes >= (size_t)file->expectedBytes))
     {
-        FileDataWrite(IncomingFileData, IncomingFileDataLen);
-        IncomingFileDataLen = 0;
-        memset(IncomingFileData, 0, FILE_DATA_MAX_LEN);
+        orp_FileDataRelease(file);
     }
 }
@@ -0,0 +1,384 @@
+/**
+ * @file:    orpPathDict.c
+ *
+ * Purpose:  Path dictionary: compact identifiers in place of resource paths
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Sierra Wireless Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *----------------------------------------------------------------------------
+ *
+ * NOTES:
+ *
+ * Identifiers are assigned by this client, one per path, and stay with the path until the
+ * resource is deleted, or its sensor removed.  A request carrying both the path and its
+ * identifier binds them, and the identifier is sent alone once the peer has responded to a
+ * binding with success.  A failure response to an identifier sent alone unbinds it, so the next
+ * request binds again.
+ *
+ * Several requests may be in flight.  Each request of a type which may carry identifiers is
+ * queued with those it carried, and the peer responds in order, so each response settles the
+ * oldest request of its type.  Any requests queued before that one are taken to have lost their
+ * responses, and bindings they carried are left unaccepted.
+ *
+ * The peer may likewise send an identifier alone, for a path which this client has bound.
+ *
+ * Each record of a batch is treated as a request of its own, and the single response to the
+ * batch accepts, or refuses, every binding it carried.  A failed record of the response which
+ * names an identifier alone unbinds it.
+ *
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include "orpPathDict.h"
+#include "orpSchema.h"
+#include "legato.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether a packet type carries a path identifier, from the packet schema
+ */
+//--------------------------------------------------------------------------------------------------
+static bool PathDictCarriesId
+(
+    enum orp_PacketType type
+)
+{
+    switch (type)
+    {
+#define X(packet, encoded, decoded, byte1, fields, name) \
+        case decoded: return (((fields) | ORP_RECORD_FIELDS(fields)) & ORP_FIELD(PATH_ID)) != 0;
+        ORP_PACKET_SCHEMA(X)
+#undef X
+        default:
+            return false;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Hash a path: FNV-1a
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t PathDictHash
+(
+    const char *path
+)
+{
+    uint32_t hash = 2166136261u;
+
+    while (*path)
+    {
+        hash = (hash ^ (uint8_t)*path++) * 16777619u;
+    }
+    return hash;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Find the identifier of a path, assigning one if requested
+ *
+ * @return: identifier, or ORP_PATH_ID_NONE if not found or the dictionary is full
+ */
+//--------------------------------------------------------------------------------------------------
+static int PathDictFind
+(
+    struct orp_PathDict *dict,
+    const char          *path,
+    bool                 assign
+)
+{
+    uint32_t hash = PathDictHash(path);
+    int freeId = ORP_PATH_ID_NONE;
+
+    for (int id = 0; id < ORP_PATH_DICT_SIZE; id++)
+    {
+        if (!dict->entries[id].used)
+        {
+            if (ORP_PATH_ID_NONE == freeId)
+            {
+                freeId = id;
+            }
+        }
+        else if ((dict->entries[id].hash == hash) && !strcmp(dict->entries[id].path, path))
+        {
+            return id;
+        }
+    }
+
+    if (!assign || (ORP_PATH_ID_NONE == freeId))
+    {
+        return ORP_PATH_ID_NONE;
+    }
+
+    dict->entries[freeId].hash = hash;
+    dict->entries[freeId].used = true;
+    dict->entries[freeId].bound = false;
+    strcpy(dict->entries[freeId].path, path);
+    return freeId;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start a new session: forget which identifiers the peer has accepted
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_PathDictReset
+(
+    struct orp_PathDict *dict,  ///< [IN/OUT] Dictionary of the link
+    bool                 enable ///< [IN] Use path identifiers in this session ?
+)
+{
+    for (int id = 0; id < ORP_PATH_DICT_SIZE; id++)
+    {
+        dict->entries[id].bound = false;
+    }
+    dict->requestFirst = 0;
+    dict->requestCount = 0;
+    dict->enabled = enable;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the request, awaiting its response, at a position from the oldest
+ */
+//--------------------------------------------------------------------------------------------------
+static struct orp_PathDictRequest *PathDictRequestAt
+(
+    struct orp_PathDict *dict,
+    unsigned int         position
+)
+{
+    return &dict->requests[(dict->requestFirst + position) % ORP_PATH_DICT_REQUESTS_MAX];
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release the identifier of a path gone from the peer.  Requests awaiting responses forget it, so
+ * that their responses do not bind the path it may next be given
+ */
+//--------------------------------------------------------------------------------------------------
+static void PathDictRelease
+(
+    struct orp_PathDict *dict,
+    int                  id
+)
+{
+    dict->entries[id].used = false;
+    for (unsigned int i = 0; i < dict->requestCount; i++)
+    {
+        struct orp_PathDictRequest *request = PathDictRequestAt(dict, i);
+
+        request->carried &= ~(1ull << id);
+        request->binding &= ~(1ull << id);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Replace or bind the path of an outgoing message or record, of the request's packet type, and
+ * add its identifier to those the request carries
+ */
+//--------------------------------------------------------------------------------------------------
+static void PathDictBind
+(
+    struct orp_PathDict        *dict,
+    struct orp_Message         *message,
+    struct orp_PathDictRequest *request
+)
+{
+    enum orp_PacketType type = request->type;
+    int id;
+
+    if (!message->path || (strlen(message->path) > ORP_PROTOCOL_PATH_LEN_MAX))
+    {
+        return;
+    }
+
+    // The path is gone from the peer once deleted, or its sensor removed.  Release its
+    // identifier and send in full
+    if ((ORP_RQST_DELETE == type) || (ORP_RQST_SENSOR_REMOVE == type))
+    {
+        id = PathDictFind(dict, message->path, false);
+        if (ORP_PATH_ID_NONE != id)
+        {
+            PathDictRelease(dict, id);
+        }
+        return;
+    }
+
+    id = PathDictFind(dict, message->path, true);
+    if (ORP_PATH_ID_NONE == id)
+    {
+        return;
+    }
+
+    message->pathId = id;
+    request->carried |= 1ull << id;
+    if (dict->entries[id].bound)
+    {
+        message->path = NULL;
+    }
+    else
+    {
+        request->binding |= 1ull << id;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Replace or bind the path of an outgoing message, or of each of its records, before encoding
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_PathDictOutbound
+(
+    struct orp_PathDict *dict,      ///< [IN/OUT] Dictionary of the link
+    struct orp_Message  *message    ///< [IN/OUT] Message to be sent
+)
+{
+    struct orp_PathDictRequest request = { .type = message->type };
+
+    if (!dict->enabled || !PathDictCarriesId(message->type))
+    {
+        return;
+    }
+
+    PathDictBind(dict, message, &request);
+    for (size_t i = 0; i < message->recordCount; i++)
+    {
+        PathDictBind(dict, &message->records[i], &request);
+    }
+
+    if (ORP_PATH_DICT_REQUESTS_MAX == dict->requestCount)
+    {
+        // Too many awaiting responses for all to still be coming: forget the oldest
+        LE_DEBUG("No response to %u requests with path identifiers", dict->requestCount);
+        dict->requestFirst = (dict->requestFirst + 1) % ORP_PATH_DICT_REQUESTS_MAX;
+        dict->requestCount--;
+    }
+    *PathDictRequestAt(dict, dict->requestCount) = request;
+    dict->requestCount++;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Resolve the path identifier of an incoming message or record
+ */
+//--------------------------------------------------------------------------------------------------
+static void PathDictResolve
+(
+    struct orp_PathDict *dict,
+    struct orp_Message  *message
+)
+{
+    // Identifiers are only those assigned here.  Where the path is also sent, it is used
+    if (   (message->pathId < 0)
+        || (message->path && message->path[0])
+        || !PathDictCarriesId(message->type))
+    {
+        return;
+    }
+
+    if ((message->pathId < ORP_PATH_DICT_SIZE) && dict->entries[message->pathId].used)
+    {
+        message->path = dict->entries[message->pathId].path;
+    }
+    else
+    {
+        LE_ERROR("Unknown path identifier: %d", message->pathId);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Resolve the path identifier of an incoming message, and track the acceptance of bindings
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_PathDictInbound
+(
+    struct orp_PathDict *dict,      ///< [IN/OUT] Dictionary of the link
+    struct orp_Message  *message    ///< [IN/OUT] Decoded message
+)
+{
+    for (unsigned int i = 0; i < dict->requestCount; i++)
+    {
+        struct orp_PathDictRequest *request = PathDictRequestAt(dict, i);
+
+        if (message->type != (request->type | ORP_RESPONSE_MASK))
+        {
+            continue;
+        }
+
+        for (int id = 0; id < ORP_PATH_DICT_SIZE; id++)
+        {
+            if (!(request->carried & (1ull << id)))
+            {
+                continue;
+            }
+            if (LE_OK == message->status)
+            {
+                dict->entries[id].bound = true;
+            }
+            else if (!(request->binding & (1ull << id)))
+            {
+                // The peer may have lost the binding.  Bind again on the next request
+                dict->entries[id].bound = false;
+            }
+        }
+
+        // This request, and any older ones, no longer await responses
+        dict->requestFirst = (dict->requestFirst + i + 1) % ORP_PATH_DICT_REQUESTS_MAX;
+        dict->requestCount -= i + 1;
+        break;
+    }
+
+    PathDictResolve(dict, message);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Resolve the path identifiers of the records of an incoming message, once decoded
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_PathDictInboundRecords
+(
+    struct orp_PathDict *dict,      ///< [IN/OUT] Dictionary of the link
+    struct orp_Message  *records,   ///< [IN/OUT] Decoded records
+    size_t               count      ///< [IN] Number of records
+)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        struct orp_Message *record = &records[i];
+
+        // A failed record naming an identifier alone may mean the peer has lost its binding
+        if (   (LE_OK != record->status)
+            && (record->pathId >= 0) && (record->pathId < ORP_PATH_DICT_SIZE)
+            && !(record->path && record->path[0]))
+        {
+            dict->entries[record->pathId].bound = false;
+        }
+        PathDictResolve(dict, record);
+    }
+}
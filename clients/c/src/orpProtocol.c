@@ -35,12 +35,15 @@
  */
 
 #include "orpProtocol.h"
+#include "orpSchema.h"
 #include "legato.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
 #include <ctype.h>
+#include <limits.h>
+#include <float.h>
 
 
 #ifndef MIN
@@ -71,110 +74,63 @@
  *   data:  D<data chars>                E.g:  D{ \"value\" : 123, \"timestamp\" : 1541112861 }
  *
  *   Note: Data may contain the terminator so it must therefore be last
+ *
+ * Once ORP_CAPABILITY_TIME_DELTA is agreed, a time may be sent as a delta from the session time
+ * base, marked by a leading '+':
+ *
+ *   time:  T+<decimal chars><separator> E.g:  T+12.982000<separator>
+ *
+ * Records, for batch packets, each hold the fields of one sample.  They are the only fields of a
+ * batch packet, and carry their length so that data may still end each one:
+ *
+ *   record: N<decimal length>:<fields>  E.g:  N25:T1541112861.982000,P/a,D1
+ *
+ * A record of a response may carry its own status, as its magnitude.  It is omitted when OK, and
+ * a record without one has the status of the packet:
+ *
+ *   status: E<decimal chars><separator> E.g:  E1<separator>
  */
 // <source id> <dest id> <trans number> <type> <contents>
 
-#define  ORP_PKT_RQST_INPUT_CREATE   'I'   // type[1] d_type[1] pad[2] path[] units[]
-#define  ORP_PKT_RESP_INPUT_CREATE   'i'   // type[1] status[1] pad[2]
-
-#define  ORP_PKT_RQST_OUTPUT_CREATE  'O'   // type[1] d_type[1] pad[2] path[] units[]
-#define  ORP_PKT_RESP_OUTPUT_CREATE  'o'   // type[1] status[1] pad[2]
-
-#define  ORP_PKT_RQST_DELETE         'D'   // type[1] pad[1]    pad[2] path[]
-#define  ORP_PKT_RESP_DELETE         'd'   // type[1] status[1] pad[2]
-
-#define  ORP_PKT_RQST_HANDLER_ADD    'H'   // type[1] pad[1]    pad[2] path[]
-#define  ORP_PKT_RESP_HANDLER_ADD    'h'   // type[1] status[1] pad[2]
-
-#define  ORP_PKT_RQST_HANDLER_REMOVE 'K'   // type[1] pad[1]    pad[2] path[]
-#define  ORP_PKT_RESP_HANDLER_REMOVE 'k'   // type[1] status[1] pad[2]
-
-#define  ORP_PKT_RQST_PUSH           'P'   // type[1] d_type[1] pad[2] time[] path[] data[]
-#define  ORP_PKT_RESP_PUSH           'p'   // type[1] status[1] pad[2]
-
-#define  ORP_PKT_RQST_GET            'G'   // type[1] pad[1]    pad[2] path[]
-#define  ORP_PKT_RESP_GET            'g'   // type[1] status[1] pad[2] time[] data[]
-
-#define  ORP_PKT_RQST_EXAMPLE_SET    'E'   // type[1] d_type[1] pad[2] path[] data[]
-#define  ORP_PKT_RESP_EXAMPLE_SET    'e'   // type[1] status[1] pad[2]
-
-#define  ORP_PKT_RQST_SENSOR_CREATE  'S'   // type[1] d_type[1] pad[2] path[] units[]
-#define  ORP_PKT_RESP_SENSOR_CREATE  's'   // type[1] status[1] pad[2]
-
-#define  ORP_PKT_RQST_SENSOR_REMOVE  'R'   // type[1] pad[1]    pad[2] path[]
-#define  ORP_PKT_RESP_SENSOR_REMOVE  'r'   // type[1] status[1] pad[2]
-
-#define  ORP_PKT_NTFY_HANDLER_CALL   'c'   // type[1] d_type[1] pad[2] time[] path[] data[]
-#define  ORP_PKT_RESP_HANDLER_CALL   'C'   // type[1] status[1] pad[2]
-
-#define  ORP_PKT_NTFY_SENSOR_CALL    'b'   // type[1] pad[1]    pad[2] path[]
-#define  ORP_PKT_RESP_SENSOR_CALL    'B'   // type[1] status[1] pad[2]
-
-// Version 2
-#define  ORP_PKT_SYNC_SYN            'Y'   // type[1] version[1] sequence[2] time[] sent[] received[] mtu[]
-#define  ORP_PKT_SYNC_SYNACK         'y'   // type[1] version[1] sequence[2] sent[] received[] mtu[]
-#define  ORP_PKT_SYNC_ACK            'z'   // type[1] version[1] unused[2]
-
-#define  ORP_PKT_RQST_FILE_DATA      'T'   // type[1] unused[1]  sequence[2] data[]
-#define  ORP_PKT_RESP_FILE_DATA      't'   // type[1] status[1]  sequence[2]
-
-#define  ORP_PKT_NTFY_FILE_CONTROL   'L'   // type[1] event[1]   sequence[2] data[]
-#define  ORP_PKT_RESP_FILE_CONTROL   'l'   // type[1] status[1]  sequence[2]
-
-#define  ORP_PKT_RESP_UNKNOWN_RQST   '?'   // type[1] status[1] pad[2]
+// Packet type wire identifiers, ORP_PKT_<packet>.  Packet layouts are described in orpSchema.h
+enum
+{
+#define X(packet, encoded, decoded, byte1, fields, name)  ORP_PKT_##packet = (encoded),
+    ORP_PACKET_SCHEMA(X)
+#undef X
+};
 
 
 // Variable length field separator
 #define  ORP_VARLENGTH_SEPARATOR ','   //
 
+// Record length terminator, and the most digits of a record length
+#define  ORP_RECORD_LENGTH_END   ':'   //
+#define  ORP_RECORD_LENGTH_DIGITS_MAX 10
+
 
-// Variable length field identifiers
-#define  ORP_FIELD_ID_PATH       'P'   // Path
-#define  ORP_FIELD_ID_TIME       'T'   // Timestamp
-#define  ORP_FIELD_ID_UNITS      'U'   // Units
-#define  ORP_FIELD_ID_DATA       'D'   // Data
-#define  ORP_FIELD_ID_RECV_COUNT 'R'   // Received byte count
-#define  ORP_FIELD_ID_SENT_COUNT 'S'   // Sent byte count
-#define  ORP_FIELD_ID_MTU        'M'   // Maximum Transfer Unit
+// Variable length field identifiers, ORP_FIELD_ID_<name>
+enum
+{
+#define X(name, id, description)  ORP_FIELD_ID_##name = (id),
+    ORP_FIELD_SCHEMA(X)
+#undef X
+};
 
 
-// Data types
-#define  ORP_DATA_TYPE_TRIGGER   'T'   // trigger - no data
-#define  ORP_DATA_TYPE_BOOLEAN   'B'   // Boolean - 1 byte:  't' | 'f'
-#define  ORP_DATA_TYPE_NUMERIC   'N'   // numeric - null-terminated ASCII string, representing double
-#define  ORP_DATA_TYPE_STRING    'S'   // string  - null-terminated ASCII string
-#define  ORP_DATA_TYPE_JSON      'J'   // JSON    - null-terminated ASCII string, representing JSON
-#define  ORP_DATA_TYPE_UNDEF     ' '   // not specified
+// Data types, ORP_DATA_TYPE_<name>
+enum
+{
+#define X(name, encoded, decoded, keyword)  ORP_DATA_TYPE_##name = (encoded),
+    ORP_DATA_TYPE_SCHEMA(X)
+#undef X
+};
 
 
 // Minimum packet length
 #define  ORP_PACKET_LEN_MIN       4    //
 
 
-/* Field masks - Used to indicate which fields are required for a packet
- * Note:  The following masks are mutually exclusive:
- *     ORP_MASK_DATA_TYPE
- *     ORP_MASK_STATUS
- *     ORP_MASK_VERSION
- *     ORP_MASK_EVENT
- */
-#define ORP_MASK_NONE             0x0000 /* no mandatory fields for incoming */
-#define ORP_MASK_PACK_TYPE        0x0001
-#define ORP_MASK_DATA_TYPE        0x0002
-#define ORP_MASK_SEG_NUM          0x0004
-#define ORP_MASK_SEG_COUNT        0x0008
-#define ORP_MASK_TIME             0x0010
-#define ORP_MASK_PATH             0x0020
-#define ORP_MASK_DATA             0x0040
-#define ORP_MASK_RECV_COUNT       0x0080
-#define ORP_MASK_SENT_COUNT       0x0100
-#define ORP_MASK_STATUS           0x0200
-#define ORP_MASK_VERSION          0x0400
-#define ORP_MASK_EVENT            0x0800
-#define ORP_MASK_BYTE1_UNUSED     0x1000
-
-
-// Status codes:  Use @-Z (0x40-0x5A) and subtract 0x40
 enum orp_resp_status
 {
     ORP_RESP_STATUS_OK = 0x40,         // LE_OK = 0
@@ -203,74 +159,101 @@ enum orp_resp_status
 };
 
 
+// Index of each packet type in orp_PacketTypeTable
+enum orp_PacketTypeIndex
+{
+#define X(packet, encoded, decoded, byte1, fields, name)  ORP_PACKET_TYPE_INDEX_##packet,
+    ORP_PACKET_SCHEMA(X)
+#undef X
+    ORP_PACKET_TYPE_TABLE_SIZE
+};
+
+
 //--------------------------------------------------------------------------------------------------
 /**
- * Mapping of encoded to decoded packet types, plus a bitmask of required fields
+ * Per packet type encoder, header decoder and version 1 field decoders, generated from the schema.
+ * Each is a specialization of orp_PacketEncode, orp_PacketHeaderDecode or orp_FieldsDecode for a
+ * single packet type, and for the records it carries
  */
 //--------------------------------------------------------------------------------------------------
-static struct
-{
-    uint8_t             encoded;
-    enum orp_PacketType decoded;
-    unsigned int        required;
-}
-orp_PacketTypeTable[] =
-{
-    { ORP_PKT_RQST_INPUT_CREATE,   ORP_RQST_INPUT_CREATE,   ORP_MASK_DATA_TYPE | ORP_MASK_PATH      },
-    { ORP_PKT_RESP_INPUT_CREATE,   ORP_RESP_INPUT_CREATE,   ORP_MASK_STATUS                         },
-
-    { ORP_PKT_RQST_OUTPUT_CREATE,  ORP_RQST_OUTPUT_CREATE,  ORP_MASK_DATA_TYPE | ORP_MASK_PATH      },
-    { ORP_PKT_RESP_OUTPUT_CREATE,  ORP_RESP_OUTPUT_CREATE,  ORP_MASK_STATUS                         },
-
-    { ORP_PKT_RQST_DELETE,         ORP_RQST_DELETE,         ORP_MASK_PATH                           },
-    { ORP_PKT_RESP_DELETE,         ORP_RESP_DELETE,         ORP_MASK_STATUS                         },
-
-    { ORP_PKT_RQST_HANDLER_ADD,    ORP_RQST_HANDLER_ADD,    ORP_MASK_PATH                           },
-    { ORP_PKT_RESP_HANDLER_ADD,    ORP_RESP_HANDLER_ADD,    ORP_MASK_STATUS                         },
-
-    { ORP_PKT_RQST_HANDLER_REMOVE, ORP_RQST_HANDLER_REM,    ORP_MASK_PATH                           },
-    { ORP_PKT_RESP_HANDLER_REMOVE, ORP_RESP_HANDLER_REM,    ORP_MASK_STATUS                         },
-
-    { ORP_PKT_RQST_PUSH,           ORP_RQST_PUSH,           ORP_MASK_DATA_TYPE | ORP_MASK_PATH      },
-    { ORP_PKT_RESP_PUSH,           ORP_RESP_PUSH,           ORP_MASK_STATUS                         },
-
-    { ORP_PKT_RQST_GET,            ORP_RQST_GET,            ORP_MASK_PATH                           },
-    { ORP_PKT_RESP_GET,            ORP_RESP_GET,            ORP_MASK_STATUS                         },
-
-    { ORP_PKT_RQST_EXAMPLE_SET,    ORP_RQST_EXAMPLE_SET,    ORP_MASK_DATA_TYPE | ORP_MASK_PATH      },
-    { ORP_PKT_RESP_EXAMPLE_SET,    ORP_RESP_EXAMPLE_SET,    ORP_MASK_STATUS                         },
-
-    { ORP_PKT_RQST_SENSOR_CREATE,  ORP_RQST_SENSOR_CREATE,  ORP_MASK_DATA_TYPE | ORP_MASK_PATH      },
-    { ORP_PKT_RESP_SENSOR_CREATE,  ORP_RESP_SENSOR_CREATE,  ORP_MASK_STATUS                         },
+typedef bool (*orp_PacketHeaderDecode_t)
+(
+    const uint8_t      *packet,
+    struct orp_Message *msg
+);
 
-    { ORP_PKT_RQST_SENSOR_REMOVE,  ORP_RQST_SENSOR_REMOVE,  ORP_MASK_PATH                           },
-    { ORP_PKT_RESP_SENSOR_REMOVE,  ORP_RESP_SENSOR_REMOVE,  ORP_MASK_STATUS                         },
+typedef bool (*orp_FieldsDecode_t)
+(
+    uint8_t            *buf,
+    size_t              len,
+    struct orp_Message *msg,
+    size_t             *errorOffset
+);
 
-    { ORP_PKT_NTFY_HANDLER_CALL,   ORP_NTFY_HANDLER_CALL,   ORP_MASK_BYTE1_UNUSED   |
-                                                            ORP_MASK_TIME           |
-                                                            ORP_MASK_PATH                           },
-    { ORP_PKT_RESP_HANDLER_CALL,   ORP_RESP_HANDLER_CALL,   ORP_MASK_STATUS                         },
+#define X(packet, encoded, decoded, byte1, fields, name)                                           \
+    static bool orp_PacketEncode_##packet(uint8_t *, size_t *, struct orp_Message *);              \
+    static bool orp_PacketHeaderDecode_##packet(const uint8_t *, struct orp_Message *);            \
+    static bool orp_FieldsDecode_##packet(uint8_t *, size_t, struct orp_Message *, size_t *);      \
+    static bool orp_RecordFieldsDecode_##packet(uint8_t *, size_t, struct orp_Message *, size_t *);
+ORP_PACKET_SCHEMA(X)
+#undef X
 
-    { ORP_PKT_NTFY_SENSOR_CALL,    ORP_NTFY_SENSOR_CALL,    ORP_MASK_BYTE1_UNUSED | ORP_MASK_PATH   },
-    { ORP_PKT_RESP_SENSOR_CALL,    ORP_RESP_SENSOR_CALL,    ORP_MASK_STATUS                         },
 
-    { ORP_PKT_SYNC_SYN,            ORP_SYNC_SYN,            ORP_MASK_VERSION                        },
-    { ORP_PKT_SYNC_SYNACK,         ORP_SYNC_SYNACK,         ORP_MASK_VERSION                        },
-    { ORP_PKT_SYNC_ACK,            ORP_SYNC_ACK,            ORP_MASK_VERSION                        },
+//--------------------------------------------------------------------------------------------------
+/**
+ * Mapping of encoded to decoded packet types, plus the content of the second byte, the variable
+ * length fields carried, and the codec for the packet type
+ */
+//--------------------------------------------------------------------------------------------------
+struct orp_PacketTypeEntry
+{
+    uint8_t                  encoded;
+    enum orp_PacketType      decoded;
+    enum orp_Byte1Field      byte1;
+    unsigned int             fields;
+    orp_ProtocolEncode_t     encode;
+    orp_PacketHeaderDecode_t headerDecode;
+    orp_FieldsDecode_t       fieldsDecode;
+    orp_FieldsDecode_t       recordFieldsDecode;
+};
 
-    { ORP_PKT_RQST_FILE_DATA,      ORP_RQST_FILE_DATA,      ORP_MASK_BYTE1_UNUSED | ORP_MASK_DATA   },
-    { ORP_PKT_RESP_FILE_DATA,      ORP_RESP_FILE_DATA,      ORP_MASK_STATUS                         },
+static const struct orp_PacketTypeEntry orp_PacketTypeTable[ORP_PACKET_TYPE_TABLE_SIZE] =
+{
+#define X(packet, encoded, decoded, byte1, fields, name)                                           \
+    [ORP_PACKET_TYPE_INDEX_##packet] = { encoded, decoded, ORP_BYTE1_##byte1, fields,             \
+                                         orp_PacketEncode_##packet,                                \
+                                         orp_PacketHeaderDecode_##packet,                          \
+                                         orp_FieldsDecode_##packet,                                \
+                                         orp_RecordFieldsDecode_##packet },
+    ORP_PACKET_SCHEMA(X)
+#undef X
+};
 
-    { ORP_PKT_NTFY_FILE_CONTROL,   ORP_NTFY_FILE_CONTROL,   ORP_MASK_EVENT                          },
-    { ORP_PKT_RESP_FILE_CONTROL,   ORP_RESP_FILE_CONTROL,   ORP_MASK_STATUS                         },
 
-    { ORP_PKT_RESP_UNKNOWN_RQST,   ORP_RESP_UNKNOWN_RQST,   ORP_MASK_NONE                           },
+//--------------------------------------------------------------------------------------------------
+/**
+ * Direct lookup of packet type table entries, by encoded (wire) byte and by enum orp_PacketType.
+ * Unused slots are NULL
+ */
+//--------------------------------------------------------------------------------------------------
+#define ORP_PACKET_TYPE_LOOKUP_SIZE 256
 
+static const struct orp_PacketTypeEntry *const orp_PacketTypeByEncoded[ORP_PACKET_TYPE_LOOKUP_SIZE] =
+{
+#define X(packet, encoded, decoded, byte1, fields, name) \
+    [encoded] = &orp_PacketTypeTable[ORP_PACKET_TYPE_INDEX_##packet],
+    ORP_PACKET_SCHEMA(X)
+#undef X
 };
 
-#define ORP_PACKET_TYPE_TABLE_SIZE (sizeof(orp_PacketTypeTable) / sizeof(orp_PacketTypeTable[0]))
+static const struct orp_PacketTypeEntry *const orp_PacketTypeByDecoded[ORP_PACKET_TYPE_LOOKUP_SIZE] =
+{
+#define X(packet, encoded, decoded, byte1, fields, name) \
+    [decoded] = &orp_PacketTypeTable[ORP_PACKET_TYPE_INDEX_##packet],
+    ORP_PACKET_SCHEMA(X)
+#undef X
+};
 
-static uint16_t last_received_seq_number = 0;
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -284,12 +267,9 @@ static struct
 }
 orp_DataTypeTable[] =
 {
-    { ORP_DATA_TYPE_TRIGGER,  ORP_IO_DATA_TYPE_TRIGGER, },
-    { ORP_DATA_TYPE_BOOLEAN,  ORP_IO_DATA_TYPE_BOOLEAN, },
-    { ORP_DATA_TYPE_NUMERIC,  ORP_IO_DATA_TYPE_NUMERIC, },
-    { ORP_DATA_TYPE_STRING,   ORP_IO_DATA_TYPE_STRING,  },
-    { ORP_DATA_TYPE_JSON,     ORP_IO_DATA_TYPE_JSON,    },
-    { ORP_DATA_TYPE_UNDEF,    ORP_IO_DATA_TYPE_UNDEF,   },
+#define X(name, encoded, decoded, keyword)  { ORP_DATA_TYPE_##name, decoded, },
+    ORP_DATA_TYPE_SCHEMA(X)
+#undef X
 };
 
 #define ORP_DATA_TYPE_TABLE_SIZE (sizeof(orp_DataTypeTable) / sizeof(orp_DataTypeTable[0]))
@@ -312,7 +292,9 @@ static void orp_MessageInInit
     msg->type     = ORP_PACKET_TYPE_UNKNOWN;
     msg->dataType = ORP_IO_DATA_TYPE_UNDEF;
     msg->path     = emptyStr;
+    msg->pathId   = ORP_PATH_ID_NONE;
     msg->unit     = emptyStr;
+    msg->time.seconds = ORP_TIME_SECONDS_INVALID;
 }
 
 
@@ -333,83 +315,57 @@ void orp_MessageInit
     msg->type = type;
     msg->status = status;
     msg->timestamp = ORP_TIMESTAMP_INVALID;
+    msg->time.seconds = ORP_TIME_SECONDS_INVALID;
     // These are ignored by the encoder if < 0
     msg->sentCount = -1;
     msg->receivedCount = -1;
     msg->mtu = -1;
+    msg->pathId = ORP_PATH_ID_NONE;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Test whether or not a field is required for a given packet type
+ * Find the packet type table entry for a decoded packet type
+ *
+ * @return: entry, or NULL if the packet type is not recognized
  */
 //--------------------------------------------------------------------------------------------------
-static bool orp_FieldRequired
+static const struct orp_PacketTypeEntry *orp_PacketTypeLookup
 (
-    enum orp_PacketType ptype,
-    unsigned int fieldMask
+    enum orp_PacketType ptype
 )
 //--------------------------------------------------------------------------------------------------
 {
-    for (unsigned int i = 0; i < ORP_PACKET_TYPE_TABLE_SIZE; i++)
+    if ((unsigned int)ptype >= ORP_PACKET_TYPE_LOOKUP_SIZE)
     {
-        if (orp_PacketTypeTable[i].decoded == ptype)
-        {
-            return (orp_PacketTypeTable[i].required & fieldMask) ? true : false;
-        }
+        return NULL;
     }
-    return false;
+    return orp_PacketTypeByDecoded[ptype];
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Decode the packet type from a packet buffer
+ * Public utility to number an outbound message, from the sequence number last received
  */
 //--------------------------------------------------------------------------------------------------
-static bool orp_PacketTypeDecode
+uint16_t orp_PacketSequenceNext
 (
-    uint8_t *buf,
-    enum orp_PacketType *ptype
+    enum orp_PacketType type,
+    uint16_t            received
 )
 //--------------------------------------------------------------------------------------------------
 {
-    for (unsigned int i = 0; i < ORP_PACKET_TYPE_TABLE_SIZE; i++)
-    {
-        if (orp_PacketTypeTable[i].encoded == buf[ORP_OFFSET_PACKET_TYPE])
-        {
-            *ptype = orp_PacketTypeTable[i].decoded;
-            return true;
-        }
-    }
-    LE_ERROR("Failed to decode data type: 0x%02X", buf[ORP_OFFSET_DATA_TYPE]);
-    return false;
-}
+    const struct orp_PacketTypeEntry *entry = orp_PacketTypeLookup(type);
 
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Encode the packet type into a packet buffer
- */
-//--------------------------------------------------------------------------------------------------
-static bool orp_PacketTypeEncode
-(
-    uint8_t *buf,
-    enum orp_PacketType ptype
-)
-//--------------------------------------------------------------------------------------------------
-{
-    for (unsigned int i = 0; i < ORP_PACKET_TYPE_TABLE_SIZE; i++)
+    // Copy Sequence Number from Request or increment it in case of request sent by the device
+    if (entry && (entry->encoded != ORP_PKT_SYNC_SYN) && isupper(entry->encoded))
     {
-        if (orp_PacketTypeTable[i].decoded == ptype)
-        {
-            buf[ORP_OFFSET_PACKET_TYPE] = orp_PacketTypeTable[i].encoded;
-            return true;
-        }
+        // The device will send a request -> increment the Sequence Number
+        return received + 1;
     }
-    LE_ERROR("Unrecognized packet type: %d", ptype);
-    return false;
+    return received;
 }
 
 
@@ -420,7 +376,7 @@ static bool orp_PacketTypeEncode
 //--------------------------------------------------------------------------------------------------
 static bool orp_DataTypeDecode
 (
-    uint8_t             *buf,
+    const uint8_t       *buf,
     enum orp_IoDataType *dtype
 )
 //--------------------------------------------------------------------------------------------------
@@ -466,226 +422,343 @@ static bool orp_DataTypeEncode
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Encode the timestamp into a packet buffer
+ * Number of decimal digits in an unsigned value
  */
 //--------------------------------------------------------------------------------------------------
-static size_t orp_TimeEncode
+static size_t orp_DecimalDigits
 (
-    uint8_t *buf,
-    size_t   bufLen,
-    double   time
+    uint64_t value
 )
 //--------------------------------------------------------------------------------------------------
 {
-#define TIME_FMT "%lf"
-    double sec = time;
-    return (time == ORP_TIMESTAMP_INVALID) ? 0 : snprintf((char *)buf, bufLen, "%c" TIME_FMT, ORP_FIELD_ID_TIME, sec);
+    size_t count = 1;
+
+    while (value >= 10)
+    {
+        value /= 10;
+        count++;
+    }
+    return count;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Decode the timestamp from a packet buffer
+ * Length of a fixed-point timestamp once formatted, or 0 if it is invalid
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t orp_TimeDigitsLength
+(
+    const struct orp_Time *time
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (   (time->seconds < 0) || (time->seconds > ORP_TIME_SECONDS_MAX)
+        || (time->microseconds >= ORP_TIME_MICROSECONDS_PER_SECOND))
+    {
+        return 0;
+    }
+
+    // Integer digits, decimal point and decimal digits
+    return orp_DecimalDigits(time->seconds) + 1 + ORP_PROTOCOL_TIMESTAMP_DECIMAL_LEN_MAX;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Format a fixed-point timestamp, without a null terminator
  *
- * @note:  Only decimal whole numbers permitted and no longer than ORP_PROTOCOL_TIMESTAMP_LEN_MAX
+ * @return: length, or -1 if the time is invalid or the buffer too small
  */
 //--------------------------------------------------------------------------------------------------
-static bool orp_TimeDecode
+static ssize_t orp_TimeDigitsEncode
 (
-    double     *timeVal,
-    const char *timeStr
+    char                  *buf,
+    size_t                 bufLen,
+    const struct orp_Time *time
 )
 //--------------------------------------------------------------------------------------------------
 {
-    if (!timeStr)
+    if (!buf || !time)
     {
-        LE_ERROR("Null time string");
-        return false;
+        return -1;
+    }
+
+    size_t len = orp_TimeDigitsLength(time);
+    if (!len || (len > bufLen))
+    {
+        return -1;
+    }
+
+    // Fill from the least significant digit
+    size_t i = len;
+    uint32_t microseconds = time->microseconds;
+    for (int digit = 0; digit < ORP_PROTOCOL_TIMESTAMP_DECIMAL_LEN_MAX; digit++)
+    {
+        buf[--i] = '0' + (microseconds % 10);
+        microseconds /= 10;
+    }
+    buf[--i] = '.';
+
+    int64_t seconds = time->seconds;
+    while (i)
+    {
+        buf[--i] = '0' + (seconds % 10);
+        seconds /= 10;
+    }
+
+    return len;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Format a fixed-point timestamp as a protocol time string
+ */
+//--------------------------------------------------------------------------------------------------
+ssize_t orp_TimeFormat
+(
+    char                  *buf,
+    size_t                 bufLen,
+    const struct orp_Time *time
+)
+//--------------------------------------------------------------------------------------------------
+{
+    // + 1 for the null terminator
+    ssize_t len = orp_TimeDigitsEncode(buf, bufLen ? bufLen - 1 : 0, time);
+
+    if (len >= 0)
+    {
+        buf[len] = '\0';
     }
+    return len;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse a protocol time string into a fixed-point timestamp, in a single pass
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_TimeParse
+(
+    const char      *str,
+    size_t           len,
+    struct orp_Time *time
+)
+//--------------------------------------------------------------------------------------------------
+{
+    int64_t seconds = 0;
+    uint32_t microseconds = 0;
+    int integerDigits = 0;
+    int decimalDigits = 0;
+    bool decimalPoint = false;
+
 
-    int len = strnlen(timeStr, ORP_PROTOCOL_TIMESTAMP_LEN_MAX + 1);
-    if (0 == len || len > ORP_PROTOCOL_TIMESTAMP_LEN_MAX)
+    if (!str || !time)
     {
-        LE_ERROR("Invalid length time string: %d", len);
+        LE_ERROR("Null time string");
         return false;
     }
 
-    int decimalIndex = -1;
-    for (unsigned int i = 0; i < strlen(timeStr); i++)
+    for (size_t i = 0; (i < len) && str[i]; i++)
     {
-        if (!isdigit(timeStr[i]))
+        char c = str[i];
+
+        if (i >= ORP_PROTOCOL_TIMESTAMP_LEN_MAX)
+        {
+            LE_ERROR("Invalid length time string: > %d", ORP_PROTOCOL_TIMESTAMP_LEN_MAX);
+            return false;
+        }
+
+        if (('0' <= c) && (c <= '9'))
         {
-            // One decimal point is fine, any more is obviously wrong
-            if (('.' == timeStr[i]) && (decimalIndex < 0))
+            if (decimalPoint)
             {
-                decimalIndex = i;
+                if (++decimalDigits > ORP_PROTOCOL_TIMESTAMP_DECIMAL_LEN_MAX)
+                {
+                    LE_ERROR("Time resolution exceeds 10^-%d", ORP_PROTOCOL_TIMESTAMP_DECIMAL_LEN_MAX);
+                    return false;
+                }
+                microseconds = (microseconds * 10) + (c - '0');
             }
             else
             {
-                LE_ERROR("Invalid character in time string: %c", timeStr[i]);
-                return false;
+                if (++integerDigits > ORP_PROTOCOL_TIMESTAMP_INTEGER_LEN_MAX)
+                {
+                    LE_ERROR("Time magnitude exceedes 10^%d - 1", ORP_PROTOCOL_TIMESTAMP_INTEGER_LEN_MAX);
+                    return false;
+                }
+                seconds = (seconds * 10) + (c - '0');
             }
         }
-    }
-
-    if (decimalIndex < 0)
-    {
-        // There are no digits to the right of the decimal
-        decimalIndex = strlen(timeStr);
-    }
-    else
-    {
-        // Check the number of decimal digits - ie. to the right of the decimal point
-        if ((strlen(timeStr) - decimalIndex - 1) > ORP_PROTOCOL_TIMESTAMP_DECIMAL_LEN_MAX)
+        // One decimal point is fine, any more is obviously wrong
+        else if (('.' == c) && !decimalPoint)
+        {
+            decimalPoint = true;
+        }
+        else
         {
-            LE_ERROR("Time resolution exceeds 10^-%d", ORP_PROTOCOL_TIMESTAMP_DECIMAL_LEN_MAX);
+            LE_ERROR("Invalid character in time string: %c", c);
             return false;
         }
     }
-    // Check the number of integral digits - ie. to the left of the decimal point
-    if (decimalIndex > ORP_PROTOCOL_TIMESTAMP_INTEGER_LEN_MAX)
+
+    if (!integerDigits && !decimalDigits)
     {
-        LE_ERROR("Time magnitude exceedes 10^%d - 1", ORP_PROTOCOL_TIMESTAMP_INTEGER_LEN_MAX);
+        LE_ERROR("Failed to decode time string: %.*s", (int)len, str);
         return false;
     }
 
-    char *endPtr;
-    errno = 0;
-    *timeVal = strtod(timeStr, &endPtr);
-    if (endPtr == timeStr)
+    // Scale the fraction to microseconds
+    for (; decimalDigits < ORP_PROTOCOL_TIMESTAMP_DECIMAL_LEN_MAX; decimalDigits++)
     {
-        LE_ERROR("Failed to decode time string: %s", timeStr);
-        return false;
+        microseconds *= 10;
     }
 
+    time->seconds = seconds;
+    time->microseconds = microseconds;
     return true;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Encode the path into a protocol buffer
+ * Convert a timestamp in seconds to fixed-point
  */
 //--------------------------------------------------------------------------------------------------
-static ssize_t orp_PathEncode
+bool orp_TimeFromDouble
 (
-    uint8_t    *buf,
-    size_t      bufLen,
-    const char *path
+    double           seconds,
+    struct orp_Time *time
 )
 //--------------------------------------------------------------------------------------------------
 {
-    size_t len = 0;
-
-
-    if (path)
+    // Written to also reject NaN
+    if (!(seconds >= 0) || !(seconds < (double)(ORP_TIME_SECONDS_MAX + 1)))
     {
-        len = strlen(path);
+        return false;
+    }
 
-        // + 1 for ID byte, no null terminator
-        if (len + 1 > bufLen)
-        {
-            LE_ERROR("Insufficient buffer size %zu", bufLen);
-            return -1;
-        }
+    int64_t whole = (int64_t)seconds;
+    int64_t microseconds = (int64_t)(((seconds - whole) * ORP_TIME_MICROSECONDS_PER_SECOND) + 0.5);
 
-        memmove(buf + 1, path, len);
-        *buf = ORP_FIELD_ID_PATH;
-        len++;
+    if (microseconds >= ORP_TIME_MICROSECONDS_PER_SECOND)
+    {
+        whole++;
+        microseconds -= ORP_TIME_MICROSECONDS_PER_SECOND;
+    }
+    if (whole > ORP_TIME_SECONDS_MAX)
+    {
+        return false;
     }
 
-    return len;
+    time->seconds = whole;
+    time->microseconds = (uint32_t)microseconds;
+    return true;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Encode data into a packet
+ * Convert a fixed-point timestamp to seconds
  */
 //--------------------------------------------------------------------------------------------------
-static ssize_t orp_DataEncode
+double orp_TimeToDouble
 (
-    uint8_t *buf,
-    size_t   bufLen,
-    uint8_t *data,
-    size_t   dataLen
+    const struct orp_Time *time
 )
 //--------------------------------------------------------------------------------------------------
 {
-    if (data && dataLen)
-    {
-        // Allow encoding of less than dataLen in order to support multi-packet transactions
-        dataLen = MIN(bufLen - 1, dataLen);
-
-        // + 1 for ID byte, no null terminator
-        memmove(buf + 1, data, dataLen);
-        *buf = ORP_FIELD_ID_DATA;
-        dataLen++;
-    }
-
-    return (ssize_t)dataLen;
+    return (double)time->seconds + ((double)time->microseconds / ORP_TIME_MICROSECONDS_PER_SECOND);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Encode the status enum into an ascii packet
+ * Encode the timestamp into a packet buffer
+ *
+ * @return: field length, 0 if there is no timestamp, or -1 on failure
  */
 //--------------------------------------------------------------------------------------------------
-static bool orp_StatusEncode
+static ssize_t orp_TimeEncode
 (
-    uint8_t *buf,
-    int      status
+    uint8_t               *buf,
+    size_t                 bufLen,
+    const struct orp_Time *time,
+    bool                   delta
 )
 //--------------------------------------------------------------------------------------------------
 {
-    buf[ORP_OFFSET_STATUS] = (uint8_t)((int)ORP_RESP_STATUS_OK - status);
-    return true;
+    size_t prefixLen = delta ? 2 : 1;
+    ssize_t len;
+
+
+    if (ORP_TIME_SECONDS_INVALID == time->seconds)
+    {
+        return 0;
+    }
+
+    // + 1 for ID byte and any delta marker, no null terminator
+    len = (bufLen > prefixLen) ?
+          orp_TimeDigitsEncode((char *)buf + prefixLen, bufLen - prefixLen, time) : -1;
+    if (len < 0)
+    {
+        LE_ERROR("Failed to encode time, buffer size %zu", bufLen);
+        return -1;
+    }
+    buf[0] = ORP_FIELD_ID_TIME;
+    if (delta)
+    {
+        buf[1] = '+';
+    }
+
+    return len + prefixLen;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Decode the status byte from a packet
+ * Decode the timestamp from a packet buffer
+ *
+ * @note:  Only decimal whole numbers permitted and no longer than ORP_PROTOCOL_TIMESTAMP_LEN_MAX,
+ *         after any delta marker
  */
 //--------------------------------------------------------------------------------------------------
-static bool orp_StatusDecode
+static bool orp_TimeDecode
 (
-    uint8_t *buf,
-    int     *status
+    struct orp_Time *time,
+    bool            *delta,
+    const char      *timeStr
 )
 //--------------------------------------------------------------------------------------------------
 {
-    *status = ((int)ORP_RESP_STATUS_OK - (int)buf[ORP_OFFSET_STATUS]);
-    return true;
+    *delta = ('+' == timeStr[0]);
+    return orp_TimeParse(timeStr + (*delta ? 1 : 0), ORP_PROTOCOL_TIMESTAMP_LEN_MAX + 1, time);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Encode an enum as an ASCII character:
- *      0:15 -> '0':'F'
- *     16:35 -> 'G':'Z'
+ * Resolve the timestamp of an outgoing message: the fixed-point time if set, otherwise the
+ * floating point timestamp
+ *
+ * @return: false if the floating point timestamp is out of range
  */
 //--------------------------------------------------------------------------------------------------
-static bool orp_EnumEncode
+static bool orp_MessageTimeGet
 (
-    uint8_t *buf,
-    unsigned int offset,
-    int enumValue
+    const struct orp_Message *msg,
+    struct orp_Time          *time
 )
 //--------------------------------------------------------------------------------------------------
 {
-    if (enumValue <= 9)
-    {
-        buf[offset] = '0' + enumValue;
-    }
-    else if (10 <= enumValue && enumValue <= 35)
-    {
-        buf[offset] = 'A' + (enumValue - 10);
-    }
-    else
+    *time = msg->time;
+    if (   (ORP_TIME_SECONDS_INVALID == time->seconds)
+        && (ORP_TIMESTAMP_INVALID != msg->timestamp)
+        && !orp_TimeFromDouble(msg->timestamp, time))
     {
+        LE_ERROR("Timestamp out of range: %lf", msg->timestamp);
         return false;
     }
     return true;
@@ -694,15 +767,152 @@ static bool orp_EnumEncode
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Decode an ASCII character as an enum:
- *     '0':'F' ->  0:15
- *     'G':'Z' -> 16:35
+ * Encode a string field, such as the path, into a protocol buffer
  */
 //--------------------------------------------------------------------------------------------------
-static bool orp_EnumDecode
+static ssize_t orp_StringFieldEncode
+(
+    uint8_t    *buf,
+    size_t      bufLen,
+    uint8_t     fieldId,
+    const char *str
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t len = 0;
+
+
+    if (str)
+    {
+        len = strlen(str);
+
+        // + 1 for ID byte, no null terminator
+        if (len + 1 > bufLen)
+        {
+            LE_ERROR("Insufficient buffer size %zu", bufLen);
+            return -1;
+        }
+
+        memmove(buf + 1, str, len);
+        *buf = fieldId;
+        len++;
+    }
+
+    return len;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode data into a packet
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t orp_DataEncode
+(
+    uint8_t *buf,
+    size_t   bufLen,
+    uint8_t *data,
+    size_t   dataLen
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (!data || !dataLen)
+    {
+        return 0;
+    }
+    if (bufLen < 1)
+    {
+        LE_ERROR("Insufficient buffer size %zu", bufLen);
+        return -1;
+    }
+
+    // Allow encoding of less than dataLen in order to support multi-packet transactions
+    dataLen = MIN(bufLen - 1, dataLen);
+
+    // + 1 for ID byte, no null terminator
+    memmove(buf + 1, data, dataLen);
+    *buf = ORP_FIELD_ID_DATA;
+
+    return (ssize_t)dataLen + 1;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode the status enum into an ascii packet
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_StatusEncode
+(
+    uint8_t *buf,
+    int      status
+)
+//--------------------------------------------------------------------------------------------------
+{
+    buf[ORP_OFFSET_STATUS] = (uint8_t)((int)ORP_RESP_STATUS_OK - status);
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode the status byte from a packet
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_StatusDecode
+(
+    const uint8_t *buf,
+    int           *status
+)
+//--------------------------------------------------------------------------------------------------
+{
+    *status = ((int)ORP_RESP_STATUS_OK - (int)buf[ORP_OFFSET_STATUS]);
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode an enum as an ASCII character:
+ *      0:15 -> '0':'F'
+ *     16:35 -> 'G':'Z'
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_EnumEncode
 (
     uint8_t *buf,
     unsigned int offset,
+    int enumValue
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (enumValue <= 9)
+    {
+        buf[offset] = '0' + enumValue;
+    }
+    else if (10 <= enumValue && enumValue <= 35)
+    {
+        buf[offset] = 'A' + (enumValue - 10);
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode an ASCII character as an enum:
+ *     '0':'F' ->  0:15
+ *     'G':'Z' -> 16:35
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_EnumDecode
+(
+    const uint8_t *buf,
+    unsigned int offset,
     int *value
 )
 //--------------------------------------------------------------------------------------------------
@@ -734,42 +944,42 @@ static bool orp_EnumDecode
  * Response: status
  * Sync:     version number
  *
- * @note: Message type field must be valid
+ * @note: byte1 is a constant in each packet type's encoder, so the switch folds away
  */
 //--------------------------------------------------------------------------------------------------
-static bool orp_PacketByte1Encode
+static inline bool orp_PacketByte1Encode
 (
-    uint8_t            *buf,
-    struct orp_Message *msg
+    uint8_t             *buf,
+    enum orp_Byte1Field  byte1,
+    struct orp_Message  *msg
 )
 //--------------------------------------------------------------------------------------------------
 {
     bool status = true;
 
-    do
+    switch (byte1)
     {
-        if (orp_FieldRequired(msg->type, ORP_MASK_STATUS))
-        {
+        case ORP_BYTE1_STATUS:
             status = orp_StatusEncode(buf, msg->status);
             break;
-        }
-        if (orp_FieldRequired(msg->type, ORP_MASK_DATA_TYPE))
-        {
+
+        case ORP_BYTE1_DATA_TYPE:
             status = orp_DataTypeEncode(buf, msg->dataType);
             break;
-        }
-        if (orp_FieldRequired(msg->type, ORP_MASK_VERSION))
-        {
+
+        case ORP_BYTE1_VERSION:
             status = orp_EnumEncode(buf, 1, ORP_PROTOCOL_V2);
             break;
-        }
-        if (orp_FieldRequired(msg->type, ORP_MASK_EVENT))
-        {
+
+        case ORP_BYTE1_EVENT:
             status = orp_EnumEncode(buf, 1, msg->status);
             break;
-        }
 
-    } while (0);
+        default:
+            // Unused
+            buf[1] = 0;
+            break;
+    }
 
     if (!status)
     {
@@ -787,48 +997,44 @@ static bool orp_PacketByte1Encode
  * Response: status
  * Sync:     version number
  *
- * @note: Message type field must be valid
+ * @note: byte1 is a constant in each packet type's header decoder, so the switch folds away
  */
 //--------------------------------------------------------------------------------------------------
-static bool orp_PacketByte1Decode
+static inline bool orp_PacketByte1Decode
 (
-    uint8_t            *buf,
-    struct orp_Message *msg
+    const uint8_t       *buf,
+    enum orp_Byte1Field  byte1,
+    struct orp_Message  *msg
 )
 //--------------------------------------------------------------------------------------------------
 {
     bool status = false;
-    do
+
+    switch (byte1)
     {
-        // Check if the byte1 is unused
-        if (orp_FieldRequired(msg->type, ORP_MASK_BYTE1_UNUSED))
-        {
+        case ORP_BYTE1_UNUSED:
             // Byte 1 is unused
             return true;
-        }
 
-        if (orp_FieldRequired(msg->type, ORP_MASK_STATUS))
-        {
+        case ORP_BYTE1_STATUS:
             status = orp_StatusDecode(buf, &msg->status);
             break;
-        }
-        if (orp_FieldRequired(msg->type, ORP_MASK_DATA_TYPE))
-        {
+
+        case ORP_BYTE1_DATA_TYPE:
             status = orp_DataTypeDecode(buf, &msg->dataType);
             break;
-        }
-        if (orp_FieldRequired(msg->type, ORP_MASK_VERSION))
-        {
+
+        case ORP_BYTE1_VERSION:
             status = orp_EnumDecode(buf, 1, &msg->version);
             break;
-        }
-        if (orp_FieldRequired(msg->type, ORP_MASK_EVENT))
-        {
+
+        case ORP_BYTE1_EVENT:
             status = orp_EnumDecode(buf, 1, &msg->status);
             break;
-        }
 
-    } while (0);
+        default:
+            break;
+    }
 
     if (!status)
     {
@@ -840,28 +1046,112 @@ static bool orp_PacketByte1Decode
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Encode the maximum transfer size into a protocol buffer
+ * Encode a field made of an ID byte and a non-negative decimal value.  No null terminator
+ *
+ * @return: field length, or -1 on failure
  */
 //--------------------------------------------------------------------------------------------------
-static ssize_t orp_MtuEncode
+static ssize_t orp_DecimalFieldEncode
 (
     uint8_t *buf,
     size_t   bufLen,
-    int      mtu
+    uint8_t  fieldId,
+    int      value
 )
 //--------------------------------------------------------------------------------------------------
 {
-    ssize_t len = snprintf((char *)buf, bufLen, "%c%d", ORP_FIELD_ID_MTU, mtu);
+    if (value < 0)
+    {
+        return -1;
+    }
+
+    // + 1 for ID byte
+    size_t len = 1 + orp_DecimalDigits(value);
+    if (bufLen < len)
+    {
+        LE_ERROR("Insufficient buffer size for field %c: %zu", fieldId, bufLen);
+        return -1;
+    }
 
-    if (bufLen <= (size_t)len)
+    buf[0] = fieldId;
+    for (size_t i = len - 1; i > 0; i--)
     {
-        LE_ERROR("Insufficient buffer size for mtu: %zu", bufLen);
-        len = -1;
+        buf[i] = '0' + (value % 10);
+        value /= 10;
     }
     return len;
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode the non-negative decimal value of a field, after its ID byte.  The value must be digits
+ * only, up to the next separator or the end of the packet, as parsed by orp_ViewInt()
+ *
+ * @note: buf[bufLen] must be null, as the value is parsed before the field is null-terminated
+ *
+ * @return: false if the value is malformed or greater than max
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_DecimalFieldDecode
+(
+    const uint8_t *buf,
+    size_t         bufLen,
+    unsigned long  max,
+    unsigned long *value
+)
+//--------------------------------------------------------------------------------------------------
+{
+    char *endPtr;
+
+
+    if (!bufLen || !isdigit(buf[0]))
+    {
+        return false;
+    }
+
+    errno = 0;
+    *value = strtoul((const char *)buf, &endPtr, 10);
+    return    (0 == errno)
+           && (*value <= max)
+           && (((const uint8_t *)endPtr == buf + bufLen) || (ORP_VARLENGTH_SEPARATOR == *endPtr));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode the path identifier into a protocol buffer
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t orp_PathIdEncode
+(
+    uint8_t *buf,
+    size_t   bufLen,
+    int      pathId
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return orp_DecimalFieldEncode(buf, bufLen, ORP_FIELD_ID_PATH_ID, pathId);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode the maximum transfer size into a protocol buffer
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t orp_MtuEncode
+(
+    uint8_t *buf,
+    size_t   bufLen,
+    int      mtu
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return orp_DecimalFieldEncode(buf, bufLen, ORP_FIELD_ID_MTU, mtu);
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Encode the sent count into a protocol buffer
@@ -875,7 +1165,7 @@ static ssize_t orp_SentCountEncode
 )
 //--------------------------------------------------------------------------------------------------
 {
-    return (count < 0) ? -1 : snprintf((char *)buf, bufLen, "%c%d", ORP_FIELD_ID_SENT_COUNT, count);
+    return orp_DecimalFieldEncode(buf, bufLen, ORP_FIELD_ID_SENT_COUNT, count);
 }
 
 
@@ -892,345 +1182,2959 @@ static ssize_t orp_ReceivedCountEncode
 )
 //--------------------------------------------------------------------------------------------------
 {
-    return (count < 0) ? -1 : snprintf((char *)buf, bufLen, "%c%d", ORP_FIELD_ID_RECV_COUNT, count);
+    return orp_DecimalFieldEncode(buf, bufLen, ORP_FIELD_ID_RECV_COUNT, count);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Decode a request from a buffer formatted according to version 1 of the protocol
+ * Encode the capability flags into a protocol buffer
  */
 //--------------------------------------------------------------------------------------------------
-static bool orp_ProtocolDecode_v1
+static ssize_t orp_CapabilitiesEncode
 (
-    uint8_t            *pktBuf,
-    size_t              pktLen,
-    struct orp_Message *msg
+    uint8_t      *buf,
+    size_t        bufLen,
+    unsigned int  capabilities
 )
 //--------------------------------------------------------------------------------------------------
 {
-    enum { SEARCH, INFIELD, DONE, ERROR } state = ERROR;
-    const char *timeStr = NULL;
-    unsigned int offset = 0;
+    return orp_DecimalFieldEncode(buf, bufLen, ORP_FIELD_ID_CAPABILITIES, (int)capabilities);
+}
 
 
-    LE_ASSERT(pktBuf && msg);
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode the status of a record into a protocol buffer, as its magnitude
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t orp_StatusFieldEncode
+(
+    uint8_t *buf,
+    size_t   bufLen,
+    int      status
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return orp_DecimalFieldEncode(buf, bufLen, ORP_FIELD_ID_STATUS, -status);
+}
 
-    do
-    {
-        if (pktLen < ORP_PACKET_LEN_MIN)
-        {
-            LE_ERROR("Packet too short: %zu", pktLen);
-            break;
-        }
 
-        orp_MessageInInit(msg);
+/* Binary encoding
+ *
+ * The fixed length fields are as in the ASCII encoding.  Each variable length field is a tag byte,
+ * followed by its value, with no separators.  Fields may be in any order:
+ *
+ *   path:     P<varint length><path bytes>
+ *   path id:  I<varint>
+ *   unit:     U<varint length><unit bytes>
+ *   data:     D<varint length><data bytes>
+ *   time:     T<varint (seconds << 1) | has microseconds>[<varint microseconds>]
+ *   time delta: t<as time>, a delta from the session time base.  See ORP_CAPABILITY_TIME_DELTA
+ *   mtu:      M<varint>
+ *   sent:     S<varint>
+ *   received: R<varint>
+ *   capabilities: C<varint>
+ *   record:   N<varint length><fields>
+ *   status:   E<varint magnitude>
+ *
+ * Numeric data may instead be sent as IEEE-754, big-endian, when the value converts back to the
+ * same text and the binary form is shorter:
+ *
+ *   numeric:  f<4 byte float> | F<8 byte double>
+ *
+ * Varints are unsigned LEB128: 7 bits per byte, least significant first, the top bit set on all
+ * but the last byte
+ */
 
-        // Fixed length fields
-        if (!orp_PacketTypeDecode(pktBuf, &msg->type))
-        {
-            LE_ERROR("Failed to decode packet type: %d", msg->type);
-            offset = ORP_OFFSET_PACKET_TYPE;
-            break;
+// Binary encoding field tags, in addition to the variable length field identifiers
+#define  ORP_BINARY_TAG_FLOAT32   'f'
+#define  ORP_BINARY_TAG_FLOAT64   'F'
+#define  ORP_BINARY_TAG_TIME_DELTA 't'
+
+// Maximum length of a varint encoding a 64-bit value
+#define  ORP_VARINT_LEN_MAX       10
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of bytes of the varint encoding of a value
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t orp_VarintLength
+(
+    uint64_t value
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t len = 1;
+
+    while (value >= 0x80)
+    {
+        value >>= 7;
+        len++;
+    }
+    return len;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode a value as a varint
+ *
+ * @return: varint length, or -1 if the buffer is too small
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t orp_VarintEncode
+(
+    uint8_t *buf,
+    size_t   bufLen,
+    uint64_t value
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t len = 0;
+
+    do
+    {
+        if (len >= bufLen)
+        {
+            LE_ERROR("Insufficient buffer size %zu", bufLen);
+            return -1;
+        }
+        buf[len++] = (value & 0x7F) | ((value >= 0x80) ? 0x80 : 0);
+        value >>= 7;
+    } while (value);
+
+    return len;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode a varint
+ *
+ * @return: varint length, or -1 if it is truncated or exceeds 64 bits
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t orp_VarintDecode
+(
+    const uint8_t *buf,
+    size_t         bufLen,
+    uint64_t      *value
+)
+//--------------------------------------------------------------------------------------------------
+{
+    uint64_t result = 0;
+
+    for (size_t i = 0; (i < bufLen) && (i < ORP_VARINT_LEN_MAX); i++)
+    {
+        uint64_t bits = buf[i] & 0x7F;
+
+        // The tenth byte holds only the top bit
+        if ((ORP_VARINT_LEN_MAX - 1 == i) && (bits > 1))
+        {
+            break;
         }
-        if (!orp_PacketByte1Decode(pktBuf, msg))
+        result |= bits << (7 * i);
+        if (!(buf[i] & 0x80))
+        {
+            *value = result;
+            return i + 1;
+        }
+    }
+
+    LE_ERROR("Invalid varint");
+    return -1;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode a fixed-point timestamp in binary: the varint of the seconds, shifted left by one and
+ * flagged in bit 0 if followed by the varint of the microseconds
+ *
+ * @return: length, or -1 on failure
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t orp_BinaryTimeEncode
+(
+    uint8_t               *buf,
+    size_t                 bufLen,
+    const struct orp_Time *time
+)
+//--------------------------------------------------------------------------------------------------
+{
+    ssize_t len;
+    ssize_t usLen = 0;
+
+
+    if (   (time->seconds < 0) || (time->seconds > ORP_TIME_SECONDS_MAX)
+        || (time->microseconds >= ORP_TIME_MICROSECONDS_PER_SECOND))
+    {
+        LE_ERROR("Invalid time");
+        return -1;
+    }
+
+    len = orp_VarintEncode(buf, bufLen,
+                           ((uint64_t)time->seconds << 1) | (time->microseconds ? 1 : 0));
+    if ((len > 0) && time->microseconds)
+    {
+        usLen = orp_VarintEncode(buf + len, bufLen - len, time->microseconds);
+    }
+
+    return ((len < 0) || (usLen < 0)) ? -1 : len + usLen;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of bytes of the binary encoding of a fixed-point timestamp
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t orp_BinaryTimeLength
+(
+    const struct orp_Time *time
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return orp_VarintLength(((uint64_t)time->seconds << 1) | (time->microseconds ? 1 : 0))
+           + (time->microseconds ? orp_VarintLength(time->microseconds) : 0);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode a binary timestamp
+ *
+ * @return: length, or -1 if it is malformed or out of range
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t orp_BinaryTimeDecode
+(
+    const uint8_t   *buf,
+    size_t           bufLen,
+    struct orp_Time *time
+)
+//--------------------------------------------------------------------------------------------------
+{
+    uint64_t seconds;
+    uint64_t microseconds = 0;
+    ssize_t len;
+    ssize_t usLen = 0;
+
+
+    len = orp_VarintDecode(buf, bufLen, &seconds);
+    if ((len > 0) && (seconds & 1))
+    {
+        usLen = orp_VarintDecode(buf + len, bufLen - len, &microseconds);
+    }
+    if (   (len < 0) || (usLen < 0)
+        || ((seconds >> 1) > ORP_TIME_SECONDS_MAX)
+        || (microseconds >= ORP_TIME_MICROSECONDS_PER_SECOND))
+    {
+        LE_ERROR("Failed to decode time");
+        return -1;
+    }
+
+    time->seconds = seconds >> 1;
+    time->microseconds = microseconds;
+    return len + usLen;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode a binary non-negative integer field, no greater than INT_MAX
+ *
+ * @return: length, or -1 on failure
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t orp_BinaryIntDecode
+(
+    const uint8_t *buf,
+    size_t         bufLen,
+    int           *value
+)
+//--------------------------------------------------------------------------------------------------
+{
+    uint64_t result;
+    ssize_t len = orp_VarintDecode(buf, bufLen, &result);
+
+    if ((len < 0) || (result > INT_MAX))
+    {
+        LE_ERROR("Invalid integer field");
+        return -1;
+    }
+    *value = (int)result;
+    return len;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Format a number as the shortest text which converts back to the same value
+ *
+ * @return: text length
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t orp_NumericFormat
+(
+    char   *buf,
+    size_t  bufLen,
+    double  value
+)
+//--------------------------------------------------------------------------------------------------
+{
+    for (int precision = 1; precision <= DBL_DECIMAL_DIG; precision++)
+    {
+        snprintf(buf, bufLen, "%.*g", precision, value);
+        if (strtod(buf, NULL) == value)
         {
-            offset = ORP_OFFSET_DATA_TYPE;
             break;
         }
+    }
+    return strlen(buf);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether numeric data can be sent in binary without loss, and more compactly than text
+ *
+ * @return: IEEE-754 width to send the value with, 4 or 8, or 0 to send the data as text
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t orp_NumericBinaryWidth
+(
+    const struct orp_Message *msg,
+    double                   *value
+)
+//--------------------------------------------------------------------------------------------------
+{
+    char text[ORP_PROTOCOL_NUMERIC_LEN_MAX + 1];
+    char shortest[ORP_PROTOCOL_NUMERIC_LEN_MAX + 1];
+    char *end;
+    size_t width;
+
+
+    if (   (ORP_IO_DATA_TYPE_NUMERIC != msg->dataType)
+        || !msg->data || !msg->dataLen || (msg->dataLen > ORP_PROTOCOL_NUMERIC_LEN_MAX))
+    {
+        return 0;
+    }
+
+    memcpy(text, msg->data, msg->dataLen);
+    text[msg->dataLen] = '\0';
+    *value = strtod(text, &end);
+    if (   (end != &text[msg->dataLen])
+        || (orp_NumericFormat(shortest, sizeof(shortest), *value) != msg->dataLen)
+        || strcmp(text, shortest))
+    {
+        return 0;
+    }
+
+    width = ((*value >= -FLT_MAX) && (*value <= FLT_MAX) && ((double)(float)*value == *value))
+            ? sizeof(float) : sizeof(double);
+
+    return (width < msg->dataLen) ? width : 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode a number as a tagged, big-endian IEEE-754 field of the given width
+ *
+ * @return: field length, or -1 if the buffer is too small
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t orp_BinaryNumericEncode
+(
+    uint8_t *buf,
+    size_t   bufLen,
+    double   value,
+    size_t   width
+)
+//--------------------------------------------------------------------------------------------------
+{
+    uint64_t bits;
+
+
+    if (bufLen < 1 + width)
+    {
+        LE_ERROR("Insufficient buffer size %zu", bufLen);
+        return -1;
+    }
+
+    if (sizeof(float) == width)
+    {
+        float f = (float)value;
+        uint32_t b32;
+        memcpy(&b32, &f, sizeof(b32));
+        bits = b32;
+        buf[0] = ORP_BINARY_TAG_FLOAT32;
+    }
+    else
+    {
+        memcpy(&bits, &value, sizeof(bits));
+        buf[0] = ORP_BINARY_TAG_FLOAT64;
+    }
+
+    for (size_t i = width; i > 0; i--)
+    {
+        buf[i] = bits & 0xFF;
+        bits >>= 8;
+    }
+    return 1 + width;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode a big-endian IEEE-754 number of 4 or 8 bytes
+ */
+//--------------------------------------------------------------------------------------------------
+static double orp_BinaryNumericDecode
+(
+    const uint8_t *buf,
+    size_t         width
+)
+//--------------------------------------------------------------------------------------------------
+{
+    uint64_t bits = 0;
+    double value;
+
+
+    for (size_t i = 0; i < width; i++)
+    {
+        bits = (bits << 8) | buf[i];
+    }
+
+    if (sizeof(float) == width)
+    {
+        uint32_t b32 = (uint32_t)bits;
+        float f;
+        memcpy(&f, &b32, sizeof(f));
+        value = f;
+    }
+    else
+    {
+        memcpy(&value, &bits, sizeof(value));
+    }
+    return value;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode the sequence number of a received packet
+ */
+//--------------------------------------------------------------------------------------------------
+static uint16_t orp_PacketSequenceDecode
+(
+    const uint8_t *buf
+)
+//--------------------------------------------------------------------------------------------------
+{
+    // Sequence number is encoded in Big-Endian
+    return ((buf[ORP_OFFSET_SEQ_NUM] << 8) & 0xFF00) | (buf[ORP_OFFSET_SEQ_NUM + 1] & 0x00FF);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Locate the record at *offset within the records of a packet, and advance *offset to the next.
+ * Each record is its field ID and length, followed by its fields:
+ *
+ *   ASCII:   N<decimal length>:<fields>, with a separator before each record but the first
+ *   Binary:  N<varint length><fields>
+ *
+ * @return: offset of the record's fields, or -1 if the record is malformed
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t orp_RecordLocate
+(
+    const uint8_t             *buf,
+    size_t                     len,
+    enum orp_ProtocolEncoding  encoding,
+    size_t                    *offset,
+    size_t                    *recordLen
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t index = *offset;
+    uint64_t value = 0;
+    size_t end;
+
+
+    if ((index >= len) || (ORP_FIELD_ID_RECORD != buf[index++]))
+    {
+        LE_ERROR("Record expected at byte %zu", *offset);
+        return -1;
+    }
+
+    if (ORP_PROTOCOL_ENCODING_BINARY == encoding)
+    {
+        ssize_t varintLen = orp_VarintDecode(&buf[index], len - index, &value);
+        if (varintLen < 0)
+        {
+            return -1;
+        }
+        index += varintLen;
+    }
+    else
+    {
+        size_t digits = 0;
+
+        while (   (index < len) && isdigit(buf[index])
+               && (digits++ < ORP_RECORD_LENGTH_DIGITS_MAX))
+        {
+            value = (value * 10) + (buf[index++] - '0');
+        }
+        if (!digits || (index >= len) || (ORP_RECORD_LENGTH_END != buf[index++]))
+        {
+            LE_ERROR("Invalid record length at byte %zu", *offset);
+            return -1;
+        }
+    }
+
+    if (value > len - index)
+    {
+        LE_ERROR("Record length exceeds packet: %llu", (unsigned long long)value);
+        return -1;
+    }
+    *recordLen = value;
+
+    // ASCII records are separated.  The last one ends the packet
+    end = index + value;
+    if ((ORP_PROTOCOL_ENCODING_ASCII == encoding) && (end < len))
+    {
+        if ((ORP_VARLENGTH_SEPARATOR != buf[end]) || (end + 1 >= len))
+        {
+            LE_ERROR("Invalid record separator at byte %zu", end);
+            return -1;
+        }
+        end++;
+    }
+
+    *offset = end;
+    return index;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the records of a packet and count them
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_RecordsCount
+(
+    const uint8_t             *buf,
+    size_t                     len,
+    enum orp_ProtocolEncoding  encoding,
+    size_t                    *count
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t offset = 0;
+    size_t recordLen;
+
+
+    *count = 0;
+    while (offset < len)
+    {
+        if (orp_RecordLocate(buf, len, encoding, &offset, &recordLen) < 0)
+        {
+            return false;
+        }
+        (*count)++;
+    }
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Find the field of a variable length field identifier
+ *
+ * @return: the field's bit, as ORP_FIELD(), or 0 if the identifier is not recognized
+ */
+//--------------------------------------------------------------------------------------------------
+static inline unsigned int orp_FieldById
+(
+    uint8_t fieldId
+)
+//--------------------------------------------------------------------------------------------------
+{
+    switch (fieldId)
+    {
+#define X(name, id, description)  case (id): return 1u << ORP_FIELD_INDEX_##name;
+        ORP_FIELD_SCHEMA(X)
+#undef X
+        default:
+            return 0;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode the variable length fields of a packet or record, formatted according to version 1 of
+ * the protocol.  Fields are null-terminated in place, including the last, at buf[len]
+ *
+ * Specialized per packet type, as orp_PacketEncode: with fields constant, the identifiers which
+ * the packet type does not carry are rejected up front, and their cases compiled out
+ *
+ * @return: false on failure, with the offset of the error in errorOffset
+ */
+//--------------------------------------------------------------------------------------------------
+static inline bool orp_FieldsDecode
+(
+    uint8_t            *buf,
+    size_t              len,
+    struct orp_Message *msg,
+    unsigned int        fields,
+    size_t             *errorOffset
+)
+//--------------------------------------------------------------------------------------------------
+{
+    enum { SEARCH, INFIELD, DONE, ERROR } state = SEARCH;
+    const char *timeStr = NULL;
+    size_t offset;
+
+
+    /* Ensure that the last byte beyond the reported length is null.  This is to null-terminate
+     * the last field, as there is no separator at the end, before any numeric field is parsed.
+     * Doing this will not affect (binary) data as long as the length is not incremented
+     */
+    buf[len] = '\0';
+
+    /* Locate and parse variable length fields
+     * Variable length fields must begin with an identifier byte
+     */
+    for (offset = 0; offset < len && state != DONE && state != ERROR; offset++)
+    {
+        // If separator found, null-terminate current field and scan for next
+        if (ORP_VARLENGTH_SEPARATOR == buf[offset])
+        {
+            buf[offset] = '\0';
+            state = SEARCH;
+            continue;
+        }
+
+        if (SEARCH == state)
+        {
+            unsigned long value = 0;
+
+            if (!(fields & orp_FieldById(buf[offset])))
+            {
+                LE_ERROR("Unexpected field identifier buf[%zu] = %02X", offset, buf[offset]);
+                state = ERROR;
+                continue;
+            }
+
+            switch (buf[offset])
+            {
+                case ORP_FIELD_ID_PATH:
+                    msg->path = (const char *)&buf[offset + 1];
+                    state = INFIELD;
+                    break;
+
+                case ORP_FIELD_ID_TIME:
+                    timeStr = (const char *)&buf[offset + 1];
+                    state = INFIELD;
+                    break;
+
+                case ORP_FIELD_ID_UNITS:
+                    msg->unit = (const char *)&buf[offset + 1];
+                    state = INFIELD;
+                    break;
+
+                case ORP_FIELD_ID_DATA:
+                    msg->data = &buf[offset + 1];
+                    msg->dataLen = len - offset - 1;
+                    buf[len] = '\0';
+                    // Data must be last field - Stop scanning immediately
+                    state = DONE;
+                    break;
+
+                case ORP_FIELD_ID_MTU:
+                    state = INFIELD;
+                    if (!orp_DecimalFieldDecode(&buf[offset + 1], len - offset - 1, INT_MAX,
+                                                &value))
+                    {
+                        LE_ERROR("Failed to decode max transfer size");
+                        state = ERROR;
+                    }
+                    msg->mtu = (int)value;
+                    break;
+
+                case ORP_FIELD_ID_RECV_COUNT:
+                    state = INFIELD;
+                    if (!orp_DecimalFieldDecode(&buf[offset + 1], len - offset - 1, INT_MAX,
+                                                &value))
+                    {
+                        LE_ERROR("Failed to decode received count");
+                        state = ERROR;
+                    }
+                    msg->receivedCount = (int)value;
+                    break;
+
+                case ORP_FIELD_ID_SENT_COUNT:
+                    state = INFIELD;
+                    if (!orp_DecimalFieldDecode(&buf[offset + 1], len - offset - 1, INT_MAX,
+                                                &value))
+                    {
+                        LE_ERROR("Failed to decode sent count");
+                        state = ERROR;
+                    }
+                    msg->sentCount = (int)value;
+                    break;
+
+                case ORP_FIELD_ID_PATH_ID:
+                    state = INFIELD;
+                    if (!orp_DecimalFieldDecode(&buf[offset + 1], len - offset - 1,
+                                                ORP_PATH_ID_MAX, &value))
+                    {
+                        LE_ERROR("Failed to decode path identifier");
+                        state = ERROR;
+                    }
+                    msg->pathId = (int)value;
+                    break;
+
+                case ORP_FIELD_ID_CAPABILITIES:
+                    state = INFIELD;
+                    if (!orp_DecimalFieldDecode(&buf[offset + 1], len - offset - 1, INT_MAX,
+                                                &value))
+                    {
+                        LE_ERROR("Failed to decode capabilities");
+                        state = ERROR;
+                    }
+                    msg->capabilities = (unsigned int)value;
+                    break;
+
+                case ORP_FIELD_ID_STATUS:
+                    state = INFIELD;
+                    if (!orp_DecimalFieldDecode(&buf[offset + 1], len - offset - 1, INT_MAX,
+                                                &value))
+                    {
+                        LE_ERROR("Failed to decode status");
+                        state = ERROR;
+                    }
+                    msg->status = -(int)value;
+                    break;
+
+                case ORP_FIELD_ID_RECORD:
+                    // Records are the only fields of a packet which carries them.  They are
+                    // decoded by the codec's decoderecords
+                    if (   (offset > 0)
+                        || !orp_RecordsCount(&buf[offset], len - offset,
+                                             ORP_PROTOCOL_ENCODING_ASCII, &msg->recordCount))
+                    {
+                        state = ERROR;
+                        break;
+                    }
+                    msg->recordsBuf = &buf[offset];
+                    msg->recordsLen = len - offset;
+                    state = DONE;
+                    break;
+            }
+        }
+    }
+
+    /* Convert the string timestamp to double, if present.  Done here to ensure string is
+     * null terminated
+     */
+    if ((ERROR != state) && timeStr)
+    {
+        if (!orp_TimeDecode(&msg->time, &msg->timeDelta, timeStr))
+        {
+            // The offset has since been incremented.  Recalculate for time field
+            offset = (size_t)((uint8_t *)timeStr - buf) - 1;
+            state = ERROR;
+        }
+        else
+        {
+            msg->timestamp = orp_TimeToDouble(&msg->time);
+        }
+    }
+
+    *errorOffset = offset;
+    return ERROR == state ? false : true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode a request from a buffer formatted according to version 1 of the protocol
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_ProtocolDecode_v1
+(
+    uint8_t            *pktBuf,
+    size_t              pktLen,
+    struct orp_Message *msg
+)
+//--------------------------------------------------------------------------------------------------
+{
+    const struct orp_PacketTypeEntry *entry;
+    bool status = false;
+    size_t offset = 0;
+
+
+    LE_ASSERT(pktBuf && msg);
+
+    do
+    {
+        if (pktLen < ORP_PACKET_LEN_MIN)
+        {
+            LE_ERROR("Packet too short: %zu", pktLen);
+            return false;
+        }
+
+        orp_MessageInInit(msg);
+
+        // Fixed length fields, decoded by the packet type's own decoder
+        entry = orp_PacketTypeByEncoded[pktBuf[ORP_OFFSET_PACKET_TYPE]];
+        if (!entry)
+        {
+            LE_ERROR("Failed to decode packet type: 0x%02X", pktBuf[ORP_OFFSET_PACKET_TYPE]);
+            offset = ORP_OFFSET_PACKET_TYPE;
+            break;
+        }
+        if (!entry->headerDecode(pktBuf, msg))
+        {
+            offset = ORP_OFFSET_DATA_TYPE;
+            break;
+        }
+
+        msg->sequenceNum = orp_PacketSequenceDecode(pktBuf);
+
+        status = entry->fieldsDecode(&pktBuf[ORP_OFFSET_VARLENGTH], pktLen - ORP_OFFSET_VARLENGTH,
+                                     msg, &offset);
+        offset += ORP_OFFSET_VARLENGTH;
+
+    } while (0);
+
+    if (!status)
+    {
+        LE_ERROR("Failed to decode: %d %d %04X %s",
+                    msg->type, msg->dataType, msg->sequenceNum,
+                    pktBuf + ORP_OFFSET_VARLENGTH);
+
+        LE_ERROR("Error near byte %zu %s", offset,
+                offset >= ORP_OFFSET_VARLENGTH ? (char *)&pktBuf[offset] : "");
+    }
+    else
+    {
+        LE_DEBUG("Decoded: %u %d %04X path: %s time: %lf unit: %s dataLen: %zu",
+                    msg->type, msg->dataType, msg->sequenceNum,
+                    msg->path ? msg->path : "",
+                    msg->timestamp,
+                    msg->unit ? msg->unit : "",
+                    msg->dataLen);
+    }
+
+    return status;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize a message view and decode the fixed length fields of a packet into it.  These are
+ * common to all encodings
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_ViewHeaderDecode
+(
+    const uint8_t          *pktBuf,
+    size_t                  pktLen,
+    struct orp_MessageView *view
+)
+//--------------------------------------------------------------------------------------------------
+{
+    const struct orp_PacketTypeEntry *entry;
+    struct orp_Message fixed;
+
+
+    memset(view, 0, sizeof(struct orp_MessageView));
+    view->type = ORP_PACKET_TYPE_UNKNOWN;
+    view->dataType = ORP_IO_DATA_TYPE_UNDEF;
+
+    if (pktLen < ORP_PACKET_LEN_MIN)
+    {
+        LE_ERROR("Packet too short: %zu", pktLen);
+        return false;
+    }
+
+    entry = orp_PacketTypeByEncoded[pktBuf[ORP_OFFSET_PACKET_TYPE]];
+    if (!entry)
+    {
+        LE_ERROR("Failed to decode packet type: 0x%02X", pktBuf[ORP_OFFSET_PACKET_TYPE]);
+        return false;
+    }
+    orp_MessageInInit(&fixed);
+    if (!entry->headerDecode(pktBuf, &fixed))
+    {
+        return false;
+    }
+    view->type = fixed.type;
+    view->dataType = fixed.dataType;
+    view->version = fixed.version;
+    view->status = fixed.status;
+
+    view->sequenceNum = orp_PacketSequenceDecode(pktBuf);
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Locate the variable length fields of a packet or record, formatted according to version 1 of
+ * the protocol, without modifying the buffer
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_ViewFieldsLocate
+(
+    const uint8_t          *buf,
+    size_t                  len,
+    struct orp_MessageView *view
+)
+//--------------------------------------------------------------------------------------------------
+{
+    struct orp_Field *field = NULL;
+    size_t offset;
+
+
+    /* Locate variable length fields.  Each begins with an identifier byte and runs to the next
+     * separator, except data and records which run to the end
+     */
+    for (offset = 0; offset < len; offset++)
+    {
+        if (ORP_VARLENGTH_SEPARATOR == buf[offset])
+        {
+            field = NULL;
+            continue;
+        }
+
+        if (field)
+        {
+            field->len++;
+            continue;
+        }
+
+        switch (buf[offset])
+        {
+            case ORP_FIELD_ID_PATH:
+                field = &view->path;
+                break;
+
+            case ORP_FIELD_ID_TIME:
+                field = &view->time;
+                view->timeDelta = ((offset + 1) < len) && ('+' == buf[offset + 1]);
+                break;
+
+            case ORP_FIELD_ID_UNITS:
+                field = &view->unit;
+                break;
+
+            case ORP_FIELD_ID_MTU:
+                field = &view->mtu;
+                break;
+
+            case ORP_FIELD_ID_RECV_COUNT:
+                field = &view->receivedCount;
+                break;
+
+            case ORP_FIELD_ID_SENT_COUNT:
+                field = &view->sentCount;
+                break;
+
+            case ORP_FIELD_ID_PATH_ID:
+                field = &view->pathId;
+                break;
+
+            case ORP_FIELD_ID_CAPABILITIES:
+                field = &view->capabilities;
+                break;
+
+            case ORP_FIELD_ID_STATUS:
+                field = &view->recordStatus;
+                break;
+
+
+            case ORP_FIELD_ID_DATA:
+                // Data must be last field - Stop scanning immediately
+                view->data.ptr = &buf[offset + 1];
+                view->data.len = len - offset - 1;
+                return true;
+
+            case ORP_FIELD_ID_RECORD:
+            {
+                // Records are the only fields of a packet which carries them, and are located
+                // by orp_ViewRecordNext
+                size_t count;
+
+                if (   (offset > 0)
+                    || !orp_RecordsCount(&buf[offset], len - offset, ORP_PROTOCOL_ENCODING_ASCII,
+                                         &count))
+                {
+                    return false;
+                }
+                view->records.ptr = &buf[offset];
+                view->records.len = len - offset;
+                return true;
+            }
+
+            default:
+                LE_ERROR("Unknown field identifier buf[%zu] = %02X", offset, buf[offset]);
+                return false;
+        }
+        field->ptr = &buf[offset + 1];
+        field->len = 0;
+    }
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode a packet formatted according to version 1 of the protocol into a view, without
+ * modifying the packet buffer.  Variable length fields are located but not parsed
+ *
+ * @note:  As with orp_ProtocolDecode_v1, the sequence number is decoded for the reply, see
+ *         orp_PacketSequenceNext()
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_ProtocolDecodeView_v1
+(
+    const uint8_t          *pktBuf,
+    size_t                  pktLen,
+    struct orp_MessageView *view
+)
+//--------------------------------------------------------------------------------------------------
+{
+    LE_ASSERT(pktBuf && view);
+
+    if (!orp_ViewHeaderDecode(pktBuf, pktLen, view))
+    {
+        return false;
+    }
+    view->encoding = ORP_PROTOCOL_ENCODING_ASCII;
+
+    return orp_ViewFieldsLocate(&pktBuf[ORP_OFFSET_VARLENGTH], pktLen - ORP_OFFSET_VARLENGTH, view);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse the timestamp of a message view
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ViewTime
+(
+    const struct orp_MessageView *view,
+    struct orp_Time              *time
+)
+//--------------------------------------------------------------------------------------------------
+{
+    LE_ASSERT(view && time);
+
+    if (!view->time.ptr)
+    {
+        return false;
+    }
+    if (ORP_PROTOCOL_ENCODING_BINARY == view->encoding)
+    {
+        return (orp_BinaryTimeDecode(view->time.ptr, view->time.len, time) > 0);
+    }
+    // Skip the delta marker, see timeDelta
+    if (view->timeDelta)
+    {
+        return orp_TimeParse((const char *)view->time.ptr + 1, view->time.len - 1, time);
+    }
+    return orp_TimeParse((const char *)view->time.ptr, view->time.len, time);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse a non-negative integer field of a message view
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ViewInt
+(
+    const struct orp_MessageView *view,
+    const struct orp_Field       *field,
+    int                          *value
+)
+//--------------------------------------------------------------------------------------------------
+{
+    int result = 0;
+
+
+    LE_ASSERT(view && field && value);
+
+    if (!field->ptr || !field->len)
+    {
+        return false;
+    }
+    if (ORP_PROTOCOL_ENCODING_BINARY == view->encoding)
+    {
+        return (orp_BinaryIntDecode(field->ptr, field->len, value) > 0);
+    }
+
+    for (size_t i = 0; i < field->len; i++)
+    {
+        uint8_t c = field->ptr[i];
+
+        if ((c < '0') || (c > '9') || (result > (INT_MAX - (c - '0')) / 10))
+        {
+            LE_ERROR("Invalid decimal field: %.*s", (int)field->len, (const char *)field->ptr);
+            return false;
+        }
+        result = (result * 10) + (c - '0');
+    }
+
+    *value = result;
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse the data of a message view as a number
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ViewNumeric
+(
+    const struct orp_MessageView *view,
+    double                       *value
+)
+//--------------------------------------------------------------------------------------------------
+{
+    // Long enough for any double printed in full, "%f"
+    char text[DBL_MAX_10_EXP + DBL_DECIMAL_DIG + 8];
+    char *end;
+
+
+    LE_ASSERT(view && value);
+
+    if (view->numeric.ptr)
+    {
+        *value = orp_BinaryNumericDecode(view->numeric.ptr, view->numeric.len);
+        return true;
+    }
+    if (!view->data.ptr || !view->data.len || (view->data.len >= sizeof(text)))
+    {
+        return false;
+    }
+
+    memcpy(text, view->data.ptr, view->data.len);
+    text[view->data.len] = '\0';
+    *value = strtod(text, &end);
+
+    return (end == &text[view->data.len]);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode the fixed length fields of an outgoing message of a given packet type.  These are
+ * common to all encodings
+ */
+//--------------------------------------------------------------------------------------------------
+static inline bool orp_PacketHeaderEncode
+(
+    uint8_t             *packet,
+    struct orp_Message  *msg,
+    uint8_t              encoded,
+    enum orp_Byte1Field  byte1
+)
+//--------------------------------------------------------------------------------------------------
+{
+    packet[ORP_OFFSET_PACKET_TYPE] = encoded;
+    if (!orp_PacketByte1Encode(packet, byte1, msg))
+    {
+        return false;
+    }
+
+    // Sequence number is encoded in Big-Endian.  See orp_PacketSequenceNext()
+    packet[ORP_OFFSET_SEQ_NUM]     = (msg->sequenceNum & 0xFF00) >> 8;
+    packet[ORP_OFFSET_SEQ_NUM + 1] = (msg->sequenceNum & 0x00FF);
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a variable length field to an encoded size.  Each field after the first is preceded by a
+ * separator
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t orp_FieldSizeAdd
+(
+    size_t len,
+    size_t fieldLen
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return len + ((len > 0) ? 1 : 0) + fieldLen;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of bytes the variable length fields of a message will occupy once encoded according to
+ * version 1 of the protocol.  Mirrors orp_FieldsEncode field for field
+ *
+ * @return: length, or -1 if the message cannot be encoded
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t orp_FieldsSize
+(
+    const struct orp_Message *msg,
+    unsigned int              fields
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t len = 0;
+
+
+    if (fields & ORP_FIELD(TIME))
+    {
+        struct orp_Time time;
+        if (!orp_MessageTimeGet(msg, &time))
+        {
+            return -1;
+        }
+        if (ORP_TIME_SECONDS_INVALID != time.seconds)
+        {
+            size_t timeLen = orp_TimeDigitsLength(&time);
+            if (!timeLen)
+            {
+                return -1;
+            }
+            // + 1 for ID byte, and for any delta marker
+            len = orp_FieldSizeAdd(len, (msg->timeDelta ? 2 : 1) + timeLen);
+        }
+    }
+
+    if ((fields & ORP_FIELD(PATH)) && msg->path)
+    {
+        len = orp_FieldSizeAdd(len, 1 + strlen(msg->path));
+    }
+    if ((fields & ORP_FIELD(PATH_ID)) && (msg->pathId >= 0))
+    {
+        len = orp_FieldSizeAdd(len, 1 + orp_DecimalDigits(msg->pathId));
+    }
+    if ((fields & ORP_FIELD(UNITS)) && msg->unit && msg->unit[0])
+    {
+        len = orp_FieldSizeAdd(len, 1 + strlen(msg->unit));
+    }
+    if ((fields & ORP_FIELD(DATA)) && msg->data && msg->dataLen)
+    {
+        len = orp_FieldSizeAdd(len, 1 + msg->dataLen);
+    }
+    if ((fields & ORP_FIELD(MTU)) && (msg->mtu >= 0))
+    {
+        len = orp_FieldSizeAdd(len, 1 + orp_DecimalDigits(msg->mtu));
+    }
+    if ((fields & ORP_FIELD(SENT_COUNT)) && (msg->sentCount >= 0))
+    {
+        len = orp_FieldSizeAdd(len, 1 + orp_DecimalDigits(msg->sentCount));
+    }
+    if ((fields & ORP_FIELD(RECV_COUNT)) && (msg->receivedCount >= 0))
+    {
+        len = orp_FieldSizeAdd(len, 1 + orp_DecimalDigits(msg->receivedCount));
+    }
+    if ((fields & ORP_FIELD(CAPABILITIES)) && msg->capabilities)
+    {
+        len = orp_FieldSizeAdd(len, 1 + orp_DecimalDigits(msg->capabilities));
+    }
+    if ((fields & ORP_FIELD(STATUS)) && msg->status)
+    {
+        if (msg->status > 0)
+        {
+            return -1;
+        }
+        len = orp_FieldSizeAdd(len, 1 + orp_DecimalDigits(-msg->status));
+    }
+
+    if ((fields & ORP_FIELD(RECORD)) && msg->records)
+    {
+        for (size_t i = 0; i < msg->recordCount; i++)
+        {
+            ssize_t recordLen = orp_FieldsSize(&msg->records[i], ORP_RECORD_FIELDS(fields));
+            if (recordLen < 0)
+            {
+                return -1;
+            }
+            // ID byte, length and its terminator, then the fields
+            len = orp_FieldSizeAdd(len, 1 + orp_DecimalDigits(recordLen) + 1 + recordLen);
+        }
+    }
+
+    return len;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of bytes the message will occupy once encoded according to version 1 of the protocol.
+ * Mirrors orp_ProtocolEncode_v1 field for field
+ */
+//--------------------------------------------------------------------------------------------------
+size_t orp_EncodedSize
+(
+    const struct orp_Message *msg
+)
+//--------------------------------------------------------------------------------------------------
+{
+    const struct orp_PacketTypeEntry *entry;
+    ssize_t fieldsLen;
+
+
+    LE_ASSERT(msg);
+
+    entry = orp_PacketTypeLookup(msg->type);
+    if (!entry)
+    {
+        return 0;
+    }
+
+    fieldsLen = orp_FieldsSize(msg, entry->fields);
+    return (fieldsLen < 0) ? 0 : ORP_OFFSET_VARLENGTH + fieldsLen;
+}
+
+
+// Records are encoded by the fields encoder, and hold fields themselves
+static ssize_t orp_RecordEncode(uint8_t *, size_t, const struct orp_Message *, unsigned int);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode the variable length fields of an outgoing message according to version 1 of the
+ * protocol, in schema order.  Fields the caller has not provided are omitted
+ *
+ * @return: length, or -1 on failure
+ */
+//--------------------------------------------------------------------------------------------------
+static inline ssize_t orp_FieldsEncode
+(
+    uint8_t             *buf,
+    size_t               len,
+    struct orp_Message  *msg,
+    unsigned int         fields
+)
+//--------------------------------------------------------------------------------------------------
+{
+    ssize_t index = 0;
+    ssize_t fieldLen = 0;
+
+
+    // Insert separators only as needed
+    if (fields & ORP_FIELD(TIME))
+    {
+        // The fixed-point time is used if set, otherwise the floating point timestamp
+        struct orp_Time time;
+        if (!orp_MessageTimeGet(msg, &time))
+        {
+            return -1;
+        }
+
+        fieldLen = orp_TimeEncode(buf + index, len - index, &time, msg->timeDelta);
+        if (fieldLen < 0)
+        {
+            return -1;
+        }
+        index += fieldLen;
+    }
+
+    // Append status if not OK.  Records only, where it must precede data
+    if ((fields & ORP_FIELD(STATUS)) && msg->status)
+    {
+        if (index > 0)
+        {
+            buf[index++] = ORP_VARLENGTH_SEPARATOR;
+        }
+        fieldLen = orp_StatusFieldEncode(buf + index, len - index, msg->status);
+        if (fieldLen < 0)
+        {
+            return -1;
+        }
+        index += fieldLen;
+    }
+
+    // Append path if provided.  Note: zero length is permitted
+    if ((fields & ORP_FIELD(PATH)) && msg->path)
+    {
+        if (index > 0)
+        {
+            buf[index++] = ORP_VARLENGTH_SEPARATOR;
+        }
+        fieldLen = orp_StringFieldEncode(buf + index, len - index, ORP_FIELD_ID_PATH, msg->path);
+        if (fieldLen < 0)
+        {
+            return -1;
+        }
+        index += fieldLen;
+    }
+
+    // Append path identifier if provided, in place of or binding the path
+    if ((fields & ORP_FIELD(PATH_ID)) && (msg->pathId >= 0))
+    {
+        if (index > 0)
+        {
+            buf[index++] = ORP_VARLENGTH_SEPARATOR;
+        }
+        fieldLen = orp_PathIdEncode(buf + index, len - index, msg->pathId);
+        if (fieldLen < 0)
+        {
+            return -1;
+        }
+        index += fieldLen;
+    }
+
+    // Append units if provided.  Zero length will be omitted
+    if ((fields & ORP_FIELD(UNITS)) && msg->unit && msg->unit[0])
+    {
+        if (index > 0)
+        {
+            buf[index++] = ORP_VARLENGTH_SEPARATOR;
+        }
+        fieldLen = orp_StringFieldEncode(buf + index, len - index, ORP_FIELD_ID_UNITS, msg->unit);
+        if (fieldLen < 0)
+        {
+            return -1;
+        }
+        index += fieldLen;
+    }
+
+    // Append data if provided.  Zero length will be omitted
+    if ((fields & ORP_FIELD(DATA)) && msg->data && msg->dataLen)
+    {
+        if (index > 0)
+        {
+            buf[index++] = ORP_VARLENGTH_SEPARATOR;
+        }
+        fieldLen = orp_DataEncode(buf + index, len - index, msg->data, msg->dataLen);
+        if (fieldLen < 0)
+        {
+            return -1;
+        }
+        index += fieldLen;
+        msg->dataLen -= fieldLen;
+    }
+
+    // Version 2: Sync packets. Append MTU, sent and received counts
+    if ((fields & ORP_FIELD(MTU)) && (msg->mtu >= 0))
+    {
+        if (index > 0)
+        {
+            buf[index++] = ORP_VARLENGTH_SEPARATOR;
+        }
+        fieldLen = orp_MtuEncode(buf + index, len - index, msg->mtu);
+        if (fieldLen < 0)
+        {
+            return -1;
+        }
+        index += fieldLen;
+    }
+    if ((fields & ORP_FIELD(SENT_COUNT)) && (msg->sentCount >= 0))
+    {
+        if (index > 0)
+        {
+            buf[index++] = ORP_VARLENGTH_SEPARATOR;
+        }
+        fieldLen = orp_SentCountEncode(buf + index, len - index, msg->sentCount);
+        if (fieldLen < 0)
+        {
+            return -1;
+        }
+        index += fieldLen;
+    }
+    if ((fields & ORP_FIELD(RECV_COUNT)) && (msg->receivedCount >= 0))
+    {
+        if (index > 0)
+        {
+            buf[index++] = ORP_VARLENGTH_SEPARATOR;
+        }
+        fieldLen = orp_ReceivedCountEncode(buf + index, len - index, msg->receivedCount);
+        if (fieldLen < 0)
+        {
+            return -1;
+        }
+        index += fieldLen;
+    }
+    if ((fields & ORP_FIELD(CAPABILITIES)) && msg->capabilities)
+    {
+        if (index > 0)
+        {
+            buf[index++] = ORP_VARLENGTH_SEPARATOR;
+        }
+        fieldLen = orp_CapabilitiesEncode(buf + index, len - index, msg->capabilities);
+        if (fieldLen < 0)
+        {
+            return -1;
+        }
+        index += fieldLen;
+    }
+
+    // Batch packets: append each record
+    if ((fields & ORP_FIELD(RECORD)) && msg->records)
+    {
+        for (size_t i = 0; i < msg->recordCount; i++)
+        {
+            // Records are not truncated, so the batch must fit as a whole
+            if ((size_t)index >= len)
+            {
+                LE_ERROR("Insufficient buffer size for records: %zu", len);
+                return -1;
+            }
+            if (index > 0)
+            {
+                buf[index++] = ORP_VARLENGTH_SEPARATOR;
+            }
+            fieldLen = orp_RecordEncode(buf + index, len - index, &msg->records[i],
+                                        ORP_RECORD_FIELDS(fields));
+            if (fieldLen < 0)
+            {
+                return -1;
+            }
+            index += fieldLen;
+        }
+    }
+
+    return index;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode one record of a batch packet: its length, then its fields.  Data is not truncated to fit
+ *
+ * @return: record length, or -1 on failure
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t orp_RecordEncode
+(
+    uint8_t                  *buf,
+    size_t                    bufLen,
+    const struct orp_Message *record,
+    unsigned int              fields
+)
+//--------------------------------------------------------------------------------------------------
+{
+    // The fields encoder consumes the data length, so works on a copy
+    struct orp_Message fieldsMsg = *record;
+    ssize_t recordLen = orp_FieldsSize(record, fields);
+    ssize_t headerLen;
+
+
+    if (recordLen < 0)
+    {
+        return -1;
+    }
+
+    headerLen = orp_DecimalFieldEncode(buf, bufLen, ORP_FIELD_ID_RECORD, (int)recordLen);
+    // + 1 for the length terminator
+    if ((headerLen < 0) || (bufLen - headerLen < 1 + (size_t)recordLen))
+    {
+        LE_ERROR("Insufficient buffer size for record: %zu", bufLen);
+        return -1;
+    }
+    buf[headerLen++] = ORP_RECORD_LENGTH_END;
+
+    if (orp_FieldsEncode(buf + headerLen, recordLen, &fieldsMsg, fields) != recordLen)
+    {
+        return -1;
+    }
+    return headerLen + recordLen;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode an outgoing message of a given packet type according to version 1 of the protocol
+ *
+ * Each packet type's encoder calls this with its own schema entry as constants, so that only
+ * the fields the packet type carries are compiled into it.  Fields the caller has not provided
+ * are omitted
+ */
+//--------------------------------------------------------------------------------------------------
+static inline bool orp_PacketEncode
+(
+    uint8_t             *packet,
+    size_t              *packetLen,
+    struct orp_Message  *msg,
+    uint8_t              encoded,
+    enum orp_Byte1Field  byte1,
+    unsigned int         fields
+)
+//--------------------------------------------------------------------------------------------------
+{
+    ssize_t fieldsLen;
+
+
+    // Encode fixed-length fields
+    if (!orp_PacketHeaderEncode(packet, msg, encoded, byte1))
+    {
+        return false;
+    }
+
+    // Encode variable length fields, starting at ORP_OFFSET_VARLENGTH
+    fieldsLen = orp_FieldsEncode(packet + ORP_OFFSET_VARLENGTH, *packetLen - ORP_OFFSET_VARLENGTH,
+                                 msg, fields);
+    if (fieldsLen < 0)
+    {
+        return false;
+    }
+
+    *packetLen = ORP_OFFSET_VARLENGTH + fieldsLen;
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode the fixed length fields of a packet of a given type, according to version 1 of the
+ * protocol.  Specialized per packet type, as orp_PacketEncode
+ */
+//--------------------------------------------------------------------------------------------------
+static inline bool orp_PacketHeaderDecode
+(
+    const uint8_t       *packet,
+    struct orp_Message  *msg,
+    enum orp_PacketType  decoded,
+    enum orp_Byte1Field  byte1
+)
+//--------------------------------------------------------------------------------------------------
+{
+    msg->type = decoded;
+    return orp_PacketByte1Decode(packet, byte1, msg);
+}
+
+
+// Per packet type encoders, header decoders and field decoders
+#define X(packet, encoded, decoded, byte1, fields, name)                                           \
+    static bool orp_PacketEncode_##packet                                                          \
+    (                                                                                              \
+        uint8_t            *buf,                                                                   \
+        size_t             *bufLen,                                                                \
+        struct orp_Message *msg                                                                    \
+    )                                                                                              \
+    {                                                                                              \
+        return orp_PacketEncode(buf, bufLen, msg, encoded, ORP_BYTE1_##byte1, fields);            \
+    }                                                                                              \
+                                                                                                   \
+    static bool orp_PacketHeaderDecode_##packet                                                    \
+    (                                                                                              \
+        const uint8_t      *buf,                                                                   \
+        struct orp_Message *msg                                                                    \
+    )                                                                                              \
+    {                                                                                              \
+        return orp_PacketHeaderDecode(buf, msg, decoded, ORP_BYTE1_##byte1);                       \
+    }                                                                                              \
+                                                                                                   \
+    static bool orp_FieldsDecode_##packet                                                          \
+    (                                                                                              \
+        uint8_t            *buf,                                                                   \
+        size_t              len,                                                                   \
+        struct orp_Message *msg,                                                                   \
+        size_t             *errorOffset                                                            \
+    )                                                                                              \
+    {                                                                                              \
+        return orp_FieldsDecode(buf, len, msg, fields, errorOffset);                               \
+    }                                                                                              \
+                                                                                                   \
+    static bool orp_RecordFieldsDecode_##packet                                                    \
+    (                                                                                              \
+        uint8_t            *buf,                                                                   \
+        size_t              len,                                                                   \
+        struct orp_Message *msg,                                                                   \
+        size_t             *errorOffset                                                            \
+    )                                                                                              \
+    {                                                                                              \
+        return orp_FieldsDecode(buf, len, msg, ORP_RECORD_FIELDS(fields), errorOffset);            \
+    }
+ORP_PACKET_SCHEMA(X)
+#undef X
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode an outgoing response according to version 1 of the protocol and load it into a buffer
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_ProtocolEncode_v1
+(
+    uint8_t            *packet,
+    size_t             *packetLen,
+    struct orp_Message *msg
+)
+//--------------------------------------------------------------------------------------------------
+{
+    const struct orp_PacketTypeEntry *entry;
+
+
+    LE_ASSERT(packet && packetLen && msg);
+
+    if (*packetLen < ORP_PACKET_LEN_MIN)
+    {
+        LE_ERROR("Buffer too short: %zu", *packetLen);
+        return false;
+    }
+
+    entry = orp_PacketTypeLookup(msg->type);
+    if (!entry)
+    {
+        LE_ERROR("Unrecognized packet type: %d", msg->type);
+        return false;
+    }
+
+    return entry->encode(packet, packetLen, msg);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode an outgoing message according to version 1 of the protocol, as a list of segments:
+ * the protocol fields, up to and including the data field ID, followed by the caller's data
+ *
+ * @note:  Packets which do not carry data, or carry fields after it, are encoded whole into the
+ *         header buffer
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_ProtocolEncodeV_v1
+(
+    uint8_t            *header,
+    size_t              headerLen,
+    struct iovec       *segments,
+    int                *segmentCount,
+    struct orp_Message *msg
+)
+//--------------------------------------------------------------------------------------------------
+{
+    const struct orp_PacketTypeEntry *entry;
+    struct orp_Message fields;
+    size_t len = headerLen;
+
+
+    LE_ASSERT(header && segments && segmentCount && msg);
+
+    if (*segmentCount < 1)
+    {
+        LE_ERROR("No segments");
+        return false;
+    }
+
+    entry = orp_PacketTypeLookup(msg->type);
+    if (   !entry
+        || !(entry->fields & ORP_FIELD(DATA))
+        || (entry->fields >> (ORP_FIELD_INDEX_DATA + 1))
+        || !msg->data
+        || !msg->dataLen)
+    {
+        if (!orp_ProtocolEncode_v1(header, &len, msg))
+        {
+            return false;
+        }
+        segments[0].iov_base = header;
+        segments[0].iov_len = len;
+        *segmentCount = 1;
+        return true;
+    }
+
+    if ((*segmentCount < 2) || (headerLen < ORP_PACKET_LEN_MIN + 2))
+    {
+        LE_ERROR("Insufficient segments %d or header size %zu", *segmentCount, headerLen);
+        return false;
+    }
+
+    // Encode everything but the data, leaving room for the data field separator and ID
+    fields = *msg;
+    fields.data = NULL;
+    fields.dataLen = 0;
+    len = headerLen - 2;
+    if (!orp_ProtocolEncode_v1(header, &len, &fields))
+    {
+        return false;
+    }
+
+    // A separator is needed if any variable length field precedes the data
+    if (len > ORP_OFFSET_VARLENGTH)
+    {
+        header[len++] = ORP_VARLENGTH_SEPARATOR;
+    }
+    header[len++] = ORP_FIELD_ID_DATA;
+
+    segments[0].iov_base = header;
+    segments[0].iov_len = len;
+    segments[1].iov_base = msg->data;
+    segments[1].iov_len = msg->dataLen;
+    *segmentCount = 2;
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode a binary field made of a tag and a varint
+ *
+ * @return: field length, or -1 on failure
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t orp_BinaryIntFieldEncode
+(
+    uint8_t *buf,
+    size_t   bufLen,
+    uint8_t  tag,
+    uint64_t value
+)
+//--------------------------------------------------------------------------------------------------
+{
+    ssize_t len;
+
+
+    if (bufLen < 1)
+    {
+        LE_ERROR("Insufficient buffer size for field %c: %zu", tag, bufLen);
+        return -1;
+    }
+    len = orp_VarintEncode(buf + 1, bufLen - 1, value);
+    if (len < 0)
+    {
+        return -1;
+    }
+    buf[0] = tag;
+    return len + 1;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode a binary field made of a tag, a varint length and that many bytes.  If truncate is set,
+ * as much of the value as fits the buffer is encoded, otherwise all of it must fit
+ *
+ * @return: field length, or -1 on failure
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t orp_BinaryBytesFieldEncode
+(
+    uint8_t    *buf,
+    size_t      bufLen,
+    uint8_t     tag,
+    const void *value,
+    size_t      valueLen,
+    bool        truncate
+)
+//--------------------------------------------------------------------------------------------------
+{
+    // + 1 for the tag byte
+    size_t headerLen = 1 + orp_VarintLength(valueLen);
+
+
+    if ((bufLen < headerLen) || (!truncate && (bufLen - headerLen < valueLen)))
+    {
+        LE_ERROR("Insufficient buffer size for field %c: %zu", tag, bufLen);
+        return -1;
+    }
+
+    // Truncating can only shorten the varint, so the value still fits after it
+    valueLen = MIN(bufLen - headerLen, valueLen);
+    headerLen = orp_BinaryIntFieldEncode(buf, bufLen, tag, valueLen);
+    memmove(buf + headerLen, value, valueLen);
+
+    return headerLen + valueLen;
+}
+
+
+// Records are encoded by the fields encoder, and hold fields themselves
+static ssize_t orp_BinaryRecordEncode(uint8_t *, size_t, const struct orp_Message *, unsigned int);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode the variable length fields of an outgoing message in binary, other than data.  Records
+ * carry their own data
+ *
+ * @return: length, or -1 on failure
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t orp_BinaryFieldsEncode
+(
+    uint8_t                  *buf,
+    size_t                    bufLen,
+    const struct orp_Message *msg,
+    unsigned int              fields
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t index = 0;
+    ssize_t fieldLen;
+    struct orp_Time time;
+
+
+    if (fields & ORP_FIELD(TIME))
+    {
+        if (!orp_MessageTimeGet(msg, &time))
+        {
+            return -1;
+        }
+        if (ORP_TIME_SECONDS_INVALID != time.seconds)
+        {
+            if (bufLen < 1)
+            {
+                return -1;
+            }
+            fieldLen = orp_BinaryTimeEncode(buf + 1, bufLen - 1, &time);
+            if (fieldLen < 0)
+            {
+                return -1;
+            }
+            buf[0] = msg->timeDelta ? ORP_BINARY_TAG_TIME_DELTA : ORP_FIELD_ID_TIME;
+            index += 1 + fieldLen;
+        }
+    }
+
+    // Note: zero length path is permitted, zero length units are omitted
+    if ((fields & ORP_FIELD(PATH)) && msg->path)
+    {
+        fieldLen = orp_BinaryBytesFieldEncode(buf + index, bufLen - index, ORP_FIELD_ID_PATH,
+                                              msg->path, strlen(msg->path), false);
+        if (fieldLen < 0)
+        {
+            return -1;
+        }
+        index += fieldLen;
+    }
+    if ((fields & ORP_FIELD(PATH_ID)) && (msg->pathId >= 0))
+    {
+        fieldLen = orp_BinaryIntFieldEncode(buf + index, bufLen - index, ORP_FIELD_ID_PATH_ID,
+                                            msg->pathId);
+        if (fieldLen < 0)
+        {
+            return -1;
+        }
+        index += fieldLen;
+    }
+    if ((fields & ORP_FIELD(UNITS)) && msg->unit && msg->unit[0])
+    {
+        fieldLen = orp_BinaryBytesFieldEncode(buf + index, bufLen - index, ORP_FIELD_ID_UNITS,
+                                              msg->unit, strlen(msg->unit), false);
+        if (fieldLen < 0)
+        {
+            return -1;
+        }
+        index += fieldLen;
+    }
+
+    // Version 2: Sync packets
+    if ((fields & ORP_FIELD(MTU)) && (msg->mtu >= 0))
+    {
+        fieldLen = orp_BinaryIntFieldEncode(buf + index, bufLen - index, ORP_FIELD_ID_MTU, msg->mtu);
+        if (fieldLen < 0)
+        {
+            return -1;
+        }
+        index += fieldLen;
+    }
+    if ((fields & ORP_FIELD(SENT_COUNT)) && (msg->sentCount >= 0))
+    {
+        fieldLen = orp_BinaryIntFieldEncode(buf + index, bufLen - index, ORP_FIELD_ID_SENT_COUNT,
+                                            msg->sentCount);
+        if (fieldLen < 0)
+        {
+            return -1;
+        }
+        index += fieldLen;
+    }
+    if ((fields & ORP_FIELD(RECV_COUNT)) && (msg->receivedCount >= 0))
+    {
+        fieldLen = orp_BinaryIntFieldEncode(buf + index, bufLen - index, ORP_FIELD_ID_RECV_COUNT,
+                                            msg->receivedCount);
+        if (fieldLen < 0)
+        {
+            return -1;
+        }
+        index += fieldLen;
+    }
+    if ((fields & ORP_FIELD(CAPABILITIES)) && msg->capabilities)
+    {
+        fieldLen = orp_BinaryIntFieldEncode(buf + index, bufLen - index, ORP_FIELD_ID_CAPABILITIES,
+                                            msg->capabilities);
+        if (fieldLen < 0)
+        {
+            return -1;
+        }
+        index += fieldLen;
+    }
+    if ((fields & ORP_FIELD(STATUS)) && msg->status)
+    {
+        // Sent as its magnitude
+        if (msg->status > 0)
+        {
+            return -1;
+        }
+        fieldLen = orp_BinaryIntFieldEncode(buf + index, bufLen - index, ORP_FIELD_ID_STATUS,
+                                            -msg->status);
+        if (fieldLen < 0)
+        {
+            return -1;
+        }
+        index += fieldLen;
+    }
+
+    // Batch packets
+    if ((fields & ORP_FIELD(RECORD)) && msg->records)
+    {
+        for (size_t i = 0; i < msg->recordCount; i++)
+        {
+            fieldLen = orp_BinaryRecordEncode(buf + index, bufLen - index, &msg->records[i],
+                                              ORP_RECORD_FIELDS(fields));
+            if (fieldLen < 0)
+            {
+                return -1;
+            }
+            index += fieldLen;
+        }
+    }
+
+    return index;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode the data of an outgoing message in binary, as IEEE-754 where possible.  If truncate is
+ * set, as much of the data as fits the buffer is encoded
+ *
+ * @return: length, 0 if there is no data, or -1 on failure
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t orp_BinaryDataEncode
+(
+    uint8_t                  *buf,
+    size_t                    bufLen,
+    const struct orp_Message *msg,
+    bool                      truncate
+)
+//--------------------------------------------------------------------------------------------------
+{
+    double number;
+    size_t width;
+
+
+    // Zero length will be omitted
+    if (!msg->data || !msg->dataLen)
+    {
+        return 0;
+    }
+
+    width = orp_NumericBinaryWidth(msg, &number);
+    if (width)
+    {
+        return orp_BinaryNumericEncode(buf, bufLen, number, width);
+    }
+    return orp_BinaryBytesFieldEncode(buf, bufLen, ORP_FIELD_ID_DATA, msg->data, msg->dataLen,
+                                      truncate);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of bytes the variable length fields of a message will occupy once encoded in binary,
+ * data included.  Mirrors orp_BinaryFieldsEncode and orp_BinaryDataEncode field for field
+ *
+ * @return: length, or -1 if the message cannot be encoded
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t orp_BinaryFieldsSize
+(
+    const struct orp_Message *msg,
+    unsigned int              fields
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t len = 0;
+    struct orp_Time time;
+    size_t strLen;
+
+
+    // Each field starts with a 1 byte tag
+    if (fields & ORP_FIELD(TIME))
+    {
+        if (!orp_MessageTimeGet(msg, &time))
+        {
+            return -1;
+        }
+        if (ORP_TIME_SECONDS_INVALID != time.seconds)
+        {
+            len += 1 + orp_BinaryTimeLength(&time);
+        }
+    }
+    if ((fields & ORP_FIELD(PATH)) && msg->path)
+    {
+        strLen = strlen(msg->path);
+        len += 1 + orp_VarintLength(strLen) + strLen;
+    }
+    if ((fields & ORP_FIELD(PATH_ID)) && (msg->pathId >= 0))
+    {
+        len += 1 + orp_VarintLength(msg->pathId);
+    }
+    if ((fields & ORP_FIELD(UNITS)) && msg->unit && msg->unit[0])
+    {
+        strLen = strlen(msg->unit);
+        len += 1 + orp_VarintLength(strLen) + strLen;
+    }
+    if ((fields & ORP_FIELD(MTU)) && (msg->mtu >= 0))
+    {
+        len += 1 + orp_VarintLength(msg->mtu);
+    }
+    if ((fields & ORP_FIELD(SENT_COUNT)) && (msg->sentCount >= 0))
+    {
+        len += 1 + orp_VarintLength(msg->sentCount);
+    }
+    if ((fields & ORP_FIELD(RECV_COUNT)) && (msg->receivedCount >= 0))
+    {
+        len += 1 + orp_VarintLength(msg->receivedCount);
+    }
+    if ((fields & ORP_FIELD(CAPABILITIES)) && msg->capabilities)
+    {
+        len += 1 + orp_VarintLength(msg->capabilities);
+    }
+    if ((fields & ORP_FIELD(STATUS)) && msg->status)
+    {
+        if (msg->status > 0)
+        {
+            return -1;
+        }
+        len += 1 + orp_VarintLength(-msg->status);
+    }
+    if ((fields & ORP_FIELD(RECORD)) && msg->records)
+    {
+        for (size_t i = 0; i < msg->recordCount; i++)
+        {
+            ssize_t recordLen = orp_BinaryFieldsSize(&msg->records[i], ORP_RECORD_FIELDS(fields));
+            if (recordLen < 0)
+            {
+                return -1;
+            }
+            len += 1 + orp_VarintLength(recordLen) + recordLen;
+        }
+    }
+    if ((fields & ORP_FIELD(DATA)) && msg->data && msg->dataLen)
+    {
+        double number;
+        size_t width = orp_NumericBinaryWidth(msg, &number);
+
+        len += 1 + (width ? width : orp_VarintLength(msg->dataLen) + msg->dataLen);
+    }
+
+    return len;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode one record of a batch packet in binary: its tag and length, then its fields, data last.
+ * Data is not truncated to fit
+ *
+ * @return: record length, or -1 on failure
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t orp_BinaryRecordEncode
+(
+    uint8_t                  *buf,
+    size_t                    bufLen,
+    const struct orp_Message *record,
+    unsigned int              fields
+)
+//--------------------------------------------------------------------------------------------------
+{
+    ssize_t recordLen = orp_BinaryFieldsSize(record, fields);
+    ssize_t headerLen;
+    ssize_t fieldsLen;
+    ssize_t dataLen = 0;
+
+
+    if (recordLen < 0)
+    {
+        return -1;
+    }
+
+    headerLen = orp_BinaryIntFieldEncode(buf, bufLen, ORP_FIELD_ID_RECORD, recordLen);
+    if ((headerLen < 0) || (bufLen - headerLen < (size_t)recordLen))
+    {
+        LE_ERROR("Insufficient buffer size for record: %zu", bufLen);
+        return -1;
+    }
+
+    fieldsLen = orp_BinaryFieldsEncode(buf + headerLen, recordLen, record, fields);
+    if ((fieldsLen >= 0) && (fields & ORP_FIELD(DATA)))
+    {
+        dataLen = orp_BinaryDataEncode(buf + headerLen + fieldsLen, recordLen - fieldsLen, record,
+                                       false);
+    }
+    if ((fieldsLen < 0) || (dataLen < 0) || (fieldsLen + dataLen != recordLen))
+    {
+        return -1;
+    }
+    return headerLen + recordLen;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode an outgoing message in binary and load it into a buffer
+ *
+ * @note:  Fields carry their own lengths, so data is encoded last, for the benefit of
+ *         orp_ProtocolEncodeVBinary_v1
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_ProtocolEncodeBinary_v1
+(
+    uint8_t            *packet,
+    size_t             *packetLen,
+    struct orp_Message *msg
+)
+//--------------------------------------------------------------------------------------------------
+{
+    const struct orp_PacketTypeEntry *entry;
+    size_t len;
+    ssize_t index;
+    ssize_t fieldLen;
+
+
+    LE_ASSERT(packet && packetLen && msg);
+
+    len = *packetLen;
+    if (len < ORP_PACKET_LEN_MIN)
+    {
+        LE_ERROR("Buffer too short: %zu", len);
+        return false;
+    }
+
+    entry = orp_PacketTypeLookup(msg->type);
+    if (!entry)
+    {
+        LE_ERROR("Unrecognized packet type: %d", msg->type);
+        return false;
+    }
+
+    if (!orp_PacketHeaderEncode(packet, msg, entry->encoded, entry->byte1))
+    {
+        return false;
+    }
+
+    fieldLen = orp_BinaryFieldsEncode(packet + ORP_OFFSET_VARLENGTH, len - ORP_OFFSET_VARLENGTH,
+                                      msg, entry->fields);
+    if (fieldLen < 0)
+    {
+        return false;
+    }
+    index = ORP_OFFSET_VARLENGTH + fieldLen;
+
+    // Append data if provided.  As in ASCII, allow encoding of less than dataLen
+    if (entry->fields & ORP_FIELD(DATA))
+    {
+        fieldLen = orp_BinaryDataEncode(packet + index, len - index, msg, true);
+        if (fieldLen < 0)
+        {
+            return false;
+        }
+        index += fieldLen;
+    }
+
+    *packetLen = index;
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of bytes the message will occupy once encoded in binary.  Mirrors
+ * orp_ProtocolEncodeBinary_v1 field for field
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t orp_EncodedSizeBinary
+(
+    const struct orp_Message *msg
+)
+//--------------------------------------------------------------------------------------------------
+{
+    const struct orp_PacketTypeEntry *entry;
+    ssize_t fieldsLen;
+
+
+    LE_ASSERT(msg);
+
+    entry = orp_PacketTypeLookup(msg->type);
+    if (!entry)
+    {
+        return 0;
+    }
+
+    fieldsLen = orp_BinaryFieldsSize(msg, entry->fields);
+    return (fieldsLen < 0) ? 0 : ORP_OFFSET_VARLENGTH + fieldsLen;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode an outgoing message in binary as a list of segments: the protocol fields, up to and
+ * including the data tag and length, followed by the caller's data
+ *
+ * @note:  Packets which do not carry data, or carry numeric data sent as IEEE-754, are encoded
+ *         whole into the header buffer
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_ProtocolEncodeVBinary_v1
+(
+    uint8_t            *header,
+    size_t              headerLen,
+    struct iovec       *segments,
+    int                *segmentCount,
+    struct orp_Message *msg
+)
+//--------------------------------------------------------------------------------------------------
+{
+    const struct orp_PacketTypeEntry *entry;
+    struct orp_Message fields;
+    size_t len = headerLen;
+    size_t dataHeaderLen;
+    double number;
+
+
+    LE_ASSERT(header && segments && segmentCount && msg);
+
+    if (*segmentCount < 1)
+    {
+        LE_ERROR("No segments");
+        return false;
+    }
+
+    entry = orp_PacketTypeLookup(msg->type);
+    if (   !entry
+        || !(entry->fields & ORP_FIELD(DATA))
+        || !msg->data
+        || !msg->dataLen
+        || orp_NumericBinaryWidth(msg, &number))
+    {
+        if (!orp_ProtocolEncodeBinary_v1(header, &len, msg))
+        {
+            return false;
+        }
+        segments[0].iov_base = header;
+        segments[0].iov_len = len;
+        *segmentCount = 1;
+        return true;
+    }
+
+    // Data tag and length
+    dataHeaderLen = 1 + orp_VarintLength(msg->dataLen);
+    if ((*segmentCount < 2) || (headerLen < ORP_PACKET_LEN_MIN + dataHeaderLen))
+    {
+        LE_ERROR("Insufficient segments %d or header size %zu", *segmentCount, headerLen);
+        return false;
+    }
+
+    // Encode everything but the data, leaving room for the data tag and length
+    fields = *msg;
+    fields.data = NULL;
+    fields.dataLen = 0;
+    len = headerLen - dataHeaderLen;
+    if (!orp_ProtocolEncodeBinary_v1(header, &len, &fields))
+    {
+        return false;
+    }
+
+    len += orp_BinaryIntFieldEncode(header + len, dataHeaderLen, ORP_FIELD_ID_DATA, msg->dataLen);
+
+    segments[0].iov_base = header;
+    segments[0].iov_len = len;
+    segments[1].iov_base = msg->data;
+    segments[1].iov_len = msg->dataLen;
+    *segmentCount = 2;
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode the variable length fields of a binary packet or record.  As with the ASCII decoder,
+ * string fields are null-terminated in place: the tag of the following field is overwritten once
+ * read, and the byte at buf[bufLen] is set to null
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_BinaryFieldsDecode
+(
+    uint8_t            *buf,
+    size_t              bufLen,
+    struct orp_Message *msg
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t offset = 0;
+    bool terminate = false;
+
+
+    while (offset < bufLen)
+    {
+        uint8_t tag = buf[offset];
+        uint8_t *value = &buf[offset + 1];
+        size_t valueLen = bufLen - offset - 1;
+        ssize_t len = -1;
+        uint64_t strLen;
+
+        if (terminate)
+        {
+            buf[offset] = '\0';
+            terminate = false;
+        }
+
+        switch (tag)
+        {
+            case ORP_FIELD_ID_PATH:
+            case ORP_FIELD_ID_UNITS:
+            case ORP_FIELD_ID_DATA:
+                len = orp_VarintDecode(value, valueLen, &strLen);
+                if ((len < 0) || (strLen > valueLen - len))
+                {
+                    len = -1;
+                    break;
+                }
+                if (ORP_FIELD_ID_PATH == tag)
+                {
+                    msg->path = (const char *)&value[len];
+                }
+                else if (ORP_FIELD_ID_UNITS == tag)
+                {
+                    msg->unit = (const char *)&value[len];
+                }
+                else
+                {
+                    msg->data = &value[len];
+                    msg->dataLen = strLen;
+                }
+                len += strLen;
+                terminate = true;
+                break;
+
+            case ORP_FIELD_ID_TIME:
+            case ORP_BINARY_TAG_TIME_DELTA:
+                len = orp_BinaryTimeDecode(value, valueLen, &msg->time);
+                if (len > 0)
+                {
+                    msg->timestamp = orp_TimeToDouble(&msg->time);
+                    msg->timeDelta = (ORP_BINARY_TAG_TIME_DELTA == tag);
+                }
+                break;
+
+            case ORP_FIELD_ID_MTU:
+                len = orp_BinaryIntDecode(value, valueLen, &msg->mtu);
+                break;
+
+            case ORP_FIELD_ID_SENT_COUNT:
+                len = orp_BinaryIntDecode(value, valueLen, &msg->sentCount);
+                break;
+
+            case ORP_FIELD_ID_RECV_COUNT:
+                len = orp_BinaryIntDecode(value, valueLen, &msg->receivedCount);
+                break;
+
+            case ORP_FIELD_ID_PATH_ID:
+                len = orp_BinaryIntDecode(value, valueLen, &msg->pathId);
+                len = (msg->pathId > ORP_PATH_ID_MAX) ? -1 : len;
+                break;
+
+            case ORP_FIELD_ID_CAPABILITIES:
+            {
+                int capabilities;
+
+                len = orp_BinaryIntDecode(value, valueLen, &capabilities);
+                if (len >= 0)
+                {
+                    msg->capabilities = capabilities;
+                }
+                break;
+            }
+
+            case ORP_FIELD_ID_STATUS:
+            {
+                int status;
+
+                len = orp_BinaryIntDecode(value, valueLen, &status);
+                if (len >= 0)
+                {
+                    msg->status = -status;
+                }
+                break;
+            }
+
+            case ORP_BINARY_TAG_FLOAT32:
+            case ORP_BINARY_TAG_FLOAT64:
+                len = (ORP_BINARY_TAG_FLOAT32 == tag) ? sizeof(float) : sizeof(double);
+                if ((size_t)len > valueLen)
+                {
+                    len = -1;
+                    break;
+                }
+                msg->dataLen = orp_NumericFormat(msg->numeric, sizeof(msg->numeric),
+                                                 orp_BinaryNumericDecode(value, len));
+                msg->data = msg->numeric;
+                break;
+
+            case ORP_FIELD_ID_RECORD:
+                // Records are the only fields of a packet which carries them.  They are decoded
+                // by the codec's decoderecords
+                if (   (0 == offset)
+                    && orp_RecordsCount(&buf[offset], bufLen - offset, ORP_PROTOCOL_ENCODING_BINARY,
+                                        &msg->recordCount))
+                {
+                    msg->recordsBuf = &buf[offset];
+                    msg->recordsLen = bufLen - offset;
+                    len = valueLen;
+                }
+                break;
+
+            default:
+                LE_ERROR("Unknown field tag buf[%zu] = %02X", offset, tag);
+                return false;
+        }
+
+        if (len < 0)
+        {
+            LE_ERROR("Failed to decode field %c near byte %zu", tag, offset);
+            return false;
+        }
+        offset += 1 + len;
+    }
+
+    // Null-terminate the last field
+    buf[bufLen] = '\0';
+    return true;
+}
 
-        // Sequence number is encoded in Big-Endian
-        last_received_seq_number = (pktBuf[ORP_OFFSET_SEQ_NUM] << 8) & 0xFF00;
-        last_received_seq_number += pktBuf[ORP_OFFSET_SEQ_NUM + 1] & 0x00FF;
-        msg->sequenceNum = last_received_seq_number;
 
-        /* Locate and parse variable length fields
-         * Variable length fields must begin with an identifier byte
-         */
-        state = SEARCH;
-        for (offset = ORP_OFFSET_VARLENGTH;
-             offset < pktLen && state != DONE && state != ERROR; offset++)
-        {
-            // If separator found, null-terminate current field and scan for next
-            if (ORP_VARLENGTH_SEPARATOR == pktBuf[offset])
-            {
-                pktBuf[offset] = '\0';
-                state = SEARCH;
-                continue;
-            }
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode a binary packet.  Fields are null-terminated in place, see orp_BinaryFieldsDecode
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_ProtocolDecodeBinary_v1
+(
+    uint8_t            *pktBuf,
+    size_t              pktLen,
+    struct orp_Message *msg
+)
+//--------------------------------------------------------------------------------------------------
+{
+    const struct orp_PacketTypeEntry *entry;
 
-            if (SEARCH == state)
-            {
-                char *endPtr;
 
-//#error "Use a table and for loop to search field IDs"
-                switch (pktBuf[offset])
-                {
-                    case ORP_FIELD_ID_PATH:
-                        msg->path = (const char *)&pktBuf[offset + 1];
-                        state = INFIELD;
-                        break;
+    LE_ASSERT(pktBuf && msg);
 
-                    case ORP_FIELD_ID_TIME:
-                        timeStr = (const char *)&pktBuf[offset + 1];
-                        state = INFIELD;
-                        break;
+    if (pktLen < ORP_PACKET_LEN_MIN)
+    {
+        LE_ERROR("Packet too short: %zu", pktLen);
+        return false;
+    }
 
-                    case ORP_FIELD_ID_UNITS:
-                        msg->unit = (const char *)&pktBuf[offset + 1];
-                        state = INFIELD;
-                        break;
+    orp_MessageInInit(msg);
 
-                    case ORP_FIELD_ID_DATA:
-                        msg->data = &pktBuf[offset + 1];
-                        msg->dataLen = pktLen - offset - 1;
-                        pktBuf[pktLen] = '\0';
-                        // Data must be last field - Stop scanning immediately
-                        state = DONE;
-                        break;
+    // Fixed length fields, decoded by the packet type's own decoder
+    entry = orp_PacketTypeByEncoded[pktBuf[ORP_OFFSET_PACKET_TYPE]];
+    if (!entry)
+    {
+        LE_ERROR("Failed to decode packet type: 0x%02X", pktBuf[ORP_OFFSET_PACKET_TYPE]);
+        return false;
+    }
+    if (!entry->headerDecode(pktBuf, msg))
+    {
+        return false;
+    }
+    msg->sequenceNum = orp_PacketSequenceDecode(pktBuf);
 
-                    case ORP_FIELD_ID_MTU:
-                        state = INFIELD;
-                        errno = 0;
-                        msg->mtu = strtoul((const char *)&pktBuf[offset + 1], &endPtr, 0);
-                        if (0 != errno)
-                        {
-                            LE_ERROR("Failed to decode max transfer size");
-                            state = ERROR;
-                        }
-                        break;
+    if (!orp_BinaryFieldsDecode(&pktBuf[ORP_OFFSET_VARLENGTH], pktLen - ORP_OFFSET_VARLENGTH, msg))
+    {
+        return false;
+    }
 
-                    case ORP_FIELD_ID_RECV_COUNT:
-                        state = INFIELD;
-                        errno = 0;
-                        msg->receivedCount = strtoul((const char *)&pktBuf[offset + 1], &endPtr, 0);
-                        if (0 != errno)
-                        {
-                            LE_ERROR("Failed to decode received count");
-                            state = ERROR;
-                        }
-                        break;
+    LE_DEBUG("Decoded: %u %d %04X path: %s time: %lf unit: %s dataLen: %zu",
+                msg->type, msg->dataType, msg->sequenceNum,
+                msg->path ? msg->path : "",
+                msg->timestamp,
+                msg->unit ? msg->unit : "",
+                msg->dataLen);
 
-                    case ORP_FIELD_ID_SENT_COUNT:
-                        state = INFIELD;
-                        errno = 0;
-                        msg->sentCount = strtoul((const char *)&pktBuf[offset + 1], &endPtr, 0);
-                        if (0 != errno)
-                        {
-                            LE_ERROR("Failed to decode sent count");
-                            state = ERROR;
-                        }
-                        break;
+    return true;
+}
 
-                    default:
-                        LE_ERROR("Unknown field identifier pktBuf[%d] = %02X", offset, pktBuf[offset]);
-                        state = ERROR;
-                        break;
-                }
-            }
-        }
 
-        /* Ensure that the last byte beyond the reported packet length is null.  This is to
-         * null-terminate the last field, as there is no separator at the end.  Doing this will
-         * not affect (binary) data as long as the packet size is not incremented
-         */
-        pktBuf[pktLen] = '\0';
+//--------------------------------------------------------------------------------------------------
+/**
+ * Locate the variable length fields of a binary packet or record, without modifying the buffer.
+ * Fields are checked, but not parsed
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_ViewFieldsLocateBinary
+(
+    const uint8_t          *buf,
+    size_t                  bufLen,
+    struct orp_MessageView *view
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t offset = 0;
+
 
-        /* Convert the string timestamp to double, if present.  Done here to ensure string is
-         * null terminated
-         */
-        if (timeStr)
+    while (offset < bufLen)
+    {
+        uint8_t tag = buf[offset];
+        const uint8_t *value = &buf[offset + 1];
+        size_t valueLen = bufLen - offset - 1;
+        struct orp_Field *field = NULL;
+        ssize_t len = -1;
+        uint64_t varint;
+        int integer;
+        struct orp_Time time;
+
+        switch (tag)
         {
-            if (!orp_TimeDecode(&msg->timestamp, timeStr))
+            case ORP_FIELD_ID_PATH:
+            case ORP_FIELD_ID_UNITS:
+            case ORP_FIELD_ID_DATA:
+                len = orp_VarintDecode(value, valueLen, &varint);
+                if ((len < 0) || (varint > valueLen - len))
+                {
+                    len = -1;
+                    break;
+                }
+                field = (ORP_FIELD_ID_PATH == tag)  ? &view->path :
+                        (ORP_FIELD_ID_UNITS == tag) ? &view->unit : &view->data;
+                field->ptr = &value[len];
+                field->len = varint;
+                len += varint;
+                field = NULL;
+                if (ORP_FIELD_ID_DATA == tag)
+                {
+                    // As in decode, the last data or numeric field is the data
+                    view->numeric.ptr = NULL;
+                    view->numeric.len = 0;
+                }
+                break;
+
+            case ORP_FIELD_ID_TIME:
+            case ORP_BINARY_TAG_TIME_DELTA:
+                len = orp_BinaryTimeDecode(value, valueLen, &time);
+                field = &view->time;
+                view->timeDelta = (ORP_BINARY_TAG_TIME_DELTA == tag);
+                break;
+
+            case ORP_FIELD_ID_MTU:
+            case ORP_FIELD_ID_SENT_COUNT:
+            case ORP_FIELD_ID_RECV_COUNT:
+            case ORP_FIELD_ID_CAPABILITIES:
+            case ORP_FIELD_ID_STATUS:
+                len = orp_BinaryIntDecode(value, valueLen, &integer);
+                field = (ORP_FIELD_ID_MTU == tag)          ? &view->mtu :
+                        (ORP_FIELD_ID_SENT_COUNT == tag)   ? &view->sentCount :
+                        (ORP_FIELD_ID_RECV_COUNT == tag)   ? &view->receivedCount :
+                        (ORP_FIELD_ID_CAPABILITIES == tag) ? &view->capabilities :
+                                                             &view->recordStatus;
+                break;
+
+            case ORP_FIELD_ID_PATH_ID:
+                len = orp_BinaryIntDecode(value, valueLen, &integer);
+                len = (integer > ORP_PATH_ID_MAX) ? -1 : len;
+                field = &view->pathId;
+                break;
+
+            case ORP_BINARY_TAG_FLOAT32:
+            case ORP_BINARY_TAG_FLOAT64:
+                len = (ORP_BINARY_TAG_FLOAT32 == tag) ? sizeof(float) : sizeof(double);
+                len = ((size_t)len > valueLen) ? -1 : len;
+                field = &view->numeric;
+                view->data.ptr = NULL;
+                view->data.len = 0;
+                break;
+
+            case ORP_FIELD_ID_RECORD:
             {
-                // The offset has since been incremented.  Recalculate for time field
-                offset = (unsigned int)((uint8_t *)timeStr - pktBuf) - 1;
-                state = ERROR;
+                // Records are the only fields of a packet which carries them, and are located
+                // by orp_ViewRecordNext
+                size_t count;
+
+                if (   (offset > 0)
+                    || !orp_RecordsCount(&buf[offset], bufLen - offset,
+                                         ORP_PROTOCOL_ENCODING_BINARY, &count))
+                {
+                    return false;
+                }
+                view->records.ptr = &buf[offset];
+                view->records.len = bufLen - offset;
+                return true;
             }
+
+            default:
+                LE_ERROR("Unknown field tag buf[%zu] = %02X", offset, tag);
+                return false;
         }
 
-    } while (0);
+        if (len < 0)
+        {
+            LE_ERROR("Failed to decode field %c near byte %zu", tag, offset);
+            return false;
+        }
+        if (field)
+        {
+            field->ptr = value;
+            field->len = len;
+        }
+        offset += 1 + len;
+    }
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode a binary packet into a view, without modifying the packet buffer.  Variable length
+ * fields are located and checked, but not parsed
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_ProtocolDecodeViewBinary_v1
+(
+    const uint8_t          *pktBuf,
+    size_t                  pktLen,
+    struct orp_MessageView *view
+)
+//--------------------------------------------------------------------------------------------------
+{
+    LE_ASSERT(pktBuf && view);
 
-    if (ERROR == state)
+    if (!orp_ViewHeaderDecode(pktBuf, pktLen, view))
     {
-        LE_ERROR("Failed to decode: %d %d %04X %s",
-                    msg->type, msg->dataType, msg->sequenceNum,
-                    pktBuf + ORP_OFFSET_VARLENGTH);
+        return false;
+    }
+    view->encoding = ORP_PROTOCOL_ENCODING_BINARY;
 
-        LE_ERROR("Error near byte %d %s", offset,
-                offset >= ORP_OFFSET_VARLENGTH ? (char *)&pktBuf[offset] : "");
+    return orp_ViewFieldsLocateBinary(&pktBuf[ORP_OFFSET_VARLENGTH], pktLen - ORP_OFFSET_VARLENGTH,
+                                      view);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Locate the next record of a message view
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ViewRecordNext
+(
+    const struct orp_MessageView *view,
+    size_t                       *offset,
+    struct orp_MessageView       *record
+)
+//--------------------------------------------------------------------------------------------------
+{
+    struct orp_MessageView fixed;
+    ssize_t start;
+    size_t recordLen;
+    bool located;
+
+
+    LE_ASSERT(view && offset && record);
+
+    if (!view->records.ptr || (*offset >= view->records.len))
+    {
+        return false;
+    }
+
+    start = orp_RecordLocate(view->records.ptr, view->records.len, view->encoding, offset,
+                             &recordLen);
+    if (start < 0)
+    {
+        return false;
+    }
+
+    // The record shares the fixed length fields of the packet
+    fixed = *view;
+    memset(record, 0, sizeof(struct orp_MessageView));
+    record->encoding = fixed.encoding;
+    record->type = fixed.type;
+    record->dataType = fixed.dataType;
+    record->version = fixed.version;
+    record->status = fixed.status;
+    record->sequenceNum = fixed.sequenceNum;
+
+    if (ORP_PROTOCOL_ENCODING_BINARY == fixed.encoding)
+    {
+        located = orp_ViewFieldsLocateBinary(&fixed.records.ptr[start], recordLen, record);
     }
     else
     {
-        LE_DEBUG("Decoded: %u %d %04X path: %s time: %lf unit: %s dataLen: %zu",
-                    msg->type, msg->dataType, msg->sequenceNum,
-                    msg->path ? msg->path : "",
-                    msg->timestamp,
-                    msg->unit ? msg->unit : "",
-                    msg->dataLen);
+        located = orp_ViewFieldsLocate(&fixed.records.ptr[start], recordLen, record);
+    }
+    if (!located)
+    {
+        return false;
     }
 
-    return ERROR == state ? false : true;
+    // A record without a status has that of the packet.  It is sent as its magnitude
+    if (record->recordStatus.ptr)
+    {
+        int status;
+
+        if (!orp_ViewInt(record, &record->recordStatus, &status))
+        {
+            return false;
+        }
+        record->status = -status;
+    }
+    return true;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Encode an outgoing response according to version 1 of the protocol and load it into a buffer
+ * Decode the records of a decoded message, in either encoding
+ *
+ * @note:  Decoding a record null-terminates its last field in place, which may overwrite the
+ *         first byte of the next record.  Each record is therefore located before the previous
+ *         one is decoded
  */
 //--------------------------------------------------------------------------------------------------
-static bool orp_ProtocolEncode_v1
+static bool orp_RecordsDecode
 (
-    uint8_t            *packet,
-    size_t             *packetLen,
-    struct orp_Message *msg
+    const struct orp_Message  *msg,
+    struct orp_Message        *records,
+    size_t                    *recordCount,
+    enum orp_ProtocolEncoding  encoding
 )
 //--------------------------------------------------------------------------------------------------
 {
-    size_t len;
-    bool result = false;
+    const struct orp_PacketTypeEntry *entry = orp_PacketTypeLookup(msg->type);
+    size_t offset = 0;
+    size_t recordLen = 0;
+    ssize_t start = 0;
 
 
-    LE_ASSERT(packet && packetLen && msg);
+    LE_ASSERT(msg && records && recordCount);
 
-    do
+    if (!msg->recordsBuf || !msg->recordCount)
     {
-        len = *packetLen;
-        if (len < ORP_PACKET_LEN_MIN)
-        {
-            LE_ERROR("Buffer too short: %zu", len);
-            break;
-        }
+        *recordCount = 0;
+        return true;
+    }
+    if (!entry)
+    {
+        LE_ERROR("Unrecognized packet type: %d", msg->type);
+        return false;
+    }
+    if (msg->recordCount > *recordCount)
+    {
+        LE_ERROR("Too many records: %zu > %zu", msg->recordCount, *recordCount);
+        return false;
+    }
 
-        memset(packet, 0, len);
+    start = orp_RecordLocate(msg->recordsBuf, msg->recordsLen, encoding, &offset, &recordLen);
+    for (size_t i = 0; i < msg->recordCount; i++)
+    {
+        uint8_t *fields = &msg->recordsBuf[start];
+        size_t fieldsLen = recordLen;
+        struct orp_Message *record = &records[i];
+        size_t errorOffset;
+        bool status;
 
-        // Encode fixed-length fields
-        if (!orp_PacketTypeEncode(packet, msg->type))
+        if (start < 0)
         {
-            break;
+            return false;
         }
-        if (!orp_PacketByte1Encode(packet, msg))
+        if (i + 1 < msg->recordCount)
         {
-            break;
+            start = orp_RecordLocate(msg->recordsBuf, msg->recordsLen, encoding, &offset,
+                                     &recordLen);
         }
 
-        uint16_t sequence_number_to_send = last_received_seq_number;
+        // Each record takes the fixed length fields of the packet
+        orp_MessageInInit(record);
+        record->type = msg->type;
+        record->dataType = msg->dataType;
+        record->version = msg->version;
+        record->status = msg->status;
+        record->sequenceNum = msg->sequenceNum;
 
-        // Copy Sequence Number from Request or increment it in case of request sent by the device
-        if ((packet[ORP_OFFSET_PACKET_TYPE] != ORP_PKT_SYNC_SYN) && isupper(packet[ORP_OFFSET_PACKET_TYPE]))
+        if (ORP_PROTOCOL_ENCODING_BINARY == encoding)
         {
-            // The device will send a request -> increment the Sequence Number
-            sequence_number_to_send = last_received_seq_number + 1;
+            status = orp_BinaryFieldsDecode(fields, fieldsLen, record);
         }
-
-        // Sequence number is encoded in Big-Endian
-        packet[ORP_OFFSET_SEQ_NUM]     = (sequence_number_to_send & 0xFF00) >> 8;
-        packet[ORP_OFFSET_SEQ_NUM + 1] = (sequence_number_to_send & 0x00FF);
-        msg->sequenceNum = sequence_number_to_send;
-
-        /* Encode variable length fields, starting at ORP_OFFSET_VARLENGTH.
-         * Insert separators only as needed
-         */
-        ssize_t index = ORP_OFFSET_VARLENGTH;
-        ssize_t fieldLen = 0;
-
-        fieldLen = orp_TimeEncode(packet + index, len - index, msg->timestamp);
-        index += fieldLen;
-
-        // Append path if provided.  Note: zero length is permitted
-        if (msg->path)
+        else
         {
-            if (fieldLen)
-            {
-                packet[index++] = ',';
-            }
-            fieldLen = orp_PathEncode(packet + index, len - index, msg->path);
-            if (fieldLen < 0)
-            {
-                break;
-            }
-            index += fieldLen;
+            status = entry->recordFieldsDecode(fields, fieldsLen, record, &errorOffset);
         }
-
-        // Append data if provided.  Zero length will be omitted
-        if (msg->dataLen)
+        if (!status)
         {
-            if (fieldLen)
-            {
-                packet[index++] = ',';
-            }
-            fieldLen = orp_DataEncode(packet + index, len - index, msg->data, msg->dataLen);
-            if (fieldLen < 0)
-            {
-                break;
-            }
-            index += fieldLen;
-            msg->dataLen -= fieldLen;
+            LE_ERROR("Failed to decode record %zu", i);
+            return false;
         }
+    }
 
-        // Version 2: Sync packets. Append sent and received counts and MTU
-        if (   (ORP_SYNC_SYN    == msg->type)
-            || (ORP_SYNC_SYNACK == msg->type))
-        {
-            if (msg->mtu >= 0)
-            {
-                if (fieldLen)
-                {
-                    packet[index++] = ',';
-                }
-                fieldLen = orp_MtuEncode(packet + index, len - index, msg->mtu);
-                if (fieldLen < 0)
-                {
-                    break;
-                }
-                index += fieldLen;
-            }
-            if (msg->sentCount >= 0)
-            {
-                if (fieldLen)
-                {
-                    packet[index++] = ',';
-                }
-                fieldLen = orp_SentCountEncode(packet + index, len - index, msg->sentCount);
-                if (fieldLen < 0)
-                {
-                    break;
-                }
-                index += fieldLen;
-            }
-            if (msg->receivedCount >= 0)
-            {
-                if (fieldLen)
-                {
-                    packet[index++] = ',';
-                }
-                fieldLen = orp_ReceivedCountEncode(packet + index, len - index, msg->receivedCount);
-                if (fieldLen < 0)
-                {
-                    break;
-                }
-                index += fieldLen;
-            }
-        }
+    *recordCount = msg->recordCount;
+    return true;
+}
 
-        *packetLen = index;
-        result = true;
 
-    } while (0);
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode the records of a message decoded according to version 1 of the protocol
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_ProtocolDecodeRecords_v1
+(
+    const struct orp_Message *msg,
+    struct orp_Message       *records,
+    size_t                   *recordCount
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return orp_RecordsDecode(msg, records, recordCount, ORP_PROTOCOL_ENCODING_ASCII);
+}
+
 
-    return result;
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode the records of a binary message
+ */
+//--------------------------------------------------------------------------------------------------
+static bool orp_ProtocolDecodeRecordsBinary_v1
+(
+    const struct orp_Message *msg,
+    struct orp_Message       *records,
+    size_t                   *recordCount
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return orp_RecordsDecode(msg, records, recordCount, ORP_PROTOCOL_ENCODING_BINARY);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Initialize protocol interface
+ * Initialize protocol interface, for a given encoding
  */
 //--------------------------------------------------------------------------------------------------
-bool orp_ProtocolClientInit
+bool orp_ProtocolCodecInit
 (
-    enum orp_ProtocolVersion  version,
-    struct orp_ProtocolCodec *codecs
+    enum orp_ProtocolVersion   version,
+    enum orp_ProtocolEncoding  encoding,
+    struct orp_ProtocolCodec  *codecs
 )
 //--------------------------------------------------------------------------------------------------
 {
@@ -1239,12 +4143,32 @@ bool orp_ProtocolClientInit
 
     LE_ASSERT(codecs);
 
-    switch (version)
+    if ((ORP_PROTOCOL_V1 != version) && (ORP_PROTOCOL_V2 != version))
+    {
+        return false;
+    }
+    codecs->version = version;
+    codecs->encoding = encoding;
+
+    switch (encoding)
     {
-        case ORP_PROTOCOL_V1:
-        case ORP_PROTOCOL_V2:
+        case ORP_PROTOCOL_ENCODING_ASCII:
             codecs->decode = orp_ProtocolDecode_v1;
+            codecs->decodeview = orp_ProtocolDecodeView_v1;
+            codecs->decoderecords = orp_ProtocolDecodeRecords_v1;
             codecs->encode = orp_ProtocolEncode_v1;
+            codecs->encodev = orp_ProtocolEncodeV_v1;
+            codecs->encodedsize = orp_EncodedSize;
+            status = true;
+            break;
+
+        case ORP_PROTOCOL_ENCODING_BINARY:
+            codecs->decode = orp_ProtocolDecodeBinary_v1;
+            codecs->decodeview = orp_ProtocolDecodeViewBinary_v1;
+            codecs->decoderecords = orp_ProtocolDecodeRecordsBinary_v1;
+            codecs->encode = orp_ProtocolEncodeBinary_v1;
+            codecs->encodev = orp_ProtocolEncodeVBinary_v1;
+            codecs->encodedsize = orp_EncodedSizeBinary;
             status = true;
             break;
 
@@ -1254,3 +4178,19 @@ bool orp_ProtocolClientInit
 
     return status;
 }
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize protocol interface, for the ASCII encoding
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ProtocolClientInit
+(
+    enum orp_ProtocolVersion  version,
+    struct orp_ProtocolCodec *codecs
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return orp_ProtocolCodecInit(version, ORP_PROTOCOL_ENCODING_ASCII, codecs);
+}
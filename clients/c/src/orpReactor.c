@@ -0,0 +1,563 @@
+/**
+ * @file:    orpReactor.c
+ *
+ * Purpose:  Event loop servicing many ORP links, timers and other file descriptors
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Sierra Wireless Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *----------------------------------------------------------------------------
+ *
+ * NOTES:
+ *
+ * Each source is registered with its own address as the epoll data, so a wakeup finds its
+ * handlers without any lookup.  A source removed while events for it are still to be handled,
+ * in the same wakeup, has those events dropped.
+ *
+ * Links are read edge-triggered, until the client reports that the file descriptor would block.
+ * So that a link which never drains cannot starve the others, reading stops after
+ * ORP_REACTOR_LINK_READS_MAX reads, and the link is re-armed to be reported again on the next
+ * wakeup.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include "orpReactor.h"
+#include "legato.h"
+
+
+// Max reads of one link per wakeup
+#define ORP_REACTOR_LINK_READS_MAX  16
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Register a source
+ */
+//--------------------------------------------------------------------------------------------------
+static bool ReactorSourceAdd
+(
+    struct orp_Reactor       *reactor,
+    struct orp_ReactorSource *source,
+    uint32_t                  events
+)
+{
+    struct epoll_event event = { .events = events, .data.ptr = source };
+
+    if (epoll_ctl(reactor->epollFd, EPOLL_CTL_ADD, source->fd, &event) < 0)
+    {
+        // EPERM, for a file epoll cannot watch, is left to the caller to handle
+        if (EPERM != errno)
+        {
+            int error = errno;
+
+            printf("Failed to watch fd %d.  Error %s\n", source->fd, strerror(error));
+            errno = error;
+        }
+        return false;
+    }
+    reactor->sourceCount++;
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handle a timer expiry
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReactorTimerHandle
+(
+    struct orp_ReactorSource *source,
+    uint32_t                  events
+)
+{
+    uint64_t expiries;
+
+    // Consume the expiries, so the timerfd is not ready again until the next
+    if (read(source->fd, &expiries, sizeof(expiries)) == sizeof(expiries))
+    {
+        source->handler(source, events);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Once a link has been read, re-arm it if not drained, and report any hang up
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReactorLinkDone
+(
+    struct orp_Reactor       *reactor,
+    struct orp_ReactorSource *source,
+    uint32_t                  events,
+    le_result_t               result
+)
+{
+    if ((events & EPOLLIN) && (LE_OK == result))
+    {
+        // Not drained.  Re-arming reports the link again, while it is still readable
+        struct epoll_event event = { .events = EPOLLIN | EPOLLRDHUP | EPOLLET,
+                                     .data.ptr = source };
+        (void)epoll_ctl(reactor->epollFd, EPOLL_CTL_MOD, source->fd, &event);
+    }
+
+    if ((events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) ||
+        (LE_CLOSED == result) || (LE_FAULT == result))
+    {
+        if (source->handler)
+        {
+            source->handler(source, events | EPOLLHUP);
+        }
+        else
+        {
+            printf("Link on fd %d closed\n", source->fd);
+            orp_ReactorRemove(reactor, source);
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Receive from a link until drained, and report hang ups
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReactorLinkHandle
+(
+    struct orp_Reactor       *reactor,
+    struct orp_ReactorSource *source,
+    uint32_t                  events
+)
+{
+    le_result_t result = LE_OK;
+
+    if (events & EPOLLIN)
+    {
+        int reads = 0;
+
+        do
+        {
+            result = orp_ClientReceive(source->context);
+        } while ((LE_OK == result) && (++reads < ORP_REACTOR_LINK_READS_MAX));
+    }
+    ReactorLinkDone(reactor, source, events, result);
+}
+
+
+#ifdef ORP_IO_URING
+//--------------------------------------------------------------------------------------------------
+/**
+ * Receive from the links of a wakeup, with one submission for the first read of all
+ *
+ * Links are non-blocking, so each read completes at once: with the data waiting, or -EAGAIN if it
+ * was drained since the wakeup.  A short read has drained the link too, so only a link whose read
+ * filled its buffer is then read again, with read()
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReactorLinksReceive
+(
+    struct orp_Reactor *reactor
+)
+{
+    le_result_t results[ORP_REACTOR_EVENTS_MAX];
+    int32_t readResults[ORP_REACTOR_EVENTS_MAX];
+    uint32_t readLens[ORP_REACTOR_EVENTS_MAX];
+    int batch[ORP_REACTOR_EVENTS_MAX];
+    unsigned int count = 0;
+
+    // Queue a read of each link
+    for (int i = 0; i < reactor->linkCount; i++)
+    {
+        struct orp_ReactorSource *source = reactor->links[i];
+        struct orp_Client *client = source->context;
+        struct io_uring_sqe *sqe;
+
+        results[i] = LE_OK;
+        if (!(reactor->linkEvents[i] & EPOLLIN))
+        {
+            continue;
+        }
+        sqe = client->uring ? orp_UringSqeGet(reactor->uring) : NULL;
+        if (!sqe)
+        {
+            // Not attached, or the ring is full: read it on its own, below
+            continue;
+        }
+        readLens[count] = sizeof(client->rxFrameBuf) - client->rxFrameLen;
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->fd = client->fd;
+        sqe->addr = (uint64_t)(uintptr_t)(client->rxFrameBuf + client->rxFrameLen);
+        sqe->len = readLens[count];
+        sqe->buf_index = client->uringBufIndex;
+        sqe->user_data = count;
+        batch[count++] = i;
+    }
+
+    if (count && !orp_UringSubmitWait(reactor->uring, readResults, count))
+    {
+        for (unsigned int j = 0; j < count; j++)
+        {
+            results[batch[j]] = LE_FAULT;
+        }
+        count = 0;
+    }
+
+    // Hand each read to its client.  Handling one may remove another
+    for (unsigned int j = 0; j < count; j++)
+    {
+        int i = batch[j];
+
+        if (reactor->links[i])
+        {
+            results[i] = orp_ClientReceiveComplete(reactor->links[i]->context, readResults[j]);
+            if ((LE_OK == results[i]) && ((uint32_t)readResults[j] < readLens[j]))
+            {
+                results[i] = LE_WOULD_BLOCK;
+            }
+        }
+    }
+
+    for (int i = 0; i < reactor->linkCount; i++)
+    {
+        struct orp_ReactorSource *source = reactor->links[i];
+        int reads = 0;
+
+        if (!source)
+        {
+            continue;
+        }
+        while ((LE_OK == results[i]) && (reactor->linkEvents[i] & EPOLLIN) &&
+               (reads++ < ORP_REACTOR_LINK_READS_MAX) && reactor->links[i])
+        {
+            results[i] = orp_ClientReceive(source->context);
+        }
+        if (reactor->links[i])
+        {
+            reactor->links[i] = NULL;
+            ReactorLinkDone(reactor, source, reactor->linkEvents[i], results[i]);
+        }
+    }
+    reactor->linkCount = 0;
+}
+#endif
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize a reactor
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ReactorInit
+(
+    struct orp_Reactor *reactor
+)
+{
+    memset(reactor, 0, sizeof(*reactor));
+    reactor->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (reactor->epollFd < 0)
+    {
+        printf("Failed to create reactor.  Error %s\n", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release a reactor
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_ReactorFini
+(
+    struct orp_Reactor *reactor
+)
+{
+    if (reactor->epollFd >= 0)
+    {
+        close(reactor->epollFd);
+        reactor->epollFd = -1;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read links with an io_uring
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_ReactorUringSet
+(
+    struct orp_Reactor *reactor,
+    struct orp_Uring   *ring
+)
+{
+    reactor->uring = ring;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Watch a file descriptor
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ReactorAdd
+(
+    struct orp_Reactor       *reactor,
+    struct orp_ReactorSource *source,
+    int                       fd,
+    uint32_t                  events,
+    orp_ReactorHandler_t      handler,
+    void                     *context
+)
+{
+    memset(source, 0, sizeof(*source));
+    source->fd = fd;
+    source->handler = handler;
+    source->context = context;
+    if (!ReactorSourceAdd(reactor, source, events))
+    {
+        source->fd = -1;
+        return false;
+    }
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start a periodic timer
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ReactorTimerAdd
+(
+    struct orp_Reactor       *reactor,
+    struct orp_ReactorSource *source,
+    unsigned int              intervalMs,
+    orp_ReactorHandler_t      handler,
+    void                     *context
+)
+{
+    struct itimerspec spec;
+
+    memset(source, 0, sizeof(*source));
+    source->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (source->fd < 0)
+    {
+        printf("Failed to create timer.  Error %s\n", strerror(errno));
+        return false;
+    }
+    source->handler = handler;
+    source->context = context;
+    source->isTimer = true;
+
+    spec.it_interval.tv_sec = intervalMs / 1000;
+    spec.it_interval.tv_nsec = (intervalMs % 1000) * 1000000L;
+    spec.it_value = spec.it_interval;
+    if ((timerfd_settime(source->fd, 0, &spec, NULL) < 0) ||
+        !ReactorSourceAdd(reactor, source, EPOLLIN))
+    {
+        close(source->fd);
+        source->fd = -1;
+        return false;
+    }
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Service an ORP link
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ReactorLinkAdd
+(
+    struct orp_Reactor       *reactor,
+    struct orp_ReactorSource *source,
+    struct orp_Client        *client,
+    orp_ReactorHandler_t      handler
+)
+{
+    int flags = fcntl(client->fd, F_GETFL);
+
+    if ((flags < 0) || (fcntl(client->fd, F_SETFL, flags | O_NONBLOCK) < 0))
+    {
+        printf("Failed to set fd %d non-blocking.  Error %s\n", client->fd, strerror(errno));
+        return false;
+    }
+
+    memset(source, 0, sizeof(*source));
+    source->fd = client->fd;
+    source->handler = handler;
+    source->context = client;
+    source->isLink = true;
+    if (!ReactorSourceAdd(reactor, source, EPOLLIN | EPOLLRDHUP | EPOLLET))
+    {
+        source->fd = -1;
+        return false;
+    }
+
+    // Without registered buffers, the link is read with read()
+    if (reactor->uring && !orp_ClientUringAttach(client, reactor->uring))
+    {
+        printf("Link on fd %d not using io_uring\n", client->fd);
+    }
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop watching a source
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_ReactorRemove
+(
+    struct orp_Reactor       *reactor,
+    struct orp_ReactorSource *source
+)
+{
+    if (source->fd < 0)
+    {
+        return;
+    }
+
+    (void)epoll_ctl(reactor->epollFd, EPOLL_CTL_DEL, source->fd, NULL);
+    reactor->sourceCount--;
+
+    // Drop any events of this wakeup not yet handled
+    for (int i = 0; i < reactor->readyCount; i++)
+    {
+        if (reactor->ready[i].data.ptr == source)
+        {
+            reactor->ready[i].data.ptr = NULL;
+        }
+    }
+    for (int i = 0; i < reactor->linkCount; i++)
+    {
+        if (reactor->links[i] == source)
+        {
+            reactor->links[i] = NULL;
+        }
+    }
+    if (source->isLink && reactor->uring)
+    {
+        orp_ClientUringDetach(source->context);
+    }
+
+    if (source->isTimer)
+    {
+        close(source->fd);
+    }
+    source->fd = -1;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for and handle events
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_ReactorRun
+(
+    struct orp_Reactor *reactor
+)
+{
+    reactor->running = true;
+    while (reactor->running && reactor->sourceCount)
+    {
+        int count = epoll_wait(reactor->epollFd, reactor->ready, ORP_REACTOR_EVENTS_MAX, -1);
+        if (count < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            printf("Failed to wait for events.  Error %s\n", strerror(errno));
+            reactor->running = false;
+            return false;
+        }
+
+        reactor->readyCount = count;
+        for (int i = 0; (i < count) && reactor->running; i++)
+        {
+            struct orp_ReactorSource *source = reactor->ready[i].data.ptr;
+            uint32_t events = reactor->ready[i].events;
+
+            if (!source)
+            {
+                continue;
+            }
+#ifdef ORP_IO_URING
+            if (source->isLink && reactor->uring)
+            {
+                // Read with the other links, once this wakeup's other sources are handled
+                reactor->links[reactor->linkCount] = source;
+                reactor->linkEvents[reactor->linkCount++] = events;
+                continue;
+            }
+#endif
+            if (source->isLink)
+            {
+                ReactorLinkHandle(reactor, source, events);
+            }
+            else if (source->isTimer)
+            {
+                ReactorTimerHandle(source, events);
+            }
+            else
+            {
+                source->handler(source, events);
+            }
+        }
+        reactor->readyCount = 0;
+#ifdef ORP_IO_URING
+        if (reactor->linkCount)
+        {
+            ReactorLinksReceive(reactor);
+        }
+#endif
+    }
+    reactor->running = false;
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Return from orp_ReactorRun()
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_ReactorStop
+(
+    struct orp_Reactor *reactor
+)
+{
+    reactor->running = false;
+}
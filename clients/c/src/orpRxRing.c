@@ -0,0 +1,156 @@
+/**
+ * @file:    orpRxRing.c
+ *
+ * Purpose:  Lock-free single-producer, single-consumer ring of received packets
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Sierra Wireless Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *----------------------------------------------------------------------------
+ *
+ * NOTES:
+ *
+ * Lengths, and packets after them, start on 4 byte boundaries.  As the ring size is a multiple
+ * of 4, there is always room for a length, or a wrap marker, before the end of the ring.
+ *
+ */
+
+#include <string.h>
+#include "orpRxRing.h"
+
+// Length in place of a packet's: the next packet is at the start of the ring
+#define RX_RING_WRAP        UINT32_MAX
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize a ring
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_RxRingInit
+(
+    struct orp_RxRing *ring
+)
+{
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->dropped, 0);
+    atomic_init(&ring->closed, false);
+    ring->peekLen = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Producer: copy in a packet
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_RxRingPush
+(
+    struct orp_RxRing *ring,
+    const uint8_t     *packet,
+    size_t             len
+)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t offset = head & (ORP_RX_RING_SIZE - 1);
+    size_t toEnd = ORP_RX_RING_SIZE - offset;
+    size_t recordLen = ORP_RX_RING_RECORD_LEN(len);
+    size_t skip = (recordLen > toEnd) ? toEnd : 0;
+    uint32_t header;
+
+    if ((len >= RX_RING_WRAP) || (skip + recordLen > ORP_RX_RING_SIZE - (head - tail)))
+    {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return false;
+    }
+
+    if (skip)
+    {
+        header = RX_RING_WRAP;
+        memcpy(&ring->data[offset], &header, sizeof(header));
+        offset = 0;
+    }
+    header = len;
+    memcpy(&ring->data[offset], &header, sizeof(header));
+    memcpy(&ring->data[offset + ORP_RX_RING_HEADER_LEN], packet, len);
+
+    // Publish the packet: the consumer reads head with acquire ordering
+    atomic_store_explicit(&ring->head, head + skip + recordLen, memory_order_release);
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Consumer: get the oldest packet
+ */
+//--------------------------------------------------------------------------------------------------
+uint8_t *orp_RxRingPeek
+(
+    struct orp_RxRing *ring,
+    size_t            *len
+)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t offset = tail & (ORP_RX_RING_SIZE - 1);
+    uint32_t header;
+
+    if (tail == head)
+    {
+        return NULL;
+    }
+
+    memcpy(&header, &ring->data[offset], sizeof(header));
+    ring->peekLen = 0;
+    if (RX_RING_WRAP == header)
+    {
+        // The packet is at the start of the ring.  Its bytes are released with it
+        ring->peekLen = ORP_RX_RING_SIZE - offset;
+        offset = 0;
+        memcpy(&header, &ring->data[offset], sizeof(header));
+    }
+    ring->peekLen += ORP_RX_RING_RECORD_LEN(header);
+
+    *len = header;
+    return &ring->data[offset + ORP_RX_RING_HEADER_LEN];
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Consumer: release the packet last peeked
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_RxRingRelease
+(
+    struct orp_RxRing *ring
+)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    // Hand the bytes back: the producer reads tail with acquire ordering
+    atomic_store_explicit(&ring->tail, tail + ring->peekLen, memory_order_release);
+    ring->peekLen = 0;
+}
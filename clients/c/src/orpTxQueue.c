@@ -0,0 +1,261 @@
+/**
+ * @file:    orpTxQueue.c
+ *
+ * Purpose:  Lock-free multi-producer, single-consumer queue of messages to send
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Sierra Wireless Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *----------------------------------------------------------------------------
+ *
+ * NOTES:
+ *
+ * A slot at position pos is free when its sequence is pos, and ready when it is pos + 1.  Once
+ * sent, the slot is freed for the next lap with a sequence of pos + ORP_TX_QUEUE_SLOTS.  A slot
+ * whose producer is still copying in holds back the consumer, so messages are sent strictly in
+ * the order positions were claimed.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "orpTxQueue.h"
+#include "legato.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Copy a field into slot storage
+ */
+//--------------------------------------------------------------------------------------------------
+static void *TxQueueCopy
+(
+    uint8_t   **storage,
+    const void *field,
+    size_t      len
+)
+{
+    void *copy = *storage;
+
+    // Null terminate, as the fields copied are strings, and data is printed as one
+    memcpy(copy, field, len);
+    (*storage)[len] = '\0';
+    *storage += len + 1;
+    return copy;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize a queue
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_TxQueueInit
+(
+    struct orp_TxQueue *queue
+)
+{
+    for (size_t i = 0; i < ORP_TX_QUEUE_SLOTS; i++)
+    {
+        atomic_init(&queue->slots[i].sequence, i);
+    }
+    atomic_init(&queue->enqueuePos, 0);
+    queue->dequeuePos = 0;
+
+    queue->eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (queue->eventFd < 0)
+    {
+        printf("Failed to create event.  Error %s\n", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release a queue
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_TxQueueFini
+(
+    struct orp_TxQueue *queue
+)
+{
+    if (queue->eventFd >= 0)
+    {
+        close(queue->eventFd);
+        queue->eventFd = -1;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Producer: queue a copy of a message
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t orp_TxQueueMessage
+(
+    struct orp_TxQueue       *queue,
+    const struct orp_Message *message
+)
+{
+    size_t pathLen = message->path ? strlen(message->path) + 1 : 0;
+    size_t unitLen = message->unit ? strlen(message->unit) + 1 : 0;
+    size_t dataLen = message->data ? message->dataLen + 1 : 0;
+    size_t pos = atomic_load_explicit(&queue->enqueuePos, memory_order_relaxed);
+    struct orp_TxQueueSlot *slot;
+    uint8_t *storage;
+    uint64_t one = 1;
+
+    if (message->recordCount)
+    {
+        return LE_BAD_PARAMETER;
+    }
+    if (pathLen + unitLen + dataLen > ORP_TX_QUEUE_DATA_MAX)
+    {
+        return LE_OVERFLOW;
+    }
+
+    // Claim the next position, unless its slot is still to be sent from the last lap
+    for (;;)
+    {
+        slot = &queue->slots[pos & (ORP_TX_QUEUE_SLOTS - 1)];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+        if (0 == diff)
+        {
+            // On failure, pos is updated to the position another producer has left next
+            if (atomic_compare_exchange_weak_explicit(&queue->enqueuePos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            return LE_NO_MEMORY;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&queue->enqueuePos, memory_order_relaxed);
+        }
+    }
+
+    slot->message = *message;
+    storage = slot->storage;
+    if (message->path)
+    {
+        slot->message.path = TxQueueCopy(&storage, message->path, pathLen - 1);
+    }
+    if (message->unit)
+    {
+        slot->message.unit = TxQueueCopy(&storage, message->unit, unitLen - 1);
+    }
+    if (message->data)
+    {
+        slot->message.data = TxQueueCopy(&storage, message->data, message->dataLen);
+    }
+
+    // Publish the message: the consumer reads the sequence with acquire ordering
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+
+    // Only fails if the counter is about to overflow, when it is readable anyway
+    (void)write(queue->eventFd, &one, sizeof(one));
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Producer: queue a push of a string-encoded data sample
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t orp_TxQueuePush
+(
+    struct orp_TxQueue  *queue,
+    const char          *path,
+    enum orp_IoDataType  dataType,
+    int64_t              seconds,
+    uint32_t             microseconds,
+    const char          *value
+)
+{
+    struct orp_Message message;
+
+    orp_MessageInit(&message, ORP_RQST_PUSH, 0);
+    message.dataType = dataType;
+    message.path = path;
+    message.time.seconds = seconds;
+    message.time.microseconds = microseconds;
+    if (value)
+    {
+        message.data = (void *)value;
+        message.dataLen = strlen(value);
+    }
+    return orp_TxQueueMessage(queue, &message);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Consumer: get the oldest queued message
+ */
+//--------------------------------------------------------------------------------------------------
+struct orp_Message *orp_TxQueuePeek
+(
+    struct orp_TxQueue *queue
+)
+{
+    struct orp_TxQueueSlot *slot = &queue->slots[queue->dequeuePos & (ORP_TX_QUEUE_SLOTS - 1)];
+
+    if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != queue->dequeuePos + 1)
+    {
+        return NULL;
+    }
+    return &slot->message;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Consumer: release the message last peeked
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_TxQueueRelease
+(
+    struct orp_TxQueue *queue
+)
+{
+    struct orp_TxQueueSlot *slot = &queue->slots[queue->dequeuePos & (ORP_TX_QUEUE_SLOTS - 1)];
+
+    // Free the slot for the next lap: producers read the sequence with acquire ordering
+    atomic_store_explicit(&slot->sequence, queue->dequeuePos + ORP_TX_QUEUE_SLOTS,
+                          memory_order_release);
+    queue->dequeuePos++;
+}
@@ -0,0 +1,426 @@
+/**
+ * @file:    orpUring.c
+ *
+ * Purpose:  Minimal io_uring interface, to batch the system calls of links and file transfers
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Sierra Wireless Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *----------------------------------------------------------------------------
+ *
+ * NOTES:
+ *
+ * Uses the io_uring system calls directly, rather than liburing, so as to add no dependency.
+ * The ring indices shared with the kernel are read with acquire, and written with release,
+ * ordering.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "orpUring.h"
+
+#ifdef ORP_IO_URING
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Register a sparse table, of buffers or of files
+ */
+//--------------------------------------------------------------------------------------------------
+static bool UringTableRegister
+(
+    struct orp_Uring *ring,
+    unsigned int      opcode,
+    unsigned int      count
+)
+{
+    struct io_uring_rsrc_register table =
+    {
+        .nr = count,
+        .flags = IORING_RSRC_REGISTER_SPARSE,
+    };
+
+    return syscall(__NR_io_uring_register, ring->fd, opcode, &table, sizeof(table)) >= 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set slots of the buffer table.  An empty buffer clears its slot
+ */
+//--------------------------------------------------------------------------------------------------
+static bool UringBuffersUpdate
+(
+    struct orp_Uring   *ring,
+    unsigned int        index,
+    const struct iovec *buffers,
+    unsigned int        count
+)
+{
+    struct io_uring_rsrc_update2 update =
+    {
+        .offset = index,
+        .data = (uint64_t)(uintptr_t)buffers,
+        .nr = count,
+    };
+
+    return syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS_UPDATE,
+                   &update, sizeof(update)) >= 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set up a ring
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_UringInit
+(
+    struct orp_Uring *ring,
+    unsigned int      entries
+)
+{
+    struct io_uring_params params;
+
+    memset(ring, 0, sizeof(*ring));
+    memset(&params, 0, sizeof(params));
+    ring->fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0)
+    {
+        printf("Failed to set up io_uring.  Error %s\n", strerror(errno));
+        return false;
+    }
+
+    ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    ring->sqRing = mmap(NULL, ring->sqRingSize, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    ring->cqRing = mmap(NULL, ring->cqRingSize, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    ring->sqes = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if ((MAP_FAILED == ring->sqRing) || (MAP_FAILED == ring->cqRing) ||
+        (MAP_FAILED == ring->sqes))
+    {
+        printf("Failed to map io_uring.  Error %s\n", strerror(errno));
+        goto err;
+    }
+
+    ring->sqHead = (unsigned int *)((uint8_t *)ring->sqRing + params.sq_off.head);
+    ring->sqTail = (unsigned int *)((uint8_t *)ring->sqRing + params.sq_off.tail);
+    ring->sqMask = (unsigned int *)((uint8_t *)ring->sqRing + params.sq_off.ring_mask);
+    ring->sqArray = (unsigned int *)((uint8_t *)ring->sqRing + params.sq_off.array);
+    ring->sqEntries = params.sq_entries;
+    ring->cqHead = (unsigned int *)((uint8_t *)ring->cqRing + params.cq_off.head);
+    ring->cqTail = (unsigned int *)((uint8_t *)ring->cqRing + params.cq_off.tail);
+    ring->cqMask = (unsigned int *)((uint8_t *)ring->cqRing + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)((uint8_t *)ring->cqRing + params.cq_off.cqes);
+
+    if (!UringTableRegister(ring, IORING_REGISTER_BUFFERS2, ORP_URING_BUFFERS_MAX) ||
+        !UringTableRegister(ring, IORING_REGISTER_FILES2, ORP_URING_FILES_MAX))
+    {
+        printf("Failed to register io_uring tables.  Error %s\n", strerror(errno));
+        goto err;
+    }
+    return true;
+
+err:
+    orp_UringFini(ring);
+    return false;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release a ring
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_UringFini
+(
+    struct orp_Uring *ring
+)
+{
+    if (ring->sqRing && (MAP_FAILED != ring->sqRing))
+    {
+        munmap(ring->sqRing, ring->sqRingSize);
+    }
+    if (ring->cqRing && (MAP_FAILED != ring->cqRing))
+    {
+        munmap(ring->cqRing, ring->cqRingSize);
+    }
+    if (ring->sqes && (MAP_FAILED != (void *)ring->sqes))
+    {
+        munmap(ring->sqes, ring->sqesSize);
+    }
+    if (ring->fd >= 0)
+    {
+        close(ring->fd);
+    }
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Register buffers, in consecutive slots of the buffer table
+ */
+//--------------------------------------------------------------------------------------------------
+int orp_UringBuffersAdd
+(
+    struct orp_Uring   *ring,
+    const struct iovec *buffers,
+    unsigned int        count
+)
+{
+    unsigned int free = 0;
+
+    for (unsigned int i = 0; i < ORP_URING_BUFFERS_MAX; i++)
+    {
+        free = ring->bufferUsed[i] ? 0 : free + 1;
+        if (free == count)
+        {
+            unsigned int index = i + 1 - count;
+
+            if (!UringBuffersUpdate(ring, index, buffers, count))
+            {
+                printf("Failed to register buffers.  Error %s\n", strerror(errno));
+                return -1;
+            }
+            memset(&ring->bufferUsed[index], true, count);
+            return index;
+        }
+    }
+    return -1;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Unregister buffers
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_UringBuffersRemove
+(
+    struct orp_Uring *ring,
+    int               index,
+    unsigned int      count
+)
+{
+    struct iovec empty[count];
+
+    if ((index < 0) || (index + count > ORP_URING_BUFFERS_MAX))
+    {
+        return;
+    }
+    memset(empty, 0, sizeof(empty));
+    (void)UringBuffersUpdate(ring, index, empty, count);
+    memset(&ring->bufferUsed[index], false, count);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a cleared submission queue entry to prepare
+ */
+//--------------------------------------------------------------------------------------------------
+struct io_uring_sqe *orp_UringSqeGet
+(
+    struct orp_Uring *ring
+)
+{
+    unsigned int head = __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE);
+    unsigned int tail = *ring->sqTail + ring->sqPending;
+    struct io_uring_sqe *sqe;
+
+    if (tail - head >= ring->sqEntries)
+    {
+        return NULL;
+    }
+
+    sqe = &ring->sqes[tail & *ring->sqMask];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sqArray[tail & *ring->sqMask] = tail & *ring->sqMask;
+    ring->sqPending++;
+    return sqe;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Discard the entries prepared and not yet submitted
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_UringDiscard
+(
+    struct orp_Uring *ring
+)
+{
+    // The tail is only advanced on submission, so the entries are simply handed out again
+    ring->sqPending = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Submit the entries prepared, and wait for all to complete
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_UringSubmitWait
+(
+    struct orp_Uring *ring,
+    int32_t          *results,
+    unsigned int      count
+)
+{
+    unsigned int submit = ring->sqPending;
+    unsigned int completed = 0;
+
+    __atomic_store_n(ring->sqTail, *ring->sqTail + submit, __ATOMIC_RELEASE);
+    ring->sqPending = 0;
+
+    while (completed < count)
+    {
+        int rc = syscall(__NR_io_uring_enter, ring->fd, submit, count - completed,
+                         IORING_ENTER_GETEVENTS, NULL, 0);
+        if (rc < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            printf("Failed to submit to io_uring.  Error %s\n", strerror(errno));
+            return false;
+        }
+        submit -= ((unsigned int)rc < submit) ? (unsigned int)rc : submit;
+
+        unsigned int head = *ring->cqHead;
+        unsigned int tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+        for ( ; head != tail; head++)
+        {
+            struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cqMask];
+
+            if (cqe->user_data < count)
+            {
+                results[cqe->user_data] = cqe->res;
+            }
+            completed++;
+        }
+        __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+    }
+    return true;
+}
+
+#else // ORP_IO_URING
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set up a ring: not built in
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_UringInit
+(
+    struct orp_Uring *ring,
+    unsigned int      entries
+)
+{
+    (void)entries;
+    ring->fd = -1;
+    printf("io_uring support not built in.  Rebuild with make IO_URING=1\n");
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release a ring: nothing to release
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_UringFini
+(
+    struct orp_Uring *ring
+)
+{
+    (void)ring;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Register buffers: no ring to register them with
+ */
+//--------------------------------------------------------------------------------------------------
+int orp_UringBuffersAdd
+(
+    struct orp_Uring   *ring,
+    const struct iovec *buffers,
+    unsigned int        count
+)
+{
+    (void)ring;
+    (void)buffers;
+    (void)count;
+    return -1;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Unregister buffers: none are registered
+ */
+//--------------------------------------------------------------------------------------------------
+void orp_UringBuffersRemove
+(
+    struct orp_Uring *ring,
+    int               index,
+    unsigned int      count
+)
+{
+    (void)ring;
+    (void)index;
+    (void)count;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Submit the entries prepared: there can be none
+ */
+//--------------------------------------------------------------------------------------------------
+bool orp_UringSubmitWait
+(
+    struct orp_Uring *ring,
+    int32_t          *results,
+    unsigned int      count
+)
+{
+    (void)ring;
+    (void)results;
+    (void)count;
+    return false;
+}
+
+#endif // ORP_IO_URING
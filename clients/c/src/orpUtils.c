@@ -34,6 +34,7 @@
 #include <string.h>
 #include <stdio.h>
 #include "orpUtils.h"
+#include "orpSchema.h"
 #include "orpFile.h"
 
 
@@ -50,43 +51,13 @@ void orp_MessagePrint
     static struct
     {
         enum orp_PacketType type;
+        enum orp_Byte1Field byte1;
         const char *name;
     } packetNames[] = {
-        { ORP_PACKET_TYPE_UNKNOWN, "Unknown packet type" },
-        { ORP_RQST_INPUT_CREATE,   "Request, input create" },
-        { ORP_RESP_INPUT_CREATE,   "Response, input create" },
-        { ORP_RQST_OUTPUT_CREATE,  "Request, output create" },
-        { ORP_RESP_OUTPUT_CREATE,  "Response, output create" },
-        { ORP_RQST_DELETE,         "Request, delete" },
-        { ORP_RESP_DELETE,         "Response, delete" },
-        { ORP_RQST_HANDLER_ADD,    "Request, handler add" },
-        { ORP_RESP_HANDLER_ADD,    "Response, handler add" },
-        { ORP_RQST_HANDLER_REM,    "Request, handler remove" },
-        { ORP_RESP_HANDLER_REM,    "Response, handler remove" },
-        { ORP_RQST_PUSH,           "Request, push" },
-        { ORP_RESP_PUSH,           "Response, push" },
-        { ORP_RQST_GET,            "Request, get" },
-        { ORP_RESP_GET,            "Response, get" },
-        { ORP_RQST_EXAMPLE_SET,    "Request, set example" },
-        { ORP_RESP_EXAMPLE_SET,    "Response, set example" },
-        { ORP_RQST_SENSOR_CREATE,  "Request, sensor create" },
-        { ORP_RESP_SENSOR_CREATE,  "Response, sensor create" },
-        { ORP_RQST_SENSOR_REMOVE,  "Request, sensor remove" },
-        { ORP_RESP_SENSOR_REMOVE,  "Response, sensor remove" },
-        { ORP_NTFY_HANDLER_CALL,   "Notification, handler called" },
-        { ORP_RESP_HANDLER_CALL,   "Response, handler called" },
-        { ORP_NTFY_SENSOR_CALL,    "Notification, sensor call" },
-        { ORP_RESP_SENSOR_CALL,    "Response, sensor call" },
-        { ORP_SYNC_SYN,            "Synchronization, sync" },
-        { ORP_SYNC_SYNACK,         "Synchronization, sync-ack" },
-        { ORP_SYNC_ACK,            "Synchronization, ack" },
-
-        { ORP_RQST_FILE_DATA,      "Request, File transfer data" },
-        { ORP_RESP_FILE_DATA,      "Response, File transfer data" },
-        { ORP_NTFY_FILE_CONTROL,   "Notification, File transfer control" },
-        { ORP_RESP_FILE_CONTROL,   "Response, File transfer control" },
-
-        { ORP_RESP_UNKNOWN_RQST,   "Response, unknown request" },
+        { ORP_PACKET_TYPE_UNKNOWN, ORP_BYTE1_NONE, "Unknown packet type" },
+#define X(packet, encoded, decoded, byte1, fields, name)  { decoded, ORP_BYTE1_##byte1, name },
+        ORP_PACKET_SCHEMA(X)
+#undef X
     };
 
     const char *statusStr[] = {
@@ -118,40 +89,53 @@ void orp_MessagePrint
     };
 
     const char *packetName = "Unknown";
+    enum orp_Byte1Field byte1 = ORP_BYTE1_NONE;
     for (int i = 0; i < (sizeof(packetNames) / sizeof(packetNames[0])); i++)
     {
         if (message->type == packetNames[i].type)
         {
             packetName = packetNames[i].name;
+            byte1 = packetNames[i].byte1;
             break;
         }
     }
     printf("\tType     : %s\n", packetName);
-    switch (message->type)
+    switch (byte1)
     {
-        // Byte[1] is unused on these notification packets
-        case ORP_NTFY_HANDLER_CALL:
-        case ORP_NTFY_SENSOR_CALL:
+        case ORP_BYTE1_STATUS:
+            printf("\tStatus   : %d (%s)\n", (int)message->status, statusStr[message->status * -1]);
             break;
 
-        case ORP_NTFY_FILE_CONTROL:
+        case ORP_BYTE1_DATA_TYPE:
+            printf("\tData type: %d\n", message->dataType);
+            break;
+
+        case ORP_BYTE1_VERSION:
+            printf("\tVersion  : %d\n", message->version);
+            break;
+
+        case ORP_BYTE1_EVENT:
             printf("\tEvent    : %d\n", (int)message->status);
             break;
 
         default:
-            if (message->type & ORP_RESPONSE_MASK)
-            {
-                printf("\tStatus   : %d (%s)\n", (int)message->status, statusStr[message->status * -1]);
-            }
-            else
-            {
-                printf("\tData type: %d\n", message->dataType);
-            }
+            // Byte[1] is unused
             break;
     }
 
     printf("\tSequence : %u\n", message->sequenceNum);
-    if (message->timestamp > 0.0)
+    if (   (message->time.seconds > 0) || message->timeDelta
+        || ((0 == message->time.seconds) && message->time.microseconds))
+    {
+        char timeStr[ORP_PROTOCOL_TIMESTAMP_LEN_MAX + 1];
+
+        // A delta from the session time base, as sent
+        if (orp_TimeFormat(timeStr, sizeof(timeStr), &message->time) > 0)
+        {
+            printf("\tTimestamp: %s%s\n", message->timeDelta ? "+" : "", timeStr);
+        }
+    }
+    else if (message->timestamp > 0.0)
     {
         printf("\tTimestamp: %lf\n", message->timestamp);
     }
@@ -159,6 +143,18 @@ void orp_MessagePrint
     {
         printf("\tPath     : %s\n", message->path);
     }
+    if (message->pathId >= 0)
+    {
+        printf("\tPath id  : %d\n", message->pathId);
+    }
+    if (message->capabilities)
+    {
+        printf("\tCapabilities: 0x%X\n", message->capabilities);
+    }
+    if (message->recordCount)
+    {
+        printf("\tRecords  : %zu\n", message->recordCount);
+    }
     if (message->data && message->dataLen)
     {
         // In case of file transfer, do not print data which can be binary
@@ -0,0 +1,670 @@
+/**
+ * @file:    codecTest.c
+ *
+ * Purpose:  Round-trip messages through the ASCII and binary codecs
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Sierra Wireless Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *----------------------------------------------------------------------------
+ *
+ * NOTES:
+ *
+ * For each message in a set covering every field, records and binary data, in each encoding:
+ *
+ *  - encodedsize gives the length encode produces
+ *  - the segments of encodev, concatenated, are the packet encode produces
+ *  - decode gives back the message
+ *  - decodeview of the packet agrees with decode, field by field, records included
+ *
+ * Packet types the client only sends must be rejected by both decoders.  In ASCII, a field which
+ * the packet type, or its records, do not carry must be rejected by decode.
+ *
+ * Every truncation of each packet, and random corruptions of it, are then decoded both ways.
+ * Each copy is allocated to size, so that a sanitizer catches any read or write beyond it.  As
+ * the view parses fields only when they are read, it may accept a packet which decode rejects,
+ * but not the reverse, and where both accept one, they must agree.
+ *
+ * The codecs log each packet they reject.  Those logs are compiled out of this test.
+ *
+ * Usage:  codecTest [random seed]
+ *
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include "orpProtocol.h"
+#include "testUtil.h"
+
+
+#define CODEC_TEST_PACKET_MAX       4096
+#define CODEC_TEST_RECORDS_MAX      8
+#define CODEC_TEST_CORRUPTIONS      200
+
+static uint64_t draws = 0;
+
+// Records of the batch messages
+static struct orp_Message pushRecords[3];
+static struct orp_Message getRecords[2];
+
+// Data which any ASCII field parser might trip over
+static const uint8_t fileData[] = { 0x00, 0x7E, ',', 'D', 0x7D, 0xFF, '\r', '\n', 0x01, 0x80 };
+
+// Checks name the message and encoding under test, from the context in scope
+#define CODEC_TEST_CHECK(cond, format, ...)                                                        \
+    TEST_CHECK(cond, "%s: " format, context, ##__VA_ARGS__)
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize a message of the test set, with the fields its packet type carries
+ *
+ * @return: false past the end of the set
+ */
+//--------------------------------------------------------------------------------------------------
+static bool test_MessageInit
+(
+    size_t              index,
+    struct orp_Message *msg
+)
+{
+    static const struct
+    {
+        enum orp_PacketType type;
+        enum orp_IoDataType dataType;
+        int                 status;
+        int64_t             seconds;
+        uint32_t            microseconds;
+        bool                timeDelta;
+        const char         *path;
+        int                 pathId;
+        const char         *unit;
+        const char         *data;
+    }
+    set[] =
+    {
+        { ORP_RQST_PUSH, ORP_IO_DATA_TYPE_STRING, 0, 1613411234, 500001, false,
+          "/app/sensor/value", ORP_PATH_ID_NONE, NULL, "hello, world" },
+        { ORP_RQST_PUSH, ORP_IO_DATA_TYPE_NUMERIC, 0, 12, 250000, true,
+          "/app/sensor/temp", 42, NULL, "21.5" },
+        { ORP_RQST_PUSH, ORP_IO_DATA_TYPE_JSON, 0, ORP_TIME_SECONDS_INVALID, 0, false,
+          NULL, 9999, NULL, "{\"a\":1,\"b\":[2,3]}" },
+        { ORP_RQST_PUSH, ORP_IO_DATA_TYPE_BOOLEAN, 0, 0, 0, false,
+          "/app/flag", ORP_PATH_ID_NONE, NULL, "true" },
+        { ORP_RQST_INPUT_CREATE, ORP_IO_DATA_TYPE_NUMERIC, 0, ORP_TIME_SECONDS_INVALID, 0, false,
+          "/app/sensor/temp", ORP_PATH_ID_NONE, "degC", NULL },
+        { ORP_RQST_OUTPUT_CREATE, ORP_IO_DATA_TYPE_TRIGGER, 0, ORP_TIME_SECONDS_INVALID, 0, false,
+          "", ORP_PATH_ID_NONE, NULL, NULL },
+        { ORP_RQST_SENSOR_REMOVE, ORP_IO_DATA_TYPE_UNDEF, 0, ORP_TIME_SECONDS_INVALID, 0, false,
+          NULL, 7, NULL, NULL },
+        { ORP_RESP_GET, ORP_IO_DATA_TYPE_UNDEF, 0, 99999999999, 999999, false,
+          NULL, ORP_PATH_ID_NONE, NULL, "-1.25e-3" },
+        { ORP_RESP_PUSH, ORP_IO_DATA_TYPE_UNDEF, -1, ORP_TIME_SECONDS_INVALID, 0, false,
+          NULL, ORP_PATH_ID_NONE, NULL, NULL },
+        { ORP_NTFY_HANDLER_CALL, ORP_IO_DATA_TYPE_UNDEF, 0, 1, 1, false,
+          "/app/control", ORP_PATH_ID_NONE, NULL, "on" },
+        { ORP_NTFY_FILE_CONTROL, ORP_IO_DATA_TYPE_UNDEF, 3, ORP_TIME_SECONDS_INVALID, 0, false,
+          NULL, ORP_PATH_ID_NONE, NULL, "auto" },
+        { ORP_SYNC_SYN, ORP_IO_DATA_TYPE_UNDEF, 0, 1613411234, 0, false,
+          NULL, ORP_PATH_ID_NONE, NULL, NULL },
+        { ORP_SYNC_SYNACK, ORP_IO_DATA_TYPE_UNDEF, 0, ORP_TIME_SECONDS_INVALID, 0, false,
+          NULL, ORP_PATH_ID_NONE, NULL, NULL },
+        { ORP_SYNC_ACK, ORP_IO_DATA_TYPE_UNDEF, 0, ORP_TIME_SECONDS_INVALID, 0, false,
+          NULL, ORP_PATH_ID_NONE, NULL, NULL },
+        { ORP_RQST_FILE_DATA, ORP_IO_DATA_TYPE_UNDEF, 0, ORP_TIME_SECONDS_INVALID, 0, false,
+          NULL, ORP_PATH_ID_NONE, NULL, NULL },
+        { ORP_RQST_PUSH_BATCH, ORP_IO_DATA_TYPE_NUMERIC, 0, ORP_TIME_SECONDS_INVALID, 0, false,
+          NULL, ORP_PATH_ID_NONE, NULL, NULL },
+        { ORP_RESP_GET_BATCH, ORP_IO_DATA_TYPE_UNDEF, 0, ORP_TIME_SECONDS_INVALID, 0, false,
+          NULL, ORP_PATH_ID_NONE, NULL, NULL },
+        { ORP_RESP_UNKNOWN_RQST, ORP_IO_DATA_TYPE_UNDEF, 0, ORP_TIME_SECONDS_INVALID, 0, false,
+          NULL, ORP_PATH_ID_NONE, NULL, NULL },
+    };
+
+    if (index >= sizeof(set) / sizeof(set[0]))
+    {
+        return false;
+    }
+
+    orp_MessageInit(msg, set[index].type, set[index].status);
+    msg->dataType = set[index].dataType;
+    msg->sequenceNum = (uint16_t)(0xFFF0 + index * 3);
+    msg->time.seconds = set[index].seconds;
+    msg->time.microseconds = set[index].microseconds;
+    msg->timeDelta = set[index].timeDelta;
+    msg->path = set[index].path;
+    msg->pathId = set[index].pathId;
+    msg->unit = set[index].unit;
+    msg->data = (void *)set[index].data;
+    msg->dataLen = set[index].data ? strlen(set[index].data) : 0;
+
+    switch (msg->type)
+    {
+        case ORP_SYNC_SYN:
+        case ORP_SYNC_SYNACK:
+            msg->version = ORP_PROTOCOL_V2;
+            msg->mtu = 1024;
+            msg->sentCount = 7;
+            msg->receivedCount = 123456;
+            msg->capabilities = ORP_CAPABILITY_PATH_ID | ORP_CAPABILITY_TIME_DELTA;
+            break;
+
+        case ORP_SYNC_ACK:
+            msg->version = ORP_PROTOCOL_V2;
+            break;
+
+        case ORP_RQST_FILE_DATA:
+            msg->data = (void *)fileData;
+            msg->dataLen = sizeof(fileData);
+            break;
+
+        case ORP_RQST_PUSH_BATCH:
+            for (size_t i = 0; i < 3; i++)
+            {
+                static const char *const values[] = { "1", "2.5", "-300" };
+                struct orp_Message *record = &pushRecords[i];
+
+                orp_MessageInit(record, msg->type, 0);
+                record->dataType = msg->dataType;
+                record->sequenceNum = msg->sequenceNum;
+                record->time.seconds = 1613411234 + i;
+                record->time.microseconds = 10 * i;
+                record->path = (1 == i) ? NULL : "/app/sensor/level";
+                record->pathId = (0 == i) ? ORP_PATH_ID_NONE : 3;
+                record->data = (void *)values[i];
+                record->dataLen = strlen(values[i]);
+            }
+            msg->records = pushRecords;
+            msg->recordCount = 3;
+            break;
+
+        case ORP_RESP_GET_BATCH:
+            for (size_t i = 0; i < 2; i++)
+            {
+                struct orp_Message *record = &getRecords[i];
+
+                orp_MessageInit(record, msg->type, i ? -1 : 0);
+                record->dataType = msg->dataType;
+                record->sequenceNum = msg->sequenceNum;
+                record->time.seconds = i ? ORP_TIME_SECONDS_INVALID : 5;
+                record->path = i ? "/app/missing" : "/app/present";
+                record->data = i ? NULL : "text";
+                record->dataLen = i ? 0 : 4;
+            }
+            msg->records = getRecords;
+            msg->recordCount = 2;
+            break;
+
+        default:
+            break;
+    }
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Packet types of the test set which the client only sends.  Their byte 1 is not accepted on
+ * receipt, see ORP_BYTE1_NONE
+ */
+//--------------------------------------------------------------------------------------------------
+static bool test_SentOnly
+(
+    enum orp_PacketType type
+)
+{
+    return (ORP_RQST_SENSOR_REMOVE == type) || (ORP_RESP_UNKNOWN_RQST == type);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compare a decoded message with the message encoded
+ */
+//--------------------------------------------------------------------------------------------------
+static void test_MessageCompare
+(
+    const char               *context,
+    const struct orp_Message *expected,
+    const struct orp_Message *decoded
+)
+{
+    const char *path = expected->path ? expected->path : "";
+    const char *unit = expected->unit ? expected->unit : "";
+
+    CODEC_TEST_CHECK(decoded->type == expected->type, "type %d", decoded->type);
+    CODEC_TEST_CHECK(decoded->dataType == expected->dataType, "data type %d", decoded->dataType);
+    CODEC_TEST_CHECK(decoded->version == expected->version, "version %d", decoded->version);
+    CODEC_TEST_CHECK(decoded->status == expected->status, "status %d", decoded->status);
+    CODEC_TEST_CHECK(decoded->sequenceNum == expected->sequenceNum, "sequence %u",
+                     decoded->sequenceNum);
+    CODEC_TEST_CHECK(0 == strcmp(decoded->path, path), "path '%s'", decoded->path);
+    CODEC_TEST_CHECK(decoded->pathId == expected->pathId, "path ID %d", decoded->pathId);
+    CODEC_TEST_CHECK(0 == strcmp(decoded->unit, unit), "unit '%s'", decoded->unit);
+
+    CODEC_TEST_CHECK(decoded->time.seconds == expected->time.seconds, "seconds %lld",
+                     (long long)decoded->time.seconds);
+    if (ORP_TIME_SECONDS_INVALID != expected->time.seconds)
+    {
+        CODEC_TEST_CHECK(decoded->time.microseconds == expected->time.microseconds,
+                         "microseconds %u", decoded->time.microseconds);
+        CODEC_TEST_CHECK(decoded->timeDelta == expected->timeDelta, "time delta %d",
+                         decoded->timeDelta);
+    }
+
+    if (!expected->dataLen)
+    {
+        CODEC_TEST_CHECK(!decoded->dataLen, "data length %zu", decoded->dataLen);
+    }
+    else if (ORP_IO_DATA_TYPE_NUMERIC == expected->dataType)
+    {
+        // Binary carries numbers as IEEE-754, and decodes them back to text
+        CODEC_TEST_CHECK(decoded->data && (strtod(decoded->data, NULL) ==
+                                           strtod(expected->data, NULL)),
+                         "numeric data '%s'", decoded->data ? (char *)decoded->data : "");
+    }
+    else
+    {
+        CODEC_TEST_CHECK((decoded->dataLen == expected->dataLen) &&
+                         (0 == memcmp(decoded->data, expected->data, expected->dataLen)),
+                         "data length %zu", decoded->dataLen);
+    }
+
+    if ((ORP_SYNC_SYN == expected->type) || (ORP_SYNC_SYNACK == expected->type))
+    {
+        CODEC_TEST_CHECK(decoded->mtu == expected->mtu, "MTU %d", decoded->mtu);
+        CODEC_TEST_CHECK(decoded->sentCount == expected->sentCount, "sent count %d",
+                         decoded->sentCount);
+        CODEC_TEST_CHECK(decoded->receivedCount == expected->receivedCount,
+                         "received count %d", decoded->receivedCount);
+        CODEC_TEST_CHECK(decoded->capabilities == expected->capabilities, "capabilities 0x%X",
+                         decoded->capabilities);
+    }
+
+    CODEC_TEST_CHECK(decoded->recordCount == expected->recordCount, "record count %zu",
+                     decoded->recordCount);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compare a field of a view with a null-terminated decoded field
+ */
+//--------------------------------------------------------------------------------------------------
+static bool test_FieldEquals
+(
+    const struct orp_Field *field,
+    const char             *decoded
+)
+{
+    size_t len = strlen(decoded);
+    size_t fieldLen = field->ptr ? field->len : 0;
+    const uint8_t *nul = fieldLen ? memchr(field->ptr, '\0', fieldLen) : NULL;
+
+    // Decoded strings end at any null the packet carries
+    if (nul)
+    {
+        fieldLen = nul - field->ptr;
+    }
+    return (fieldLen == len) && (!len || !memcmp(field->ptr, decoded, len));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Integer field of a view, or a default if it is absent
+ */
+//--------------------------------------------------------------------------------------------------
+static int test_ViewInt
+(
+    const struct orp_MessageView *view,
+    const struct orp_Field       *field,
+    int                           absent
+)
+{
+    int value = absent;
+
+    if (field->ptr && !orp_ViewInt(view, field, &value))
+    {
+        return -2;
+    }
+    return value;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compare the view of a packet, or of a record, with its decoded message
+ */
+//--------------------------------------------------------------------------------------------------
+static void test_ViewCompare
+(
+    const char                   *context,
+    const struct orp_MessageView *view,
+    const struct orp_Message     *decoded
+)
+{
+    struct orp_Time time;
+    bool timeValid = orp_ViewTime(view, &time);
+    int status = view->status;
+    int recordStatus;
+    double number;
+
+    // As orp_ViewRecordNext() does for a record, apply any status field
+    if (view->recordStatus.ptr && orp_ViewInt(view, &view->recordStatus, &recordStatus))
+    {
+        status = -recordStatus;
+    }
+
+    CODEC_TEST_CHECK(view->type == decoded->type, "view type %d", view->type);
+    CODEC_TEST_CHECK(view->dataType == decoded->dataType, "view data type %d", view->dataType);
+    CODEC_TEST_CHECK(view->version == decoded->version, "view version %d", view->version);
+    CODEC_TEST_CHECK(status == decoded->status, "view status %d", status);
+    CODEC_TEST_CHECK(view->sequenceNum == decoded->sequenceNum, "view sequence %u",
+                     view->sequenceNum);
+    CODEC_TEST_CHECK(test_FieldEquals(&view->path, decoded->path), "view path");
+    CODEC_TEST_CHECK(test_FieldEquals(&view->unit, decoded->unit), "view unit");
+    CODEC_TEST_CHECK(test_ViewInt(view, &view->pathId, ORP_PATH_ID_NONE) == decoded->pathId,
+                     "view path ID");
+
+    if (ORP_TIME_SECONDS_INVALID == decoded->time.seconds)
+    {
+        CODEC_TEST_CHECK(!timeValid, "view time present");
+    }
+    else
+    {
+        CODEC_TEST_CHECK(timeValid && (time.seconds == decoded->time.seconds) &&
+                         (time.microseconds == decoded->time.microseconds) &&
+                         (view->timeDelta == decoded->timeDelta), "view time");
+    }
+
+    if (view->numeric.ptr)
+    {
+        double expected = decoded->data ? strtod(decoded->data, NULL) : 0;
+
+        CODEC_TEST_CHECK(decoded->data && orp_ViewNumeric(view, &number) &&
+                         ((number == expected) || (isnan(number) && isnan(expected))),
+                         "view numeric %g", number);
+    }
+    else
+    {
+        CODEC_TEST_CHECK((view->data.ptr ? view->data.len : 0) == decoded->dataLen &&
+                         (!decoded->dataLen ||
+                          !memcmp(view->data.ptr, decoded->data, decoded->dataLen)),
+                         "view data length %zu", view->data.len);
+    }
+
+    CODEC_TEST_CHECK(test_ViewInt(view, &view->mtu, 0) == decoded->mtu, "view MTU");
+    CODEC_TEST_CHECK(test_ViewInt(view, &view->sentCount, 0) == decoded->sentCount,
+                     "view sent count");
+    CODEC_TEST_CHECK(test_ViewInt(view, &view->receivedCount, 0) == decoded->receivedCount,
+                     "view received count");
+    CODEC_TEST_CHECK((unsigned int)test_ViewInt(view, &view->capabilities, 0) ==
+                     decoded->capabilities, "view capabilities");
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode a packet both ways, from copies allocated to size
+ *
+ * @return: true if both accepted it.  They must then agree, records included
+ */
+//--------------------------------------------------------------------------------------------------
+static bool test_Decode
+(
+    const char                     *context,
+    const struct orp_ProtocolCodec *codec,
+    const uint8_t                  *packet,
+    size_t                          len,
+    struct orp_Message             *decoded,
+    struct orp_Message             *records,
+    size_t                         *recordCount,
+    uint8_t                       **decodedBuf
+)
+{
+    // decode null-terminates its last field at packet[len]
+    uint8_t *copy = malloc(len + 1);
+    uint8_t *viewCopy = malloc(len ? len : 1);
+    struct orp_MessageView view;
+    struct orp_MessageView recordView;
+    size_t offset = 0;
+    size_t count = 0;
+    bool decodeOk;
+    bool viewOk;
+
+    memcpy(copy, packet, len);
+    memcpy(viewCopy, packet, len);
+    decodeOk = codec->decode(copy, len, decoded);
+    viewOk = codec->decodeview(viewCopy, len, &view);
+
+    *recordCount = CODEC_TEST_RECORDS_MAX;
+    if (decodeOk && !codec->decoderecords(decoded, records, recordCount))
+    {
+        decodeOk = false;
+    }
+
+    // Walk the records of the view, whether or not decode accepted the packet
+    while (viewOk && orp_ViewRecordNext(&view, &offset, &recordView))
+    {
+        if (decodeOk && (count < *recordCount))
+        {
+            test_ViewCompare(context, &recordView, &records[count]);
+        }
+        count++;
+    }
+
+    if (decodeOk && viewOk)
+    {
+        test_ViewCompare(context, &view, decoded);
+        CODEC_TEST_CHECK((count == *recordCount) && (offset >= view.records.len),
+                         "view records %zu, decoded %zu", count, *recordCount);
+    }
+    else
+    {
+        // The view parses fields only when read, so may accept what decode rejects
+        CODEC_TEST_CHECK(!decodeOk, "length %zu: decoded, but decodeview failed", len);
+    }
+
+    free(viewCopy);
+    *decodedBuf = copy;
+    return decodeOk && viewOk;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode a message every way, and check that it decodes back.  Then decode every truncation and
+ * some corruptions of the packet
+ */
+//--------------------------------------------------------------------------------------------------
+static void test_RoundTrip
+(
+    const struct orp_ProtocolCodec *codec,
+    const struct orp_Message       *msg
+)
+{
+    char context[64];
+    uint8_t packet[CODEC_TEST_PACKET_MAX];
+    uint8_t header[CODEC_TEST_PACKET_MAX];
+    uint8_t joined[CODEC_TEST_PACKET_MAX];
+    uint8_t corrupt[CODEC_TEST_PACKET_MAX];
+    struct iovec segments[2];
+    int segmentCount = 2;
+    struct orp_Message copy;
+    struct orp_Message decoded;
+    struct orp_Message records[CODEC_TEST_RECORDS_MAX];
+    size_t recordCount;
+    size_t packetLen = sizeof(packet);
+    size_t joinedLen = 0;
+    size_t size;
+    uint8_t *decodedBuf;
+
+    snprintf(context, sizeof(context), "%s packet type %d, sequence %u",
+             (ORP_PROTOCOL_ENCODING_ASCII == codec->encoding) ? "ASCII" : "binary",
+             msg->type, msg->sequenceNum);
+
+    // The encoders may consume the data length, so each is given a copy
+    size = codec->encodedsize(msg);
+    copy = *msg;
+    CODEC_TEST_CHECK(codec->encode(packet, &packetLen, &copy), "encode");
+    CODEC_TEST_CHECK(size == packetLen, "encoded size %zu, encoded %zu", size, packetLen);
+
+    copy = *msg;
+    CODEC_TEST_CHECK(codec->encodev(header, sizeof(header), segments, &segmentCount, &copy),
+                     "encodev");
+    for (int i = 0; i < segmentCount; i++)
+    {
+        if (joinedLen + segments[i].iov_len <= sizeof(joined))
+        {
+            memcpy(joined + joinedLen, segments[i].iov_base, segments[i].iov_len);
+        }
+        joinedLen += segments[i].iov_len;
+    }
+    CODEC_TEST_CHECK((joinedLen == packetLen) && (0 == memcmp(joined, packet, packetLen)),
+                     "encodev %zu bytes in %d segments, encode %zu bytes",
+                     joinedLen, segmentCount, packetLen);
+
+    if (test_SentOnly(msg->type))
+    {
+        CODEC_TEST_CHECK(!test_Decode(context, codec, packet, packetLen, &decoded, records,
+                                      &recordCount, &decodedBuf), "decoded a request");
+    }
+    else
+    {
+        CODEC_TEST_CHECK(test_Decode(context, codec, packet, packetLen, &decoded, records,
+                                     &recordCount, &decodedBuf), "decode");
+        test_MessageCompare(context, msg, &decoded);
+        for (size_t i = 0; (i < recordCount) && (i < msg->recordCount); i++)
+        {
+            test_MessageCompare(context, &msg->records[i], &records[i]);
+        }
+    }
+    free(decodedBuf);
+
+    // Truncated.  Decoding may succeed, as a shorter packet, but must stay within the packet
+    for (size_t len = 0; len < packetLen; len++)
+    {
+        test_Decode(context, codec, packet, len, &decoded, records, &recordCount, &decodedBuf);
+        free(decodedBuf);
+    }
+
+    // Corrupted: one to three bytes replaced
+    for (int i = 0; i < CODEC_TEST_CORRUPTIONS; i++)
+    {
+        int bytes = 1 + test_Random(draws++) % 3;
+
+        memcpy(corrupt, packet, packetLen);
+        for (int j = 0; j < bytes; j++)
+        {
+            size_t pos = test_Random(draws++) % packetLen;
+
+            corrupt[pos] = (uint8_t)test_Random(draws++);
+        }
+        test_Decode(context, codec, corrupt, packetLen, &decoded, records, &recordCount,
+                    &decodedBuf);
+        free(decodedBuf);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode ASCII packets with and without a field their packet type, or its records, do not carry
+ */
+//--------------------------------------------------------------------------------------------------
+static void test_FieldsCarried
+(
+    const struct orp_ProtocolCodec *codec
+)
+{
+    static const struct
+    {
+        const char *packet;
+        bool        accepted;
+    }
+    cases[] =
+    {
+        { "p@01",             true  },
+        { "p@01P/a",          false },
+        { "g@01T1.5,D1",      true  },
+        { "g@01T1.5,UmV,D1",  false },
+        { "q@01N6:E1,P/a",    true  },
+        { "q@01N6:UmV,D1",    false },
+    };
+    const char *context = "ASCII fields carried";
+    struct orp_Message decoded;
+    struct orp_Message records[CODEC_TEST_RECORDS_MAX];
+    size_t recordCount;
+    uint8_t *decodedBuf;
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        bool accepted = test_Decode(context, codec, (const uint8_t *)cases[i].packet,
+                                    strlen(cases[i].packet), &decoded, records, &recordCount,
+                                    &decodedBuf);
+
+        CODEC_TEST_CHECK(accepted == cases[i].accepted, "%s %s", cases[i].packet,
+                         accepted ? "accepted" : "rejected");
+        free(decodedBuf);
+    }
+}
+
+
+int main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    static const enum orp_ProtocolEncoding encodings[] =
+    {
+        ORP_PROTOCOL_ENCODING_ASCII,
+        ORP_PROTOCOL_ENCODING_BINARY,
+    };
+    struct orp_ProtocolCodec codec;
+    struct orp_Message msg;
+    const char *context = "init";
+
+    test_SeedParse(argc, argv);
+
+    for (size_t e = 0; e < sizeof(encodings) / sizeof(encodings[0]); e++)
+    {
+        CODEC_TEST_CHECK(orp_ProtocolCodecInit(ORP_PROTOCOL_V1, encodings[e], &codec),
+                         "codec %d", encodings[e]);
+        for (size_t i = 0; test_MessageInit(i, &msg); i++)
+        {
+            test_RoundTrip(&codec, &msg);
+        }
+        if (ORP_PROTOCOL_ENCODING_ASCII == encodings[e])
+        {
+            test_FieldsCarried(&codec);
+        }
+    }
+
+    printf("codecTest: %lu checks, %lu failures\n", checks, failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,185 @@
+/**
+ * @file:    crcTest.c
+ *
+ * Purpose:  Check every CRC-16/CCITT kernel against a bitwise reference
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Sierra Wireless Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *----------------------------------------------------------------------------
+ *
+ * NOTES:
+ *
+ * The reference shifts one bit at a time through a register, with polynomial 0x1021, and shares
+ * nothing with crc.c, whose tables it checks too.  crc.c is included, rather than linked, to reach
+ * its kernels directly.  For random initial values, every length from 0 to CRC_TEST_LEN_MAX and
+ * every start offset within a 16 byte block, the reference is compared with:
+ *
+ * - the slicing-by-8 kernel, whose 8 byte loop and trailing bytes between them cover every table
+ * - the single byte update
+ * - the folding kernel, from CRC_CLMUL_LEN_MIN bytes, where the CPU supports it, through its
+ *   accumulator loop, block loop and trailing bytes
+ * - crc16_update, whichever kernel it selects, with the buffer whole and split at a random point,
+ *   to check that updates chain
+ *
+ * On an x86-64 CPU with PCLMULQDQ, the folding kernel must have been selected: it falls back to
+ * the tables, silently other than a log, if its start-up self-test fails.
+ *
+ * Usage:  crcTest [random seed]
+ *
+ */
+
+#include <stdbool.h>
+#include "testUtil.h"
+#include "../src/crc.c"
+
+
+#define CRC_TEST_LEN_MAX        4096
+#define CRC_TEST_OFFSET_MAX     16
+#define CRC_TEST_POLY           0x1021
+
+static uint8_t data[CRC_TEST_LEN_MAX + CRC_TEST_OFFSET_MAX];
+static uint64_t draws = 0;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * CRC of a buffer, one bit at a time
+ */
+//--------------------------------------------------------------------------------------------------
+static uint16_t test_Reference
+(
+    uint16_t       crc,
+    const uint8_t *buf,
+    size_t         len
+)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= (uint16_t)(buf[i] << 8);
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ CRC_TEST_POLY) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * CRC of a buffer, through the single byte update
+ */
+//--------------------------------------------------------------------------------------------------
+static uint16_t test_ByteUpdate
+(
+    uint16_t       crc,
+    const uint8_t *buf,
+    size_t         len
+)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        crc = _crc_ccitt_update(crc, buf[i]);
+    }
+    return crc;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check that the folding kernel is in use, where the CPU supports it
+ */
+//--------------------------------------------------------------------------------------------------
+static void test_KernelCheck
+(
+    void
+)
+{
+#ifdef CRC_CLMUL_SUPPORTED
+    unsigned int eax, ebx, ecx, edx;
+    bool supported = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_PCLMUL) &&
+                     (ecx & bit_SSSE3);
+
+    TEST_CHECK(crc_clmulEnabled == supported, "CPU %s PCLMULQDQ, but the folding kernel is %s",
+               supported ? "supports" : "lacks", crc_clmulEnabled ? "enabled" : "disabled");
+    printf("Kernel: %s\n", crc_clmulEnabled ? "clmul" : "table");
+#else
+    printf("Kernel: table\n");
+#endif
+}
+
+
+int main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    test_SeedParse(argc, argv);
+    for (size_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)test_Random(draws++);
+    }
+
+    test_KernelCheck();
+
+    for (size_t len = 0; len <= CRC_TEST_LEN_MAX; len++)
+    {
+        for (size_t offset = 0; offset < CRC_TEST_OFFSET_MAX; offset++)
+        {
+            const uint8_t *buf = data + offset;
+            uint16_t init = (uint16_t)test_Random(draws++);
+            size_t split = test_Random(draws++) % (len + 1);
+            uint16_t expected = test_Reference(init, buf, len);
+            uint16_t crc;
+
+            crc = crc16_UpdateTable(init, buf, len);
+            TEST_CHECK(crc == expected, "table: init 0x%04X, length %zu, offset %zu: 0x%04X, "
+                       "expected 0x%04X", init, len, offset, crc, expected);
+
+            crc = test_ByteUpdate(init, buf, len);
+            TEST_CHECK(crc == expected, "byte: init 0x%04X, length %zu, offset %zu: 0x%04X, "
+                       "expected 0x%04X", init, len, offset, crc, expected);
+
+#ifdef CRC_CLMUL_SUPPORTED
+            if (crc_clmulEnabled && (len >= CRC_CLMUL_LEN_MIN))
+            {
+                crc = crc16_UpdateClmul(init, buf, len);
+                TEST_CHECK(crc == expected, "clmul: init 0x%04X, length %zu, offset %zu: 0x%04X, "
+                           "expected 0x%04X", init, len, offset, crc, expected);
+            }
+#endif
+
+            crc = crc16_update(init, buf, len);
+            TEST_CHECK(crc == expected, "update: init 0x%04X, length %zu, offset %zu: 0x%04X, "
+                       "expected 0x%04X", init, len, offset, crc, expected);
+
+            crc = crc16_update(crc16_update(init, buf, split), buf + split, len - split);
+            TEST_CHECK(crc == expected, "chained: init 0x%04X, length %zu, offset %zu, split %zu: "
+                       "0x%04X, expected 0x%04X", init, len, offset, split, crc, expected);
+        }
+    }
+
+    printf("crcTest: %lu checks, %lu failures\n", checks, failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
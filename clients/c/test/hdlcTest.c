@@ -0,0 +1,720 @@
+/**
+ * @file:    hdlcTest.c
+ *
+ * Purpose:  Check the HDLC framing routines against hdlc_Pack and hdlc_Unpack
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Sierra Wireless Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *----------------------------------------------------------------------------
+ *
+ * NOTES:
+ *
+ * hdlc_Pack, with hdlc_PackFinalize, and hdlc_Unpack, each called once per frame, are the
+ * references which the other routines are checked against, byte for byte.
+ *
+ * Bursts of random frames, some with idle flags between them, and with random payloads which
+ * range from no bytes needing escape to nothing else, are unpacked by hdlc_UnpackBurst, in random
+ * chunks, and by hdlc_Unpack.  Both must report the same frames, and those must be the payloads.
+ *
+ * Bursts are then damaged, one frame at a time: a bit flipped, the end of a frame lost, up to the
+ * flag which opens the next, or an escape ahead of the flag which closes it.  hdlc_Unpack must
+ * reject each damaged frame, and still unpack the frame which follows it, having scanned the flag
+ * which ended the damaged one again as an opening flag.  hdlc_UnpackBurst must agree, on the
+ * burst whole, or in chunks.
+ *
+ * Random payloads, split into random segments, are framed by hdlc_PackV, given few output
+ * segments and little scratch space, so that it is called again and again to resume, and
+ * sometimes followed by hdlc_Pack for the rest of the payload.  The output segments, concatenated,
+ * must be the frame hdlc_Pack gives.
+ *
+ * hdlc_PackInPlace must give that frame too, in a buffer allocated to the size of the frame, so
+ * that a sanitizer catches any write beyond it, or to more, and refuse a buffer one byte short.
+ *
+ * The routines log each frame they reject.  Those logs are compiled out of this test.
+ *
+ * Usage:  hdlcTest [random seed]
+ *
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "testUtil.h"
+#include "hdlc.h"
+#include "crc.h"
+
+
+#define HDLC_TEST_BURSTS        2000
+#define HDLC_TEST_FRAMES_MAX    8
+#define HDLC_TEST_PAYLOAD_MAX   600
+#define HDLC_TEST_PACKS         20000
+#define HDLC_TEST_SEGMENTS_MAX  8
+
+// Longest frame: every payload and CRC byte escaped, between two flags.  A burst may also have an
+// idle flag ahead of each frame
+#define HDLC_TEST_FRAME_MAX     (2 * HDLC_TEST_PAYLOAD_MAX + HDLC_OVERHEAD_BYTES_COUNT)
+#define HDLC_TEST_BURST_MAX     (HDLC_TEST_FRAMES_MAX * (1 + HDLC_TEST_FRAME_MAX))
+
+// A frame, or an error, reported by an unpacking routine
+struct test_Event
+{
+    int     status;
+    size_t  length;
+    uint8_t data[HDLC_TEST_BURST_MAX];
+};
+
+static uint64_t draws = 0;
+static uint8_t payloads[HDLC_TEST_FRAMES_MAX][HDLC_TEST_PAYLOAD_MAX];
+static size_t payloadLens[HDLC_TEST_FRAMES_MAX];
+static uint8_t wire[HDLC_TEST_BURST_MAX];
+static struct test_Event expected[HDLC_TEST_FRAMES_MAX];
+static struct test_Event reference[HDLC_TEST_FRAMES_MAX];
+static struct test_Event burst[HDLC_TEST_FRAMES_MAX];
+
+// Damage done to a frame of a burst
+enum test_Damage
+{
+    TEST_DAMAGE_NONE,
+    TEST_DAMAGE_FLIP,                   // A bit flipped
+    TEST_DAMAGE_TRUNCATE,               // The end lost, up to the flag opening the next frame
+    TEST_DAMAGE_ESCAPE,                 // An escape ahead of the closing flag
+    TEST_DAMAGE_COUNT
+};
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fill a payload with random bytes, of which a random share need escaping
+ */
+//--------------------------------------------------------------------------------------------------
+static void test_Payload
+(
+    uint8_t *payload,
+    size_t   len
+)
+{
+    // Escape one byte in: never, 64, 2 or every one
+    static const unsigned int periods[] = { 0, 64, 2, 1 };
+    unsigned int period = periods[test_Random(draws++) % 4];
+
+    for (size_t i = 0; i < len; i++)
+    {
+        uint64_t r = test_Random(draws++);
+
+        if (period && (0 == (r >> 8) % period))
+        {
+            payload[i] = (r & 1) ? 0x7E : 0x7D;
+        }
+        else
+        {
+            payload[i] = (uint8_t)r;
+            if ((0x7E == payload[i]) || (0x7D == payload[i]))
+            {
+                payload[i] ^= 0x80;
+            }
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Frame a payload with hdlc_Pack and hdlc_PackFinalize
+ *
+ * @return: length of the frame
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t test_Frame
+(
+    const uint8_t *payload,
+    size_t         len,
+    uint8_t       *frame
+)
+{
+    hdlc_context_t hdlc;
+    size_t packed = len;
+    ssize_t frameLen;
+    ssize_t finalLen;
+
+    hdlc_Init(&hdlc);
+    frameLen = hdlc_Pack(&hdlc, frame, HDLC_TEST_FRAME_MAX, (uint8_t *)payload, &packed);
+    TEST_CHECK((frameLen >= 0) && (packed == len), "hdlc_Pack: %zd, packed %zu of %zu", frameLen,
+               packed, len);
+    if (frameLen < 0)
+    {
+        return 0;
+    }
+    finalLen = hdlc_PackFinalize(&hdlc, frame + frameLen, HDLC_TEST_FRAME_MAX - frameLen);
+    TEST_CHECK(finalLen > 0, "hdlc_PackFinalize: %zd", finalLen);
+    return (finalLen > 0) ? (size_t)(frameLen + finalLen) : 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Record an event
+ */
+//--------------------------------------------------------------------------------------------------
+static void test_EventSet
+(
+    struct test_Event *event,
+    int                status,
+    const uint8_t     *data,
+    size_t             length
+)
+{
+    event->status = status;
+    event->length = length;
+    if (length)
+    {
+        memcpy(event->data, data, length);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Unpack a burst with hdlc_Unpack, into a separate buffer
+ *
+ * @return: number of events
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t test_UnpackReference
+(
+    const uint8_t     *src,
+    size_t             len,
+    struct test_Event *events
+)
+{
+    static uint8_t dest[HDLC_TEST_BURST_MAX];
+    hdlc_context_t hdlc;
+    size_t count = 0;
+    size_t destLen = 0;
+    size_t pos = 0;
+
+    hdlc_Init(&hdlc);
+    while ((pos < len) && (count < HDLC_TEST_FRAMES_MAX))
+    {
+        size_t srclen = len - pos;
+        ssize_t result = hdlc_Unpack(&hdlc, dest + destLen, sizeof(dest) - destLen,
+                                     (uint8_t *)src + pos, &srclen);
+
+        if (result < 0)
+        {
+            test_EventSet(&events[count++], (int)result, NULL, 0);
+            destLen = 0;
+        }
+        else
+        {
+            destLen += result;
+            if (hdlc_UnpackDone(&hdlc))
+            {
+                test_EventSet(&events[count++], 0, dest, destLen);
+                destLen = 0;
+            }
+        }
+        if (!srclen)
+        {
+            TEST_CHECK(false, "hdlc_Unpack: no progress at %zu of %zu", pos, len);
+            break;
+        }
+        pos += srclen;
+    }
+    return count;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Unpack a burst with hdlc_UnpackBurst, in place, whole or as it arrives in random chunks.  Each
+ * call is also limited to a random number of frames
+ *
+ * @return: number of events
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t test_UnpackBurst
+(
+    const uint8_t     *src,
+    size_t             len,
+    bool               chunked,
+    struct test_Event *events
+)
+{
+    static uint8_t buf[HDLC_TEST_BURST_MAX];
+    hdlc_frame_t frames[HDLC_TEST_FRAMES_MAX];
+    hdlc_context_t hdlc;
+    size_t count = 0;
+    size_t held = 0;
+    size_t fed = 0;
+
+    hdlc_Init(&hdlc);
+    for (;;)
+    {
+        uint64_t r = test_Random(draws++);
+        size_t chunk = (!chunked || (0 == r % 4)) ? len - fed : (r >> 8) % (len - fed + 1);
+        size_t maxFrames = 1 + (r >> 32) % HDLC_TEST_FRAMES_MAX;
+        size_t buflen;
+        ssize_t result;
+
+        memcpy(buf + held, src + fed, chunk);
+        fed += chunk;
+        held += chunk;
+
+        buflen = held;
+        result = hdlc_UnpackBurst(&hdlc, buf, &buflen, frames, maxFrames);
+        TEST_CHECK((result >= 0) && ((size_t)result <= maxFrames) && (buflen <= held),
+                   "hdlc_UnpackBurst: %zd of %zu frames, %zu of %zu bytes", result, maxFrames,
+                   buflen, held);
+        if (result < 0)
+        {
+            break;
+        }
+
+        for (ssize_t i = 0; (i < result) && (count < HDLC_TEST_FRAMES_MAX); i++)
+        {
+            test_EventSet(&events[count++], frames[i].status, buf + frames[i].offset,
+                          frames[i].length);
+        }
+
+        // Present what was not processed again, followed by the next chunk
+        memmove(buf, buf + buflen, held - buflen);
+        held -= buflen;
+        if ((fed == len) && !buflen)
+        {
+            break;
+        }
+    }
+    return count;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check that two unpacking routines reported the same events
+ */
+//--------------------------------------------------------------------------------------------------
+static void test_EventsCompare
+(
+    const char              *name,
+    const struct test_Event *events,
+    size_t                   count,
+    const struct test_Event *expectedEvents,
+    size_t                   expectedCount
+)
+{
+    TEST_CHECK(count == expectedCount, "%s: %zu events, expected %zu", name, count,
+               expectedCount);
+    for (size_t i = 0; (i < count) && (i < expectedCount); i++)
+    {
+        TEST_CHECK((events[i].status == expectedEvents[i].status) &&
+                   (events[i].length == expectedEvents[i].length) &&
+                   (0 == memcmp(events[i].data, expectedEvents[i].data, events[i].length)),
+                   "%s: event %zu: status %d, length %zu, expected status %d, length %zu", name,
+                   i, events[i].status, events[i].length, expectedEvents[i].status,
+                   expectedEvents[i].length);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Unpack bursts of frames with hdlc_UnpackBurst, and with hdlc_Unpack
+ */
+//--------------------------------------------------------------------------------------------------
+static void test_UnpackBursts
+(
+    void
+)
+{
+    static uint8_t frame[HDLC_TEST_FRAME_MAX];
+
+    for (unsigned int b = 0; b < HDLC_TEST_BURSTS; b++)
+    {
+        size_t frameCount = 1 + test_Random(draws++) % HDLC_TEST_FRAMES_MAX;
+        size_t wireLen = 0;
+        size_t referenceCount;
+        size_t burstCount;
+
+        for (size_t f = 0; f < frameCount; f++)
+        {
+            uint64_t r = test_Random(draws++);
+            size_t frameLen;
+
+            payloadLens[f] = (r >> 8) % (HDLC_TEST_PAYLOAD_MAX + 1);
+            test_Payload(payloads[f], payloadLens[f]);
+            frameLen = test_Frame(payloads[f], payloadLens[f], frame);
+
+            // Idle flags may come between frames
+            if (r & 1)
+            {
+                wire[wireLen++] = 0x7E;
+            }
+            memcpy(wire + wireLen, frame, frameLen);
+            wireLen += frameLen;
+            test_EventSet(&expected[f], 0, payloads[f], payloadLens[f]);
+        }
+
+        referenceCount = test_UnpackReference(wire, wireLen, reference);
+        test_EventsCompare("hdlc_Unpack", reference, referenceCount, expected, frameCount);
+        burstCount = test_UnpackBurst(wire, wireLen, true, burst);
+        test_EventsCompare("hdlc_UnpackBurst", burst, burstCount, reference, referenceCount);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Length of the start of a frame, up to and including a number of its payload bytes
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t test_FramePrefix
+(
+    const uint8_t *frame,
+    size_t         payloadLen
+)
+{
+    size_t idx = 1;
+
+    for (size_t i = 0; i < payloadLen; i++)
+    {
+        idx += (0x7D == frame[idx]) ? 2 : 1;
+    }
+    return idx;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append a frame to the wire, with any damage, and the event it should be unpacked as
+ *
+ * @return: the damage done, which may be none if the frame could not take that requested
+ */
+//--------------------------------------------------------------------------------------------------
+static enum test_Damage test_FrameDamage
+(
+    size_t           *wireLen,
+    const uint8_t    *payload,
+    size_t            payloadLen,
+    enum test_Damage  damage,
+    bool              last,
+    struct test_Event *event
+)
+{
+    static uint8_t frame[HDLC_TEST_FRAME_MAX];
+    size_t frameLen = test_Frame(payload, payloadLen, frame);
+    uint64_t r = test_Random(draws++);
+
+    // The last frame has no flag after it to lose its end up to.  A shorter payload than the CRC
+    // leaves nothing for the decoder to take as a CRC
+    if ((TEST_DAMAGE_TRUNCATE == damage) && (last || (payloadLen < sizeof(uint16_t))))
+    {
+        damage = TEST_DAMAGE_NONE;
+    }
+
+    switch (damage)
+    {
+        case TEST_DAMAGE_FLIP:
+        {
+            // Neither flag, nor an escape, so that exactly one unpacked bit changes.  The other
+            // bytes are never 0x7E, and the byte after an escape is never 0x7D
+            size_t pos;
+            do
+            {
+                pos = 1 + (r >> 8) % (frameLen - 2);
+                r = test_Random(draws++);
+            } while (0x7D == frame[pos]);
+
+            frame[pos] ^= (0x7C == frame[pos] || 0x7F == frame[pos]) ? 0x10 : 0x01;
+            memcpy(wire + *wireLen, frame, frameLen);
+            *wireLen += frameLen;
+            test_EventSet(event, HDLC_ERROR_CRC, NULL, 0);
+            break;
+        }
+
+        case TEST_DAMAGE_TRUNCATE:
+        {
+            // Keep at least two payload bytes, which are taken as the CRC of those before them
+            size_t kept = sizeof(uint16_t) + (r >> 8) % (payloadLen - 1);
+            size_t crcLen = kept - sizeof(uint16_t);
+            uint16_t crc = crc16_update(CRC_CRC16_CCITT_INIT, payload, crcLen);
+
+            if (crc == (((uint16_t)payload[crcLen] << 8) | payload[crcLen + 1]))
+            {
+                // They happen to be that CRC: the damage would go unnoticed
+                memcpy(wire + *wireLen, frame, frameLen);
+                *wireLen += frameLen;
+                test_EventSet(event, 0, payload, payloadLen);
+                return TEST_DAMAGE_NONE;
+            }
+            frameLen = test_FramePrefix(frame, kept);
+            memcpy(wire + *wireLen, frame, frameLen);
+            *wireLen += frameLen;
+            test_EventSet(event, HDLC_ERROR_CRC, NULL, 0);
+            break;
+        }
+
+        case TEST_DAMAGE_ESCAPE:
+            // The escape is followed by the flag opening the next frame, or by one of its own
+            memcpy(wire + *wireLen, frame, frameLen - 1);
+            *wireLen += frameLen - 1;
+            wire[(*wireLen)++] = 0x7D;
+            if (last)
+            {
+                wire[(*wireLen)++] = 0x7E;
+            }
+            test_EventSet(event, HDLC_ERROR_FRAME, NULL, 0);
+            break;
+
+        default:
+            memcpy(wire + *wireLen, frame, frameLen);
+            *wireLen += frameLen;
+            test_EventSet(event, 0, payload, payloadLen);
+            break;
+    }
+    return damage;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Unpack bursts with damaged frames, checking that each is rejected without losing the next
+ */
+//--------------------------------------------------------------------------------------------------
+static void test_Rescans
+(
+    void
+)
+{
+    unsigned long damaged[TEST_DAMAGE_COUNT] = { 0 };
+
+    for (unsigned int b = 0; b < HDLC_TEST_BURSTS; b++)
+    {
+        size_t frameCount = 2 + test_Random(draws++) % (HDLC_TEST_FRAMES_MAX - 1);
+        size_t wireLen = 0;
+        size_t referenceCount;
+        size_t burstCount;
+
+        for (size_t f = 0; f < frameCount; f++)
+        {
+            uint64_t r = test_Random(draws++);
+            enum test_Damage damage;
+
+            payloadLens[f] = (r >> 8) % (HDLC_TEST_PAYLOAD_MAX + 1);
+            test_Payload(payloads[f], payloadLens[f]);
+            damage = test_FrameDamage(&wireLen, payloads[f], payloadLens[f],
+                                      (enum test_Damage)(r % TEST_DAMAGE_COUNT),
+                                      f == frameCount - 1, &expected[f]);
+            damaged[damage]++;
+        }
+
+        referenceCount = test_UnpackReference(wire, wireLen, reference);
+        test_EventsCompare("hdlc_Unpack", reference, referenceCount, expected, frameCount);
+        burstCount = test_UnpackBurst(wire, wireLen, false, burst);
+        test_EventsCompare("hdlc_UnpackBurst", burst, burstCount, reference, referenceCount);
+        burstCount = test_UnpackBurst(wire, wireLen, true, burst);
+        test_EventsCompare("hdlc_UnpackBurst, chunked", burst, burstCount, reference,
+                           referenceCount);
+    }
+
+    for (int damage = TEST_DAMAGE_FLIP; damage < TEST_DAMAGE_COUNT; damage++)
+    {
+        TEST_CHECK(damaged[damage], "no frame took damage %d", damage);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Frame random payloads with hdlc_PackV, and check the frames against hdlc_Pack's
+ */
+//--------------------------------------------------------------------------------------------------
+static void test_PackV
+(
+    void
+)
+{
+    static uint8_t payload[HDLC_TEST_PAYLOAD_MAX];
+    static uint8_t frame[HDLC_TEST_FRAME_MAX];
+    static uint8_t packed[HDLC_TEST_FRAME_MAX];
+
+    for (unsigned int p = 0; p < HDLC_TEST_PACKS; p++)
+    {
+        uint64_t r = test_Random(draws++);
+        size_t len = (r >> 8) % (HDLC_TEST_PAYLOAD_MAX + 1);
+        int srccnt = 1 + (r >> 32) % HDLC_TEST_SEGMENTS_MAX;
+        bool packRest = r & 1;
+        struct iovec src[HDLC_TEST_SEGMENTS_MAX];
+        hdlc_context_t hdlc;
+        size_t frameLen;
+        size_t packedLen = 0;
+        size_t offset = 0;
+        size_t start = 0;
+        unsigned int calls = 0;
+        ssize_t result;
+
+        test_Payload(payload, len);
+        frameLen = test_Frame(payload, len, frame);
+
+        // Split the payload at random points, which may leave some segments empty
+        for (int i = 0; i < srccnt; i++)
+        {
+            size_t end = (i == srccnt - 1) ? len : start + test_Random(draws++) % (len - start + 1);
+
+            src[i].iov_base = payload + start;
+            src[i].iov_len = end - start;
+            start = end;
+        }
+
+        hdlc_Init(&hdlc);
+        do
+        {
+            struct iovec dest[4];
+            uint8_t scratch[8];
+            uint64_t limits = test_Random(draws++);
+            int destcnt = 1 + limits % 4;
+            size_t scratchlen = 2 + (limits >> 8) % (sizeof(scratch) - 1);
+            size_t described = 0;
+
+            result = hdlc_PackV(&hdlc, dest, &destcnt, scratch, scratchlen, src, srccnt, &offset);
+            TEST_CHECK(result >= 0, "hdlc_PackV: %zd", result);
+            if (result < 0)
+            {
+                break;
+            }
+            for (int i = 0; i < destcnt; i++)
+            {
+                memcpy(packed + packedLen, dest[i].iov_base, dest[i].iov_len);
+                packedLen += dest[i].iov_len;
+                described += dest[i].iov_len;
+            }
+            TEST_CHECK(described == (size_t)result, "hdlc_PackV: %zd bytes, in segments of %zu",
+                       result, described);
+
+            if (packRest && (offset < len))
+            {
+                size_t srclen = len - offset;
+
+                result = hdlc_Pack(&hdlc, packed + packedLen, sizeof(packed) - packedLen,
+                                   payload + offset, &srclen);
+                TEST_CHECK((result >= 0) && (srclen == len - offset),
+                           "hdlc_Pack after hdlc_PackV: %zd, packed %zu", result, srclen);
+                if (result < 0)
+                {
+                    break;
+                }
+                packedLen += result;
+                offset += srclen;
+            }
+        } while ((offset < len) && (++calls < 4 * HDLC_TEST_FRAME_MAX));
+        TEST_CHECK(offset == len, "hdlc_PackV: %zu of %zu bytes packed", offset, len);
+
+        result = hdlc_PackFinalize(&hdlc, packed + packedLen, sizeof(packed) - packedLen);
+        TEST_CHECK(result > 0, "hdlc_PackFinalize: %zd", result);
+        packedLen += (result > 0) ? result : 0;
+
+        TEST_CHECK((packedLen == frameLen) && (0 == memcmp(packed, frame, frameLen)),
+                   "hdlc_PackV: length %zu in %d segments: frame of %zu bytes, expected %zu",
+                   len, srccnt, packedLen, frameLen);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Frame random payloads with hdlc_PackInPlace, and check the frames against hdlc_Pack's
+ */
+//--------------------------------------------------------------------------------------------------
+static void test_PackInPlace
+(
+    void
+)
+{
+    static uint8_t payload[HDLC_TEST_PAYLOAD_MAX];
+    static uint8_t frame[HDLC_TEST_FRAME_MAX];
+
+    for (unsigned int p = 0; p < HDLC_TEST_PACKS; p++)
+    {
+        uint64_t r = test_Random(draws++);
+        size_t len = (r >> 8) % (HDLC_TEST_PAYLOAD_MAX + 1);
+        size_t frameLen;
+        size_t buflen;
+        uint8_t *buf;
+        ssize_t result;
+
+        test_Payload(payload, len);
+        frameLen = test_Frame(payload, len, frame);
+
+        // Exactly the frame's size, one byte short, or room to spare
+        switch (r % 4)
+        {
+            case 0:
+                buflen = frameLen - 1;
+                break;
+            case 1:
+                buflen = frameLen + (r >> 32) % HDLC_TEST_FRAME_MAX;
+                break;
+            default:
+                buflen = frameLen;
+                break;
+        }
+        buf = malloc(buflen);
+        if (!buf)
+        {
+            TEST_CHECK(false, "cannot allocate %zu bytes", buflen);
+            return;
+        }
+        memcpy(buf + HDLC_PACK_HEADROOM, payload, len);
+
+        result = hdlc_PackInPlace(buf, buflen, len);
+        if (buflen < frameLen)
+        {
+            TEST_CHECK(result < 0, "hdlc_PackInPlace: length %zu: %zd, in %zu bytes", len, result,
+                       buflen);
+        }
+        else
+        {
+            TEST_CHECK((result == (ssize_t)frameLen) && (0 == memcmp(buf, frame, frameLen)),
+                       "hdlc_PackInPlace: length %zu: frame of %zd bytes, expected %zu", len,
+                       result, frameLen);
+        }
+        free(buf);
+    }
+}
+
+
+int main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    test_SeedParse(argc, argv);
+
+    test_UnpackBursts();
+    test_Rescans();
+    test_PackV();
+    test_PackInPlace();
+
+    printf("hdlcTest: %lu checks, %lu failures\n", checks, failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
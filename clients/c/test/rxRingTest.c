@@ -0,0 +1,304 @@
+/**
+ * @file:    rxRingTest.c
+ *
+ * Purpose:  Check the receive ring, from one thread and then between a producer and a consumer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Sierra Wireless Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *----------------------------------------------------------------------------
+ *
+ * NOTES:
+ *
+ * From one thread, the ring is filled until a push is refused and counted as dropped.  Releasing
+ * the oldest packet then makes room for one more only after a wrap marker, and the packets come
+ * back in order, intact, the wrapped one from the start of the ring.
+ *
+ * Then a producer thread pushes RX_RING_TEST_PACKETS packets of varying length, retrying each
+ * which is refused, while the main thread peeks, checks and releases them.  Each packet carries
+ * its sequence number, and contents and length derived from it, so the consumer checks order and
+ * contents without sharing any other state with the producer.  The consumer also writes the spare
+ * byte after each packet, as the decoder does, and stalls now and then, to let the ring fill.
+ * Run under make clean test SANITIZE=thread to check the ordering of the two threads' accesses
+ * too.
+ *
+ * Usage:  rxRingTest [random seed]
+ *
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "orpRxRing.h"
+#include "testUtil.h"
+
+
+#define RX_RING_TEST_PACKETS    100000
+
+// Length of the packets which fill the ring
+#define RX_RING_TEST_FILL_LEN   1000
+
+static struct orp_RxRing ring;
+static unsigned long producerRefusals = 0;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Length of a packet: mostly short, as responses are, sometimes up to 64 KB
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t test_Length
+(
+    uint32_t sequence
+)
+{
+    uint64_t r = test_Random(sequence);
+
+    return sizeof(sequence) + (((r & 0xF) == 0) ? (r >> 8) % 65536 : (r >> 8) % 256);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Build a packet: its sequence number, then bytes derived from it
+ */
+//--------------------------------------------------------------------------------------------------
+static void test_PacketBuild
+(
+    uint32_t  sequence,
+    uint8_t  *packet,
+    size_t    len
+)
+{
+    uint8_t fill = (uint8_t)test_Random(sequence);
+
+    memcpy(packet, &sequence, sizeof(sequence));
+    for (size_t i = sizeof(sequence); i < len; i++)
+    {
+        packet[i] = (uint8_t)(fill + i);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check a packet peeked from the ring
+ *
+ * @return: true if it is the packet of the sequence number
+ */
+//--------------------------------------------------------------------------------------------------
+static bool test_PacketCheck
+(
+    uint32_t       sequence,
+    const uint8_t *packet,
+    size_t         len,
+    size_t         expectedLen
+)
+{
+    uint8_t fill = (uint8_t)test_Random(sequence);
+    uint32_t received;
+
+    if ((len != expectedLen) || (len < sizeof(received)))
+    {
+        return false;
+    }
+    memcpy(&received, packet, sizeof(received));
+    if (received != sequence)
+    {
+        return false;
+    }
+    for (size_t i = sizeof(sequence); i < len; i++)
+    {
+        if (packet[i] != (uint8_t)(fill + i))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fill the ring until a push is refused, then wrap, from one thread
+ */
+//--------------------------------------------------------------------------------------------------
+static void test_FullAndWrap
+(
+    void
+)
+{
+    static uint8_t packet[RX_RING_TEST_FILL_LEN];
+    size_t recordLen = ORP_RX_RING_RECORD_LEN(RX_RING_TEST_FILL_LEN);
+    size_t expected = ORP_RX_RING_SIZE / recordLen;
+    uint32_t pushed = 0;
+    uint8_t *peeked;
+    size_t len;
+
+    orp_RxRingInit(&ring);
+    TEST_CHECK(NULL == orp_RxRingPeek(&ring, &len), "empty ring peeked a packet");
+
+    for (;;)
+    {
+        test_PacketBuild(pushed, packet, sizeof(packet));
+        if (!orp_RxRingPush(&ring, packet, sizeof(packet)))
+        {
+            break;
+        }
+        pushed++;
+    }
+    TEST_CHECK(pushed == expected, "%u packets fit, rather than %zu", pushed, expected);
+    TEST_CHECK(1 == atomic_load(&ring.dropped), "%zu dropped, rather than 1",
+               atomic_load(&ring.dropped));
+
+    // The room released at the start, with what is left at the end, fits one more after a wrap
+    peeked = orp_RxRingPeek(&ring, &len);
+    TEST_CHECK(peeked && test_PacketCheck(0, peeked, len, sizeof(packet)), "first packet changed");
+    orp_RxRingRelease(&ring);
+    TEST_CHECK(orp_RxRingPush(&ring, packet, sizeof(packet)), "no room after a release");
+    TEST_CHECK(!orp_RxRingPush(&ring, packet, sizeof(packet)), "room for two after one release");
+
+    for (uint32_t sequence = 1; sequence <= pushed; sequence++)
+    {
+        peeked = orp_RxRingPeek(&ring, &len);
+        TEST_CHECK(peeked && test_PacketCheck(sequence, peeked, len, sizeof(packet)),
+                   "packet %u changed", sequence);
+        if (!peeked)
+        {
+            return;
+        }
+        if (sequence == pushed)
+        {
+            TEST_CHECK(peeked == &ring.data[ORP_RX_RING_HEADER_LEN],
+                       "wrapped packet at offset %td", peeked - ring.data);
+        }
+        orp_RxRingRelease(&ring);
+    }
+    TEST_CHECK(NULL == orp_RxRingPeek(&ring, &len), "drained ring peeked a packet");
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Producer thread: push every packet, retrying each until there is room
+ */
+//--------------------------------------------------------------------------------------------------
+static void *test_Producer
+(
+    void *context
+)
+{
+    static uint8_t packet[sizeof(uint32_t) + 65536];
+
+    (void)context;
+    for (uint32_t sequence = 0; sequence < RX_RING_TEST_PACKETS; sequence++)
+    {
+        size_t len = test_Length(sequence);
+
+        test_PacketBuild(sequence, packet, len);
+        while (!orp_RxRingPush(&ring, packet, len))
+        {
+            producerRefusals++;
+            sched_yield();
+        }
+    }
+    atomic_store_explicit(&ring.closed, true, memory_order_release);
+    return NULL;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Consume every packet of the producer thread, checking each
+ */
+//--------------------------------------------------------------------------------------------------
+static void test_ProducerConsumer
+(
+    void
+)
+{
+    pthread_t producer;
+    uint32_t sequence = 0;
+
+    orp_RxRingInit(&ring);
+    if (0 != pthread_create(&producer, NULL, test_Producer, NULL))
+    {
+        TEST_CHECK(false, "cannot start the producer");
+        return;
+    }
+
+    for (;;)
+    {
+        // Read closed before peeking, so no packet pushed before closing is missed
+        bool closed = atomic_load_explicit(&ring.closed, memory_order_acquire);
+        size_t len;
+        uint8_t *packet = orp_RxRingPeek(&ring, &len);
+
+        if (!packet)
+        {
+            if (closed)
+            {
+                break;
+            }
+            sched_yield();
+            continue;
+        }
+        TEST_CHECK(test_PacketCheck(sequence, packet, len, test_Length(sequence)),
+                   "packet %u out of order or changed", sequence);
+        TEST_CHECK(0 == ((uintptr_t)packet & 3), "packet %u misaligned", sequence);
+        packet[len] = '\0';
+        orp_RxRingRelease(&ring);
+        sequence++;
+
+        // Fall behind now and then, so the producer fills the ring, however fast this thread runs
+        if (0 == sequence % TEST_STALL_PERIOD)
+        {
+            usleep(TEST_STALL_US);
+        }
+    }
+    pthread_join(producer, NULL);
+
+    TEST_CHECK(RX_RING_TEST_PACKETS == sequence, "%u packets received", sequence);
+    TEST_CHECK(producerRefusals == atomic_load(&ring.dropped), "%zu dropped, for %lu refusals",
+               atomic_load(&ring.dropped), producerRefusals);
+}
+
+
+int main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    test_SeedParse(argc, argv);
+
+    test_FullAndWrap();
+    test_ProducerConsumer();
+
+    printf("rxRingTest: %lu checks, %lu failures, %lu pushes refused\n", checks, failures,
+           producerRefusals);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,125 @@
+/**
+ * @file:    testUtil.h
+ *
+ * Purpose:  Checks and pseudo-random numbers shared by the tests
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Sierra Wireless Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *----------------------------------------------------------------------------
+ *
+ * NOTES:
+ *
+ * Each test is a single source file, which includes this header once, so the check counters are
+ * defined here.  A test takes an optional random seed as its first argument, and prints the
+ * first failures in full, which is enough to reproduce them with the same seed.
+ *
+ */
+
+#ifndef TEST_UTIL_H_INCLUDE_GUARD
+#define TEST_UTIL_H_INCLUDE_GUARD
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Defines, Constants
+ */
+//--------------------------------------------------------------------------------------------------
+// Seed of the pseudo-random numbers, unless another is given on the command line
+#define TEST_SEED_DEFAULT       0x9E3779B97F4A7C15ull
+
+// Failures printed in full.  Any more are only counted
+#define TEST_FAILURES_PRINTED   10
+
+// Items a consumer thread takes between stalls, and the length of each stall, long enough for
+// even an instrumented producer to fill what is between them
+#define TEST_STALL_PERIOD       4096
+#define TEST_STALL_US           20000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Count a check, and print it if it fails: the condition, then a printf format and its arguments
+ */
+//--------------------------------------------------------------------------------------------------
+#define TEST_CHECK(cond, ...)                                                                      \
+    do                                                                                             \
+    {                                                                                              \
+        checks++;                                                                                  \
+        if (!(cond))                                                                               \
+        {                                                                                          \
+            if (failures < TEST_FAILURES_PRINTED)                                                  \
+            {                                                                                      \
+                printf("FAIL: line %d: ", __LINE__);                                               \
+                printf(__VA_ARGS__);                                                               \
+                printf("\n");                                                                      \
+            }                                                                                      \
+            failures++;                                                                            \
+        }                                                                                          \
+    } while (0)
+
+
+static uint64_t seed = TEST_SEED_DEFAULT;
+static unsigned long checks = 0;
+static unsigned long failures = 0;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Take the seed from the command line, if one is given
+ */
+//--------------------------------------------------------------------------------------------------
+static inline void test_SeedParse
+(
+    int   argc,
+    char *argv[]
+)
+{
+    if (argc > 1)
+    {
+        seed = strtoull(argv[1], NULL, 0);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pseudo-random number n of the seed (splitmix64).  Any thread may derive the same number from
+ * the same n, without sharing any state
+ */
+//--------------------------------------------------------------------------------------------------
+static inline uint64_t test_Random
+(
+    uint64_t n
+)
+{
+    uint64_t z = seed + (n + 1) * 0x9E3779B97F4A7C15ull;
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+#endif // TEST_UTIL_H_INCLUDE_GUARD
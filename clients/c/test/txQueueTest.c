@@ -0,0 +1,375 @@
+/**
+ * @file:    txQueueTest.c
+ *
+ * Purpose:  Check the transmit queue, from one thread and then between producers and a consumer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Sierra Wireless Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *----------------------------------------------------------------------------
+ *
+ * NOTES:
+ *
+ * From one thread, the queue is filled until a message is refused, messages too large or with
+ * records are refused, and the queue's event is checked.  The messages then come back in order,
+ * copied whole.
+ *
+ * Then TX_QUEUE_TEST_PRODUCERS threads each queue TX_QUEUE_TEST_MESSAGES messages, retrying each
+ * which is refused, while the main thread peeks, checks and releases them.  A message names its
+ * producer in its path, and carries its number in its data, with units and data of a length
+ * derived from both, so the consumer checks that the messages of each producer arrive in order
+ * and intact.  The consumer stalls now and then, to let the queue fill.  Run under
+ * make clean test SANITIZE=thread to check the ordering of the threads' accesses too.
+ *
+ * Usage:  txQueueTest [random seed]
+ *
+ */
+
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "orpTxQueue.h"
+#include "legato.h"
+#include "testUtil.h"
+
+
+#define TX_QUEUE_TEST_PRODUCERS     4
+#define TX_QUEUE_TEST_MESSAGES      25000
+
+// Longest data of a message, leaving room for its path and units in the slot
+#define TX_QUEUE_TEST_DATA_MAX      (ORP_TX_QUEUE_DATA_MAX - 64)
+
+// A message as queued, with the storage its fields point into
+struct test_Message
+{
+    struct orp_Message message;
+    char               path[16];
+    char               unit[16];
+    uint8_t            data[TX_QUEUE_TEST_DATA_MAX];
+};
+
+static struct orp_TxQueue queue;
+static unsigned long refusals[TX_QUEUE_TEST_PRODUCERS];
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Build a message: a push of a string, or every other one of JSON with units, its data its number
+ * then bytes derived from it
+ */
+//--------------------------------------------------------------------------------------------------
+static void test_MessageBuild
+(
+    unsigned int         producer,
+    uint32_t             number,
+    struct test_Message *built
+)
+{
+    uint64_t r = test_Random(((uint64_t)producer << 32) | number);
+    size_t len = sizeof(number) + (((r & 0xF) == 0) ? (r >> 8) % (TX_QUEUE_TEST_DATA_MAX - 3)
+                                                    : (r >> 8) % 64);
+
+    orp_MessageInit(&built->message, ORP_RQST_PUSH, 0);
+    snprintf(built->path, sizeof(built->path), "/p%u", producer);
+    built->message.path = built->path;
+    if (number & 1)
+    {
+        snprintf(built->unit, sizeof(built->unit), "u%u", (unsigned int)(r >> 56));
+        built->message.unit = built->unit;
+        built->message.dataType = ORP_IO_DATA_TYPE_JSON;
+    }
+    else
+    {
+        built->message.dataType = ORP_IO_DATA_TYPE_STRING;
+    }
+    memcpy(built->data, &number, sizeof(number));
+    for (size_t i = sizeof(number); i < len; i++)
+    {
+        built->data[i] = (uint8_t)(r + i);
+    }
+    built->message.data = built->data;
+    built->message.dataLen = len;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check a message peeked from the queue against the message it should be
+ *
+ * @return: true if they match
+ */
+//--------------------------------------------------------------------------------------------------
+static bool test_MessageCheck
+(
+    const struct orp_Message *message,
+    const struct orp_Message *expected
+)
+{
+    const char *unit = expected->unit ? expected->unit : "";
+
+    return (message->type == expected->type) &&
+           (message->dataType == expected->dataType) &&
+           message->path && (0 == strcmp(message->path, expected->path)) &&
+           (0 == strcmp(message->unit ? message->unit : "", unit)) &&
+           (message->dataLen == expected->dataLen) &&
+           (0 == memcmp(message->data, expected->data, expected->dataLen)) &&
+           (0 == ((const uint8_t *)message->data)[message->dataLen]);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether the queue's event is readable, clearing it
+ */
+//--------------------------------------------------------------------------------------------------
+static bool test_EventRead
+(
+    void
+)
+{
+    struct pollfd event = { .fd = queue.eventFd, .events = POLLIN };
+    uint64_t count;
+
+    if (poll(&event, 1, 0) != 1)
+    {
+        return false;
+    }
+    return read(queue.eventFd, &count, sizeof(count)) == sizeof(count);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fill the queue until a message is refused, then empty it, from one thread
+ */
+//--------------------------------------------------------------------------------------------------
+static void test_FullAndEmpty
+(
+    void
+)
+{
+    static struct test_Message built;
+    static struct orp_Message records[1];
+    struct orp_Message *message;
+    uint32_t queued = 0;
+    int result;
+
+    if (!orp_TxQueueInit(&queue))
+    {
+        TEST_CHECK(false, "cannot initialize the queue");
+        return;
+    }
+    TEST_CHECK(NULL == orp_TxQueuePeek(&queue), "empty queue peeked a message");
+    TEST_CHECK(!test_EventRead(), "empty queue's event readable");
+
+    // Too large for a slot, then with records
+    test_MessageBuild(0, 0, &built);
+    built.message.dataLen = ORP_TX_QUEUE_DATA_MAX;
+    result = orp_TxQueueMessage(&queue, &built.message);
+    TEST_CHECK(LE_OVERFLOW == result, "oversize message: result %d", result);
+    test_MessageBuild(0, 0, &built);
+    built.message.records = records;
+    built.message.recordCount = 1;
+    result = orp_TxQueueMessage(&queue, &built.message);
+    TEST_CHECK(LE_BAD_PARAMETER == result, "message with records: result %d", result);
+
+    for (;;)
+    {
+        test_MessageBuild(0, queued, &built);
+        result = orp_TxQueueMessage(&queue, &built.message);
+        if (LE_OK != result)
+        {
+            break;
+        }
+        queued++;
+    }
+    TEST_CHECK(LE_NO_MEMORY == result, "full queue: result %d", result);
+    TEST_CHECK(ORP_TX_QUEUE_SLOTS == queued, "%u messages fit", queued);
+    TEST_CHECK(test_EventRead(), "queue's event not readable");
+
+    // A push of a string value, into the slot of the first message
+    message = orp_TxQueuePeek(&queue);
+    test_MessageBuild(0, 0, &built);
+    TEST_CHECK(message && test_MessageCheck(message, &built.message), "message 0 changed");
+    orp_TxQueueRelease(&queue);
+    result = orp_TxQueuePush(&queue, "/p0", ORP_IO_DATA_TYPE_STRING, 1, 2, "value");
+    TEST_CHECK(LE_OK == result, "push after a release: result %d", result);
+
+    for (uint32_t number = 1; number <= queued; number++)
+    {
+        message = orp_TxQueuePeek(&queue);
+        if (!message)
+        {
+            TEST_CHECK(false, "message %u missing", number);
+            return;
+        }
+        if (number < queued)
+        {
+            test_MessageBuild(0, number, &built);
+            TEST_CHECK(test_MessageCheck(message, &built.message), "message %u changed", number);
+        }
+        else
+        {
+            TEST_CHECK((message->time.seconds == 1) &&
+                       (message->time.microseconds == 2) &&
+                       (message->dataLen == 5) &&
+                       (0 == memcmp(message->data, "value", 6)),
+                       "push changed");
+        }
+        orp_TxQueueRelease(&queue);
+    }
+    TEST_CHECK(NULL == orp_TxQueuePeek(&queue), "emptied queue peeked a message");
+    orp_TxQueueFini(&queue);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Producer thread: queue every message, retrying each until there is room
+ */
+//--------------------------------------------------------------------------------------------------
+static void *test_Producer
+(
+    void *context
+)
+{
+    unsigned int producer = (unsigned int)(uintptr_t)context;
+    struct test_Message *built = malloc(sizeof(*built));
+
+    if (!built)
+    {
+        return NULL;
+    }
+    for (uint32_t number = 0; number < TX_QUEUE_TEST_MESSAGES; number++)
+    {
+        test_MessageBuild(producer, number, built);
+        while (LE_NO_MEMORY == orp_TxQueueMessage(&queue, &built->message))
+        {
+            refusals[producer]++;
+            sched_yield();
+        }
+    }
+    free(built);
+    return NULL;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Consume every message of the producer threads, checking each
+ */
+//--------------------------------------------------------------------------------------------------
+static void test_ProducersConsumer
+(
+    void
+)
+{
+    static struct test_Message built;
+    pthread_t producers[TX_QUEUE_TEST_PRODUCERS];
+    uint32_t next[TX_QUEUE_TEST_PRODUCERS] = { 0 };
+    unsigned int started = 0;
+    unsigned long total = 0;
+
+    if (!orp_TxQueueInit(&queue))
+    {
+        TEST_CHECK(false, "cannot initialize the queue");
+        return;
+    }
+    for ( ; started < TX_QUEUE_TEST_PRODUCERS; started++)
+    {
+        if (0 != pthread_create(&producers[started], NULL, test_Producer,
+                                (void *)(uintptr_t)started))
+        {
+            TEST_CHECK(false, "cannot start producer %u", started);
+            break;
+        }
+    }
+
+    while (total < (unsigned long)started * TX_QUEUE_TEST_MESSAGES)
+    {
+        struct orp_Message *message = orp_TxQueuePeek(&queue);
+        unsigned int producer;
+
+        if (!message)
+        {
+            sched_yield();
+            continue;
+        }
+        // Every message is released, whatever it holds, so that the producers always finish
+        if (!message->path || (1 != sscanf(message->path, "/p%u", &producer)) ||
+            (producer >= started))
+        {
+            TEST_CHECK(false, "message %lu from no producer", total);
+        }
+        else
+        {
+            test_MessageBuild(producer, next[producer], &built);
+            TEST_CHECK(test_MessageCheck(message, &built.message),
+                       "message %u of producer %u out of order or changed",
+                       next[producer], producer);
+            next[producer]++;
+        }
+        orp_TxQueueRelease(&queue);
+        total++;
+
+        // Fall behind now and then, so the producers fill the queue, however fast this thread runs
+        if (0 == total % TEST_STALL_PERIOD)
+        {
+            usleep(TEST_STALL_US);
+        }
+    }
+
+    for (unsigned int i = 0; i < started; i++)
+    {
+        pthread_join(producers[i], NULL);
+    }
+    TEST_CHECK(NULL == orp_TxQueuePeek(&queue), "message left after the last");
+    orp_TxQueueFini(&queue);
+}
+
+
+int main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    unsigned long refused = 0;
+
+    test_SeedParse(argc, argv);
+
+    test_FullAndEmpty();
+    test_ProducersConsumer();
+
+    for (unsigned int i = 0; i < TX_QUEUE_TEST_PRODUCERS; i++)
+    {
+        refused += refusals[i];
+    }
+    printf("txQueueTest: %lu checks, %lu failures, %lu messages refused\n", checks, failures,
+           refused);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file:    orpSchemaPy.c
+ *
+ * Purpose:  Generate the Python client's protocol tables from the packet schema
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 Sierra Wireless Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *----------------------------------------------------------------------------
+ *
+ * NOTES:
+ *
+ * Expands the X-macro lists of orpSchema.h into Python, written to stdout.  The output is
+ * checked in as clients/python/modules/orp_schema.py, so the Python client needs no build step.
+ *
+ * Usage:  make python_schema
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "orpSchema.h"
+
+
+// Python spelling of each byte 1 content
+static const char *byte1Names[] =
+{
+    [ORP_BYTE1_NONE]      = "ORP_BYTE1_NONE",
+    [ORP_BYTE1_UNUSED]    = "ORP_BYTE1_UNUSED",
+    [ORP_BYTE1_STATUS]    = "ORP_BYTE1_STATUS",
+    [ORP_BYTE1_DATA_TYPE] = "ORP_BYTE1_DATA_TYPE",
+    [ORP_BYTE1_VERSION]   = "ORP_BYTE1_VERSION",
+    [ORP_BYTE1_EVENT]     = "ORP_BYTE1_EVENT",
+};
+
+// Python spelling of each variable length field identifier, by field index
+static const char *fieldNames[ORP_FIELD_COUNT] =
+{
+#define X(name, id, description)  [ORP_FIELD_INDEX_##name] = "ORP_FIELD_ID_" #name,
+    ORP_FIELD_SCHEMA(X)
+#undef X
+};
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Print the list of field identifiers in a field mask, as a Python list
+ */
+//--------------------------------------------------------------------------------------------------
+static void schema_FieldsPrint
+(
+    unsigned int fields
+)
+{
+    const char *separator = "";
+
+    printf("[");
+    for (int i = 0; i < ORP_FIELD_COUNT; i++)
+    {
+        if (fields & (1u << i))
+        {
+            printf("%s %s", separator, fieldNames[i]);
+            separator = ",";
+        }
+    }
+    printf(" ]");
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write the Python tables
+ */
+//--------------------------------------------------------------------------------------------------
+int main
+(
+    void
+)
+{
+    printf("#============================================================================\n"
+           "#\n"
+           "# Filename:  orp_schema.py\n"
+           "#\n"
+           "# Purpose:   Packet schema tables for the Octave Resource Protocol\n"
+           "#\n"
+           "# MIT License\n"
+           "#\n"
+           "# Copyright (c) 2020 Sierra Wireless Inc.\n"
+           "#\n"
+           "#----------------------------------------------------------------------------\n"
+           "#\n"
+           "# NOTES:\n"
+           "#\n"
+           "# Generated from clients/c/inc/orpSchema.h - do not edit.  To regenerate:\n"
+           "#     make -C clients/c python_schema\n"
+           "#\n\n");
+
+    printf("#\n# Packet type field - byte 0\n#\n");
+#define X(packet, encoded, decoded, byte1, fields, name) \
+    printf("%-31s = '%c'\n", "ORP_PKT_" #packet, encoded);
+    ORP_PACKET_SCHEMA(X)
+#undef X
+
+    printf("\n\n#\n# Content of byte 1\n#\n");
+    for (size_t i = 0; i < (sizeof(byte1Names) / sizeof(byte1Names[0])); i++)
+    {
+        printf("%-31s = %zu\n", byte1Names[i], i);
+    }
+
+    printf("\n\n#\n# Data type field - byte 1\n#\n");
+#define X(name, encoded, decoded, keyword) \
+    printf("%-31s = '%c'\n", "ORP_DATA_TYPE_" #name, encoded);
+    ORP_DATA_TYPE_SCHEMA(X)
+#undef X
+
+    printf("\n\n#\n# Variable length field identifiers\n#\n");
+#define X(name, id, description) \
+    printf("%-31s = '%c'\n", "ORP_FIELD_ID_" #name, id);
+    ORP_FIELD_SCHEMA(X)
+#undef X
+
+    printf("\n# Variable length field separator\n");
+    printf("%-31s = ','\n", "ORP_VARLENGTH_SEPARATOR");
+
+    printf("\n\n#\n# Packet types: [ type, byte 1 content, variable length fields, description ]\n#\n");
+    printf("packet_schema = [\n");
+#define X(packet, encoded, decoded, byte1, fields, name)                                           \
+    printf("    [ %-28s %s, ", "ORP_PKT_" #packet ",", byte1Names[ORP_BYTE1_##byte1]);            \
+    schema_FieldsPrint(fields);                                                                    \
+    printf(", '%s' ],\n", name);
+    ORP_PACKET_SCHEMA(X)
+#undef X
+    printf("]\n");
+
+    printf("\n\n#\n# Variable length fields: [ identifier, description ]\n#\n");
+    printf("field_schema = [\n");
+#define X(name, id, description) \
+    printf("    [ %-25s '%s' ],\n", "ORP_FIELD_ID_" #name ",", description);
+    ORP_FIELD_SCHEMA(X)
+#undef X
+    printf("]\n");
+
+    printf("\n\n#\n# Data types: [ keyword, type ]\n#\n");
+    printf("data_types = [\n");
+#define X(name, encoded, decoded, keyword)                                                         \
+    if (keyword[0])                                                                                \
+    {                                                                                              \
+        printf("    [ %-8s %-21s ],\n", "'" keyword "',", "ORP_DATA_TYPE_" #name);                \
+    }
+    ORP_DATA_TYPE_SCHEMA(X)
+#undef X
+    printf("]\n");
+
+    return EXIT_SUCCESS;
+}
@@ -37,122 +37,31 @@ import ast
 import shlex
 
 #
-# Packet type field - byte 0
+# Packet types, data types and field identifiers are generated from the C client's packet
+# schema, clients/c/inc/orpSchema.h
 #
-ORP_PKT_RQST_INPUT_CREATE   = 'I'   # type[1] d_type[1] pad[2] path[] units[]
-ORP_PKT_RESP_INPUT_CREATE   = 'i'   # type[1] status[1] pad[2]
-
-ORP_PKT_RQST_OUTPUT_CREATE  = 'O'   # type[1] d_type[1] pad[2] path[] units[]
-ORP_PKT_RESP_OUTPUT_CREATE  = 'o'   # type[1] status[1] pad[2]
-
-ORP_PKT_RQST_DELETE         = 'D'   # type[1] pad[1]    pad[2] path[]
-ORP_PKT_RESP_DELETE         = 'd'   # type[1] status[1] pad[2]
-
-ORP_PKT_RQST_HANDLER_ADD    = 'H'   # type[1] pad[1]    pad[2] path[]
-ORP_PKT_RESP_HANDLER_ADD    = 'h'   # type[1] status[1] pad[2]
-
-ORP_PKT_RQST_HANDLER_REMOVE = 'K'   # type[1] pad[1]    pad[2] path[]
-ORP_PKT_RESP_HANDLER_REMOVE = 'k'   # type[1] status[1] pad[2]
-
-ORP_PKT_RQST_PUSH           = 'P'   # type[1] d_type[1] pad[2] time[] path[] data[]
-ORP_PKT_RESP_PUSH           = 'p'   # type[1] status[1] pad[2]
-
-ORP_PKT_RQST_GET            = 'G'   # type[1] pad[1]    pad[2] path[]
-ORP_PKT_RESP_GET            = 'g'   # type[1] status[1] pad[2] time[] data[]
-
-ORP_PKT_RQST_EXAMPLE_SET    = 'E'   # type[1] d_type[1] pad[2] path[] data[]
-ORP_PKT_RESP_EXAMPLE_SET    = 'e'   # type[1] status[1] pad[2]
-
-ORP_PKT_RQST_SENSOR_CREATE  = 'S'   # type[1] d_type[1] pad[2] path[] units[]
-ORP_PKT_RESP_SENSOR_CREATE  = 's'   # type[1] status[1] pad[2]
-
-ORP_PKT_RQST_SENSOR_REMOVE  = 'R'   # type[1] pad[1]    pad[2] path[]
-ORP_PKT_RESP_SENSOR_REMOVE  = 'r'   # type[1] status[1] pad[2]
-
-ORP_PKT_NTFY_HANDLER_CALL   = 'c'   # type[1] d_type[1] pad[2] time[] path[] data[]
-ORP_PKT_RESP_HANDLER_CALL   = 'C'   # type[1] status[1] pad[2]
-
-ORP_PKT_NTFY_SENSOR_CALL    = 'b'   # type[1] pad[1]    pad[2] path[]
-ORP_PKT_RESP_SENSOR_CALL    = 'B'   # type[1] status[1] pad[2]
-
-# Version 2
-ORP_PKT_SYNC_SYN            = 'Y'   # type[1] version[1] unused[2] time[] sent[] received[]
-ORP_PKT_SYNC_SYNACK         = 'z'   # type[1] version[1] unused[2] sent[] received[]
-ORP_PKT_SYNC_ACK            = 'y'   # type[1] version[1] unused[2]
-
-ORP_PKT_RESP_UNKNOWN_RQST   = '?'   # type[1] status[1] pad[2]
+if sys.version_info[0] == 2:
+    from orp_schema import *
+else:
+    from .orp_schema import *
 
 
 #
-# Data type field - byte 1
+# Keys of the decoded variable length fields
 #
-ORP_DATA_TYPE_TRIGGER       = 'T'   # trigger - no data
-ORP_DATA_TYPE_BOOLEAN       = 'B'   # Boolean - 1 byte:  't' | 'f'
-ORP_DATA_TYPE_NUMERIC       = 'N'   # numeric - null-terminated ASCII string, representing double
-ORP_DATA_TYPE_STRING        = 'S'   # string  - null-terminated ASCII string
-ORP_DATA_TYPE_JSON          = 'J'   # JSON    - null-terminated ASCII string, representing JSON
-ORP_DATA_TYPE_UNDEF         = ' '   # not specified
-
-
-#
-# Variable length field identifiers
-#
-ORP_FIELD_ID_PATH           = 'P'
-ORP_FIELD_ID_TIME           = 'T'
-ORP_FIELD_ID_UNITS          = 'U'
-ORP_FIELD_ID_DATA           = 'D'
-
-# Variable length field separator
-ORP_VARLENGTH_SEPARATOR     = ','
-
-
-
-#
-# Packet type descriptions
-#
-ptypes = [
-    [ ORP_PKT_RQST_INPUT_CREATE,   'request create input'     ],
-    [ ORP_PKT_RESP_INPUT_CREATE,   'response create input'    ],
-
-    [ ORP_PKT_RQST_OUTPUT_CREATE,  'request create output'    ],
-    [ ORP_PKT_RESP_OUTPUT_CREATE,  'response create output'   ],
-
-    [ ORP_PKT_RQST_DELETE,         'request delete resource'  ],
-    [ ORP_PKT_RESP_DELETE,         'response delete resource' ],
-
-    [ ORP_PKT_RQST_HANDLER_ADD,    'request add handler'      ],
-    [ ORP_PKT_RESP_HANDLER_ADD,    'response add handler'     ],
-
-    [ ORP_PKT_RQST_HANDLER_REMOVE, 'request remove handler'   ],
-    [ ORP_PKT_RESP_HANDLER_REMOVE, 'response remove handler'  ],
-
-    [ ORP_PKT_RQST_PUSH,           'request push'             ],
-    [ ORP_PKT_RESP_PUSH,           'response push'            ],
-
-    [ ORP_PKT_RQST_GET,            'request get'              ],
-    [ ORP_PKT_RESP_GET,            'response get'             ],
-
-    [ ORP_PKT_RQST_EXAMPLE_SET,    'request set example'      ],
-    [ ORP_PKT_RESP_EXAMPLE_SET,    'response set example'     ],
-
-    [ ORP_PKT_RQST_SENSOR_CREATE,  'request create sensor'    ],
-    [ ORP_PKT_RESP_SENSOR_CREATE,  'response create sensor'   ],
-
-    [ ORP_PKT_RQST_SENSOR_REMOVE,  'request remove sensor'    ],
-    [ ORP_PKT_RESP_SENSOR_REMOVE,  'response remove sensor'   ],
-
-    [ ORP_PKT_NTFY_HANDLER_CALL,   'handler call'             ],
-    [ ORP_PKT_RESP_HANDLER_CALL,   'handler ack'              ],
-
-    [ ORP_PKT_NTFY_SENSOR_CALL,    'sensor poll'              ],
-    [ ORP_PKT_RESP_SENSOR_CALL,    'sensor poll ack'          ],
-
-    # Version 2
-    [ ORP_PKT_SYNC_SYN,            'sync packet'              ],
-    [ ORP_PKT_SYNC_SYNACK,         'sync ack packet'          ],
-
-    [ ORP_PKT_RESP_UNKNOWN_RQST,   'unknown packet type'      ],
-]
+field_keys = {
+    ORP_FIELD_ID_TIME       : 'timestamp',
+    ORP_FIELD_ID_PATH       : 'path',
+    ORP_FIELD_ID_PATH_ID    : 'path_id',
+    ORP_FIELD_ID_UNITS      : 'units',
+    ORP_FIELD_ID_DATA       : 'data',
+    ORP_FIELD_ID_MTU        : 'mtu',
+    ORP_FIELD_ID_SENT_COUNT : 'sent',
+    ORP_FIELD_ID_RECV_COUNT : 'received',
+    ORP_FIELD_ID_CAPABILITIES : 'capabilities',
+    ORP_FIELD_ID_RECORD     : 'records',
+    ORP_FIELD_ID_STATUS     : 'record_status',
+}
 
 
 #
@@ -185,18 +94,6 @@ status_list = [
 ]
 
 
-#
-# Data types
-#
-data_types = [
-    [ 'trig',   ORP_DATA_TYPE_TRIGGER ],
-    [ 'bool',   ORP_DATA_TYPE_BOOLEAN ],
-    [ 'num',    ORP_DATA_TYPE_NUMERIC ],
-    [ 'str',    ORP_DATA_TYPE_STRING  ],
-    [ 'json',   ORP_DATA_TYPE_JSON    ]
-]
-
-
 #
 # Syntax
 #
@@ -653,21 +550,20 @@ def decode_response(response):
         var_length = (response[4:len(response)]).decode("utf-8")
         print('Received     : ' + chr(response[0]) + chr(response[1]) + chr(response[2]) + chr(response[3]) + var_length)
 
-    for i in range(len(ptypes)):
-        test = ptypes[i]
+    byte1 = ORP_BYTE1_NONE
+    for i in range(len(packet_schema)):
+        test = packet_schema[i]
         if test[0] == ptype:
-            print('Message type : ' + test[1])
+            print('Message type : ' + test[3])
             resp['responseType'] = test[0]
+            byte1 = test[1]
 
-    # If this is a SYNC packet, byte 1 contains the version number.
-    # Otherwise, it may contain status
-    if ORP_PKT_SYNC_SYN == ptype:
+    # Byte 1 content depends on the packet type
+    if ORP_BYTE1_VERSION == byte1:
         version = chr(status_ver + 1)
         resp['version'] = version
         print('Version      : ' + version)
-    if ORP_PKT_SYNC_SYNACK == ptype:
-        pass
-    else:
+    elif ORP_BYTE1_STATUS == byte1:
         # Status is represented in ASCII, starting with '@' (0x40) for OK.
         # Subtract 0x40 to index into the table, above
         #
@@ -682,24 +578,20 @@ def decode_response(response):
     print('Sequence     : ' + str(seq_num))
 
     if len(var_length):
-        var_fields = var_length.split(',')
+        var_fields = var_length.split(ORP_VARLENGTH_SEPARATOR)
         for i in range(len(var_fields)):
             field = var_fields[i]
-            if field[0] == 'P':
-                resp['path'] = field[1:]
-                print('Path         : ' + field[1:])
-            if field[0] == 'T':
-                resp['timestamp'] = field[1:]
-                print('Timestamp    : ' + field[1:])
-            if field[0] == 'D':
-                resp['data'] = field[1:]
-                print('Data         : ' + field[1:])
+            if not len(field):
+                continue
+            # Data may contain the separator, so runs to the end of the packet.  So do
+            # records, which are the last fields, and are kept undecoded
+            if field[0] in (ORP_FIELD_ID_DATA, ORP_FIELD_ID_RECORD):
+                field = ORP_VARLENGTH_SEPARATOR.join(var_fields[i:])
+            for j in range(len(field_schema)):
+                if field[0] == field_schema[j][0]:
+                    resp[field_keys[field[0]]] = field[1:]
+                    print('%-13s: %s' % (field_schema[j][1], field[1:]))
+            if field[0] in (ORP_FIELD_ID_DATA, ORP_FIELD_ID_RECORD):
                 break
-            if field[0] == 'S':
-                resp['sent'] = field[1:]
-                print('Sent         : ' + field[1:])
-            if field[0] == 'R':
-                resp['sent'] = field[1:]
-                print('Received     : ' + field[1:])
 
     return resp
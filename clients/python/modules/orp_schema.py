@@ -0,0 +1,171 @@
+#============================================================================
+#
+# Filename:  orp_schema.py
+#
+# Purpose:   Packet schema tables for the Octave Resource Protocol
+#
+# MIT License
+#
+# Copyright (c) 2020 Sierra Wireless Inc.
+#
+#----------------------------------------------------------------------------
+#
+# NOTES:
+#
+# Generated from clients/c/inc/orpSchema.h - do not edit.  To regenerate:
+#     make -C clients/c python_schema
+#
+
+#
+# Packet type field - byte 0
+#
+ORP_PKT_RQST_INPUT_CREATE       = 'I'
+ORP_PKT_RESP_INPUT_CREATE       = 'i'
+ORP_PKT_RQST_OUTPUT_CREATE      = 'O'
+ORP_PKT_RESP_OUTPUT_CREATE      = 'o'
+ORP_PKT_RQST_DELETE             = 'D'
+ORP_PKT_RESP_DELETE             = 'd'
+ORP_PKT_RQST_HANDLER_ADD        = 'H'
+ORP_PKT_RESP_HANDLER_ADD        = 'h'
+ORP_PKT_RQST_HANDLER_REMOVE     = 'K'
+ORP_PKT_RESP_HANDLER_REMOVE     = 'k'
+ORP_PKT_RQST_PUSH               = 'P'
+ORP_PKT_RESP_PUSH               = 'p'
+ORP_PKT_RQST_PUSH_BATCH         = 'M'
+ORP_PKT_RESP_PUSH_BATCH         = 'm'
+ORP_PKT_RQST_GET                = 'G'
+ORP_PKT_RESP_GET                = 'g'
+ORP_PKT_RQST_GET_BATCH          = 'Q'
+ORP_PKT_RESP_GET_BATCH          = 'q'
+ORP_PKT_RQST_EXAMPLE_SET        = 'E'
+ORP_PKT_RESP_EXAMPLE_SET        = 'e'
+ORP_PKT_RQST_SENSOR_CREATE      = 'S'
+ORP_PKT_RESP_SENSOR_CREATE      = 's'
+ORP_PKT_RQST_SENSOR_REMOVE      = 'R'
+ORP_PKT_RESP_SENSOR_REMOVE      = 'r'
+ORP_PKT_NTFY_HANDLER_CALL       = 'c'
+ORP_PKT_RESP_HANDLER_CALL       = 'C'
+ORP_PKT_NTFY_SENSOR_CALL        = 'b'
+ORP_PKT_RESP_SENSOR_CALL        = 'B'
+ORP_PKT_SYNC_SYN                = 'Y'
+ORP_PKT_SYNC_SYNACK             = 'y'
+ORP_PKT_SYNC_ACK                = 'z'
+ORP_PKT_RQST_FILE_DATA          = 'T'
+ORP_PKT_RESP_FILE_DATA          = 't'
+ORP_PKT_NTFY_FILE_CONTROL       = 'L'
+ORP_PKT_RESP_FILE_CONTROL       = 'l'
+ORP_PKT_RESP_UNKNOWN_RQST       = '?'
+
+
+#
+# Content of byte 1
+#
+ORP_BYTE1_NONE                  = 0
+ORP_BYTE1_UNUSED                = 1
+ORP_BYTE1_STATUS                = 2
+ORP_BYTE1_DATA_TYPE             = 3
+ORP_BYTE1_VERSION               = 4
+ORP_BYTE1_EVENT                 = 5
+
+
+#
+# Data type field - byte 1
+#
+ORP_DATA_TYPE_TRIGGER           = 'T'
+ORP_DATA_TYPE_BOOLEAN           = 'B'
+ORP_DATA_TYPE_NUMERIC           = 'N'
+ORP_DATA_TYPE_STRING            = 'S'
+ORP_DATA_TYPE_JSON              = 'J'
+ORP_DATA_TYPE_UNDEF             = ' '
+
+
+#
+# Variable length field identifiers
+#
+ORP_FIELD_ID_TIME               = 'T'
+ORP_FIELD_ID_PATH               = 'P'
+ORP_FIELD_ID_PATH_ID            = 'I'
+ORP_FIELD_ID_UNITS              = 'U'
+ORP_FIELD_ID_DATA               = 'D'
+ORP_FIELD_ID_MTU                = 'M'
+ORP_FIELD_ID_SENT_COUNT         = 'S'
+ORP_FIELD_ID_RECV_COUNT         = 'R'
+ORP_FIELD_ID_CAPABILITIES       = 'C'
+ORP_FIELD_ID_RECORD             = 'N'
+ORP_FIELD_ID_STATUS             = 'E'
+
+# Variable length field separator
+ORP_VARLENGTH_SEPARATOR         = ','
+
+
+#
+# Packet types: [ type, byte 1 content, variable length fields, description ]
+#
+packet_schema = [
+    [ ORP_PKT_RQST_INPUT_CREATE,   ORP_BYTE1_DATA_TYPE, [ ORP_FIELD_ID_PATH, ORP_FIELD_ID_PATH_ID, ORP_FIELD_ID_UNITS ], 'Request, input create' ],
+    [ ORP_PKT_RESP_INPUT_CREATE,   ORP_BYTE1_STATUS, [ ], 'Response, input create' ],
+    [ ORP_PKT_RQST_OUTPUT_CREATE,  ORP_BYTE1_DATA_TYPE, [ ORP_FIELD_ID_PATH, ORP_FIELD_ID_PATH_ID, ORP_FIELD_ID_UNITS ], 'Request, output create' ],
+    [ ORP_PKT_RESP_OUTPUT_CREATE,  ORP_BYTE1_STATUS, [ ], 'Response, output create' ],
+    [ ORP_PKT_RQST_DELETE,         ORP_BYTE1_NONE, [ ORP_FIELD_ID_PATH, ORP_FIELD_ID_PATH_ID ], 'Request, delete' ],
+    [ ORP_PKT_RESP_DELETE,         ORP_BYTE1_STATUS, [ ], 'Response, delete' ],
+    [ ORP_PKT_RQST_HANDLER_ADD,    ORP_BYTE1_NONE, [ ORP_FIELD_ID_PATH, ORP_FIELD_ID_PATH_ID ], 'Request, handler add' ],
+    [ ORP_PKT_RESP_HANDLER_ADD,    ORP_BYTE1_STATUS, [ ], 'Response, handler add' ],
+    [ ORP_PKT_RQST_HANDLER_REMOVE, ORP_BYTE1_NONE, [ ORP_FIELD_ID_PATH, ORP_FIELD_ID_PATH_ID ], 'Request, handler remove' ],
+    [ ORP_PKT_RESP_HANDLER_REMOVE, ORP_BYTE1_STATUS, [ ], 'Response, handler remove' ],
+    [ ORP_PKT_RQST_PUSH,           ORP_BYTE1_DATA_TYPE, [ ORP_FIELD_ID_TIME, ORP_FIELD_ID_PATH, ORP_FIELD_ID_PATH_ID, ORP_FIELD_ID_DATA ], 'Request, push' ],
+    [ ORP_PKT_RESP_PUSH,           ORP_BYTE1_STATUS, [ ], 'Response, push' ],
+    [ ORP_PKT_RQST_PUSH_BATCH,     ORP_BYTE1_DATA_TYPE, [ ORP_FIELD_ID_RECORD ], 'Request, push batch' ],
+    [ ORP_PKT_RESP_PUSH_BATCH,     ORP_BYTE1_STATUS, [ ], 'Response, push batch' ],
+    [ ORP_PKT_RQST_GET,            ORP_BYTE1_NONE, [ ORP_FIELD_ID_PATH, ORP_FIELD_ID_PATH_ID ], 'Request, get' ],
+    [ ORP_PKT_RESP_GET,            ORP_BYTE1_STATUS, [ ORP_FIELD_ID_TIME, ORP_FIELD_ID_DATA ], 'Response, get' ],
+    [ ORP_PKT_RQST_GET_BATCH,      ORP_BYTE1_NONE, [ ORP_FIELD_ID_RECORD ], 'Request, get batch' ],
+    [ ORP_PKT_RESP_GET_BATCH,      ORP_BYTE1_STATUS, [ ORP_FIELD_ID_RECORD ], 'Response, get batch' ],
+    [ ORP_PKT_RQST_EXAMPLE_SET,    ORP_BYTE1_DATA_TYPE, [ ORP_FIELD_ID_PATH, ORP_FIELD_ID_PATH_ID, ORP_FIELD_ID_DATA ], 'Request, set example' ],
+    [ ORP_PKT_RESP_EXAMPLE_SET,    ORP_BYTE1_STATUS, [ ], 'Response, set example' ],
+    [ ORP_PKT_RQST_SENSOR_CREATE,  ORP_BYTE1_DATA_TYPE, [ ORP_FIELD_ID_PATH, ORP_FIELD_ID_PATH_ID, ORP_FIELD_ID_UNITS ], 'Request, sensor create' ],
+    [ ORP_PKT_RESP_SENSOR_CREATE,  ORP_BYTE1_STATUS, [ ], 'Response, sensor create' ],
+    [ ORP_PKT_RQST_SENSOR_REMOVE,  ORP_BYTE1_NONE, [ ORP_FIELD_ID_PATH, ORP_FIELD_ID_PATH_ID ], 'Request, sensor remove' ],
+    [ ORP_PKT_RESP_SENSOR_REMOVE,  ORP_BYTE1_STATUS, [ ], 'Response, sensor remove' ],
+    [ ORP_PKT_NTFY_HANDLER_CALL,   ORP_BYTE1_UNUSED, [ ORP_FIELD_ID_TIME, ORP_FIELD_ID_PATH, ORP_FIELD_ID_PATH_ID, ORP_FIELD_ID_DATA ], 'Notification, handler called' ],
+    [ ORP_PKT_RESP_HANDLER_CALL,   ORP_BYTE1_STATUS, [ ], 'Response, handler called' ],
+    [ ORP_PKT_NTFY_SENSOR_CALL,    ORP_BYTE1_UNUSED, [ ORP_FIELD_ID_PATH, ORP_FIELD_ID_PATH_ID ], 'Notification, sensor call' ],
+    [ ORP_PKT_RESP_SENSOR_CALL,    ORP_BYTE1_STATUS, [ ], 'Response, sensor call' ],
+    [ ORP_PKT_SYNC_SYN,            ORP_BYTE1_VERSION, [ ORP_FIELD_ID_TIME, ORP_FIELD_ID_MTU, ORP_FIELD_ID_SENT_COUNT, ORP_FIELD_ID_RECV_COUNT, ORP_FIELD_ID_CAPABILITIES ], 'Synchronization, sync' ],
+    [ ORP_PKT_SYNC_SYNACK,         ORP_BYTE1_VERSION, [ ORP_FIELD_ID_TIME, ORP_FIELD_ID_MTU, ORP_FIELD_ID_SENT_COUNT, ORP_FIELD_ID_RECV_COUNT, ORP_FIELD_ID_CAPABILITIES ], 'Synchronization, sync-ack' ],
+    [ ORP_PKT_SYNC_ACK,            ORP_BYTE1_VERSION, [ ], 'Synchronization, ack' ],
+    [ ORP_PKT_RQST_FILE_DATA,      ORP_BYTE1_UNUSED, [ ORP_FIELD_ID_DATA ], 'Request, File transfer data' ],
+    [ ORP_PKT_RESP_FILE_DATA,      ORP_BYTE1_STATUS, [ ], 'Response, File transfer data' ],
+    [ ORP_PKT_NTFY_FILE_CONTROL,   ORP_BYTE1_EVENT, [ ORP_FIELD_ID_DATA ], 'Notification, File transfer control' ],
+    [ ORP_PKT_RESP_FILE_CONTROL,   ORP_BYTE1_STATUS, [ ], 'Response, File transfer control' ],
+    [ ORP_PKT_RESP_UNKNOWN_RQST,   ORP_BYTE1_NONE, [ ], 'Response, unknown request' ],
+]
+
+
+#
+# Variable length fields: [ identifier, description ]
+#
+field_schema = [
+    [ ORP_FIELD_ID_TIME,        'Timestamp' ],
+    [ ORP_FIELD_ID_PATH,        'Path' ],
+    [ ORP_FIELD_ID_PATH_ID,     'Path identifier' ],
+    [ ORP_FIELD_ID_UNITS,       'Units' ],
+    [ ORP_FIELD_ID_DATA,        'Data' ],
+    [ ORP_FIELD_ID_MTU,         'Maximum Transfer Unit' ],
+    [ ORP_FIELD_ID_SENT_COUNT,  'Sent byte count' ],
+    [ ORP_FIELD_ID_RECV_COUNT,  'Received byte count' ],
+    [ ORP_FIELD_ID_CAPABILITIES, 'Capabilities' ],
+    [ ORP_FIELD_ID_RECORD,      'Record' ],
+    [ ORP_FIELD_ID_STATUS,      'Status' ],
+]
+
+
+#
+# Data types: [ keyword, type ]
+#
+data_types = [
+    [ 'trig',  ORP_DATA_TYPE_TRIGGER ],
+    [ 'bool',  ORP_DATA_TYPE_BOOLEAN ],
+    [ 'num',   ORP_DATA_TYPE_NUMERIC ],
+    [ 'str',   ORP_DATA_TYPE_STRING  ],
+    [ 'json',  ORP_DATA_TYPE_JSON    ],
+]